@@ -0,0 +1,121 @@
+#ifndef DG_ADT_ARENA_H_
+#define DG_ADT_ARENA_H_
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <utility>
+#include <vector>
+
+namespace dg {
+namespace ADT {
+
+///
+// Bump allocator for objects that live as long as their owner (e.g.,
+// the nodes of a graph). The objects are allocated one after another
+// in the order of creation in big chunks of memory and the chunks
+// are freed all at once when the arena is destroyed. The arena does
+// not call destructors of the objects, these are called by the owners
+// of the objects via ArenaPtr, which does not free the memory.
+// The owners of the objects must be destroyed before the arena.
+class Arena {
+    static const size_t MinChunkSize = 4096;
+    static const size_t MaxChunkSize = 1 << 20;
+
+    std::vector<std::unique_ptr<char[]>> _chunks;
+    char *_cur{nullptr};
+    char *_end{nullptr};
+    size_t _nextChunkSize{MinChunkSize};
+    size_t _allocated{0};
+
+    void newChunk(size_t size) {
+        // the chunks grow geometrically, so that there is
+        // only a few of them even for huge graphs
+        size_t chunkSize = std::max(size, _nextChunkSize);
+        if (_nextChunkSize < MaxChunkSize)
+            _nextChunkSize *= 2;
+
+        _chunks.emplace_back(new char[chunkSize]);
+        _cur = _chunks.back().get();
+        _end = _cur + chunkSize;
+    }
+
+  public:
+    Arena() = default;
+    Arena(const Arena &) = delete;
+    Arena &operator=(const Arena &) = delete;
+    Arena(Arena &&rhs) noexcept { swap(rhs); }
+    // swap the chunks, so that the memory of this arena is freed
+    // only with 'rhs' (after the objects from the memory are destroyed)
+    Arena &operator=(Arena &&rhs) noexcept {
+        swap(rhs);
+        return *this;
+    }
+
+    void swap(Arena &rhs) noexcept {
+        _chunks.swap(rhs._chunks);
+        std::swap(_cur, rhs._cur);
+        std::swap(_end, rhs._end);
+        std::swap(_nextChunkSize, rhs._nextChunkSize);
+        std::swap(_allocated, rhs._allocated);
+    }
+
+    void *allocate(size_t size, size_t align) {
+        assert(align > 0 && (align & (align - 1)) == 0 &&
+               "Alignment must be a power of two");
+
+        auto addr = reinterpret_cast<uintptr_t>(_cur);
+        auto aligned = (addr + align - 1) & ~(uintptr_t(align) - 1);
+        if (!_cur || aligned + size > reinterpret_cast<uintptr_t>(_end)) {
+            newChunk(size + align);
+            addr = reinterpret_cast<uintptr_t>(_cur);
+            aligned = (addr + align - 1) & ~(uintptr_t(align) - 1);
+        }
+
+        _cur = reinterpret_cast<char *>(aligned + size);
+        _allocated += size;
+        return reinterpret_cast<void *>(aligned);
+    }
+
+    template <typename T, typename... Args>
+    T *create(Args &&...args) {
+        return new (allocate(sizeof(T), alignof(T)))
+                T(std::forward<Args>(args)...);
+    }
+
+    // Take over the memory of 'rhs' (e.g., of the objects created
+    // in another thread), it is freed with this arena. The new objects
+    // are still allocated in the current chunk of this arena.
+    void take(Arena &rhs) {
+        _chunks.reserve(_chunks.size() + rhs._chunks.size());
+        for (auto &chunk : rhs._chunks)
+            _chunks.push_back(std::move(chunk));
+        _allocated += rhs._allocated;
+
+        rhs._chunks.clear();
+        rhs._cur = rhs._end = nullptr;
+        rhs._allocated = 0;
+    }
+
+    // the number of bytes taken by the objects
+    size_t getAllocatedBytes() const { return _allocated; }
+    size_t getChunksNum() const { return _chunks.size(); }
+};
+
+// calls the destructor of an object allocated in an arena
+// (the memory is freed with the arena)
+template <typename T>
+struct ArenaDeleter {
+    void operator()(T *obj) const { obj->~T(); }
+};
+
+template <typename T>
+using ArenaPtr = std::unique_ptr<T, ArenaDeleter<T>>;
+
+} // namespace ADT
+} // namespace dg
+
+#endif // DG_ADT_ARENA_H_
@@ -118,6 +118,52 @@ class SparseBitvectorImpl {
         return true;
     }
 
+    // is there a bit set in both bitvectors? Compares whole buckets
+    // and looks up only the buckets of the bitvector with fewer buckets
+    bool intersects(const SparseBitvectorImpl &rhs) const {
+        const auto &smaller = _bits.size() < rhs._bits.size() ? _bits
+                                                              : rhs._bits;
+        const auto &larger = &smaller == &_bits ? rhs._bits : _bits;
+        for (auto &pair : smaller) {
+            auto it = larger.find(pair.first);
+            if (it != larger.end() && (it->second & pair.second))
+                return true;
+        }
+
+        return false;
+    }
+
+    bool operator==(const SparseBitvectorImpl &rhs) const {
+        if (_bits.size() != rhs._bits.size())
+            return false;
+
+        for (auto &pair : _bits) {
+            auto it = rhs._bits.find(pair.first);
+            if (it == rhs._bits.end() || it->second != pair.second)
+                return false;
+        }
+
+        return true;
+    }
+
+    bool operator!=(const SparseBitvectorImpl &rhs) const {
+        return !operator==(rhs);
+    }
+
+    // the hash does not depend on the order of the buckets
+    // (that is arbitrary when using a hash map)
+    size_t hash() const {
+        size_t h = _bits.size();
+        for (auto &pair : _bits) {
+            uint64_t x = static_cast<uint64_t>(pair.first) * 0x9e3779b97f4a7c15ULL;
+            x ^= static_cast<uint64_t>(pair.second);
+            x *= 0xff51afd7ed558ccdULL;
+            h += static_cast<size_t>(x ^ (x >> 32));
+        }
+
+        return h;
+    }
+
     // FIXME: track the number of elements
     // in a variable, to avoid this search...
     size_t size() const {
@@ -0,0 +1,649 @@
+#ifndef DG_HYBRID_BITVECTOR_H_
+#define DG_HYBRID_BITVECTOR_H_
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <vector>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace dg {
+namespace ADT {
+
+namespace detail {
+
+// 256 bits, the unit of storage of HybridBitvector
+struct BitBlock {
+    static const size_t WORDS = 4;
+    static const size_t BITS = WORDS * 64;
+
+    uint64_t words[WORDS];
+};
+
+inline size_t popcount(uint64_t w) { return __builtin_popcountll(w); }
+
+inline size_t popcount(const uint64_t (&words)[BitBlock::WORDS]) {
+    return popcount(words[0]) + popcount(words[1]) + popcount(words[2]) +
+           popcount(words[3]);
+}
+
+// The kernels operating on whole blocks. They use AVX2 or SSE2
+// if the compiler targets them, otherwise the scalar fallback.
+
+inline bool isZero(const BitBlock &b) {
+#if defined(__AVX2__)
+    __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(b.words));
+    return _mm256_testz_si256(x, x);
+#elif defined(__SSE2__)
+    __m128i x = _mm_or_si128(
+            _mm_loadu_si128(reinterpret_cast<const __m128i *>(b.words)),
+            _mm_loadu_si128(reinterpret_cast<const __m128i *>(b.words + 2)));
+    return _mm_movemask_epi8(_mm_cmpeq_epi32(x, _mm_setzero_si128())) ==
+           0xFFFF;
+#else
+    return (b.words[0] | b.words[1] | b.words[2] | b.words[3]) == 0;
+#endif
+}
+
+inline bool equal(const BitBlock &a, const BitBlock &b) {
+#if defined(__AVX2__)
+    __m256i x = _mm256_xor_si256(
+            _mm256_loadu_si256(reinterpret_cast<const __m256i *>(a.words)),
+            _mm256_loadu_si256(reinterpret_cast<const __m256i *>(b.words)));
+    return _mm256_testz_si256(x, x);
+#elif defined(__SSE2__)
+    __m128i lo = _mm_cmpeq_epi32(
+            _mm_loadu_si128(reinterpret_cast<const __m128i *>(a.words)),
+            _mm_loadu_si128(reinterpret_cast<const __m128i *>(b.words)));
+    __m128i hi = _mm_cmpeq_epi32(
+            _mm_loadu_si128(reinterpret_cast<const __m128i *>(a.words + 2)),
+            _mm_loadu_si128(reinterpret_cast<const __m128i *>(b.words + 2)));
+    return _mm_movemask_epi8(_mm_and_si128(lo, hi)) == 0xFFFF;
+#else
+    return a.words[0] == b.words[0] && a.words[1] == b.words[1] &&
+           a.words[2] == b.words[2] && a.words[3] == b.words[3];
+#endif
+}
+
+inline bool intersects(const BitBlock &a, const BitBlock &b) {
+#if defined(__AVX2__)
+    return !_mm256_testz_si256(
+            _mm256_loadu_si256(reinterpret_cast<const __m256i *>(a.words)),
+            _mm256_loadu_si256(reinterpret_cast<const __m256i *>(b.words)));
+#else
+    return ((a.words[0] & b.words[0]) | (a.words[1] & b.words[1]) |
+            (a.words[2] & b.words[2]) | (a.words[3] & b.words[3])) != 0;
+#endif
+}
+
+// dst |= src, returns the number of bits that were added to dst
+inline size_t unite(BitBlock &dst, const BitBlock &src) {
+    uint64_t added[BitBlock::WORDS];
+#if defined(__AVX2__)
+    __m256i d = _mm256_loadu_si256(reinterpret_cast<__m256i *>(dst.words));
+    __m256i s =
+            _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src.words));
+    __m256i a = _mm256_andnot_si256(d, s);
+    if (_mm256_testz_si256(a, a))
+        return 0;
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst.words),
+                        _mm256_or_si256(d, s));
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(added), a);
+#elif defined(__SSE2__)
+    for (size_t i = 0; i < BitBlock::WORDS; i += 2) {
+        __m128i d =
+                _mm_loadu_si128(reinterpret_cast<__m128i *>(dst.words + i));
+        __m128i s = _mm_loadu_si128(
+                reinterpret_cast<const __m128i *>(src.words + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(added + i),
+                         _mm_andnot_si128(d, s));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst.words + i),
+                         _mm_or_si128(d, s));
+    }
+#else
+    for (size_t i = 0; i < BitBlock::WORDS; ++i) {
+        added[i] = src.words[i] & ~dst.words[i];
+        dst.words[i] |= src.words[i];
+    }
+#endif
+    return popcount(added);
+}
+
+// dst &= src, returns the number of bits that were removed from dst
+inline size_t intersect(BitBlock &dst, const BitBlock &src) {
+    uint64_t removed[BitBlock::WORDS];
+#if defined(__AVX2__)
+    __m256i d = _mm256_loadu_si256(reinterpret_cast<__m256i *>(dst.words));
+    __m256i s =
+            _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src.words));
+    __m256i r = _mm256_andnot_si256(s, d);
+    if (_mm256_testz_si256(r, r))
+        return 0;
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst.words),
+                        _mm256_and_si256(d, s));
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(removed), r);
+#elif defined(__SSE2__)
+    for (size_t i = 0; i < BitBlock::WORDS; i += 2) {
+        __m128i d =
+                _mm_loadu_si128(reinterpret_cast<__m128i *>(dst.words + i));
+        __m128i s = _mm_loadu_si128(
+                reinterpret_cast<const __m128i *>(src.words + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(removed + i),
+                         _mm_andnot_si128(s, d));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst.words + i),
+                         _mm_and_si128(d, s));
+    }
+#else
+    for (size_t i = 0; i < BitBlock::WORDS; ++i) {
+        removed[i] = dst.words[i] & ~src.words[i];
+        dst.words[i] &= src.words[i];
+    }
+#endif
+    return popcount(removed);
+}
+
+} // namespace detail
+
+///
+// Bitvector that stores the bits in blocks of 256 bits. While the set
+// bits are sparse, the bitvector keeps a sorted sequence of non-empty
+// blocks together with their indices. Once the blocks cover at least
+// a half of the range between the first and the last block, the bitvector
+// switches to the dense mode where it stores all the blocks of the range
+// and no indices. It returns to the sparse mode if the range gets sparse
+// again. The number of set bits is cached.
+// The API is the same as the API of SparseBitvectorImpl.
+class HybridBitvector {
+  public:
+    using IndexT = uint64_t;
+
+  private:
+    using Block = detail::BitBlock;
+    static const size_t BLOCK_BITS = Block::BITS;
+    // the bitvectors with fewer blocks are always sparse
+    static const size_t MIN_DENSE_BLOCKS = 8;
+    // switch to dense mode if range <= DENSE_FACTOR * (non-empty blocks)
+    // and back to sparse mode if range > SPARSE_FACTOR * (non-empty blocks)
+    static const size_t DENSE_FACTOR = 2;
+    static const size_t SPARSE_FACTOR = 4;
+
+    std::vector<Block> _blocks;
+    // sparse mode: the sorted indices of _blocks (the blocks are not empty),
+    // dense mode: empty, _blocks[k] is the block _base + k
+    std::vector<IndexT> _indices;
+    IndexT _base{0};
+    bool _dense{false};
+    // the number of non-empty blocks in the dense mode
+    size_t _used{0};
+    // the number of set bits
+    size_t _count{0};
+
+    static IndexT _blockOf(IndexT i) { return i / BLOCK_BITS; }
+
+    static uint64_t &_word(Block &B, IndexT i) {
+        return B.words[(i % BLOCK_BITS) / 64];
+    }
+    static uint64_t _word(const Block &B, IndexT i) {
+        return B.words[(i % BLOCK_BITS) / 64];
+    }
+    static uint64_t _mask(IndexT i) { return uint64_t{1} << (i % 64); }
+
+    IndexT _blockIndex(size_t k) const {
+        return _dense ? _base + k : _indices[k];
+    }
+    size_t _usedBlocks() const { return _dense ? _used : _blocks.size(); }
+    IndexT _firstBlock() const { return _blockIndex(0); }
+    IndexT _lastBlock() const { return _blockIndex(_blocks.size() - 1); }
+
+    // walks over the non-empty blocks in the order of indices
+    class BlockCursor {
+        const HybridBitvector &bv;
+        size_t k{0};
+
+        void skipEmpty() {
+            while (k < bv._blocks.size() && detail::isZero(bv._blocks[k]))
+                ++k;
+        }
+
+      public:
+        BlockCursor(const HybridBitvector &b) : bv(b) { skipEmpty(); }
+        bool done() const { return k >= bv._blocks.size(); }
+        IndexT index() const { return bv._blockIndex(k); }
+        const Block &block() const { return bv._blocks[k]; }
+        void next() {
+            ++k;
+            skipEmpty();
+        }
+    };
+
+    Block *_findBlock(IndexT idx) {
+        if (_dense) {
+            return (idx >= _base && idx - _base < _blocks.size())
+                           ? &_blocks[idx - _base]
+                           : nullptr;
+        }
+
+        auto it = std::lower_bound(_indices.begin(), _indices.end(), idx);
+        if (it == _indices.end() || *it != idx)
+            return nullptr;
+        return &_blocks[it - _indices.begin()];
+    }
+
+    const Block *_findBlock(IndexT idx) const {
+        return const_cast<HybridBitvector *>(this)->_findBlock(idx);
+    }
+
+    void _toDense() {
+        assert(!_dense);
+        std::vector<Block> blocks(_lastBlock() - _firstBlock() + 1, Block{});
+        for (size_t k = 0; k < _blocks.size(); ++k)
+            blocks[_indices[k] - _indices[0]] = _blocks[k];
+
+        _base = _indices[0];
+        _used = _blocks.size();
+        _blocks.swap(blocks);
+        std::vector<IndexT>().swap(_indices);
+        _dense = true;
+    }
+
+    void _toSparse() {
+        assert(_dense);
+        std::vector<Block> blocks;
+        blocks.reserve(_used);
+        _indices.reserve(_used);
+        for (BlockCursor C(*this); !C.done(); C.next()) {
+            _indices.push_back(C.index());
+            blocks.push_back(C.block());
+        }
+
+        _blocks.swap(blocks);
+        _dense = false;
+        _used = 0;
+    }
+
+    void _maybeToDense() {
+        if (!_dense && _blocks.size() >= MIN_DENSE_BLOCKS &&
+            _lastBlock() - _firstBlock() + 1 <= DENSE_FACTOR * _blocks.size())
+            _toDense();
+    }
+
+    // make the dense range cover the blocks lo..hi
+    void _extendRange(IndexT lo, IndexT hi) {
+        assert(_dense && lo <= _base && hi >= _lastBlock());
+        _blocks.insert(_blocks.begin(), _base - lo, Block{});
+        _blocks.resize(hi - lo + 1, Block{});
+        _base = lo;
+    }
+
+    // get the block with the given index, create an empty one if needed
+    Block &_getOrCreateBlock(IndexT idx) {
+        if (_dense) {
+            if (Block *B = _findBlock(idx))
+                return *B;
+
+            IndexT lo = std::min(_base, idx);
+            IndexT hi = std::max(_lastBlock(), idx);
+            if (hi - lo + 1 <= SPARSE_FACTOR * (_used + 1)) {
+                _extendRange(lo, hi);
+                return _blocks[idx - _base];
+            }
+            _toSparse();
+        }
+
+        auto it = std::lower_bound(_indices.begin(), _indices.end(), idx);
+        auto pos = it - _indices.begin();
+        if (it != _indices.end() && *it == idx)
+            return _blocks[pos];
+
+        _indices.insert(it, idx);
+        _blocks.insert(_blocks.begin() + pos, Block{});
+        _maybeToDense();
+        return *_findBlock(idx);
+    }
+
+    // restore the invariants after some blocks may have become empty
+    void _normalize() {
+        if (_count == 0) {
+            reset();
+            return;
+        }
+
+        if (!_dense) {
+            size_t n = 0;
+            for (size_t k = 0; k < _blocks.size(); ++k) {
+                if (detail::isZero(_blocks[k]))
+                    continue;
+                _blocks[n] = _blocks[k];
+                _indices[n] = _indices[k];
+                ++n;
+            }
+            _blocks.resize(n);
+            _indices.resize(n);
+            return;
+        }
+
+        _used = 0;
+        size_t first = _blocks.size(), last = 0;
+        for (size_t k = 0; k < _blocks.size(); ++k) {
+            if (detail::isZero(_blocks[k]))
+                continue;
+            ++_used;
+            first = std::min(first, k);
+            last = k;
+        }
+        _blocks.resize(last + 1);
+        _blocks.erase(_blocks.begin(), _blocks.begin() + first);
+        _base += first;
+
+        if (_blocks.size() > SPARSE_FACTOR * _used)
+            _toSparse();
+    }
+
+    void _uniteDense(const HybridBitvector &rhs) {
+        _extendRange(std::min(_base, rhs._firstBlock()),
+                     std::max(_lastBlock(), rhs._lastBlock()));
+        for (BlockCursor C(rhs); !C.done(); C.next()) {
+            Block &B = _blocks[C.index() - _base];
+            bool wasZero = detail::isZero(B);
+            _count += detail::unite(B, C.block());
+            if (wasZero)
+                ++_used;
+        }
+    }
+
+    void _uniteSparse(const HybridBitvector &rhs) {
+        // find out whether we need new blocks
+        size_t missing = 0;
+        size_t k = 0;
+        for (BlockCursor C(rhs); !C.done(); C.next()) {
+            while (k < _indices.size() && _indices[k] < C.index())
+                ++k;
+            if (k == _indices.size() || _indices[k] != C.index())
+                ++missing;
+        }
+
+        if (missing == 0) {
+            k = 0;
+            for (BlockCursor C(rhs); !C.done(); C.next()) {
+                while (_indices[k] < C.index())
+                    ++k;
+                _count += detail::unite(_blocks[k], C.block());
+            }
+            return;
+        }
+
+        std::vector<Block> blocks;
+        std::vector<IndexT> indices;
+        blocks.reserve(_blocks.size() + missing);
+        indices.reserve(_blocks.size() + missing);
+        k = 0;
+        for (BlockCursor C(rhs); !C.done(); C.next()) {
+            while (k < _indices.size() && _indices[k] < C.index()) {
+                indices.push_back(_indices[k]);
+                blocks.push_back(_blocks[k]);
+                ++k;
+            }
+            if (k < _indices.size() && _indices[k] == C.index()) {
+                indices.push_back(_indices[k]);
+                blocks.push_back(_blocks[k]);
+                _count += detail::unite(blocks.back(), C.block());
+                ++k;
+            } else {
+                indices.push_back(C.index());
+                blocks.push_back(C.block());
+                _count += detail::popcount(C.block().words);
+            }
+        }
+        indices.insert(indices.end(), _indices.begin() + k, _indices.end());
+        blocks.insert(blocks.end(), _blocks.begin() + k, _blocks.end());
+
+        _indices.swap(indices);
+        _blocks.swap(blocks);
+        _maybeToDense();
+    }
+
+  public:
+    HybridBitvector() = default;
+    HybridBitvector(IndexT i) { set(i); } // singleton ctor
+
+    HybridBitvector(const HybridBitvector &) = default;
+    HybridBitvector(HybridBitvector &&) = default;
+    HybridBitvector &operator=(const HybridBitvector &) = default;
+    HybridBitvector &operator=(HybridBitvector &&) = default;
+
+    void reset() {
+        _blocks.clear();
+        _indices.clear();
+        _base = 0;
+        _dense = false;
+        _used = 0;
+        _count = 0;
+    }
+
+    bool empty() const { return _count == 0; }
+
+    void swap(HybridBitvector &oth) {
+        _blocks.swap(oth._blocks);
+        _indices.swap(oth._indices);
+        std::swap(_base, oth._base);
+        std::swap(_dense, oth._dense);
+        std::swap(_used, oth._used);
+        std::swap(_count, oth._count);
+    }
+
+    // the number of blocks does not follow from the number of bits,
+    // the blocks are allocated as needed
+    void reserve(size_t /*unused*/) {}
+
+    bool isDense() const { return _dense; }
+
+    bool get(IndexT i) const {
+        const Block *B = _findBlock(_blockOf(i));
+        return B && (_word(*B, i) & _mask(i));
+    }
+
+    // returns the previous value of the i-th bit
+    bool set(IndexT i) {
+        Block &B = _getOrCreateBlock(_blockOf(i));
+        uint64_t &w = _word(B, i);
+        if (w & _mask(i))
+            return true;
+
+        if (_dense && detail::isZero(B))
+            ++_used;
+        w |= _mask(i);
+        ++_count;
+        return false;
+    }
+
+    // union operation
+    bool set(const HybridBitvector &rhs) {
+        if (rhs.empty() || &rhs == this)
+            return false;
+        if (empty()) {
+            *this = rhs;
+            return true;
+        }
+
+        auto oldCount = _count;
+        if (_dense) {
+            IndexT lo = std::min(_base, rhs._firstBlock());
+            IndexT hi = std::max(_lastBlock(), rhs._lastBlock());
+            if (hi - lo + 1 <= SPARSE_FACTOR * (_used + rhs._usedBlocks())) {
+                _uniteDense(rhs);
+                if (_blocks.size() > SPARSE_FACTOR * _used)
+                    _toSparse();
+                return _count != oldCount;
+            }
+            _toSparse();
+        }
+
+        _uniteSparse(rhs);
+        return _count != oldCount;
+    }
+
+    // intersection operation, returns true if this bitvector changed
+    bool intersect(const HybridBitvector &rhs) {
+        if (&rhs == this)
+            return false;
+
+        auto oldCount = _count;
+        for (size_t k = 0; k < _blocks.size(); ++k) {
+            Block &B = _blocks[k];
+            if (const Block *R = rhs._findBlock(_blockIndex(k))) {
+                _count -= detail::intersect(B, *R);
+            } else {
+                _count -= detail::popcount(B.words);
+                B = Block{};
+            }
+        }
+
+        if (_count == oldCount)
+            return false;
+        _normalize();
+        return true;
+    }
+
+    // do the bitvectors have a common bit?
+    bool intersects(const HybridBitvector &rhs) const {
+        BlockCursor L(*this), R(rhs);
+        while (!L.done() && !R.done()) {
+            if (L.index() < R.index()) {
+                L.next();
+            } else if (R.index() < L.index()) {
+                R.next();
+            } else {
+                if (detail::intersects(L.block(), R.block()))
+                    return true;
+                L.next();
+                R.next();
+            }
+        }
+        return false;
+    }
+
+    // returns the previous value of the i-th bit
+    bool unset(IndexT i) {
+        Block *B = _findBlock(_blockOf(i));
+        if (!B || !(_word(*B, i) & _mask(i)))
+            return false;
+
+        _word(*B, i) &= ~_mask(i);
+        --_count;
+        if (detail::isZero(*B))
+            _normalize();
+
+        assert(get(i) == 0 && "Failed removing");
+        return true;
+    }
+
+    bool operator==(const HybridBitvector &rhs) const {
+        if (_count != rhs._count)
+            return false;
+
+        BlockCursor L(*this), R(rhs);
+        for (; !L.done() && !R.done(); L.next(), R.next()) {
+            if (L.index() != R.index() || !detail::equal(L.block(), R.block()))
+                return false;
+        }
+        return L.done() && R.done();
+    }
+
+    bool operator!=(const HybridBitvector &rhs) const {
+        return !operator==(rhs);
+    }
+
+    // the hash does not depend on the mode of the bitvector
+    size_t hash() const {
+        uint64_t h = _count;
+        for (BlockCursor C(*this); !C.done(); C.next()) {
+            h = (h ^ C.index()) * 0x9e3779b97f4a7c15ULL;
+            for (auto w : C.block().words) {
+                h = (h ^ w) * 0xff51afd7ed558ccdULL;
+                h ^= h >> 32;
+            }
+        }
+
+        return static_cast<size_t>(h);
+    }
+
+    size_t size() const { return _count; }
+
+    // the bytes allocated on the heap by the bitvector
+    size_t getMemoryUsage() const {
+        return _blocks.capacity() * sizeof(Block) +
+               _indices.capacity() * sizeof(IndexT);
+    }
+
+    class const_iterator {
+        const HybridBitvector *bv{nullptr};
+        size_t block{0};
+        size_t word{0};
+        // the bits of the current word that were not visited yet
+        uint64_t bits{0};
+
+        const_iterator(const HybridBitvector &b, bool end = false)
+                : bv(&b), block(end ? b._blocks.size() : 0) {
+            if (block < b._blocks.size()) {
+                bits = b._blocks[0].words[0];
+                _findClosestBit();
+            }
+        }
+
+        void _findClosestBit() {
+            while (bits == 0) {
+                if (++word == Block::WORDS) {
+                    word = 0;
+                    if (++block == bv->_blocks.size())
+                        return;
+                }
+                bits = bv->_blocks[block].words[word];
+            }
+        }
+
+      public:
+        const_iterator() = default;
+        const_iterator &operator++() {
+            assert(bits != 0 && "operator++ called on end");
+            bits &= bits - 1;
+            _findClosestBit();
+            return *this;
+        }
+
+        const_iterator operator++(int) {
+            auto tmp = *this;
+            operator++();
+            return tmp;
+        }
+
+        IndexT operator*() const {
+            return bv->_blockIndex(block) * BLOCK_BITS + word * 64 +
+                   __builtin_ctzll(bits);
+        }
+
+        bool operator==(const const_iterator &rhs) const {
+            return block == rhs.block && word == rhs.word && bits == rhs.bits;
+        }
+
+        bool operator!=(const const_iterator &rhs) const {
+            return !operator==(rhs);
+        }
+
+        friend class HybridBitvector;
+    };
+
+    const_iterator begin() const { return const_iterator(*this); }
+    const_iterator end() const { return const_iterator(*this, true /* end */); }
+
+    friend class const_iterator;
+};
+
+} // namespace ADT
+} // namespace dg
+
+#endif // DG_HYBRID_BITVECTOR_H_
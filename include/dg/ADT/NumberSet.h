@@ -2,17 +2,17 @@
 #define _DG_NUMBER_SET_H_
 
 #include "Bits.h"
-#include "Bitvector.h"
+#include "HybridBitvector.h"
 
 namespace dg {
 namespace ADT {
 
-// this is just a wrapper around sparse bitvector
+// this is just a wrapper around hybrid bitvector
 // that translates the bitvector methods to a new methods.
 // There is no possibility to remove elements from the set.
 class BitvectorNumberSet {
     using NumT = uint64_t;
-    using ContainerT = SparseBitvectorImpl<uint64_t, NumT>;
+    using ContainerT = HybridBitvector;
 
     ContainerT _bitvector;
 
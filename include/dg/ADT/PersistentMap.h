@@ -0,0 +1,318 @@
+#ifndef DG_ADT_PERSISTENT_MAP_H_
+#define DG_ADT_PERSISTENT_MAP_H_
+
+#include <cassert>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace dg {
+namespace ADT {
+
+///
+// Map from pointers to values implemented as a persistent (structurally
+// shared) big-endian Patricia trie. Copying the map is O(1) as the copy
+// shares the nodes of the trie with the original map. A node that is
+// shared by more maps is copied when it is modified in one of them
+// (copy-on-write), so only the path to the modified entry gets copied.
+// The shape of the trie depends only on the set of keys and the merge
+// of two maps skips the subtrees that the maps share, so merging maps
+// that were created from each other is proportional to their difference.
+// The entries are iterated in the order of keys, like in std::map.
+template <typename KeyT, typename ValueT>
+class PersistentMap {
+    static_assert(std::is_pointer<KeyT>::value, "The keys must be pointers");
+
+    using BitsT = uintptr_t;
+    struct Node;
+    using NodePtr = std::shared_ptr<Node>;
+
+  public:
+    using value_type = std::pair<const KeyT, ValueT>;
+
+  private:
+    struct Node {
+        // the key (bits) of a leaf or the common prefix of keys of a branch
+        BitsT prefix;
+        // the branching bit, 0 for leaves
+        BitsT mask{0};
+        // the entry of a leaf
+        value_type entry;
+        // the subtries of a branch (the bit is 0 and 1, respectively)
+        NodePtr left, right;
+
+        Node(KeyT key, ValueT value)
+                : prefix(bits(key)), entry(key, std::move(value)) {}
+        Node(BitsT p, BitsT m, NodePtr l, NodePtr r)
+                : prefix(p), mask(m), entry(nullptr, ValueT()),
+                  left(std::move(l)), right(std::move(r)) {}
+
+        bool isLeaf() const { return mask == 0; }
+    };
+
+    NodePtr root;
+
+    static BitsT bits(KeyT key) { return reinterpret_cast<BitsT>(key); }
+
+    // the highest bit in which the given keys differ
+    static BitsT branchingBit(BitsT a, BitsT b) {
+        BitsT x = a ^ b;
+        assert(x != 0 && "The keys do not differ");
+        while (x & (x - 1))
+            x &= x - 1;
+        return x;
+    }
+
+    // the bits of the key above the branching bit
+    static BitsT maskPrefix(BitsT k, BitsT m) { return k & ~(m | (m - 1)); }
+
+    static bool matchPrefix(BitsT k, const Node *n) {
+        return n->isLeaf() ? k == n->prefix
+                           : maskPrefix(k, n->mask) == n->prefix;
+    }
+
+    static NodePtr join(NodePtr t1, NodePtr t2) {
+        BitsT m = branchingBit(t1->prefix, t2->prefix);
+        if ((t1->prefix & m) == 0)
+            return std::make_shared<Node>(maskPrefix(t1->prefix, m), m,
+                                          std::move(t1), std::move(t2));
+        return std::make_shared<Node>(maskPrefix(t1->prefix, m), m,
+                                      std::move(t2), std::move(t1));
+    }
+
+    // copy the node if it is shared with another trie (or another
+    // place in this trie), so that it can be modified
+    static Node *writable(NodePtr &n) {
+        if (n.use_count() > 1)
+            n = std::make_shared<Node>(*n);
+        return n.get();
+    }
+
+    // Run 'modify' on a writable version of the node. If the node is shared
+    // and 'modify' does not change anything, the node is left untouched.
+    template <typename F>
+    static bool modifyNode(NodePtr &n, F modify) {
+        if (n.use_count() == 1)
+            return modify(n.get());
+
+        NodePtr copy = std::make_shared<Node>(*n);
+        if (!modify(copy.get()))
+            return false;
+        n = std::move(copy);
+        return true;
+    }
+
+    // Take the trie 't' from another map. The leaves that cannot be
+    // shared are re-created using the merge policy.
+    template <typename MergeT>
+    static NodePtr adopt(const NodePtr &t, MergeT &merge) {
+        if (merge.canShareAll())
+            return t;
+
+        if (t->isLeaf()) {
+            if (merge.canShare(t->entry.first, t->entry.second))
+                return t;
+            auto leaf = std::make_shared<Node>(t->entry.first,
+                                               merge.create(t->entry.first));
+            merge.merge(leaf->entry.second, t->entry.second);
+            return leaf;
+        }
+
+        auto l = adopt(t->left, merge);
+        auto r = adopt(t->right, merge);
+        if (l == t->left && r == t->right)
+            return t;
+        return std::make_shared<Node>(t->prefix, t->mask, std::move(l),
+                                      std::move(r));
+    }
+
+    // merge the trie 't' into the trie 's'
+    template <typename MergeT>
+    static bool mergeTries(NodePtr &s, const NodePtr &t, MergeT &merge) {
+        if (!t || s == t)
+            return false;
+
+        if (!s) {
+            s = adopt(t, merge);
+            return true;
+        }
+
+        if (s->isLeaf() && t->isLeaf() && s->prefix == t->prefix) {
+            return modifyNode(s, [&t, &merge](Node *n) {
+                return merge.merge(n->entry.second, t->entry.second);
+            });
+        }
+
+        if (s->mask == t->mask && s->prefix == t->prefix) {
+            // the same branch, merge the subtries
+            return modifyNode(s, [&t, &merge](Node *n) {
+                bool changed = mergeTries(n->left, t->left, merge);
+                changed |= mergeTries(n->right, t->right, merge);
+                return changed;
+            });
+        }
+
+        if (!s->isLeaf() && (t->isLeaf() || s->mask > t->mask) &&
+            matchPrefix(t->prefix, s.get())) {
+            // 't' belongs to one of the subtries of 's'
+            return modifyNode(s, [&t, &merge](Node *n) {
+                return mergeTries((t->prefix & n->mask) ? n->right : n->left,
+                                  t, merge);
+            });
+        }
+
+        if (!t->isLeaf() && (s->isLeaf() || t->mask > s->mask) &&
+            matchPrefix(s->prefix, t.get())) {
+            // 's' belongs to one of the subtries of 't'
+            NodePtr sub = std::move(s);
+            bool right = (sub->prefix & t->mask) != 0;
+            mergeTries(sub, right ? t->right : t->left, merge);
+            s = std::make_shared<Node>(
+                    t->prefix, t->mask,
+                    right ? adopt(t->left, merge) : std::move(sub),
+                    right ? std::move(sub) : adopt(t->right, merge));
+            return true;
+        }
+
+        // the tries have disjoint keys
+        s = join(s, adopt(t, merge));
+        return true;
+    }
+
+  public:
+    class const_iterator {
+        std::vector<const Node *> stack;
+
+        void descend(const Node *n) {
+            while (n && !n->isLeaf()) {
+                stack.push_back(n->right.get());
+                n = n->left.get();
+            }
+            if (n)
+                stack.push_back(n);
+        }
+
+        const_iterator(const Node *n) { descend(n); }
+        friend class PersistentMap;
+
+      public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = PersistentMap::value_type;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const value_type *;
+        using reference = const value_type &;
+
+        const_iterator() = default;
+
+        const_iterator &operator++() {
+            assert(!stack.empty());
+            stack.pop_back();
+            if (!stack.empty() && !stack.back()->isLeaf()) {
+                const Node *n = stack.back();
+                stack.pop_back();
+                descend(n);
+            }
+            return *this;
+        }
+
+        const_iterator operator++(int) {
+            auto tmp = *this;
+            operator++();
+            return tmp;
+        }
+
+        reference operator*() const { return stack.back()->entry; }
+        pointer operator->() const { return &stack.back()->entry; }
+
+        bool operator==(const const_iterator &rhs) const {
+            return stack.empty() ? rhs.stack.empty()
+                                 : (!rhs.stack.empty() &&
+                                    stack.back() == rhs.stack.back());
+        }
+        bool operator!=(const const_iterator &rhs) const {
+            return !operator==(rhs);
+        }
+    };
+
+    using iterator = const_iterator;
+
+    bool empty() const { return root == nullptr; }
+    void clear() { root.reset(); }
+
+    // O(n), the size is not stored
+    size_t size() const {
+        size_t n = 0;
+        for (auto it = begin(), et = end(); it != et; ++it)
+            ++n;
+        return n;
+    }
+
+    const_iterator begin() const { return const_iterator(root.get()); }
+    const_iterator end() const { return const_iterator(); }
+
+    // do the maps share the whole trie?
+    bool sharesWith(const PersistentMap &rhs) const { return root == rhs.root; }
+
+    const ValueT *find(KeyT key) const {
+        BitsT k = bits(key);
+        const Node *n = root.get();
+        while (n && !n->isLeaf()) {
+            if (!matchPrefix(k, n))
+                return nullptr;
+            n = (k & n->mask) ? n->right.get() : n->left.get();
+        }
+        return (n && n->prefix == k) ? &n->entry.second : nullptr;
+    }
+
+    size_t count(KeyT key) const { return find(key) ? 1 : 0; }
+
+    // Get the value for the key that can be modified in this map.
+    // If the key is not in the map, it is inserted with the value 'init'.
+    // The returned reference is valid until the map is modified
+    // (other than via getWritable for a different key) or destroyed.
+    ValueT &getWritable(KeyT key, const ValueT &init = ValueT()) {
+        BitsT k = bits(key);
+        NodePtr *cur = &root;
+        while (*cur && matchPrefix(k, cur->get())) {
+            Node *n = writable(*cur);
+            if (n->isLeaf())
+                return n->entry.second;
+            cur = (k & n->mask) ? &n->right : &n->left;
+        }
+
+        auto leaf = std::make_shared<Node>(key, init);
+        ValueT &ret = leaf->entry.second;
+        *cur = *cur ? join(std::move(*cur), std::move(leaf)) : std::move(leaf);
+        return ret;
+    }
+
+    ValueT &operator[](KeyT key) { return getWritable(key); }
+
+    ///
+    // Merge 'rhs' into this map, return true if this map changed.
+    // 'merge' is the policy that says how to merge the values:
+    //
+    //  bool canShareAll() - can all the values from 'rhs' be shared
+    //                       (taken as they are) if their keys are not
+    //                       in this map?
+    //  bool canShare(KeyT, const ValueT&) - the same for a single value
+    //  ValueT create(KeyT) - create a value for a key that is not in this
+    //                        map and whose value cannot be shared
+    //  bool merge(ValueT& to, const ValueT& from) - merge the values,
+    //                        return true if 'to' changed
+    //
+    // The subtries that are shared by the maps are skipped. Adding a new
+    // key to this map is always reported as a change.
+    template <typename MergeT>
+    bool merge(const PersistentMap &rhs, MergeT &merge) {
+        return mergeTries(root, rhs.root, merge);
+    }
+};
+
+} // namespace ADT
+} // namespace dg
+
+#endif // DG_ADT_PERSISTENT_MAP_H_
@@ -0,0 +1,105 @@
+#ifndef DG_POINTER_ANALYSIS_ALIAS_CACHE_H_
+#define DG_POINTER_ANALYSIS_ALIAS_CACHE_H_
+
+#include <cstddef>
+#include <list>
+#include <unordered_map>
+#include <utility>
+
+#include "dg/ADT/Bitvector.h"
+#include "dg/Offset.h"
+#include "dg/PointerAnalysis/PSNode.h"
+
+namespace dg {
+namespace pta {
+
+///
+// Answer alias queries on the points-to sets of nodes: may the memory
+// of 'size1' bytes accessed via the pointers of 'n1' overlap the memory
+// of 'size2' bytes accessed via the pointers of 'n2'? The unknown size
+// (or 0) means that the access may span the rest of the object.
+// Null and invalidated memory is not taken into account (accessing
+// it is undefined behavior), an empty points-to set and the unknown
+// memory may alias with anything.
+//
+// The targets of the points-to sets are kept as bitvectors of IDs
+// of nodes, so that the sets without common targets are found without
+// comparing the pointers. The answers are kept in a cache of bounded
+// size that drops the least recently used answers. The bitvectors
+// of targets are dropped together with the last answer about the node,
+// so they are bounded by the size of the cache too. The cache must be
+// cleared when the points-to sets change.
+class AliasCache {
+    struct Key {
+        const PSNode *n1;
+        const PSNode *n2;
+        Offset::type size1;
+        Offset::type size2;
+
+        bool operator==(const Key &rhs) const {
+            return n1 == rhs.n1 && n2 == rhs.n2 && size1 == rhs.size1 &&
+                   size2 == rhs.size2;
+        }
+    };
+
+    struct KeyHash {
+        size_t operator()(const Key &k) const {
+            size_t h = std::hash<const PSNode *>()(k.n1);
+            h = h * 0x9e3779b97f4a7c15ULL ^ std::hash<const PSNode *>()(k.n2);
+            h = h * 0x9e3779b97f4a7c15ULL ^ k.size1;
+            return h * 0x9e3779b97f4a7c15ULL ^ k.size2;
+        }
+    };
+
+    using LRUList = std::list<std::pair<Key, bool>>;
+
+    size_t _capacity;
+    // the most recently used answers are at the front
+    LRUList _answers;
+    std::unordered_map<Key, LRUList::iterator, KeyHash> _index;
+    struct Targets {
+        // the IDs of targets of the points-to set of the node
+        // (the unknown memory is not included)
+        ADT::SparseBitvector ids;
+        // the number of cached answers about the node
+        size_t answers{0};
+    };
+
+    std::unordered_map<const PSNode *, Targets> _targets;
+
+    size_t _hits{0};
+    size_t _misses{0};
+
+    const ADT::SparseBitvector &getTargets(const PSNode *node);
+    void retainTargets(const PSNode *node);
+    void releaseTargets(const PSNode *node);
+    bool compute(const PSNode *n1, Offset size1, const PSNode *n2,
+                 Offset size2);
+
+  public:
+    AliasCache(size_t capacity = 1 << 16) : _capacity(capacity) {}
+
+    bool alias(const PSNode *n1, Offset size1, const PSNode *n2,
+               Offset size2);
+
+    // do the accesses of memory of 'size1' bytes at 'off1'
+    // and 'size2' bytes at 'off2' overlap?
+    static bool overlap(Offset off1, Offset size1, Offset off2,
+                        Offset size2);
+
+    void clear() {
+        _answers.clear();
+        _index.clear();
+        _targets.clear();
+    }
+
+    size_t size() const { return _answers.size(); }
+    size_t getTargetsNum() const { return _targets.size(); }
+    size_t getHits() const { return _hits; }
+    size_t getMisses() const { return _misses; }
+};
+
+} // namespace pta
+} // namespace dg
+
+#endif // DG_POINTER_ANALYSIS_ALIAS_CACHE_H_
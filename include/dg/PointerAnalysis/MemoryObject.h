@@ -1,10 +1,9 @@
 #ifndef DG_MEMORY_OBJECT_H_
 #define DG_MEMORY_OBJECT_H_
 
+#include <algorithm>
 #include <cassert>
-#include <map>
-#include <set>
-#include <unordered_map>
+#include <utility>
 
 #ifndef NDEBUG
 #include "dg/PointerAnalysis/PSNode.h"
@@ -17,7 +16,7 @@ namespace dg {
 namespace pta {
 
 struct MemoryObject {
-    using PointsToMapT = std::map<Offset, PointsToSetT>;
+    using PointsToMapT = pta::PointsToMapT;
 
     MemoryObject(/*uint64_t s = 0, bool isheap = false, */ PSNode *n = nullptr)
             : node(n) /*, is_heap(isheap), size(s)*/ {}
@@ -51,6 +50,60 @@ struct MemoryObject {
         return changed;
     }
 
+    // the entries with known offsets in [off, off + len)
+    std::pair<PointsToMapT::const_iterator, PointsToMapT::const_iterator>
+    range(Offset off, Offset len) const {
+        return pointsTo.range(off, len);
+    }
+
+    ///
+    // Copy the pointers stored in 'src' at the offsets [from, from + len)
+    // to this object at the offsets shifted by 'to - from' (like memcpy).
+    // The pointers that would get to an offset not less than 'limit'
+    // go to the unknown offset, as do the pointers from the unknown
+    // offset of 'src' and all the copied pointers if 'from' or 'to'
+    // is unknown. The cost is proportional to the number of copied
+    // entries and entries of this object.
+    bool mergeRange(const MemoryObject &src, Offset from, Offset len,
+                    Offset to, Offset limit) {
+        // adding to this object may move its entries
+        if (&src == this) {
+            MemoryObject tmp(*this);
+            return mergeRange(tmp, from, len, to, limit);
+        }
+
+        bool changed = false;
+        if (from.isUnknown()) {
+            for (const auto &it : src.pointsTo)
+                changed |= addPointsTo(Offset::UNKNOWN, it.second);
+            return changed;
+        }
+
+        auto copied = src.range(from, len);
+        auto shifted = copied.first;
+        if (!to.isUnknown() && to < limit) {
+            // the entries that get below the limit (the unknown limit
+            // means that only the overflowing offsets are unknown)
+            Offset span = limit.isUnknown() ? Offset(Offset::UNKNOWN - *to)
+                                            : limit - to;
+            shifted = src.range(from, std::min(len, span)).second;
+            changed |= pointsTo.mergeShifted(
+                    copied.first, shifted, from, to,
+                    [](PointsToSetT &dst, const PointsToSetT &pointers) {
+                        return dst.add(pointers);
+                    });
+        }
+
+        for (auto it = shifted; it != copied.second; ++it)
+            changed |= addPointsTo(Offset::UNKNOWN, it->second);
+
+        auto unknown = src.pointsTo.find(Offset::UNKNOWN);
+        if (unknown != src.pointsTo.end())
+            changed |= addPointsTo(Offset::UNKNOWN, unknown->second);
+
+        return changed;
+    }
+
     bool addPointsTo(const Offset &off, const Pointer &ptr) {
         assert(ptr.target != nullptr &&
                "Cannot have NULL target, use unknown instead");
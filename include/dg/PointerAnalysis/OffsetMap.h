@@ -0,0 +1,310 @@
+#ifndef DG_OFFSET_MAP_H_
+#define DG_OFFSET_MAP_H_
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <utility>
+
+#include "dg/Offset.h"
+
+namespace dg {
+namespace pta {
+
+///
+// Map from offsets to values (the points-to sets stored in memory).
+// Most of the memory objects have only one offset (0 or the unknown
+// offset), so the entries are stored in an array sorted by the offsets
+// that is inline in the map for up to 'InlineN' entries and on the heap
+// for more entries (looked up by binary search then). Every inline
+// entry is paid for by every memory object, so keep 'InlineN' small.
+// The unknown offset is the greatest offset, so its entry is always
+// the last one and it is found without search. The entries are
+// iterated in the order of offsets, like in std::map. Unlike in
+// std::map, adding a new offset invalidates the references and
+// iterators to the entries and it moves the entries with greater
+// offsets, so it is linear in the size of the map (adding offsets
+// in increasing order is cheap). The number of offsets is not bounded
+// by default (fieldSensitivity is unknown), so objects with many
+// offsets should be filled by mergeShifted() where possible.
+template <typename ValueT, unsigned InlineN = 1>
+class OffsetMap {
+  public:
+    using value_type = std::pair<Offset, ValueT>;
+    using iterator = value_type *;
+    using const_iterator = const value_type *;
+
+  private:
+    // up to this size, the entries are searched linearly
+    static const unsigned LinearSearchMax = 8;
+
+    value_type *_data;
+    uint32_t _size{0};
+    uint32_t _capacity{InlineN};
+    alignas(value_type) unsigned char _inline[InlineN * sizeof(value_type)];
+
+    value_type *inlineData() {
+        return reinterpret_cast<value_type *>(_inline);
+    }
+
+    bool isInline() const {
+        return _data == reinterpret_cast<const value_type *>(_inline);
+    }
+
+    // the position of the entry with the offset
+    // or the position where the entry belongs
+    uint32_t lowerBound(Offset off) const {
+        if (off.isUnknown())
+            return (_size > 0 && _data[_size - 1].first.isUnknown())
+                           ? _size - 1
+                           : _size;
+
+        if (_size <= LinearSearchMax) {
+            uint32_t i = 0;
+            while (i < _size && _data[i].first < off)
+                ++i;
+            return i;
+        }
+
+        return std::lower_bound(_data, _data + _size, off,
+                                [](const value_type &e, Offset o) {
+                                    return e.first < o;
+                                }) -
+               _data;
+    }
+
+    void reserve(uint32_t cap) {
+        if (cap <= _capacity)
+            return;
+
+        auto *data = static_cast<value_type *>(
+                ::operator new(cap * sizeof(value_type)));
+        for (uint32_t i = 0; i < _size; ++i) {
+            new (&data[i]) value_type(std::move(_data[i]));
+            _data[i].~value_type();
+        }
+        if (!isInline())
+            ::operator delete(_data);
+
+        _data = data;
+        _capacity = cap;
+    }
+
+    // move the entry 'from' to the slot 'to', slots at 'constructed'
+    // and above are not constructed yet
+    void moveEntry(uint32_t from, uint32_t to, uint32_t constructed) {
+        if (from == to)
+            return;
+        if (to >= constructed)
+            new (&_data[to]) value_type(std::move(_data[from]));
+        else
+            _data[to] = std::move(_data[from]);
+    }
+
+    value_type &insertAt(uint32_t pos, Offset off) {
+        if (_size == _capacity)
+            reserve(2 * _capacity);
+
+        if (pos == _size) {
+            new (&_data[_size]) value_type(off, ValueT());
+        } else {
+            // move the tail one slot to the right
+            new (&_data[_size]) value_type(std::move(_data[_size - 1]));
+            for (uint32_t i = _size - 1; i > pos; --i)
+                _data[i] = std::move(_data[i - 1]);
+            _data[pos] = value_type(off, ValueT());
+        }
+        ++_size;
+        return _data[pos];
+    }
+
+    void destroy() {
+        for (uint32_t i = 0; i < _size; ++i)
+            _data[i].~value_type();
+        _size = 0;
+    }
+
+    void release() {
+        destroy();
+        if (!isInline())
+            ::operator delete(_data);
+        _data = inlineData();
+        _capacity = InlineN;
+    }
+
+    void copyFrom(const OffsetMap &rhs) {
+        reserve(rhs._size);
+        for (uint32_t i = 0; i < rhs._size; ++i)
+            new (&_data[i]) value_type(rhs._data[i]);
+        _size = rhs._size;
+    }
+
+    void moveFrom(OffsetMap &&rhs) {
+        if (rhs.isInline()) {
+            for (uint32_t i = 0; i < rhs._size; ++i)
+                new (&_data[i]) value_type(std::move(rhs._data[i]));
+            _size = rhs._size;
+            rhs.destroy();
+            return;
+        }
+
+        // steal the heap array
+        _data = rhs._data;
+        _size = rhs._size;
+        _capacity = rhs._capacity;
+        rhs._data = rhs.inlineData();
+        rhs._size = 0;
+        rhs._capacity = InlineN;
+    }
+
+  public:
+    OffsetMap() : _data(inlineData()) {}
+    OffsetMap(const OffsetMap &rhs) : _data(inlineData()) { copyFrom(rhs); }
+    OffsetMap(OffsetMap &&rhs) noexcept : _data(inlineData()) {
+        moveFrom(std::move(rhs));
+    }
+
+    OffsetMap &operator=(const OffsetMap &rhs) {
+        if (this != &rhs) {
+            destroy();
+            copyFrom(rhs);
+        }
+        return *this;
+    }
+
+    OffsetMap &operator=(OffsetMap &&rhs) noexcept {
+        if (this != &rhs) {
+            release();
+            moveFrom(std::move(rhs));
+        }
+        return *this;
+    }
+
+    ~OffsetMap() { release(); }
+
+    bool empty() const { return _size == 0; }
+    size_t size() const { return _size; }
+    void clear() { release(); }
+
+    iterator begin() { return _data; }
+    iterator end() { return _data + _size; }
+    const_iterator begin() const { return _data; }
+    const_iterator end() const { return _data + _size; }
+
+    iterator find(Offset off) {
+        auto pos = lowerBound(off);
+        return (pos < _size && _data[pos].first == off) ? _data + pos : end();
+    }
+
+    const_iterator find(Offset off) const {
+        auto pos = lowerBound(off);
+        return (pos < _size && _data[pos].first == off) ? _data + pos : end();
+    }
+
+    size_t count(Offset off) const { return find(off) != end() ? 1 : 0; }
+
+    // the first entry with the offset that is not less than 'off'
+    iterator lower_bound(Offset off) { return _data + lowerBound(off); }
+    const_iterator lower_bound(Offset off) const {
+        return _data + lowerBound(off);
+    }
+
+    // the entries with known offsets in [off, off + len). If the length
+    // is unknown (or the end overflows), the range spans all the greater
+    // known offsets.
+    std::pair<const_iterator, const_iterator> range(Offset off,
+                                                    Offset len) const {
+        assert(!off.isUnknown() && "Range at unknown offset");
+        // off + len is unknown if it overflows
+        return {lower_bound(off), lower_bound(off + len)};
+    }
+
+    ///
+    // Merge the entries [first, last) of another map into this map with
+    // the offsets shifted by 'to - from'. The entries must have known
+    // offsets not less than 'from' and the shifted offsets must be known
+    // too. The values are merged by 'merge(ValueT &, const ValueT &)'
+    // that returns true if the value changed, the entries with empty
+    // values are skipped. Returns true if any value changed.
+    // The new entries are inserted in one pass from the back, so the cost
+    // is linear in the number of entries of both maps (inserting
+    // the entries one by one would move the tail of the map every time).
+    template <typename MergeFn>
+    bool mergeShifted(const_iterator first, const_iterator last, Offset from,
+                      Offset to, MergeFn merge) {
+        assert((last <= _data || first >= _data + _size) &&
+               "Merging the entries of the same map");
+        auto shift = [from, to](Offset off) {
+            assert(from <= off && "Offset below the shifted range");
+            assert(*off - *from < Offset::UNKNOWN - *to && "Offset overflow");
+            return Offset(*off - *from + *to);
+        };
+
+        // count the offsets that are not in this map yet
+        uint32_t missing = 0;
+        uint32_t pos = 0;
+        for (auto it = first; it != last; ++it) {
+            if (it->second.empty())
+                continue;
+            auto off = shift(it->first);
+            while (pos < _size && _data[pos].first < off)
+                ++pos;
+            if (pos == _size || _data[pos].first != off)
+                ++missing;
+        }
+
+        if (_size + missing > _capacity)
+            reserve(std::max(_size + missing, 2 * _capacity));
+
+        // merge from the back, every old entry is moved at most once
+        // (the unknown offset is the greatest one, so it stays last)
+        bool changed = false;
+        const uint32_t size = _size;
+        uint32_t old = _size;
+        uint32_t slot = _size + missing;
+        for (auto it = last; it != first;) {
+            const auto &entry = *(it - 1);
+            if (entry.second.empty()) {
+                --it;
+                continue;
+            }
+
+            auto off = shift(entry.first);
+            if (old > 0 && off < _data[old - 1].first) {
+                --old;
+                moveEntry(old, --slot, size);
+                continue;
+            }
+
+            --it;
+            --slot;
+            if (old > 0 && _data[old - 1].first == off) {
+                moveEntry(--old, slot, size);
+            } else if (slot >= size) {
+                new (&_data[slot]) value_type(off, ValueT());
+            } else {
+                _data[slot] = value_type(off, ValueT());
+            }
+            changed |= merge(_data[slot].second, entry.second);
+        }
+        assert(old == slot && "Entries got lost");
+
+        _size += missing;
+        return changed;
+    }
+
+    // the value for the offset, inserted if not present
+    ValueT &operator[](Offset off) {
+        auto pos = lowerBound(off);
+        if (pos < _size && _data[pos].first == off)
+            return _data[pos].second;
+        return insertAt(pos, off).second;
+    }
+};
+
+} // namespace pta
+} // namespace dg
+
+#endif // DG_OFFSET_MAP_H_
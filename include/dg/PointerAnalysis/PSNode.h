@@ -1,11 +1,14 @@
 #ifndef DG_PS_NODE_H_
 #define DG_PS_NODE_H_
 
+#include <algorithm>
 #include <cassert>
 #include <cstdarg>
 #include <iostream>
+#include <memory>
 #include <string>
 #include <utility>
+#include <vector>
 
 #ifndef NDEBUG
 #include <iostream>
@@ -139,6 +142,11 @@ class PSNode : public SubgraphNode<PSNode> {
 
     unsigned int dfsid = 0;
 
+    // pointers in the order in which they were added to 'pointsTo'.
+    // It is kept only when the analysis uses difference propagation
+    // (users then process only the pointers they have not seen yet)
+    std::unique_ptr<std::vector<Pointer>> ptsHistory;
+
   public:
     ///
     // Construct a PSNode
@@ -232,13 +240,49 @@ class PSNode : public SubgraphNode<PSNode> {
     PointsToSetT pointsTo;
 
     // convenient helper
-    bool addPointsTo(PSNode *n, Offset o) {
-        return pointsTo.add(Pointer(n, o));
+    bool addPointsTo(PSNode *n, Offset o) { return addPointsTo(Pointer(n, o)); }
+    bool addPointsTo(const Pointer &ptr) {
+        if (!pointsTo.add(ptr))
+            return false;
+        if (ptsHistory)
+            ptsHistory->push_back(ptr);
+        return true;
+    }
+    bool addPointsTo(const PointsToSetT &ptrs) {
+        if (!ptsHistory)
+            return pointsTo.add(ptrs);
+
+        bool changed = false;
+        for (const auto &ptr : ptrs)
+            changed |= addPointsTo(ptr);
+        return changed;
     }
-    bool addPointsTo(const Pointer &ptr) { return pointsTo.add(ptr); }
-    bool addPointsTo(const PointsToSetT &ptrs) { return pointsTo.add(ptrs); }
     bool addPointsTo(std::initializer_list<Pointer> ptrs) {
-        return pointsTo.add(ptrs);
+        bool changed = false;
+        for (const auto &ptr : ptrs)
+            changed |= addPointsTo(ptr);
+        return changed;
+    }
+
+    ///
+    // Start recording the order in which pointers are added
+    // to the points-to set. The pointers that are already
+    // in the set are recorded first.
+    void trackPointsToHistory() {
+        if (ptsHistory)
+            return;
+
+        ptsHistory.reset(new std::vector<Pointer>());
+        ptsHistory->reserve(pointsTo.size());
+        for (const auto &ptr : pointsTo)
+            ptsHistory->push_back(ptr);
+    }
+
+    void dropPointsToHistory() { ptsHistory.reset(); }
+
+    // nullptr if the history is not tracked
+    const std::vector<Pointer> *getPointsToHistory() const {
+        return ptsHistory.get();
     }
 
     bool doesPointsTo(const Pointer &p) const { return pointsTo.count(p) == 1; }
@@ -451,6 +495,11 @@ class PSNodeEntry : public PSNode {
         callers.push_back(n);
         return true;
     }
+
+    void removeCaller(PSNode *n) {
+        callers.erase(std::remove(callers.begin(), callers.end(), n),
+                      callers.end());
+    }
 };
 
 class PSNodeCall : public PSNode {
@@ -490,6 +539,11 @@ class PSNodeCall : public PSNode {
         return true;
     }
 
+    void removeCallee(PointerSubgraph *ps) {
+        callees.erase(std::remove(callees.begin(), callees.end(), ps),
+                      callees.end());
+    }
+
 #ifndef NDEBUG
     // verbose dump
     void dumpv() const override {
@@ -548,6 +602,11 @@ class PSNodeCallRet : public PSNode {
         return true;
     }
 
+    void removeReturn(PSNode *p) {
+        returns.erase(std::remove(returns.begin(), returns.end(), p),
+                      returns.end());
+    }
+
 #ifndef NDEBUG
     // verbose dump
     void dumpv() const override {
@@ -593,6 +652,11 @@ class PSNodeRet : public PSNode {
         return true;
     }
 
+    void removeReturnSite(PSNode *r) {
+        returns.erase(std::remove(returns.begin(), returns.end(), r),
+                      returns.end());
+    }
+
 #ifndef NDEBUG
     // verbose dump
     void dumpv() const override {
@@ -2,6 +2,13 @@
 #define DG_POINTER_ANALYSIS_H_
 
 #include <cassert>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <set>
+#include <unordered_map>
+#include <unordered_set>
 #include <utility>
 #include <vector>
 
@@ -9,14 +16,37 @@
 #include "dg/PointerAnalysis/MemoryObject.h"
 #include "dg/PointerAnalysis/Pointer.h"
 #include "dg/PointerAnalysis/PointerAnalysisOptions.h"
+#include "dg/PointerAnalysis/PointerAnalysisStatistics.h"
 #include "dg/PointerAnalysis/PointerGraph.h"
+#include "dg/PointerAnalysis/PointsToSetTrace.h"
 
 namespace dg {
 namespace pta {
 
+class PointerAnalysisSteensgaard;
+
 class PointerAnalysis {
     static void initPointerAnalysis() {}
 
+  public:
+    ///
+    // The abstractions used by the analysis. The analysis starts with
+    // the full precision and switches to the coarser abstractions
+    // when it exceeds its budget (see PointerAnalysisOptions).
+    // Every abstraction is sound and includes the previous ones.
+    enum class Precision {
+        FULL,
+        // all GEPs have unknown offset
+        FIELD_INSENSITIVE,
+        // all pointers to memory have unknown offset
+        // (and memory objects store pointers only at unknown offset)
+        COLLAPSED_OBJECTS,
+        // the analysis has been stopped, all nodes that yield pointers
+        // point also to unknown memory. Calls via pointers that have
+        // not been resolved before remain unresolved.
+        UNKNOWN_MEMORY
+    };
+
   protected:
     // a set of changed nodes that are going to be
     // processed by the analysis
@@ -28,10 +58,114 @@ class PointerAnalysis {
 
     const PointerAnalysisOptions options{};
 
+    // compute the points-to set of the node (or the effect of the node
+    // on memory) from its operands, return true if anything changed.
+    // 'Impl' is the analysis whose hooks are called (see solve())
+    template <typename Impl = PointerAnalysis>
+    bool processNode(PSNode *node);
+
+    // Run the analysis. The hooks that are called for every processed
+    // node (beforeProcessed(), afterProcessed(), getMemoryObjects(),
+    // enqueue() and errorEmptyPointsTo()) are called on the analysis
+    // 'Impl'. They are final in the specialized solvers
+    // (see PointerAnalysisSolver), so the calls are not virtual
+    // and can be inlined. With Impl = PointerAnalysis, they are called
+    // virtually. The solver is instantiated in PointerAnalysis.cpp.
+    template <typename Impl>
+    bool solve();
+
+    // gather the statistics that describe the results
+    void finishStatistics();
+
+  private:
+    // created only with the 'statistics' option
+    std::unique_ptr<PointerAnalysisStatistics> stats;
+
+    // Difference propagation: for every node (indexed by its ID)
+    // and every its operand, remember how many pointers from
+    // the history of the operand's points-to set the node
+    // has already processed
+    struct ConsumedPointers {
+        PSNode *operand{nullptr};
+        size_t pos{0};
+    };
+    std::vector<std::vector<ConsumedPointers>> consumed;
+
+    // SCC-ordered worklist: the nodes are ordered by their position
+    // in the topological order of SCCs of the control flow
+    using WorklistItemT = std::pair<uint64_t, PSNode *>;
+    ADT::PrioritySet<WorklistItemT, std::less<WorklistItemT>> worklist;
+    // the position of nodes (indexed by ID) in the order,
+    // 0 means that the node is not reachable from the entry.
+    // The positions of ordered nodes are multiples of WORKLIST_POS_GAP,
+    // the nodes that become reachable during the analysis (e.g.,
+    // a function called via a pointer) are put into the gaps.
+    std::vector<uint64_t> worklistPos;
+    static constexpr uint64_t WORKLIST_POS_GAP = uint64_t(1) << 20;
+    // the last used position in the gaps (indexed by the gap)
+    std::unordered_map<uint64_t, uint64_t> worklistGapEnd;
+    // every change of memory gets a new epoch number.
+    // A node propagates the change to its successors
+    // if it has not propagated the epoch yet
+    std::vector<unsigned> pendingEpoch;
+    std::vector<unsigned> propagatedEpoch;
+    unsigned memoryEpoch{0};
+    // the nodes that read the memory of allocations. The memory may be read
+    // from anywhere in flow-insensitive analysis, so the changes of memory
+    // are not propagated only along the control flow, but also to readers.
+    // The readers are kept for the allocations and not for the memory
+    // objects, since the flow-sensitive analysis replaces the objects.
+    std::unordered_map<PSNode *, std::unordered_set<PSNode *>>
+            memoryReaders;
+    // the solver runs the SCC-ordered worklist
+    bool worklistRunning{false};
+    // the readers of memory objects are tracked and queued
+    // when the objects change
+    bool queueMemoryReaders{false};
+
+    // Cycles of copy nodes (PHI, CAST, GEP with zero offset)
+    // collapsed into a representative node (indexed by ID).
+    // Only the representative is processed, the other nodes
+    // of the cycle get a copy of its points-to set.
+    std::vector<PSNode *> cycleRep;
+    std::vector<std::vector<PSNode *>> cycleMembers;
+    // the edges (operand, user) already checked for cycles
+    std::set<std::pair<unsigned, unsigned>> checkedCopyEdges;
+
+    // the nodes (indexed by ID) that cannot get any pointers
+    // according to the unification-based pre-pass
+    std::vector<bool> inert;
+
+    // Parallel solver: the pointers computed by a node in a thread.
+    // They are added to the node once all threads are done, so that
+    // the threads only read the points-to sets and memory objects.
+    struct CollectedPointers {
+        PSNode *node{nullptr};
+        std::vector<Pointer> pointers;
+
+        bool addPointsTo(const Pointer &ptr) {
+            if (node->pointsTo.has(ptr))
+                return false;
+            pointers.push_back(ptr);
+            return true;
+        }
+        bool addPointsTo(PSNode *target, Offset off) {
+            return addPointsTo(Pointer(target, off));
+        }
+        bool addPointsTo(const PointsToSetT &ptrs) {
+            bool changed = false;
+            for (const auto &ptr : ptrs)
+                changed |= addPointsTo(ptr);
+            return changed;
+        }
+    };
+
   public:
     PointerAnalysis(PointerGraph *ps, PointerAnalysisOptions opts)
             : PG(ps), options(std::move(opts)) {
         initPointerAnalysis();
+        if (options.statistics)
+            stats.reset(new PointerAnalysisStatistics());
     }
 
     // default options
@@ -64,6 +198,25 @@ class PointerAnalysis {
     PointerGraph *getPG() { return PG; }
     const PointerGraph *getPG() const { return PG; }
 
+    // the statistics of the solver or nullptr
+    // if the 'statistics' option is not set
+    const PointerAnalysisStatistics *getStatistics() const {
+        return stats.get();
+    }
+
+    // add the number of memory objects and their offsets
+    // and the memory of their points-to sets to the statistics
+    virtual void
+    collectMemoryStatistics(PointerAnalysisStatistics & /*unused*/) const {}
+
+    // the precision of the results (lower than FULL
+    // if the analysis has exceeded its budget)
+    Precision getPrecision() const { return precision; }
+
+    // move the pointers stored at all offsets of memory objects
+    // to the unknown offset (Precision::COLLAPSED_OBJECTS)
+    virtual void collapseMemoryObjects() {}
+
     virtual void enqueue(PSNode *n) { changed.push_back(n); }
 
     virtual void preprocess() {}
@@ -84,21 +237,8 @@ class PointerAnalysis {
         }
     }
 
-    bool iteration() {
-        assert(changed.empty());
-
-        for (PSNode *cur : to_process) {
-            bool enq = false;
-            enq |= beforeProcessed(cur);
-            enq |= processNode(cur);
-            enq |= afterProcessed(cur);
-
-            if (enq)
-                enqueue(cur);
-        }
-
-        return !changed.empty();
-    }
+    template <typename Impl = PointerAnalysis>
+    bool iteration();
 
     void queue_changed() {
         unsigned last_processed_num = to_process.size();
@@ -118,7 +258,12 @@ class PointerAnalysis {
         }
     }
 
-    bool run();
+    // run the generic solver, the analyses of dg run
+    // the specialized solver (see PointerAnalysisSolver).
+    // Return false if the analysis has been stopped before reaching
+    // the fixpoint (Precision::UNKNOWN_MEMORY, the results are sound,
+    // but the calls via pointers may not be resolved)
+    virtual bool run();
 
     // generic error
     // @msg - message for the user
@@ -158,17 +303,175 @@ class PointerAnalysis {
     // we do not need to pass this to the LLVM part...
     virtual bool handleJoin(PSNode * /*unused*/) { return false; }
 
+    // Can the analysis use the parallel solver? That is, it does not need
+    // the before/afterProcessed hooks for the nodes that do not write
+    // to memory and getMemoryObjects() can be called from multiple threads
+    virtual bool supportsParallelSolver() const { return false; }
+
+    // How the SCC-ordered worklist propagates the changes of memory:
+    // along the control flow (the state of memory differs at different
+    // nodes), to the readers of the changed memory objects (the memory
+    // is the same everywhere) or to the nodes given by getMemoryUsers()
+    // (the analysis knows the def-use edges of memory). The analyses
+    // with DEF_USE are always solved by the worklist.
+    enum class MemoryPropagation { CONTROL_FLOW, READERS, DEF_USE };
+    virtual MemoryPropagation memoryPropagation() const {
+        return MemoryPropagation::CONTROL_FLOW;
+    }
+
+    // the nodes that must be processed again when the memory
+    // changes at the node (used with MemoryPropagation::DEF_USE)
+    virtual const std::vector<PSNode *> &getMemoryUsers(PSNode * /*where*/) {
+        static const std::vector<PSNode *> none;
+        return none;
+    }
+
   private:
+    Precision precision{Precision::FULL};
+    std::chrono::steady_clock::time_point startTime;
+    // the nodes processed since the memory was measured. Measuring
+    // the memory scans the whole graph, so it is done only after
+    // the analysis has processed as many nodes as the graph has
+    size_t processedSinceMemoryCheck{0};
+
+    bool hasBudget() const {
+        return options.timeBudget > 0 || options.memoryBudget > 0;
+    }
+    // the precision that the spent time and memory allow
+    Precision getBudgetPrecision();
+    // switch to the coarser precision, return true if the analysis
+    // should continue (and all nodes must be processed again)
+    bool degradePrecision(Precision to);
+    void dropFieldSensitivity();
+    void collapseOffsets();
+    void addUnknownMemory();
+
     // check the sanity of results of pointer analysis
     void sanityCheck();
 
-    bool processNode(PSNode * /*node*/);
-    bool processLoad(PSNode *node);
-    bool processGep(PSNode *node);
+    template <typename Impl>
+    bool processNodeImpl(PSNode *node);
+    template <typename Impl>
+    bool processNodeWithStatistics(PSNode *node);
+    // the bytes taken by the points-to sets of the nodes
+    size_t getPointsToMemory() const;
+    // called at the beginning of every iteration
+    void iterationStatistics(size_t queued);
+
+    // the analysis whose hooks the solver calls (see solve())
+    template <typename Impl>
+    Impl *analysis() { return static_cast<Impl *>(this); }
+
+    template <typename Impl>
+    bool processStore(PSNode *node);
+    // process the node, but add the pointers to 'dest'
+    // (which differs from node in collapsed cycles
+    //  and in the parallel solver)
+    template <typename Impl, typename DestT>
+    bool processLoad(PSNode *node, DestT *dest);
+    template <typename DestT>
+    bool processGep(PSNode *node, DestT *dest);
+    template <typename DestT>
+    bool processCopy(PSNode *node, DestT *dest);
+    template <typename Impl>
     bool processMemcpy(PSNode *node);
     bool processMemcpy(std::vector<MemoryObject *> &srcObjects,
                        std::vector<MemoryObject *> &destObjects,
                        const Pointer &sptr, const Pointer &dptr, Offset len);
+
+    // call 'F' on the pointers of the idx-th operand of 'node'
+    // that the node has not processed yet (with difference propagation)
+    // or on all pointers of the operand (without difference propagation)
+    template <typename FunT>
+    void forEachNewPointer(PSNode *node, size_t idx, FunT F);
+    ConsumedPointers &getConsumed(PSNode *node, size_t idx);
+    void dropPointsToHistory();
+
+    void addMemoryReader(PSNode *node,
+                         const std::vector<MemoryObject *> &objects);
+    void memoryChanged(MemoryObject *o);
+
+    PSNode *getCycleRep(PSNode *node) const {
+        return node->getID() < cycleRep.size() ? cycleRep[node->getID()]
+                                               : nullptr;
+    }
+    bool inCycleOf(PSNode *op, PSNode *rep) const {
+        return getCycleRep(op) == rep;
+    }
+    // cycles are not collapsed with the parallel solver
+    static bool inCycleOf(PSNode * /*op*/, CollectedPointers * /*dest*/) {
+        return false;
+    }
+    bool detectCycles(PSNode *node);
+    // collapse the cycles of copy nodes found in the classes
+    // of the unification-based analysis
+    void seedCycles(PointerAnalysisSteensgaard &unification);
+    void collapseCycle(const std::vector<PSNode *> &cycle);
+    bool processCycle(PSNode *rep);
+    void syncCycle(PSNode *rep);
+    void queueUsers(PSNode *node);
+
+    void unificationPrepass();
+    bool isInert(const PSNode *node) const {
+        return node->getID() < inert.size() && inert[node->getID()];
+    }
+
+    void computeWorklistOrder();
+    // order the nodes that are not ordered yet and that are reachable
+    // from the (ordered) node, they get positions right after the node
+    void insertIntoWorklistOrder(PSNode *node);
+    void enqueueWorklist(PSNode *node);
+    // run the fixpoint computation using the SCC-ordered worklist,
+    // return the number of iterations
+    template <typename Impl>
+    size_t runWorklist();
+
+    // the recording of points-to sets is not thread-safe
+    // (and the trace would not be deterministic), so the sets
+    // are never processed in parallel while recording
+    bool useParallelSolver() const {
+        return options.solverThreads > 1 && !options.diffPropagation &&
+               !options.sccOrderedWorklist && !options.collapseCycles &&
+               supportsParallelSolver() && !PointsToSetTraceWriter::get();
+    }
+    static bool canProcessInParallel(PSNode *node);
+    template <typename Impl>
+    void processInParallel(CollectedPointers &C);
+    // the same as iteration(), but the nodes that only compute
+    // their points-to sets are processed in parallel
+    template <typename Impl>
+    bool parallelIteration();
+};
+
+///
+// The analysis 'Base' run by the solver specialized for it
+// (see PointerAnalysis::solve()). The hooks that the solver calls
+// for every node are final here, so that the solver calls them
+// directly. An analysis that needs to override these hooks
+// must derive from 'Base' (and is run by the generic solver).
+template <typename Base>
+class PointerAnalysisSolver : public Base {
+  public:
+    using Base::Base;
+
+    bool beforeProcessed(PSNode *n) final { return Base::beforeProcessed(n); }
+
+    bool afterProcessed(PSNode *n) final { return Base::afterProcessed(n); }
+
+    void getMemoryObjects(PSNode *where, const Pointer &pointer,
+                          std::vector<MemoryObject *> &objects) final {
+        Base::getMemoryObjects(where, pointer, objects);
+    }
+
+    void enqueue(PSNode *n) final { Base::enqueue(n); }
+
+    bool errorEmptyPointsTo(PSNode *from, PSNode *to) final {
+        return Base::errorEmptyPointsTo(from, to);
+    }
+
+    bool run() override {
+        return this->template solve<PointerAnalysisSolver>();
+    }
 };
 
 } // namespace pta
@@ -0,0 +1,398 @@
+#ifndef DG_ANALYSIS_POINTS_TO_DEMAND_DRIVEN_H_
+#define DG_ANALYSIS_POINTS_TO_DEMAND_DRIVEN_H_
+
+#include <cassert>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "dg/ADT/Queue.h"
+#include "PointerAnalysisFI.h"
+
+namespace dg {
+namespace pta {
+
+///
+// Demand-driven flow-insensitive pointer analysis.
+//
+// run() only resolves the calls via function pointers (the call graph
+// must be complete to know all nodes that may write to memory). The
+// points-to sets of other nodes are computed by query(), which processes
+// only the nodes that the queried node depends on: its operands
+// (transitively) and the nodes that may write to the memory that
+// these nodes read. The writers of a memory object are found by following
+// the flow of the address of the object. If the address is never
+// stored to memory, only the writers whose destination operand the
+// address flows to can write the object. Otherwise, the destinations
+// of all writers are computed and the writers are added once their
+// destination may point to the object.
+//
+// The processed nodes are kept up to date between queries, so later
+// queries re-use the work of the previous ones. The results are the
+// same as the results of the flow-insensitive analysis. If a query
+// processes more nodes than given by the 'demandBudget' option,
+// the analysis solves the whole graph and answers further queries
+// from its results.
+class PointerAnalysisDemand : public PointerAnalysisFI {
+    // the nodes (indexed by ID) whose points-to sets are maintained
+    std::vector<bool> inSlice;
+    // the nodes reachable from the entry or globals (indexed by ID),
+    // the exhaustive analysis processes only these nodes
+    std::vector<bool> relevant;
+    std::vector<bool> queued;
+    ADT::QueueFIFO<PSNode *> queue;
+
+    // memory objects (allocation nodes) whose writers are being tracked
+    std::unordered_set<PSNode *> expanded;
+    // the nodes in the slice that read the memory objects
+    std::unordered_map<PSNode *, std::unordered_set<PSNode *>> readers;
+    // STORE and MEMCPY nodes indexed by their destination operand
+    std::unordered_map<PSNode *, std::vector<PSNode *>> writers;
+    // the destination operands whose writers are added on demand
+    std::unordered_set<PSNode *> watched;
+    // the nodes that had some points-to set before the analysis
+    // (e.g., constants), indexed by the memory node of the pointers
+    std::unordered_map<PSNode *, std::vector<PSNode *>> initialPointsTo;
+    size_t indexedNodes{0};
+
+    size_t processed{0};
+    bool graphChanged{false};
+    bool exhaustive{false};
+    bool prepared{false};
+
+    static bool isMemoryPointer(const Pointer &ptr) {
+        return ptr.isValid() && !ptr.isInvalidated() && !ptr.isUnknown() &&
+               ptr.target->getType() != PSNodeType::FUNCTION;
+    }
+
+    bool isRelevant(PSNode *n) const {
+        return n->getID() < relevant.size() && relevant[n->getID()];
+    }
+
+    bool isInSlice(PSNode *n) const {
+        return n->getID() < inSlice.size() && inSlice[n->getID()];
+    }
+
+    void push(PSNode *n) {
+        if (queued[n->getID()])
+            return;
+        queued[n->getID()] = true;
+        queue.push(n);
+    }
+
+    // forget the slice, e.g., because the graph changed.
+    // The points-to sets and memory objects are kept, they are
+    // a subset of the fixpoint and the new slice continues from them.
+    void reset() {
+        const auto size = PG->getNodes().size();
+        inSlice.assign(size, false);
+        queued.assign(size, false);
+        queue = ADT::QueueFIFO<PSNode *>();
+        expanded.clear();
+        readers.clear();
+        writers.clear();
+        watched.clear();
+
+        relevant.assign(size, false);
+        for (PSNode *nd : PG->getNodes(PG->getEntry()->getRoot()))
+            relevant[nd->getID()] = true;
+        for (PSNode *nd : PG->getGlobals())
+            relevant[nd->getID()] = true;
+
+        const auto &nodes = PG->getNodes();
+        for (const auto &nd : nodes) {
+            if (!nd || !isRelevant(nd.get()))
+                continue;
+            if (nd->getType() == PSNodeType::STORE)
+                writers[nd->getOperand(1)].push_back(nd.get());
+            else if (nd->getType() == PSNodeType::MEMCPY)
+                writers[PSNodeMemcpy::get(nd.get())->getDestination()]
+                        .push_back(nd.get());
+        }
+
+        // the new nodes have not been processed yet,
+        // so they have only the points-to sets set by the builder
+        for (; indexedNodes < size; ++indexedNodes) {
+            PSNode *nd = nodes[indexedNodes].get();
+            if (!nd)
+                continue;
+            for (const auto &ptr : nd->pointsTo) {
+                if (isMemoryPointer(ptr))
+                    initialPointsTo[getMemoryNode(ptr.target)].push_back(nd);
+            }
+        }
+    }
+
+    // add the node and the nodes it depends on to the slice
+    void addToSlice(PSNode *n) {
+        std::vector<PSNode *> stack{n};
+        while (!stack.empty()) {
+            PSNode *cur = stack.back();
+            stack.pop_back();
+            if (!isRelevant(cur) || isInSlice(cur))
+                continue;
+
+            inSlice[cur->getID()] = true;
+            push(cur);
+            for (PSNode *op : cur->getOperands())
+                stack.push_back(op);
+        }
+    }
+
+    // Find the nodes that the address of the memory object may flow to
+    // without going through memory and gather the destination operands
+    // of writers among them. Return true if the address may be stored
+    // to memory, that is, it can flow anywhere.
+    bool flowsTo(PSNode *obj, std::vector<PSNode *> &dests) {
+        std::unordered_set<PSNode *> visited;
+        std::vector<PSNode *> stack{obj};
+        auto it = initialPointsTo.find(obj);
+        if (it != initialPointsTo.end())
+            stack.insert(stack.end(), it->second.begin(), it->second.end());
+
+        while (!stack.empty()) {
+            PSNode *cur = stack.back();
+            stack.pop_back();
+            if (!visited.insert(cur).second)
+                continue;
+
+            if (writers.count(cur) > 0)
+                dests.push_back(cur);
+
+            for (PSNode *user : cur->getUsers()) {
+                switch (user->getType()) {
+                case PSNodeType::STORE:
+                    if (user->getOperand(0) == cur)
+                        return true;
+                    break;
+                case PSNodeType::GEP:
+                case PSNodeType::CAST:
+                case PSNodeType::PHI:
+                case PSNodeType::CONSTANT:
+                case PSNodeType::RETURN:
+                case PSNodeType::CALL_RETURN:
+                case PSNodeType::CALL_FUNCPTR:
+                    stack.push_back(user);
+                    break;
+                default:
+                    // loads, memcpy and others do not copy the address
+                    break;
+                }
+            }
+        }
+
+        return false;
+    }
+
+    bool pointsToExpanded(PSNode *n) const {
+        for (const auto &ptr : n->pointsTo) {
+            if (isMemoryPointer(ptr) &&
+                expanded.count(getMemoryNode(ptr.target)) > 0)
+                return true;
+        }
+        return false;
+    }
+
+    void checkWriters(PSNode *dest) {
+        if (!pointsToExpanded(dest))
+            return;
+        for (PSNode *w : writers[dest])
+            addToSlice(w);
+    }
+
+    void watch(PSNode *dest) {
+        if (watched.insert(dest).second)
+            addToSlice(dest);
+        checkWriters(dest);
+    }
+
+    // track the writers of the memory object
+    void expand(PSNode *obj) {
+        if (!expanded.insert(obj).second)
+            return;
+
+        std::vector<PSNode *> dests;
+        if (flowsTo(obj, dests)) {
+            dests.clear();
+            for (auto &it : writers)
+                dests.push_back(it.first);
+        }
+
+        for (PSNode *dest : dests)
+            watch(dest);
+    }
+
+    void readsMemory(PSNode *reader, PSNode *src) {
+        for (const auto &ptr : src->pointsTo) {
+            if (!isMemoryPointer(ptr))
+                continue;
+            PSNode *obj = getMemoryNode(ptr.target);
+            readers[obj].insert(reader);
+            expand(obj);
+        }
+    }
+
+    void queueReaders(PSNode *dest) {
+        for (const auto &ptr : dest->pointsTo) {
+            if (!isMemoryPointer(ptr))
+                continue;
+            auto it = readers.find(getMemoryNode(ptr.target));
+            if (it == readers.end())
+                continue;
+            for (PSNode *reader : it->second)
+                push(reader);
+        }
+    }
+
+    // Compute the fixpoint on the slice. Return false if the budget
+    // was exceeded. Stops when the graph changes.
+    bool solve() {
+        const auto budget = options.demandBudget;
+        while (!queue.empty()) {
+            if (budget > 0 && processed >= budget)
+                return false;
+            ++processed;
+
+            PSNode *cur = queue.pop();
+            queued[cur->getID()] = false;
+
+            bool changed = processNode(cur);
+            if (graphChanged)
+                return true;
+
+            if (changed) {
+                for (PSNode *user : cur->getUsers()) {
+                    if (isInSlice(user))
+                        push(user);
+                }
+                if (watched.count(cur) > 0)
+                    checkWriters(cur);
+            }
+
+            switch (cur->getType()) {
+            case PSNodeType::LOAD:
+                readsMemory(cur, cur->getOperand(0));
+                break;
+            case PSNodeType::STORE:
+                if (changed)
+                    queueReaders(cur->getOperand(1));
+                break;
+            case PSNodeType::MEMCPY:
+                readsMemory(cur, PSNodeMemcpy::get(cur)->getSource());
+                if (changed)
+                    queueReaders(PSNodeMemcpy::get(cur)->getDestination());
+                break;
+            default:
+                break;
+            }
+        }
+        return true;
+    }
+
+    void runExhaustive() {
+        exhaustive = true;
+        queue = ADT::QueueFIFO<PSNode *>();
+        PointerAnalysisFI::run();
+    }
+
+    static bool hasThreads(PointerGraph *PG) {
+        for (const auto &nd : PG->getNodes()) {
+            if (nd && (nd->getType() == PSNodeType::FORK ||
+                       nd->getType() == PSNodeType::JOIN))
+                return true;
+        }
+        return false;
+    }
+
+    // process the calls via pointers until no new function is called
+    bool resolveCalls() {
+        do {
+            graphChanged = false;
+            reset();
+            // the nodes that are added to the graph
+            // are handled in the next round
+            const auto size = PG->getNodes().size();
+            for (size_t i = 0; i < size; ++i) {
+                PSNode *nd = PG->getNodes()[i].get();
+                if (nd && nd->getType() == PSNodeType::CALL_FUNCPTR)
+                    addToSlice(nd);
+            }
+            if (!solve())
+                return false;
+        } while (graphChanged);
+
+        return true;
+    }
+
+  public:
+    PointerAnalysisDemand(PointerGraph *ps) : PointerAnalysisDemand(ps, {}) {}
+
+    PointerAnalysisDemand(PointerGraph *ps, const PointerAnalysisOptions &opts)
+            : PointerAnalysisFI(ps, opts) {}
+
+    bool functionPointerCall(PSNode *where, PSNode *what) override {
+        graphChanged = true;
+        return PointerAnalysisFI::functionPointerCall(where, what);
+    }
+
+    ///
+    // Prepare the analysis for queries. The threads (fork and join)
+    // are not supported, the whole graph is solved in that case.
+    bool run() override {
+        if (exhaustive)
+            return PointerAnalysisFI::run();
+
+        PointerIDLookupTable::Scope pointerIDs(PG->getPointerIDs());
+        preprocess();
+
+        processed = 0;
+        if (hasThreads(PG) || !resolveCalls())
+            runExhaustive();
+
+        prepared = true;
+        if (getStatistics())
+            finishStatistics();
+        return true;
+    }
+
+    ///
+    // Compute the points-to set of the node. Return true if the set
+    // was computed on demand, false if the whole graph was solved
+    // (now or in an earlier query).
+    bool query(PSNode *n) {
+        if (!prepared)
+            run();
+        if (exhaustive)
+            return false;
+
+        PointerIDLookupTable::Scope pointerIDs(PG->getPointerIDs());
+        processed = 0;
+        addToSlice(n);
+        if (!solve()) {
+            runExhaustive();
+            return false;
+        }
+
+        assert(!graphChanged && "Resolved calls changed the graph");
+        if (getStatistics())
+            finishStatistics();
+        return true;
+    }
+
+    // the whole graph has been solved
+    bool isExhaustive() const { return exhaustive; }
+
+    // the number of nodes that the queries need (or needed before
+    // the whole graph was solved)
+    size_t getSliceSize() const {
+        size_t num = 0;
+        for (bool b : inSlice)
+            num += b;
+        return num;
+    }
+};
+
+} // namespace pta
+} // namespace dg
+
+#endif // DG_ANALYSIS_POINTS_TO_DEMAND_DRIVEN_H_
@@ -3,18 +3,26 @@
 
 #include <cassert>
 #include <memory>
+#include <mutex>
 #include <vector>
 
 #include "PointerAnalysis.h"
+#include "dg/ADT/Arena.h"
 
 namespace dg {
 namespace pta {
 
 ///
 // Flow-insensitive inclusion-based pointer analysis
+// (run by the generic solver, see PointerAnalysisFI)
 //
-class PointerAnalysisFI : public PointerAnalysis {
-    std::vector<std::unique_ptr<MemoryObject>> memory_objects;
+class PointerAnalysisFIBase : public PointerAnalysis {
+    // the memory objects are allocated in the arena,
+    // 'memory_objects' destroys them
+    ADT::Arena memory_arena;
+    std::vector<ADT::ArenaPtr<MemoryObject>> memory_objects;
+    // guards creating memory objects in the parallel solver
+    std::mutex memory_objects_mutex;
 
     void preprocessGEPs() {
         // if a node is in a loop (a scc that has more than one node),
@@ -35,9 +43,21 @@ class PointerAnalysisFI : public PointerAnalysis {
     }
 
   public:
-    PointerAnalysisFI(PointerGraph *ps) : PointerAnalysisFI(ps, {}) {}
+    // the node that holds the memory object for pointers to 'n'
+    // (we want to have memory in allocation sites)
+    static PSNode *getMemoryNode(PSNode *n) {
+        if (n->getType() == PSNodeType::CAST || n->getType() == PSNodeType::GEP)
+            return n->getOperand(0);
+        if (n->getType() == PSNodeType::CONSTANT) {
+            assert(n->pointsTo.size() == 1);
+            return (*n->pointsTo.begin()).target;
+        }
+        return n;
+    }
 
-    PointerAnalysisFI(PointerGraph *ps, const PointerAnalysisOptions &opts)
+    PointerAnalysisFIBase(PointerGraph *ps) : PointerAnalysisFIBase(ps, {}) {}
+
+    PointerAnalysisFIBase(PointerGraph *ps, const PointerAnalysisOptions &opts)
             : PointerAnalysis(ps, opts) {
         memory_objects.reserve(
                 std::max(ps->size() / 100, static_cast<size_t>(8)));
@@ -48,19 +68,16 @@ class PointerAnalysisFI : public PointerAnalysis {
             preprocessGEPs();
     }
 
+    bool supportsParallelSolver() const override { return true; }
+    MemoryPropagation memoryPropagation() const override {
+        return MemoryPropagation::READERS;
+    }
+
     void getMemoryObjects(PSNode *where, const Pointer &pointer,
                           std::vector<MemoryObject *> &objects) override {
         // irrelevant in flow-insensitive
         (void) where;
-        PSNode *n = pointer.target;
-
-        // we want to have memory in allocation sites
-        if (n->getType() == PSNodeType::CAST || n->getType() == PSNodeType::GEP)
-            n = n->getOperand(0);
-        else if (n->getType() == PSNodeType::CONSTANT) {
-            assert(n->pointsTo.size() == 1);
-            n = (*n->pointsTo.begin()).target;
-        }
+        PSNode *n = getMemoryNode(pointer.target);
 
         if (n->getType() == PSNodeType::FUNCTION)
             return;
@@ -68,15 +85,50 @@ class PointerAnalysisFI : public PointerAnalysis {
         assert(n->getType() == PSNodeType::ALLOC ||
                n->getType() == PSNodeType::UNKNOWN_MEM);
 
+        std::unique_lock<std::mutex> lock(memory_objects_mutex,
+                                          std::defer_lock);
+        if (options.solverThreads > 1)
+            lock.lock();
+
         MemoryObject *mo = n->getData<MemoryObject>();
         if (!mo) {
-            mo = new MemoryObject(n);
+            mo = memory_arena.create<MemoryObject>(n);
             memory_objects.emplace_back(mo);
             n->setData<MemoryObject>(mo);
         }
 
         objects.push_back(mo);
     }
+
+    void collapseMemoryObjects() override {
+        for (const auto &mo : memory_objects) {
+            if (mo->pointsTo.empty())
+                continue;
+
+            PointsToSetT pointers;
+            for (const auto &it : mo->pointsTo)
+                pointers.add(it.second);
+            mo->pointsTo.clear();
+            mo->pointsTo[Offset::UNKNOWN] = std::move(pointers);
+        }
+    }
+
+    void collectMemoryStatistics(PointerAnalysisStatistics &S) const override {
+        S.memoryObjects += memory_objects.size();
+        for (const auto &mo : memory_objects) {
+            S.memoryObjectsOffsets += mo->pointsTo.size();
+            for (const auto &it : mo->pointsTo)
+                S.pointsToMemory += it.second.getMemoryUsage();
+        }
+    }
+};
+
+///
+// Flow-insensitive inclusion-based pointer analysis
+//
+class PointerAnalysisFI : public PointerAnalysisSolver<PointerAnalysisFIBase> {
+  public:
+    using PointerAnalysisSolver::PointerAnalysisSolver;
 };
 
 } // namespace pta
@@ -3,24 +3,29 @@
 
 #include <cassert>
 #include <memory>
+#include <set>
 
 #include "MemoryObject.h"
+#include "PointerAnalysis.h"
 #include "PointerGraph.h"
+#include "dg/ADT/PersistentMap.h"
 
 namespace dg {
 namespace pta {
 
 ///
-// Flow-sensitive pointer analysis
+// Flow-sensitive pointer analysis (run by the generic solver,
+// the analyses that customize it derive from this class)
 //
-class PointerAnalysisFS : public PointerAnalysis {
+class PointerAnalysisFSBase : public PointerAnalysis {
   public:
     // using MemoryObjectsSetT = std::set<MemoryObject *>;
-    using MemoryMapT = std::map<PSNode *, std::unique_ptr<MemoryObject>>;
+    // the maps share the memory objects that they did not change
+    using MemoryMapT = ADT::PersistentMap<PSNode *, MemoryObject>;
 
     // this is an easy but not very efficient implementation,
     // works for testing
-    PointerAnalysisFS(PointerGraph *ps, PointerAnalysisOptions opts)
+    PointerAnalysisFSBase(PointerGraph *ps, PointerAnalysisOptions opts)
             : PointerAnalysis(ps, opts.setPreprocessGeps(false)) {
         assert(opts.preprocessGeps == false &&
                "Preprocessing GEPs does not work correctly for FS analysis");
@@ -28,7 +33,7 @@ class PointerAnalysisFS : public PointerAnalysis {
         ps->computeLoops();
     }
 
-    PointerAnalysisFS(PointerGraph *ps) : PointerAnalysisFS(ps, {}) {}
+    PointerAnalysisFSBase(PointerGraph *ps) : PointerAnalysisFSBase(ps, {}) {}
 
     bool beforeProcessed(PSNode *n) override {
         MemoryMapT *mm = n->getData<MemoryMapT>();
@@ -114,9 +119,9 @@ class PointerAnalysisFS : public PointerAnalysis {
         return changed;
     }
 
-    bool functionPointerCall(PSNode * /*unused*/,
-                             PSNode * /*unused*/) override {
-        PG->computeLoops();
+    bool functionPointerCall(PSNode *where, PSNode * /*unused*/) override {
+        // update only the loops of the caller and the new callees
+        PG->updateLoops(where);
         return false;
     }
 
@@ -125,19 +130,34 @@ class PointerAnalysisFS : public PointerAnalysis {
         MemoryMapT *mm = where->getData<MemoryMapT>();
         assert(mm && "Node does not have memory map");
 
-        auto I = mm->find(pointer.target);
-        if (I != mm->end()) {
-            objects.push_back(I->second.get());
+        // if this psnode is a write to memory, get an object that
+        // can be written to (create a new one if there is none,
+        // so that the write has something to write to)
+        if (canChangeMM(where)) {
+            objects.push_back(&mm->getWritable(pointer.target,
+                                               MemoryObject(pointer.target)));
+            return;
+        }
+
+        // other nodes only read the objects
+        if (const MemoryObject *mo = mm->find(pointer.target)) {
+            objects.push_back(const_cast<MemoryObject *>(mo));
         }
+    }
 
-        // if we haven't found any memory object, but this psnode
-        // is a write to memory, create a new one, so that
-        // the write has something to write to
-        if (objects.empty() && canChangeMM(where)) {
-            MemoryObject *mo = new MemoryObject(pointer.target);
-            mm->emplace(pointer.target, std::unique_ptr<MemoryObject>(mo));
-            objects.push_back(mo);
+    void collectMemoryStatistics(PointerAnalysisStatistics &S) const override {
+        // the maps share the objects, count every object once
+        std::set<const MemoryObject *> objects;
+        for (const auto &mm : memoryMaps) {
+            for (const auto &it : *mm) {
+                if (!objects.insert(&it.second).second)
+                    continue;
+                S.memoryObjectsOffsets += it.second.pointsTo.size();
+                for (const auto &oit : it.second.pointsTo)
+                    S.pointsToMemory += oit.second.getMemoryUsage();
+            }
         }
+        S.memoryObjects += objects.size();
     }
 
   protected:
@@ -165,7 +185,8 @@ class PointerAnalysisFS : public PointerAnalysis {
         return false;
     }
 
-    static bool mergeObjects(PSNode *node, MemoryObject *to, MemoryObject *from,
+    static bool mergeObjects(PSNode *node, MemoryObject *to,
+                             const MemoryObject *from,
                              PointsToSetT *overwritten) {
         bool changed = false;
 
@@ -181,22 +202,29 @@ class PointerAnalysisFS : public PointerAnalysis {
         return changed;
     }
 
+    // the policy for merging memory maps, the objects that
+    // are not overwritten can be shared between the maps
+    struct MergeMapsPolicy {
+        PointsToSetT *overwritten;
+
+        bool canShareAll() const { return !overwritten; }
+        bool canShare(PSNode *target, const MemoryObject & /*unused*/) const {
+            return !overwritten || !overwritten->pointsToTarget(target);
+        }
+        static MemoryObject create(PSNode *target) {
+            return MemoryObject(target);
+        }
+        bool merge(MemoryObject &to, const MemoryObject &from) const {
+            return mergeObjects(from.node, &to, &from, overwritten);
+        }
+    };
+
     // Merge two Memory maps, return true if any new information was created,
     // otherwise return false
     static bool mergeMaps(MemoryMapT *mm, MemoryMapT *from,
                           PointsToSetT *overwritten) {
-        bool changed = false;
-        for (auto &it : *from) {
-            PSNode *fromTarget = it.first;
-            std::unique_ptr<MemoryObject> &toMo = (*mm)[fromTarget];
-            if (toMo == nullptr)
-                toMo.reset(new MemoryObject(fromTarget));
-
-            changed |= mergeObjects(fromTarget, toMo.get(), it.second.get(),
-                                    overwritten);
-        }
-
-        return changed;
+        MergeMapsPolicy policy{overwritten};
+        return mm->merge(*from, policy);
     }
 
     MemoryMapT *createMM() {
@@ -206,8 +234,16 @@ class PointerAnalysisFS : public PointerAnalysis {
     }
 
     static bool isOnLoop(const PSNode *n) {
+        // the loops are computed lazily, so we need the non-const subgraph
+        PointerSubgraph *subg = const_cast<PSNode *>(n)->getParent();
+        if (!subg)
+            return false;
+        // the subgraphs created during the analysis
+        // (e.g., functions called via pointers)
+        if (!subg->computedLoops())
+            subg->computeLoops();
         // if the scc's size > 1, the node is in loop
-        return n->getParent() ? (n->getParent()->getLoop(n) != nullptr) : false;
+        return subg->getLoop(n) != nullptr;
     }
 
     static bool pointsToAllocationInLoop(PSNode *n) {
@@ -243,6 +279,14 @@ class PointerAnalysisFS : public PointerAnalysis {
     std::vector<std::unique_ptr<MemoryMapT>> memoryMaps;
 };
 
+///
+// Flow-sensitive pointer analysis
+//
+class PointerAnalysisFS : public PointerAnalysisSolver<PointerAnalysisFSBase> {
+  public:
+    using PointerAnalysisSolver::PointerAnalysisSolver;
+};
+
 } // namespace pta
 } // namespace dg
 
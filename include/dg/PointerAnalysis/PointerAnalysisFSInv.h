@@ -3,11 +3,16 @@
 
 #include "PointerAnalysisFS.h"
 #include <cassert>
+#include <vector>
 
 namespace dg {
 namespace pta {
 
-class PointerAnalysisFSInv : public PointerAnalysisFS {
+///
+// Flow-sensitive pointer analysis that tracks invalidated memory
+// (run by the generic solver, see PointerAnalysisFSInv)
+//
+class PointerAnalysisFSInvBase : public PointerAnalysisFSBase {
     static bool canInvalidateMM(PSNode *n) {
         return isa<PSNodeType::FREE>(n) ||
                isa<PSNodeType::INVALIDATE_OBJECT>(n) ||
@@ -15,28 +20,26 @@ class PointerAnalysisFSInv : public PointerAnalysisFS {
     }
 
     static bool needsMerge(PSNode *n) {
-        return canInvalidateMM(n) || PointerAnalysisFS::needsMerge(n);
+        return canInvalidateMM(n) || PointerAnalysisFSBase::needsMerge(n);
     }
 
     static MemoryObject *getOrCreateMO(MemoryMapT *mm, PSNode *target) {
-        std::unique_ptr<MemoryObject> &moptr = (*mm)[target];
-        if (!moptr)
-            moptr.reset(new MemoryObject(target));
-
-        assert(mm->find(target) != mm->end());
-        return moptr.get();
+        MemoryObject *mo = &mm->getWritable(target, MemoryObject(target));
+        assert(mm->find(target) == mo);
+        return mo;
     }
 
   public:
-    using MemoryMapT = PointerAnalysisFS::MemoryMapT;
+    using MemoryMapT = PointerAnalysisFSBase::MemoryMapT;
 
     // this is an easy but not very efficient implementation,
     // works for testing
-    PointerAnalysisFSInv(PointerGraph *ps, PointerAnalysisOptions opts)
-            : PointerAnalysisFS(ps, opts.setInvalidateNodes(true)) {}
+    PointerAnalysisFSInvBase(PointerGraph *ps, PointerAnalysisOptions opts)
+            : PointerAnalysisFSBase(ps, opts.setInvalidateNodes(true)) {}
 
     // default options
-    PointerAnalysisFSInv(PointerGraph *ps) : PointerAnalysisFSInv(ps, {}) {}
+    PointerAnalysisFSInvBase(PointerGraph *ps)
+            : PointerAnalysisFSInvBase(ps, {}) {}
 
     // NOTE: we must override this method as it is using our "needsMerge"
     bool beforeProcessed(PSNode *n) override {
@@ -84,7 +87,7 @@ class PointerAnalysisFSInv : public PointerAnalysisFS {
                n->getType() != PSNodeType::INVALIDATE_OBJECT &&
                n->getType() != PSNodeType::INVALIDATE_LOCALS);
 
-        bool ret = PointerAnalysisFS::afterProcessed(n);
+        bool ret = PointerAnalysisFSBase::afterProcessed(n);
 
         // check that all pointers in this memory map
         // are initialized in all predecessors and
@@ -172,7 +175,7 @@ class PointerAnalysisFSInv : public PointerAnalysisFS {
             // get or create a memory object for this target
 
             MemoryObject *mo = getOrCreateMO(mm, I.first);
-            MemoryObject *pmo = I.second.get();
+            const MemoryObject *pmo = &I.second;
 
             for (auto &it : *mo) {
                 // remove pointers to locals from the points-to set
@@ -184,7 +187,7 @@ class PointerAnalysisFSInv : public PointerAnalysisFS {
             }
 
             for (auto &it : *pmo) {
-                PointsToSetT &predS = it.second;
+                const PointsToSetT &predS = it.second;
                 if (predS.empty())
                     continue;
 
@@ -342,7 +345,7 @@ class PointerAnalysisFSInv : public PointerAnalysisFS {
 
             // get or create a memory object for this target
             MemoryObject *mo = getOrCreateMO(mm, I.first);
-            MemoryObject *pmo = I.second.get();
+            const MemoryObject *pmo = &I.second;
 
             // Remove references to invalidated memory from mo
             // if the invalidated object is just one.
@@ -379,7 +382,7 @@ class PointerAnalysisFSInv : public PointerAnalysisFS {
             // merge pointers from pmo to mo, but skip
             // the pointers that may point to the freed memory
             for (auto &it : *pmo) {
-                PointsToSetT &predS = it.second;
+                const PointsToSetT &predS = it.second;
                 if (predS.empty()) // keep the map clean
                     continue;
 
@@ -416,20 +419,17 @@ class PointerAnalysisFSInv : public PointerAnalysisFS {
 
     bool handleUninitialized(MemoryMapT *mm, MemoryMapT *pm) {
         bool changed = false;
-        for (auto &it : *mm) {
-            auto pmit = pm->find(it.first);
-            if (pmit == pm->end()) {
-                for (auto &mit : *it.second) {
-                    if (mit.first.isUnknown())
-                        continue; // FIXME: we are optimistic here...
-                    changed |= it.second->addPointsTo(mit.first,
-                                                      Pointer{INVALIDATED, 0});
-                }
+        // the objects are modified only after the iteration over the map,
+        // since getting a writable object may change the map
+        std::vector<PSNode *> uninitialized;
+        for (const auto &it : *mm) {
+            if (!pm->find(it.first)) {
+                uninitialized.push_back(it.first);
                 continue;
             }
 
             /* check the initialization of memory objects
-            auto *pmo = pmit->second.get();
+            auto *pmo = pm->find(it.first);
             for (auto &mit : *it.second) {
                 if (pmo->find(mit.first) != pmo->end())
                     continue;
@@ -442,10 +442,25 @@ class PointerAnalysisFSInv : public PointerAnalysisFS {
             */
         }
 
+        for (PSNode *target : uninitialized) {
+            MemoryObject *mo = getOrCreateMO(mm, target);
+            for (auto &mit : *mo) {
+                if (mit.first.isUnknown())
+                    continue; // FIXME: we are optimistic here...
+                changed |= mit.second.add(Pointer{INVALIDATED, 0});
+            }
+        }
+
         return changed;
     }
 };
 
+class PointerAnalysisFSInv
+        : public PointerAnalysisSolver<PointerAnalysisFSInvBase> {
+  public:
+    using PointerAnalysisSolver::PointerAnalysisSolver;
+};
+
 } // namespace pta
 } // namespace dg
 
@@ -1,6 +1,8 @@
 #ifndef DG_POINTER_ANALYSIS_OPTIONS_H_
 #define DG_POINTER_ANALYSIS_OPTIONS_H_
 
+#include <cstdint>
+
 #include "dg/AnalysisOptions.h"
 
 namespace dg {
@@ -18,6 +20,62 @@ struct PointerAnalysisOptions : AnalysisOptions {
     // INVALIDATED object.
     bool invalidateNodes{false};
 
+    // Use difference propagation: nodes that copy or transform
+    // the pointers of their operands (PHI, CAST, GEP, STORE, ...)
+    // process only the pointers that were added to the operands
+    // since the node was processed the last time.
+    // The results are the same as without this option.
+    bool diffPropagation{false};
+
+    // Instead of re-processing all nodes reachable from the changed
+    // nodes in every iteration, use a worklist ordered by the topological
+    // order of strongly connected components of the (interprocedural)
+    // control flow. A node is queued only when its operands changed
+    // or when a change of memory can flow to it.
+    bool sccOrderedWorklist{false};
+
+    // Detect cycles of copy nodes (PHI, CAST, GEP with zero offset)
+    // during the analysis and collapse them into a single node.
+    // All nodes on such cycle have the same points-to set
+    // in the fixpoint, but it takes many iterations to get there.
+    bool collapseCycles{false};
+
+    // The number of threads used to solve the analysis. With more than
+    // one thread, the nodes that only compute their points-to sets
+    // (loads, GEPs, casts, PHIs, ...) are processed in parallel in every
+    // iteration and their results are merged afterwards. The results
+    // are the same as with one thread. Used only by the flow-insensitive
+    // analysis and only if none of the options above is set.
+    unsigned solverThreads{1};
+
+    // Run the unification-based (Steensgaard's) analysis before
+    // solving. Its classes over-approximate the results, so the nodes
+    // that cannot point anywhere according to the classes are not
+    // processed at all (only if the graph has no calls via pointers,
+    // these are not resolved by the pre-pass), and with 'collapseCycles'
+    // the cycles of copy nodes inside the classes are collapsed before
+    // the first iteration. The results are the same as without this option.
+    bool unificationPrepass{false};
+
+    // The maximal number of nodes that the demand-driven analysis
+    // may process to answer a single query. If exceeded, the analysis
+    // solves the whole graph instead. 0 means no limit.
+    size_t demandBudget{100000};
+
+    // Gather statistics of the solver (see PointerAnalysisStatistics).
+    // Without this option, the solver only checks that it is not set.
+    bool statistics{false};
+
+    // The budget of the analysis: the wall-clock time in milliseconds
+    // and the memory taken by the points-to sets in bytes (0 means
+    // no limit). When the budget is exceeded, the analysis does not stop,
+    // but continues with coarser and cheaper abstractions that keep
+    // the results sound (see PointerAnalysis::Precision). If the analysis
+    // must stop, the calls via pointers that were not resolved yet
+    // remain unresolved and PointerAnalysis::run() returns false.
+    uint64_t timeBudget{0};
+    size_t memoryBudget{0};
+
     PointerAnalysisOptions &setInvalidateNodes(bool b) {
         invalidateNodes = b;
         return *this;
@@ -26,10 +84,50 @@ struct PointerAnalysisOptions : AnalysisOptions {
         preprocessGeps = b;
         return *this;
     }
+    PointerAnalysisOptions &setDiffPropagation(bool b) {
+        diffPropagation = b;
+        return *this;
+    }
+    PointerAnalysisOptions &setSCCOrderedWorklist(bool b) {
+        sccOrderedWorklist = b;
+        return *this;
+    }
+    PointerAnalysisOptions &setCollapseCycles(bool b) {
+        collapseCycles = b;
+        return *this;
+    }
+    PointerAnalysisOptions &setSolverThreads(unsigned n) {
+        solverThreads = n;
+        return *this;
+    }
+    PointerAnalysisOptions &setUnificationPrepass(bool b) {
+        unificationPrepass = b;
+        return *this;
+    }
+    PointerAnalysisOptions &setDemandBudget(size_t n) {
+        demandBudget = n;
+        return *this;
+    }
+
+    PointerAnalysisOptions &setStatistics(bool b) {
+        statistics = b;
+        return *this;
+    }
+
+    PointerAnalysisOptions &setTimeBudget(uint64_t ms) {
+        timeBudget = ms;
+        return *this;
+    }
+
+    PointerAnalysisOptions &setMemoryBudget(size_t bytes) {
+        memoryBudget = bytes;
+        return *this;
+    }
 
     // Perform maximally this number of iterations.
-    // If exceeded, the analysis is terminated and points-to sets
-    // of the unprocessed nodes are set to {}.
+    // If exceeded, the analysis is terminated and the nodes
+    // that yield pointers are set to point also to unknown memory
+    // (see PointerAnalysis::Precision::UNKNOWN_MEMORY).
     size_t maxIterations{0};
 };
 
@@ -0,0 +1,340 @@
+#ifndef DG_ANALYSIS_POINTS_TO_SPARSE_FLOW_SENSITIVE_H_
+#define DG_ANALYSIS_POINTS_TO_SPARSE_FLOW_SENSITIVE_H_
+
+#include <algorithm>
+#include <cassert>
+#include <memory>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "PointerAnalysisFS.h"
+
+namespace dg {
+namespace pta {
+
+///
+// Flow-sensitive pointer analysis staged on the results
+// of flow-insensitive analysis.
+//
+// The analysis first runs flow-insensitive analysis. From its results,
+// it finds out which memory objects may be read (by loads and memcpy)
+// and which nodes may write these objects (the definitions). Then it
+// runs the flow-sensitive analysis, but the memory maps are tracked
+// only for the read objects, only the definitions of these objects
+// get their own memory map, and join nodes get their own memory map
+// only if different maps flow into them. Other nodes share
+// the map of the definition (or join) that reaches them
+// (the same way as the nodes with a single predecessor in FS analysis).
+// The flow-sensitive stage is solved by the SCC-ordered worklist that
+// follows the def-use edges of the memory maps: a change of a map
+// queues only the loads that read the map and the definitions and joins
+// into which the map flows, not all the nodes in the control flow.
+class PointerAnalysisSFS : public PointerAnalysisFSBase {
+    enum class Stage { FI, FS } stage{Stage::FI};
+
+    // memory objects of the flow-insensitive stage
+    std::unordered_map<PSNode *, std::unique_ptr<MemoryObject>> fiObjects;
+    // the objects that may be read by some node
+    std::unordered_set<PSNode *> readObjects;
+    // writes to objects that are never read are not tracked in memory maps
+    std::unordered_map<PSNode *, std::unique_ptr<MemoryObject>> unreadObjects;
+
+    // the node whose memory map a node uses (indexed by ID),
+    // nullptr if not computed (e.g., the node is new)
+    std::vector<PSNode *> mapOwner;
+
+    // the nodes that use the memory map of a node (indexed by the ID
+    // of the node that owns the map): the nodes that read the map
+    // and the owners of the maps into which the map is merged
+    std::vector<std::vector<PSNode *>> memoryUsers;
+
+    // the points-to sets of the nodes before running the analysis,
+    // the flow-sensitive stage starts from these
+    std::vector<PointsToSetT> initialPointsTo;
+
+    static bool keepsPointsTo(PSNode *n) {
+        switch (n->getType()) {
+        case PSNodeType::ALLOC:
+        case PSNodeType::FUNCTION:
+        case PSNodeType::CONSTANT:
+        // the called functions have been already
+        // added to the graph in the first stage
+        case PSNodeType::CALL_FUNCPTR:
+        case PSNodeType::FORK:
+            return true;
+        default:
+            return false;
+        }
+    }
+
+    bool writesReadMemory(PSNode *n) const {
+        PSNode *dest = nullptr;
+        if (n->getType() == PSNodeType::STORE)
+            dest = n->getOperand(1);
+        else if (n->getType() == PSNodeType::MEMCPY)
+            dest = PSNodeMemcpy::get(n)->getDestination();
+        else
+            return true;
+
+        for (const auto &ptr : dest->pointsTo) {
+            if (readObjects.count(ptr.target) > 0)
+                return true;
+        }
+        return false;
+    }
+
+    // the nodes that always need their own memory map
+    bool ownsMap(PSNode *n) const {
+        return n->predecessorsNum() == 0 ||
+               n->getType() == PSNodeType::CALL_RETURN ||
+               (canChangeMM(n) && writesReadMemory(n));
+    }
+
+    void findReadObjects() {
+        for (const auto &nd : PG->getNodes()) {
+            if (!nd)
+                continue;
+
+            PSNode *src = nullptr;
+            if (nd->getType() == PSNodeType::LOAD)
+                src = nd->getOperand(0);
+            else if (nd->getType() == PSNodeType::MEMCPY)
+                src = PSNodeMemcpy::get(nd.get())->getSource();
+            else
+                continue;
+
+            for (const auto &ptr : src->pointsTo)
+                readObjects.insert(ptr.target);
+        }
+    }
+
+    // Find the node whose memory map every node uses. A node that does
+    // not own a map uses the map of its predecessors if they all use
+    // the same map, otherwise it is a join of different maps and
+    // needs its own map. Unprocessed predecessors are ignored,
+    // so this is an optimistic fixpoint computation.
+    void computeMapOwners() {
+        const auto &nodes = PG->getNodes();
+        mapOwner.assign(nodes.size(), nullptr);
+
+        ADT::QueueFIFO<PSNode *> queue;
+        for (const auto &nd : nodes) {
+            if (nd && ownsMap(nd.get())) {
+                mapOwner[nd->getID()] = nd.get();
+                queue.push(nd.get());
+            }
+        }
+
+        while (!queue.empty()) {
+            PSNode *cur = queue.pop();
+            for (PSNode *succ : cur->successors()) {
+                auto &owner = mapOwner[succ->getID()];
+                if (owner == succ)
+                    continue;
+
+                PSNode *newOwner = nullptr;
+                for (PSNode *pred : succ->predecessors()) {
+                    PSNode *predOwner = mapOwner[pred->getID()];
+                    if (!predOwner)
+                        continue;
+                    if (newOwner && newOwner != predOwner) {
+                        newOwner = succ;
+                        break;
+                    }
+                    newOwner = predOwner;
+                }
+
+                if (newOwner != owner) {
+                    owner = newOwner;
+                    queue.push(succ);
+                }
+            }
+        }
+    }
+
+    static bool readsMemory(PSNode *n) {
+        return n->getType() == PSNodeType::LOAD ||
+               n->getType() == PSNodeType::MEMCPY;
+    }
+
+    // call F on the nodes that merge the memory map of the node
+    template <typename FunT>
+    static void forEachMapSuccessor(PSNode *n, FunT &&F) {
+        for (PSNode *succ : n->successors())
+            F(succ);
+        if (auto *C = PSNodeCall::get(n)) {
+            for (auto *subg : C->getCallees())
+                F(subg->root);
+        } else if (auto *R = PSNodeRet::get(n)) {
+            for (PSNode *ret : R->getReturnSites())
+                F(ret);
+        }
+    }
+
+    void computeMemoryUsers() {
+        const auto &nodes = PG->getNodes();
+        memoryUsers.assign(nodes.size(), {});
+        for (const auto &nd : nodes) {
+            if (!nd)
+                continue;
+
+            PSNode *owner = getMapOwner(nd.get());
+            auto &users = memoryUsers[owner->getID()];
+            // the owner sees the changes of its map, it is processed
+            // again when its map changes after processing it
+            if (owner != nd.get() && readsMemory(nd.get()))
+                users.push_back(nd.get());
+            forEachMapSuccessor(nd.get(), [this, &users](PSNode *succ) {
+                if (getMapOwner(succ) == succ)
+                    users.push_back(succ);
+            });
+        }
+
+        for (auto &users : memoryUsers) {
+            std::sort(users.begin(), users.end());
+            users.erase(std::unique(users.begin(), users.end()),
+                        users.end());
+        }
+    }
+
+    PSNode *getMapOwner(PSNode *n) const {
+        while (true) {
+            auto id = n->getID();
+            if (id < mapOwner.size() && mapOwner[id])
+                return mapOwner[id];
+
+            // the node was not reached or was created during the analysis,
+            // fall back to what the flow-sensitive analysis does
+            if (needsMerge(n))
+                return n;
+            n = n->getSinglePredecessor();
+        }
+    }
+
+    void resetPointsTo() {
+        for (const auto &nd : PG->getNodes()) {
+            if (!nd || keepsPointsTo(nd.get()))
+                continue;
+
+            auto id = nd->getID();
+            if (id < initialPointsTo.size())
+                nd->pointsTo = initialPointsTo[id];
+            else
+                nd->pointsTo.clear();
+        }
+        decltype(initialPointsTo)().swap(initialPointsTo);
+    }
+
+    MemoryMapT *getOrCreateMM(PSNode *n) {
+        if (MemoryMapT *mm = n->getData<MemoryMapT>())
+            return mm;
+
+        MemoryMapT *mm = createMM();
+        // if this is the root of the entry procedure,
+        // we must propagate the points-to information
+        // from the globals initialization
+        if (n == PG->getEntry()->getRoot()) {
+            mergeGlobalsState(mm, PG->getGlobals());
+        }
+        n->setData<MemoryMapT>(mm);
+        return mm;
+    }
+
+  public:
+    PointerAnalysisSFS(PointerGraph *ps) : PointerAnalysisSFS(ps, {}) {}
+
+    PointerAnalysisSFS(PointerGraph *ps, const PointerAnalysisOptions &opts)
+            : PointerAnalysisFSBase(ps, opts) {}
+
+    bool run() override {
+        PointerIDLookupTable::Scope pointerIDs(PG->getPointerIDs());
+
+        initialPointsTo.clear();
+        initialPointsTo.reserve(PG->getNodes().size());
+        for (const auto &nd : PG->getNodes())
+            initialPointsTo.push_back(nd ? nd->pointsTo : PointsToSetT());
+
+        stage = Stage::FI;
+        PointerAnalysis::run();
+
+        findReadObjects();
+        computeMapOwners();
+        computeMemoryUsers();
+        resetPointsTo();
+        fiObjects.clear();
+
+        stage = Stage::FS;
+        return PointerAnalysis::run();
+    }
+
+    MemoryPropagation memoryPropagation() const override {
+        return stage == Stage::FI ? MemoryPropagation::READERS
+                                  : MemoryPropagation::DEF_USE;
+    }
+
+    const std::vector<PSNode *> &getMemoryUsers(PSNode *where) override {
+        // the owner changed its map or a node that shares the map
+        // got it for the first time (and so its successors that
+        // merge the map may have missed it so far)
+        auto id = getMapOwner(where)->getID();
+        if (id >= memoryUsers.size())
+            return PointerAnalysisFSBase::getMemoryUsers(where);
+        return memoryUsers[id];
+    }
+
+    bool beforeProcessed(PSNode *n) override {
+        if (stage == Stage::FI || n->getData<MemoryMapT>())
+            return false;
+
+        n->setData<MemoryMapT>(getOrCreateMM(getMapOwner(n)));
+        return true;
+    }
+
+    bool afterProcessed(PSNode *n) override {
+        if (stage == Stage::FI || getMapOwner(n) != n)
+            return false;
+
+        return PointerAnalysisFSBase::afterProcessed(n);
+    }
+
+    void getMemoryObjects(PSNode *where, const Pointer &pointer,
+                          std::vector<MemoryObject *> &objects) override {
+        if (stage == Stage::FI) {
+            auto &mo = fiObjects[pointer.target];
+            if (!mo)
+                mo.reset(new MemoryObject(pointer.target));
+            objects.push_back(mo.get());
+            return;
+        }
+
+        if (readObjects.count(pointer.target) == 0) {
+            // nobody reads this object, but writes
+            // still need an object to write to
+            if (canChangeMM(where)) {
+                auto &mo = unreadObjects[pointer.target];
+                if (!mo)
+                    mo.reset(new MemoryObject(pointer.target));
+                objects.push_back(mo.get());
+            }
+            return;
+        }
+
+        PointerAnalysisFSBase::getMemoryObjects(where, pointer, objects);
+    }
+
+    // the number of nodes that have their own memory map
+    size_t getNumOfMapOwners() const {
+        size_t num = 0;
+        for (size_t i = 0; i < mapOwner.size(); ++i) {
+            if (mapOwner[i] && mapOwner[i]->getID() == i)
+                ++num;
+        }
+        return num;
+    }
+};
+
+} // namespace pta
+} // namespace dg
+
+#endif // DG_ANALYSIS_POINTS_TO_SPARSE_FLOW_SENSITIVE_H_
@@ -0,0 +1,75 @@
+#ifndef DG_POINTER_ANALYSIS_STATISTICS_H_
+#define DG_POINTER_ANALYSIS_STATISTICS_H_
+
+#include <array>
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+#include "dg/PointerAnalysis/PSNode.h"
+
+namespace dg {
+namespace pta {
+
+///
+// Statistics of the solver of pointer analysis. These are gathered
+// only if the 'statistics' option is set.
+struct PointerAnalysisStatistics {
+    struct NodeTypeStatistics {
+        size_t visits{0};
+        // the visits that changed a points-to set or memory
+        size_t changes{0};
+        // the time spent processing the nodes (the nodes processed
+        // by the parallel solver are not timed)
+        uint64_t nanoseconds{0};
+    };
+
+    static const size_t NODE_TYPES_NUM =
+            static_cast<size_t>(PSNodeType::INVALIDATED) + 1;
+
+    // indexed by PSNodeType
+    std::array<NodeTypeStatistics, NODE_TYPES_NUM> nodeTypes{};
+
+    size_t iterations{0};
+    // the number of queued nodes at the beginning of every iteration
+    std::vector<size_t> worklistSizes;
+    // the functions found to be called via pointers or spawned in threads
+    size_t functionPointerCalls{0};
+    size_t forkedFunctions{0};
+
+    // these are gathered when the analysis finishes:
+    // the number of nodes whose points-to set has 0, 1, 2-3, 4-7, ...
+    // elements (i.e., the i-th item counts sizes in [2^(i-1), 2^i))
+    std::vector<size_t> pointsToSizes;
+    size_t maxPointsToSize{0};
+    size_t memoryObjects{0};
+    // the number of offsets with a points-to set in memory objects
+    size_t memoryObjectsOffsets{0};
+    // the bytes taken by the points-to sets of the nodes and memory
+    // objects (including the storage shared by the sets). The peak
+    // is sampled after every iteration and does not include memory objects.
+    size_t pointsToMemory{0};
+    size_t peakPointsToMemory{0};
+
+    void addVisit(PSNodeType type, bool changed, uint64_t nanoseconds) {
+        auto &S = nodeTypes[static_cast<size_t>(type)];
+        ++S.visits;
+        S.changes += changed;
+        S.nanoseconds += nanoseconds;
+    }
+
+    void addPointsToSize(size_t size);
+
+    void addPointsToMemorySample(size_t bytes) {
+        if (bytes > peakPointsToMemory)
+            peakPointsToMemory = bytes;
+    }
+
+    // dump the statistics as a JSON object
+    void dumpJSON(std::ostream &os) const;
+};
+
+} // namespace pta
+} // namespace dg
+
+#endif // DG_POINTER_ANALYSIS_STATISTICS_H_
@@ -0,0 +1,162 @@
+#ifndef DG_ANALYSIS_POINTS_TO_UNIFICATION_H_
+#define DG_ANALYSIS_POINTS_TO_UNIFICATION_H_
+
+#include <cstdint>
+#include <map>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "PointerAnalysis.h"
+
+namespace dg {
+namespace pta {
+
+///
+// Flow-insensitive unification-based (Steensgaard's) pointer analysis.
+//
+// The pointed memory is partitioned into equivalence classes kept
+// in a union-find structure and every node and every class points
+// to (at most) one class. An assignment unifies the classes pointed
+// by its both sides instead of adding a subset edge, so the analysis
+// runs in almost linear time. The results are a superset of the results
+// of the inclusion-based analysis (PointerAnalysisFI).
+//
+// The classes are field-insensitive: a memory object has one class
+// of its contents for all offsets. The offsets of pointers are tracked
+// separately for every node and every class of stored pointers (a few
+// offsets or the unknown offset) and they respect 'fieldSensitivity'
+// the same way as in the inclusion-based analysis.
+//
+class PointerAnalysisSteensgaard : public PointerAnalysis {
+    static constexpr unsigned NONE = ~0U;
+
+    // the flags of classes, the special nodes (null, unknown memory,
+    // invalidated) are not members of classes, but flags. Otherwise,
+    // a single class would hold everything that may be null.
+    enum : uint8_t {
+        // the class contains a memory object (ALLOC or FUNCTION)
+        HAS_OBJECTS = 1 << 0,
+        HAS_NULL = 1 << 1,
+        // if a class has unknown memory, its contents are unknown too
+        HAS_UNKNOWN = 1 << 2,
+        HAS_INVALIDATED = 1 << 3
+    };
+
+    // the union-find structure of elements, the element
+    // pointed by a class is stored in its representative
+    std::vector<unsigned> parent;
+    std::vector<uint8_t> rank;
+    std::vector<unsigned> pointee;
+    std::vector<uint8_t> flags;
+
+    // the elements of pointers computed by nodes and of memory
+    // objects (ALLOC, FUNCTION) indexed by the ID of nodes
+    std::vector<unsigned> valueElem;
+    std::vector<unsigned> objectElem;
+    // how many operands of the node were unified already
+    // (PHI nodes get new operands when calls are resolved)
+    std::vector<unsigned> processed;
+
+    // the sorted offsets of pointers, at most MAX_OFFSETS of them,
+    // otherwise only the unknown offset. Empty if there are no pointers.
+    using Offsets = std::vector<Offset::type>;
+    static constexpr size_t MAX_OFFSETS = 4;
+
+    // the offsets of pointers computed by nodes (indexed by ID)
+    // and stored in memory (indexed by the representative of the class
+    // of stored pointers) and the nodes that read the stored pointers
+    std::vector<Offsets> offsets;
+    std::unordered_map<unsigned, Offsets> contentsOffsets;
+    std::unordered_map<unsigned, std::vector<PSNode *>> contentsReaders;
+
+    // the memory objects in classes (indexed by the representative)
+    std::unordered_map<unsigned, std::vector<PSNode *>> classObjects;
+    // the points-to sets created for (class, offset),
+    // nodes with the same class and offset share the set
+    std::map<std::pair<unsigned, Offset::type>, PointsToSetT> classSets;
+
+    unsigned newElement(uint8_t f = 0);
+    unsigned find(unsigned e);
+    unsigned getPointee(unsigned e);
+    void unify(unsigned a, unsigned b);
+    void addFlags(unsigned e, uint8_t f);
+
+    unsigned getValue(PSNode *node);
+    unsigned getObject(PSNode *node);
+    // the class of the memory pointed by the pointer 'node'
+    unsigned getPointed(PSNode *node) { return getPointee(getValue(node)); }
+    // the class of the pointers stored in the memory pointed by 'node'
+    unsigned getContents(PSNode *node) {
+        return getPointee(getPointed(node));
+    }
+
+    static bool isSpecial(const PSNode *node) {
+        return node->isNull() || node->isUnknownMemory() ||
+               node->isInvalidated();
+    }
+    static uint8_t specialFlag(const PSNode *node);
+
+    // add the pointers of 'op' to the class 'cls'
+    void addPointers(unsigned cls, PSNode *op);
+    // add the pointer to 'target' to the class 'cls'
+    void addTarget(unsigned cls, PSNode *target);
+
+    // unify the classes according to the not processed operands of node
+    void processNode(PSNode *node);
+    std::vector<PSNode *> getReachableNodes();
+
+    // compute the offsets of pointers of nodes
+    // and the points-to sets from the classes
+    static bool isUnknown(const Offsets &offs) {
+        return offs.size() == 1 && offs[0] == Offset::UNKNOWN;
+    }
+    static bool joinOffsets(Offsets &to, const Offsets &from);
+    Offsets getOffsets(const PSNode *node) const;
+    void joinContentsOffsets(unsigned cls, const Offsets &offs,
+                             std::vector<PSNode *> &queue);
+    bool computeOffsets(PSNode *node, std::vector<PSNode *> &queue);
+    void computeOffsets(const std::vector<PSNode *> &nodes);
+    void groupObjects();
+    const PointsToSetT &getClassSet(unsigned cls, Offset off);
+    void setPointsTo(const std::vector<PSNode *> &nodes);
+
+    // resolve calls via pointers and threads,
+    // return true if the graph changed
+    bool resolveCalls(const std::vector<PSNode *> &nodes);
+
+  public:
+    PointerAnalysisSteensgaard(PointerGraph *ps)
+            : PointerAnalysisSteensgaard(ps, {}) {}
+
+    PointerAnalysisSteensgaard(PointerGraph *ps,
+                               const PointerAnalysisOptions &opts)
+            : PointerAnalysis(ps, opts) {}
+
+    // the memory is not modelled by memory objects
+    void getMemoryObjects(PSNode * /*where*/, const Pointer & /*pointer*/,
+                          std::vector<MemoryObject *> & /*objects*/) override {
+    }
+
+    ///
+    // Unify the classes of the nodes that are reachable in the graph
+    // without changing the graph or the points-to sets of the nodes.
+    // Calls via pointers are not resolved. Used as a pre-pass
+    // of the inclusion-based analyses.
+    void unifyClasses();
+
+    // may the node point to anything after unifyClasses()
+    // (calls via pointers not taken into account)? Returns true
+    // also for the nodes that were not unified.
+    bool mayPointTo(PSNode *node);
+
+    // do the nodes point to the same class after unifyClasses()?
+    bool pointToSameClass(PSNode *a, PSNode *b);
+
+    bool run() override;
+};
+
+} // namespace pta
+} // namespace dg
+
+#endif // DG_ANALYSIS_POINTS_TO_UNIFICATION_H_
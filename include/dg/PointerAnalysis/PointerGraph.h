@@ -1,14 +1,17 @@
 #ifndef DG_POINTER_GRAPH_H_
 #define DG_POINTER_GRAPH_H_
 
+#include "dg/ADT/Arena.h"
 #include "dg/ADT/Queue.h"
 #include "dg/BFS.h"
 #include "dg/CallGraph/CallGraph.h"
 #include "dg/PointerAnalysis/PSNode.h"
+#include "dg/PointerAnalysis/PointsToSets/LookupTable.h"
 #include "dg/SCC.h"
 #include "dg/SubgraphNode.h"
 #include "dg/util/debug.h"
 
+#include <algorithm>
 #include <cassert>
 #include <cstdarg>
 #include <functional>
@@ -82,6 +85,49 @@ class PointerSubgraph {
 
     // FIXME: remember just that a node is on loop, not the whole loops
     void computeLoops();
+
+    // Update the loops after new nodes were inserted between the call
+    // 'callsite' from this subgraph and its call return (e.g., when
+    // a call via a pointer has been resolved). The loops are computed
+    // with calls stepping over to their call returns, so only
+    // the loop of the call site can change.
+    void callInserted(PSNode *callsite);
+};
+
+///
+// Nodes built apart from a graph, e.g., by another thread while
+// the graph is being built. The nodes get their IDs when they are added
+// to the graph by PointerGraph::adopt(), so the IDs depend only
+// on the order in which the pools are adopted. Until then, the points-to
+// sets of the nodes use the table of pointer IDs of the pool and the nodes
+// are not registered as users of their operands (the operands may
+// be nodes of the graph shared with other threads).
+class PointerNodesPool {
+    friend class PointerGraph;
+
+    std::unique_ptr<PointerIDLookupTable> _pointerIDs{
+            new PointerIDLookupTable()};
+    ADT::Arena _arena;
+    std::vector<ADT::ArenaPtr<PSNode>> _nodes;
+
+  public:
+    // build the nodes of the pool in this thread
+    // until the end of the scope
+    class Scope {
+        PointerIDLookupTable::Scope _pointerIDs;
+        SubgraphNode<PSNode>::DeferUsers _deferUsers;
+
+      public:
+        Scope(PointerNodesPool &pool) : _pointerIDs(*pool._pointerIDs) {}
+    };
+
+    // the nodes are numbered from 1 in the pool,
+    // the graph gives them new IDs
+    template <PSNodeType Type, typename... Args>
+    PSNode *create(Args &&...args);
+
+    size_t size() const { return _nodes.size(); }
+    bool empty() const { return _nodes.empty(); }
 };
 
 // IDs of special nodes
@@ -96,21 +142,36 @@ enum PointerGraphReservedIDs {
 // Basic graph for pointer analysis
 // -- contains CFG graphs for all procedures of the program.
 class PointerGraph {
+    friend class PointerNodesPool;
+
+    // IDs of pointers used by the points-to sets of this graph,
+    // it is declared first so that it is destroyed after the nodes.
+    // It is allocated separately so that it does not move with the graph.
+    std::unique_ptr<PointerIDLookupTable> _pointerIDs{
+            new PointerIDLookupTable()};
+    // the memory of the nodes, the nodes are destroyed by 'nodes',
+    // the memory is freed at once after that
+    ADT::Arena _arena;
+
     unsigned int dfsnum{0};
 
     // root of the pointer state subgraph
     PointerSubgraph *_entry{nullptr};
 
-    using NodesT = std::vector<std::unique_ptr<PSNode>>;
+  public:
+    using NodesT = std::vector<ADT::ArenaPtr<PSNode>>;
     using GlobalNodesT = std::vector<PSNode *>;
     using SubgraphsT = std::vector<std::unique_ptr<PointerSubgraph>>;
 
+  private:
     NodesT nodes;
     SubgraphsT _subgraphs;
 
     // Take care of assigning ids to new nodes
     unsigned int last_node_id = PointerGraphReservedIDs::LAST_RESERVED_ID;
     unsigned int getNewNodeId() { return ++last_node_id; }
+    // subgraphs may be removed, so their IDs are not their positions
+    unsigned int last_subgraph_id = 0;
 
     GenericCallGraph<PSNode *> callGraph;
     GlobalNodesT _globals;
@@ -144,21 +205,23 @@ class PointerGraph {
     //   * replace GetNodeType with a chain of `if constexpr` expressions
     template <PSNodeType Type, typename... Args,
               typename Node = typename GetNodeType<Type>::type>
-    typename std::enable_if<!std::is_same<Node, PSNode>::value, Node *>::type
-    nodeFactory(Args &&...args) {
-        return new Node(getNewNodeId(), std::forward<Args>(args)...);
+    static typename std::enable_if<!std::is_same<Node, PSNode>::value,
+                                   Node *>::type
+    nodeFactory(ADT::Arena &arena, unsigned id, Args &&...args) {
+        return arena.create<Node>(id, std::forward<Args>(args)...);
     }
 
     // we need to check that the number of arguments is correct with general
     // PSNode
     template <PSNodeType Type, typename... Args,
               typename Node = typename GetNodeType<Type>::type>
-    typename std::enable_if<std::is_same<Node, PSNode>::value, Node *>::type
-    nodeFactory(Args &&...args) {
+    static typename std::enable_if<std::is_same<Node, PSNode>::value,
+                                   Node *>::type
+    nodeFactory(ADT::Arena &arena, unsigned id, Args &&...args) {
         static_assert(expected_args_size<Type, sizeof...(args)>() ==
                               sizeof...(args),
                       "Incorrect number of arguments");
-        return new Node(getNewNodeId(), Type, std::forward<Args>(args)...);
+        return arena.create<Node>(id, Type, std::forward<Args>(args)...);
     }
 
   public:
@@ -174,18 +237,26 @@ class PointerGraph {
         initStaticNodes();
     }
 
+    ~PointerGraph() {
+        if (_pointerIDs &&
+            &PointerIDLookupTable::current() == _pointerIDs.get())
+            PointerIDLookupTable::setCurrent(nullptr);
+    }
+
     static void initStaticNodes();
 
     PointerSubgraph *createSubgraph(PSNode *root, PSNode *vararg = nullptr) {
-        // NOTE: id of the subgraph is always index in _subgraphs + 1
-        _subgraphs.emplace_back(new PointerSubgraph(
-                static_cast<unsigned>(_subgraphs.size()) + 1, root, vararg));
+        _subgraphs.emplace_back(
+                new PointerSubgraph(++last_subgraph_id, root, vararg));
         return _subgraphs.back().get();
     }
 
     template <PSNodeType Type, typename... Args>
     PSNode *create(Args &&...args) {
-        PSNode *n = nodeFactory<Type>(std::forward<Args>(args)...);
+        // the points-to sets of the nodes use the table of this graph
+        PointerIDLookupTable::Scope pointerIDs(*_pointerIDs);
+        PSNode *n = nodeFactory<Type>(_arena, getNewNodeId(),
+                                      std::forward<Args>(args)...);
         nodes.emplace_back(n); // C++17 returns a referece
         assert(n->getID() == nodes.size() - 1);
         return n;
@@ -203,6 +274,12 @@ class PointerGraph {
         return n;
     }
 
+    // Add the nodes of the pool to the graph. The nodes get IDs in the order
+    // in which they were created, their points-to sets are moved to the table
+    // of pointer IDs of this graph and they are registered as users
+    // of their operands. The pool is empty afterwards.
+    void adopt(PointerNodesPool &pool);
+
     bool registerCall(PSNode *a, PSNode *b) { return callGraph.addCall(a, b); }
 
     GenericCallGraph<PSNode *> &getCallGraph() { return callGraph; }
@@ -215,6 +292,19 @@ class PointerGraph {
 
     void computeLoops();
 
+    // Update the information about loops after a call has been
+    // inserted at 'callsite' (e.g., a call via a pointer has been
+    // resolved): compute the loops of the called subgraphs that do
+    // not have them yet and update the loop of the call site.
+    // Other subgraphs are not touched.
+    void updateLoops(PSNode *callsite);
+
+    PointerIDLookupTable &getPointerIDs() { return *_pointerIDs; }
+    const PointerIDLookupTable &getPointerIDs() const { return *_pointerIDs; }
+
+    // make the table of pointer IDs of this graph current in this thread
+    void activate() { PointerIDLookupTable::setCurrent(_pointerIDs.get()); }
+
     PointerGraph(PointerGraph &&) = default;
     PointerGraph &operator=(PointerGraph &&) = default;
     PointerGraph(const PointerGraph &) = delete;
@@ -225,6 +315,58 @@ class PointerGraph {
 
     void remove(PSNode *nd);
 
+    // Remove the subgraph with all its nodes (the nodes whose parent
+    // is the subgraph) from the graph. The calls of the subgraph and
+    // the calls from the subgraph are disconnected, the nodes of other
+    // subgraphs lose the removed nodes as operands and the pointers
+    // to the removed nodes are removed from the points-to sets.
+    // Memory objects of analyses are not updated, so a new analysis
+    // must be run on the graph afterwards (see clearNodesData()).
+    // Returns the nodes that lost some operand.
+    std::vector<PSNode *> removeSubgraph(PointerSubgraph *subg);
+
+    // Clear the points-to sets of the nodes and of the nodes that use
+    // them (transitively), so that an analysis computes them anew.
+    // Only the points-to sets computed by analyses are cleared
+    // (not the points-to sets of allocations, functions, constants, etc.).
+    void invalidatePointsTo(const std::vector<PSNode *> &nodes);
+
+    // clear the data that an analysis attached to the nodes,
+    // this must be done before a new analysis runs on the graph
+    void clearNodesData();
+
+    // call F on the successors of the node in the control flow.
+    // If 'interprocedural' is set, call nodes of defined functions
+    // have as successors the roots of the called functions
+    // and return nodes the return sites instead of their successors.
+    template <typename FunT>
+    static void forEachSuccessor(PSNode *cur, FunT &&F,
+                                 bool interprocedural = true) {
+        if (interprocedural) {
+            if (PSNodeCall *C = PSNodeCall::get(cur)) {
+                for (auto *subg : C->getCallees()) {
+                    F(subg->root);
+                }
+                // we do not need to iterate over succesors
+                // if we dive into the procedure (as we will
+                // return via call return)
+                // NOTE: we must iterate over successors if the
+                // function is undefined
+                if (!C->getCallees().empty())
+                    return;
+            } else if (PSNodeRet *R = PSNodeRet::get(cur)) {
+                for (auto *ret : R->getReturnSites()) {
+                    F(ret);
+                }
+                if (!R->getReturnSites().empty())
+                    return;
+            }
+        }
+
+        for (auto *s : cur->successors())
+            F(s);
+    }
+
     // get nodes in BFS order and store them into
     // the container
     template <typename ContainerOrNode>
@@ -251,29 +393,7 @@ class PointerGraph {
             EdgeChooser(bool inter = true) : interproc(inter) {}
 
             void foreach (PSNode *cur, std::function<void(PSNode *)> Dispatch) {
-                if (interproc) {
-                    if (PSNodeCall *C = PSNodeCall::get(cur)) {
-                        for (auto *subg : C->getCallees()) {
-                            Dispatch(subg->root);
-                        }
-                        // we do not need to iterate over succesors
-                        // if we dive into the procedure (as we will
-                        // return via call return)
-                        // NOTE: we must iterate over successors if the
-                        // function is undefined
-                        if (!C->getCallees().empty())
-                            return;
-                    } else if (PSNodeRet *R = PSNodeRet::get(cur)) {
-                        for (auto *ret : R->getReturnSites()) {
-                            Dispatch(ret);
-                        }
-                        if (!R->getReturnSites().empty())
-                            return;
-                    }
-                }
-
-                for (auto *s : cur->successors())
-                    Dispatch(s);
+                forEachSuccessor(cur, Dispatch, interproc);
             }
         };
 
@@ -287,6 +407,15 @@ class PointerGraph {
     }
 };
 
+template <PSNodeType Type, typename... Args>
+PSNode *PointerNodesPool::create(Args &&...args) {
+    PointerIDLookupTable::Scope pointerIDs(*_pointerIDs);
+    PSNode *n = PointerGraph::nodeFactory<Type>(_arena, _nodes.size() + 1,
+                                                std::forward<Args>(args)...);
+    _nodes.emplace_back(n);
+    return n;
+}
+
 ///
 // get nodes reachable from n (including n),
 // stop at node 'exit' (excluding) if not set to null
@@ -332,6 +461,84 @@ inline std::set<PSNode *> getReachableNodes(PSNode *n, PSNode *exit = nullptr,
     return cont;
 }
 
+// Tarjan's algorithm on the graph given by the successors function
+// (without recursion as the graphs may be huge). Returns the SCCs
+// reachable from 'start' in the reverse topological order,
+// the nodes inside the SCCs are in the DFS order.
+template <typename SuccessorsFunT>
+std::vector<std::vector<PSNode *>>
+computeSCCs(PSNode *start, SuccessorsFunT &&forEachSucc) {
+    struct NodeInfo {
+        unsigned dfsid{0};
+        unsigned lowpt{0};
+        bool onStack{false};
+    };
+    std::unordered_map<PSNode *, NodeInfo> info;
+    std::vector<PSNode *> stack;
+    std::vector<std::vector<PSNode *>> sccs;
+
+    struct Frame {
+        PSNode *node;
+        std::vector<PSNode *> successors;
+        size_t next{0};
+
+        Frame(PSNode *n, SuccessorsFunT &forEachSucc) : node(n) {
+            forEachSucc(n, [this](PSNode *s) { successors.push_back(s); });
+        }
+    };
+    std::vector<Frame> dfs;
+
+    unsigned dfsnum = 0;
+    auto visit = [&](PSNode *n) {
+        auto &I = info[n];
+        I.dfsid = I.lowpt = ++dfsnum;
+        I.onStack = true;
+        stack.push_back(n);
+        dfs.emplace_back(n, forEachSucc);
+    };
+
+    visit(start);
+    while (!dfs.empty()) {
+        auto &frame = dfs.back();
+        PSNode *cur = frame.node;
+        if (frame.next < frame.successors.size()) {
+            PSNode *succ = frame.successors[frame.next++];
+            auto &SI = info[succ];
+            if (SI.dfsid == 0) {
+                // invalidates 'frame'
+                visit(succ);
+            } else if (SI.onStack) {
+                auto &I = info[cur];
+                I.lowpt = std::min(I.lowpt, SI.dfsid);
+            }
+            continue;
+        }
+
+        dfs.pop_back();
+        auto &I = info[cur];
+        if (!dfs.empty()) {
+            auto &PI = info[dfs.back().node];
+            PI.lowpt = std::min(PI.lowpt, I.lowpt);
+        }
+
+        if (I.lowpt == I.dfsid) {
+            sccs.emplace_back();
+            PSNode *w;
+            do {
+                w = stack.back();
+                stack.pop_back();
+                info[w].onStack = false;
+                sccs.back().push_back(w);
+            } while (w != cur);
+            // the nodes were popped from the stack
+            std::reverse(sccs.back().begin(), sccs.back().end());
+        }
+    }
+    assert(stack.empty());
+
+    return sccs;
+}
+
 } // namespace pta
 } // namespace dg
 
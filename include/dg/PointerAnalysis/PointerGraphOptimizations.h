@@ -1,6 +1,9 @@
 #ifndef DG_POINTER_SUBGRAPH_OPTIMIZATIONS_H_
 #define DG_POINTER_SUBGRAPH_OPTIMIZATIONS_H_
 
+#include <set>
+
+#include "PointerGraph.h"
 #include "PointsToMapping.h"
 
 namespace dg {
@@ -21,6 +24,8 @@ class PSUnknownsReducer {
     using MappingT = PointsToMapping<PSNode *>;
 
     PointerGraph *G;
+    // nodes that must be kept
+    const std::set<PSNode *> *pinned;
     MappingT mapping;
 
     unsigned removed = 0;
@@ -28,7 +33,9 @@ class PSUnknownsReducer {
     void processAllocs();
 
   public:
-    PSUnknownsReducer(PointerGraph *g) : G(g) {}
+    PSUnknownsReducer(PointerGraph *g,
+                      const std::set<PSNode *> *pinned = nullptr)
+            : G(g), pinned(pinned) {}
 
     MappingT &getMapping() { return mapping; }
     const MappingT &getMapping() const { return mapping; }
@@ -43,7 +50,9 @@ class PSEquivalentNodesMerger {
   public:
     using MappingT = PointsToMapping<PSNode *>;
 
-    PSEquivalentNodesMerger(PointerGraph *g) : G(g), merged_nodes_num(0) {
+    PSEquivalentNodesMerger(PointerGraph *g,
+                            const std::set<PSNode *> *pinned = nullptr)
+            : G(g), pinned(pinned), merged_nodes_num(0) {
         mapping.reserve(32);
     }
 
@@ -67,22 +76,73 @@ class PSEquivalentNodesMerger {
     void merge(PSNode *node1, PSNode *node2);
 
     PointerGraph *G;
+    // nodes that must be kept
+    const std::set<PSNode *> *pinned;
     // map nodes to its equivalent representant
     MappingT mapping;
 
     unsigned merged_nodes_num;
 };
 
+// Offline pointer-equivalence: merge nodes that provably have the same
+// points-to set before running the analysis -- GEPs with the same source
+// and offset, PHIs and CALL_RETURNs with the same set of operands
+// and (in flow-insensitive analysis) loads from the same pointer.
+// The nodes are numbered by their kind and operands and nodes with
+// the same number are merged. This is repeated until no more
+// nodes are merged, since merging nodes may make their users equivalent.
+class PSPointerEquivalenceMerger {
+  public:
+    using MappingT = PointsToMapping<PSNode *>;
+
+    PSPointerEquivalenceMerger(PointerGraph *g, bool flowInsensitive,
+                               const std::set<PSNode *> *pinned = nullptr)
+            : G(g), flowInsensitive(flowInsensitive), pinned(pinned) {}
+
+    MappingT &getMapping() { return mapping; }
+    const MappingT &getMapping() const { return mapping; }
+
+    unsigned getNumOfMergedNodes() const { return merged_nodes_num; }
+
+    unsigned run();
+
+  private:
+    // one round of value numbering, returns the number of merged nodes
+    unsigned mergeEquivalent();
+    bool canMerge(PSNode *node) const;
+    void merge(PSNode *node, PSNode *rep);
+
+    PointerGraph *G;
+    // loads from the same pointer yield the same pointers
+    // only if the analysis is flow-insensitive
+    bool flowInsensitive;
+    // nodes that must be kept, e.g. because
+    // they may get new operands during the analysis
+    const std::set<PSNode *> *pinned;
+    MappingT mapping;
+
+    unsigned merged_nodes_num = 0;
+};
+
 class PointerGraphOptimizer {
     using MappingT = PointsToMapping<PSNode *>;
 
     PointerGraph *G;
     MappingT mapping;
+    // the nodes that must not be removed or merged
+    std::set<PSNode *> pinned;
+    bool flowInsensitive;
 
     unsigned removed = 0;
 
   public:
-    PointerGraphOptimizer(PointerGraph *g) : G(g) {}
+    PointerGraphOptimizer(PointerGraph *g, bool flowInsensitive = false)
+            : G(g), flowInsensitive(flowInsensitive) {}
+
+    // do not remove this node, e.g., because it can be
+    // changed later (like formal arguments of functions
+    // that get new operands when called via a pointer)
+    void pin(PSNode *nd) { pinned.insert(nd); }
 
     void removeNoops() {
         PSNoopRemover remover(G);
@@ -90,7 +150,7 @@ class PointerGraphOptimizer {
     }
 
     void removeUnknowns() {
-        PSUnknownsReducer reducer(G);
+        PSUnknownsReducer reducer(G, &pinned);
         if (auto r = reducer.run()) {
             mapping.merge(std::move(reducer.getMapping()));
             removed += r;
@@ -98,7 +158,15 @@ class PointerGraphOptimizer {
     }
 
     void removeEquivalentNodes() {
-        PSEquivalentNodesMerger merger(G);
+        PSEquivalentNodesMerger merger(G, &pinned);
+        if (auto r = merger.run()) {
+            mapping.merge(std::move(merger.getMapping()));
+            removed += r;
+        }
+    }
+
+    void mergePointerEquivalentNodes() {
+        PSPointerEquivalenceMerger merger(G, flowInsensitive, &pinned);
         if (auto r = merger.run()) {
             mapping.merge(std::move(merger.getMapping()));
             removed += r;
@@ -106,8 +174,18 @@ class PointerGraphOptimizer {
     }
 
     unsigned run() {
+        // vararg nodes get new operands during the analysis
+        for (const auto &subg : G->getSubgraphs()) {
+            if (subg->vararg)
+                pin(subg->vararg);
+        }
+        // global nodes are referenced from the graph
+        for (PSNode *glob : G->getGlobals())
+            pin(glob);
+
         removeNoops();
         removeEquivalentNodes();
+        mergePointerEquivalentNodes();
         removeUnknowns();
         // need to call this once more because
         // the optimizations may have created
@@ -19,6 +19,11 @@ class PointerGraphValidator {
 
     // do not check for the connectivity of the graph
     bool no_connectivity;
+    // check only the nodes with this or higher ID (e.g., the nodes
+    // added to the graph since the last check)
+    unsigned first_node;
+
+    bool isKnownNode(const PSNode *nd) const;
 
   protected:
     const PointerGraph *PS;
@@ -37,8 +42,9 @@ class PointerGraphValidator {
     virtual bool warn(const PSNode *n, const std::string &warning);
 
   public:
-    PointerGraphValidator(const PointerGraph *ps, bool no_conn = false)
-            : no_connectivity(no_conn), PS(ps) {}
+    PointerGraphValidator(const PointerGraph *ps, bool no_conn = false,
+                          unsigned first = 0)
+            : no_connectivity(no_conn), first_node(first), PS(ps) {}
     virtual ~PointerGraphValidator() = default;
 
     bool validate();
@@ -55,9 +55,12 @@ class PointsToMapping {
     // compose this mapping with some other mapping:
     // (PSNode * -> PSNode *) o (ValT -> PSNode *)
     // leads to (ValT -> PSNode *).
+    // The mapping 'rhs' may contain chains of nodes
+    // (a node was merged to a node that was merged later again),
+    // these are followed to the last node.
     void compose(PointsToMapping<PSNode *> &&rhs) {
         for (auto &it : mapping) {
-            if (PSNode *rhs_node = rhs.get(it.second)) {
+            while (PSNode *rhs_node = rhs.get(it.second)) {
                 it.second = rhs_node;
             }
         }
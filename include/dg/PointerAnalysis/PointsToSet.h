@@ -1,19 +1,35 @@
 #ifndef DG_POINTS_TO_SET_H_
 #define DG_POINTS_TO_SET_H_
 
+#include "dg/PointerAnalysis/OffsetMap.h"
 #include "dg/PointerAnalysis/PointsToSets/AlignedPointerIdPointsToSet.h"
 #include "dg/PointerAnalysis/PointsToSets/AlignedSmallOffsetsPointsToSet.h"
+#include "dg/PointerAnalysis/PointsToSets/BddPointsToSet.h"
 #include "dg/PointerAnalysis/PointsToSets/OffsetsSetPointsToSet.h"
 #include "dg/PointerAnalysis/PointsToSets/PointerIdPointsToSet.h"
+#include "dg/PointerAnalysis/PointsToSets/RecordingPointsToSet.h"
 #include "dg/PointerAnalysis/PointsToSets/SeparateOffsetsPointsToSet.h"
+#include "dg/PointerAnalysis/PointsToSets/SharedPointerIdPointsToSet.h"
 #include "dg/PointerAnalysis/PointsToSets/SimplePointsToSet.h"
 #include "dg/PointerAnalysis/PointsToSets/SmallOffsetsPointsToSet.h"
 
 namespace dg {
 namespace pta {
 
-using PointsToSetT = PointerIdPointsToSet;
-using PointsToMapT = std::map<Offset, PointsToSetT>;
+#if defined(DG_BDD_POINTS_TO_SET)
+using DefaultPointsToSetT = BddPointsToSet;
+#elif defined(DG_SHARED_POINTS_TO_SET)
+using DefaultPointsToSetT = SharedPointerIdPointsToSet;
+#else
+using DefaultPointsToSetT = PointerIdPointsToSet;
+#endif
+
+#ifdef DG_RECORD_POINTS_TO_SETS
+using PointsToSetT = RecordingPointsToSet<DefaultPointsToSetT>;
+#else
+using PointsToSetT = DefaultPointsToSetT;
+#endif
+using PointsToMapT = OffsetMap<PointsToSetT>;
 
 } // namespace pta
 } // namespace dg
@@ -0,0 +1,119 @@
+#ifndef DG_POINTS_TO_SET_TRACE_H_
+#define DG_POINTS_TO_SET_TRACE_H_
+
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "dg/Offset.h"
+#include "dg/PointerAnalysis/Pointer.h"
+
+namespace dg {
+namespace pta {
+
+///
+// Traces of operations on points-to sets. The traces are recorded
+// by RecordingPointsToSet (when dg is built with RECORD_POINTS_TO_SETS)
+// and replayed by the ptset-replay benchmark against all implementations
+// of points-to sets.
+//
+// The trace is a header followed by records. A record is the operation
+// (one byte) and its operands encoded as LEB128 numbers: the set
+// (sets are numbered from 1 in the order of their creation), then
+// the other set or the ID of the target node and the offset
+// (incremented by one, so that the unknown offset is 0).
+enum class PointsToSetOp : uint8_t {
+    CREATE = 1,  // set
+    DESTROY,     // set
+    COPY,        // new set, copied set
+    MOVE,        // new set, moved set
+    ASSIGN,      // set, assigned set
+    MOVE_ASSIGN, // set, moved set
+    SWAP,        // set, other set
+    CLEAR,       // set
+    ADD,         // set, target, offset
+    ADD_SET,     // set, added set
+    REMOVE,      // set, target, offset
+    REMOVE_ANY,  // set, target
+    POINTS_TO,   // set, target, offset
+    ITERATE,     // set
+    LAST = ITERATE
+};
+
+class PointsToSetTraceWriter {
+    FILE *_file;
+    std::vector<uint8_t> _buffer;
+    uint64_t _lastSet{0};
+    // the sets may be created in multiple threads
+    std::mutex _mutex;
+
+    static PointsToSetTraceWriter *_current;
+
+    PointsToSetTraceWriter(FILE *file);
+
+    void put(uint64_t num);
+    void flush();
+
+  public:
+    ~PointsToSetTraceWriter();
+
+    PointsToSetTraceWriter(const PointsToSetTraceWriter &) = delete;
+    PointsToSetTraceWriter &operator=(const PointsToSetTraceWriter &) = delete;
+
+    // the writer of the trace that is being recorded (or nullptr)
+    static PointsToSetTraceWriter *get() { return _current; }
+
+    // start recording the trace into the file, return false if the file
+    // cannot be created. The sets keep their numbers from the first
+    // trace, so only one trace can be recorded in a process.
+    static bool start(const std::string &path);
+    // stop recording and close the file
+    static void stop();
+
+    // record a new set (empty or a copy of the set 'from')
+    // and get its number
+    uint64_t create(PointsToSetOp op = PointsToSetOp::CREATE,
+                    uint64_t from = 0);
+
+    void write(PointsToSetOp op, uint64_t set);
+    void write(PointsToSetOp op, uint64_t set, uint64_t other);
+    void write(PointsToSetOp op, uint64_t set, const PSNode *target);
+    void write(PointsToSetOp op, uint64_t set, const Pointer &ptr);
+};
+
+class PointsToSetTraceReader {
+    FILE *_file{nullptr};
+    bool _error{false};
+
+    bool get(uint64_t &num);
+
+  public:
+    struct Record {
+        PointsToSetOp op;
+        uint64_t set;
+        // the other set or the ID of the target node
+        uint64_t arg;
+        Offset::type offset;
+    };
+
+    PointsToSetTraceReader() = default;
+    ~PointsToSetTraceReader();
+
+    PointsToSetTraceReader(const PointsToSetTraceReader &) = delete;
+    PointsToSetTraceReader &operator=(const PointsToSetTraceReader &) = delete;
+
+    // open the trace and check its header
+    bool open(const std::string &path);
+
+    // read the next record, return false at the end of the trace
+    // (or when the trace is malformed, then hasError() is true)
+    bool next(Record &rec);
+    bool hasError() const { return _error; }
+};
+
+} // namespace pta
+} // namespace dg
+
+#endif // DG_POINTS_TO_SET_TRACE_H_
@@ -0,0 +1,471 @@
+#ifndef DG_BDDPOINTSTOSET_H
+#define DG_BDDPOINTSTOSET_H
+
+#include <cassert>
+#include <cstdint>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "LookupTable.h"
+#include "dg/PointerAnalysis/Pointer.h"
+
+namespace dg {
+namespace pta {
+
+class PSNode;
+
+///
+// Points-to set represented as a reduced ordered binary decision diagram
+// (BDD) over the bits of pointer IDs (the IDs are the same as
+// in PointerIdPointsToSet). All sets share one table of BDD nodes
+// where every node is unique (hash-consed), so equal sets are the same
+// node and comparing sets is O(1). Sets that contain similar pointers
+// share the common parts of the diagrams. The results of unions and
+// differences of diagrams are kept in a (lossy) operation cache.
+// The nodes are never freed, the table only grows.
+class BddPointsToSet {
+    using NodeID = uint32_t;
+
+    // the number of bits of pointer IDs (the variables of the diagrams),
+    // the variable 0 is the most significant bit
+    static constexpr unsigned NUM_VARS = 32;
+    static constexpr NodeID FALSE = 0;
+    static constexpr NodeID TRUE = 1;
+
+    class Manager {
+        struct Node {
+            unsigned var;
+            NodeID low, high;
+            // the number of assignments to variables var..NUM_VARS-1
+            // that lead to TRUE, i.e., the number of elements
+            // of the set represented by the subdiagram
+            uint64_t count;
+        };
+
+        struct NodeKey {
+            unsigned var;
+            NodeID low, high;
+
+            bool operator==(const NodeKey &rhs) const {
+                return var == rhs.var && low == rhs.low && high == rhs.high;
+            }
+        };
+
+        struct NodeKeyHash {
+            size_t operator()(const NodeKey &k) const {
+                return (static_cast<size_t>(k.low) * 0x9e3779b97f4a7c15ULL) ^
+                       (static_cast<size_t>(k.high) << 7) ^ k.var;
+            }
+        };
+
+        enum class Op : unsigned { NONE, UNION, DIFF };
+
+        struct CacheEntry {
+            Op op{Op::NONE};
+            NodeID a{0}, b{0}, result{0};
+        };
+
+        static constexpr size_t CACHE_SIZE = 1 << 16;
+
+        std::vector<Node> _nodes;
+        std::unordered_map<NodeKey, NodeID, NodeKeyHash> _unique;
+        std::vector<CacheEntry> _cache;
+
+        static uint64_t scale(uint64_t count, unsigned from, unsigned to) {
+            assert(from <= to);
+            return to - from >= 64 ? 0 : count << (to - from);
+        }
+
+        NodeID mk(unsigned var, NodeID low, NodeID high) {
+            if (low == high)
+                return low;
+
+            NodeKey key{var, low, high};
+            auto it = _unique.find(key);
+            if (it != _unique.end())
+                return it->second;
+
+            const Node &l = _nodes[low];
+            const Node &h = _nodes[high];
+            uint64_t count = scale(l.count, var + 1, l.var) +
+                             scale(h.count, var + 1, h.var);
+            NodeID id = _nodes.size();
+            _nodes.push_back({var, low, high, count});
+            _unique.emplace(key, id);
+            return id;
+        }
+
+        NodeID apply(Op op, NodeID a, NodeID b) {
+            switch (op) {
+            case Op::UNION:
+                if (a == b || b == FALSE)
+                    return a;
+                if (a == FALSE)
+                    return b;
+                if (a == TRUE || b == TRUE)
+                    return TRUE;
+                if (a > b)
+                    std::swap(a, b);
+                break;
+            case Op::DIFF:
+                if (a == FALSE || a == b || b == TRUE)
+                    return FALSE;
+                if (b == FALSE)
+                    return a;
+                break;
+            default:
+                assert(false && "Invalid operation");
+            }
+
+            auto &entry =
+                    _cache[(static_cast<size_t>(a) * 0x9e3779b97f4a7c15ULL ^
+                            (static_cast<size_t>(b) << 2) ^
+                            static_cast<size_t>(op)) &
+                           (CACHE_SIZE - 1)];
+            if (entry.op == op && entry.a == a && entry.b == b)
+                return entry.result;
+
+            // the terminals have the variable NUM_VARS,
+            // so the cofactors of TRUE are TRUE
+            Node A = _nodes[a];
+            Node B = _nodes[b];
+            unsigned var = A.var < B.var ? A.var : B.var;
+            NodeID low = apply(op, A.var == var ? A.low : a,
+                               B.var == var ? B.low : b);
+            NodeID high = apply(op, A.var == var ? A.high : a,
+                                B.var == var ? B.high : b);
+            NodeID result = mk(var, low, high);
+
+            entry = {op, a, b, result};
+            return result;
+        }
+
+      public:
+        Manager() : _cache(CACHE_SIZE) {
+            _nodes.push_back({NUM_VARS, FALSE, FALSE, 0});
+            _nodes.push_back({NUM_VARS, TRUE, TRUE, 1});
+        }
+
+        unsigned var(NodeID n) const { return _nodes[n].var; }
+        NodeID low(NodeID n) const { return _nodes[n].low; }
+        NodeID high(NodeID n) const { return _nodes[n].high; }
+
+        static bool bit(uint64_t id, unsigned var) {
+            return (id >> (NUM_VARS - 1 - var)) & 1;
+        }
+
+        NodeID singleton(uint64_t id) {
+            assert(id >> NUM_VARS == 0 && "Too many pointers for BDD sets");
+            NodeID n = TRUE;
+            for (unsigned var = NUM_VARS; var-- > 0;)
+                n = bit(id, var) ? mk(var, FALSE, n) : mk(var, n, FALSE);
+            return n;
+        }
+
+        NodeID getUnion(NodeID a, NodeID b) { return apply(Op::UNION, a, b); }
+        NodeID getDifference(NodeID a, NodeID b) {
+            return apply(Op::DIFF, a, b);
+        }
+
+        bool contains(NodeID n, uint64_t id) const {
+            while (n != FALSE && n != TRUE) {
+                const Node &N = _nodes[n];
+                n = bit(id, N.var) ? N.high : N.low;
+            }
+            return n == TRUE;
+        }
+
+        uint64_t size(NodeID n) const {
+            return scale(_nodes[n].count, 0, _nodes[n].var);
+        }
+
+        size_t getNumOfNodes() const { return _nodes.size(); }
+
+        // an estimate, the overhead of the hash table is not known
+        size_t getMemoryUsage() const {
+            return _nodes.capacity() * sizeof(Node) +
+                   _unique.size() * (sizeof(NodeKey) + sizeof(NodeID)) +
+                   _unique.bucket_count() * sizeof(void *) +
+                   _cache.capacity() * sizeof(CacheEntry);
+        }
+    };
+
+    // the manager is never destroyed, as there are static nodes
+    // with points-to sets that may be destroyed after it
+    static Manager &manager() {
+        static auto *M = new Manager();
+        return *M;
+    }
+
+    // the table of pointer IDs of the graph in which the set was created
+    PointerIDLookupTable *_table{&PointerIDLookupTable::current()};
+    NodeID root{FALSE};
+
+    PointerIDLookupTable &lookupTable() const { return *_table; }
+
+    // if the pointer doesn't have ID, it's assigned one
+    size_t getPointerID(const Pointer &ptr) const {
+        return lookupTable().getOrCreate(ptr);
+    }
+
+    // the ID of the pointer or 0 if the pointer has no ID
+    // (then it is not in any set that uses the table)
+    size_t findPointerID(const Pointer &ptr) const {
+        return lookupTable().get(ptr);
+    }
+
+    const Pointer &getPointer(size_t id) const { return lookupTable().get(id); }
+
+    bool setRoot(NodeID n) {
+        bool changed = n != root;
+        root = n;
+        return changed;
+    }
+
+    bool addID(size_t id) {
+        if (manager().contains(root, id))
+            return false;
+        return setRoot(manager().getUnion(root, manager().singleton(id)));
+    }
+
+    bool addWithUnknownOffset(PSNode *node) {
+        auto ptrid = getPointerID({node, Offset::UNKNOWN});
+        if (!manager().contains(root, ptrid)) {
+            removeAny(node);
+            return addID(ptrid);
+        }
+        return false; // we already had it
+    }
+
+  public:
+    BddPointsToSet() = default;
+    explicit BddPointsToSet(const std::initializer_list<Pointer> &elems) {
+        add(elems);
+    }
+
+    bool add(PSNode *target, Offset off) { return add(Pointer(target, off)); }
+
+    bool add(const Pointer &ptr) {
+        if (has({ptr.target, Offset::UNKNOWN})) {
+            return false;
+        }
+        if (ptr.offset.isUnknown()) {
+            return addWithUnknownOffset(ptr.target);
+        }
+        return addID(getPointerID(ptr));
+    }
+
+    template <typename ContainerTy>
+    bool add(const ContainerTy &C) {
+        bool changed = false;
+        for (const auto &ptr : C)
+            changed |= add(ptr);
+        return changed;
+    }
+
+    bool add(const BddPointsToSet &S) {
+        if (S._table == _table)
+            return setRoot(manager().getUnion(root, S.root));
+
+        // the set uses another table (e.g., a set of a static node),
+        // the IDs must be translated
+        bool changed = false;
+        for (const auto &ptr : S)
+            changed |= add(ptr);
+        return changed;
+    }
+
+    bool remove(const Pointer &ptr) {
+        auto ptrid = findPointerID(ptr);
+        if (ptrid == 0 || !manager().contains(root, ptrid))
+            return false;
+        return setRoot(
+                manager().getDifference(root, manager().singleton(ptrid)));
+    }
+
+    bool remove(PSNode *target, Offset offset) {
+        return remove(Pointer(target, offset));
+    }
+
+    bool removeAny(PSNode *target) {
+        NodeID removed = FALSE;
+        for (auto it = begin(), et = end(); it != et; ++it) {
+            if (getPointer(it.id()).target == target)
+                removed = manager().getUnion(removed,
+                                             manager().singleton(it.id()));
+        }
+
+        if (removed == FALSE)
+            return false;
+        return setRoot(manager().getDifference(root, removed));
+    }
+
+    void clear() { root = FALSE; }
+
+    bool pointsTo(const Pointer &ptr) const {
+        auto ptrid = findPointerID(ptr);
+        return ptrid != 0 && manager().contains(root, ptrid);
+    }
+
+    bool mayPointTo(const Pointer &ptr) const {
+        return pointsTo(ptr) || pointsTo(Pointer(ptr.target, Offset::UNKNOWN));
+    }
+
+    bool mustPointTo(const Pointer &ptr) const {
+        assert(!ptr.offset.isUnknown() && "Makes no sense");
+        return pointsTo(ptr) && isSingleton();
+    }
+
+    bool pointsToTarget(PSNode *target) const {
+        for (const auto &ptr : *this) {
+            if (ptr.target == target) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool isSingleton() const { return size() == 1; }
+
+    bool empty() const { return root == FALSE; }
+
+    size_t count(const Pointer &ptr) const { return pointsTo(ptr); }
+
+    bool has(const Pointer &ptr) const { return count(ptr) > 0; }
+
+    bool hasUnknown() const { return pointsToTarget(UNKNOWN_MEMORY); }
+
+    bool hasNull() const { return pointsToTarget(NULLPTR); }
+
+    bool hasNullWithOffset() const {
+        for (const auto &ptr : *this) {
+            if (ptr.target == NULLPTR && *ptr.offset != 0) {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    bool hasInvalidated() const { return pointsToTarget(INVALIDATED); }
+
+    size_t size() const { return manager().size(root); }
+
+    // the diagrams are comparable only in the same table
+    bool operator==(const BddPointsToSet &rhs) const {
+        return root == rhs.root && _table == rhs._table;
+    }
+    bool operator!=(const BddPointsToSet &rhs) const {
+        return !operator==(rhs);
+    }
+
+    // the number of nodes of all the diagrams
+    static size_t getNumOfNodes() { return manager().getNumOfNodes(); }
+
+    // the diagrams are stored only in the shared table of nodes
+    size_t getMemoryUsage() const { return 0; }
+    static size_t getSharedMemoryUsage() {
+        return manager().getMemoryUsage();
+    }
+
+    // allow querying sets from multiple threads. The sets still must not
+    // be modified concurrently (the table of nodes is not thread-safe)
+    static void setConcurrent(bool b) {
+        PointerIDLookupTable::current().setConcurrent(b);
+    }
+
+    void swap(BddPointsToSet &rhs) {
+        std::swap(_table, rhs._table);
+        std::swap(root, rhs.root);
+    }
+
+    // iterates over the paths to TRUE in the diagram,
+    // i.e., over the pointer IDs in ascending order
+    class const_iterator {
+        struct Frame {
+            NodeID node;
+            unsigned level;
+            uint64_t prefix;
+        };
+
+        const PointerIDLookupTable *_table;
+        std::vector<Frame> stack;
+        uint64_t current{0};
+        bool atEnd{true};
+
+        void advance() {
+            const auto &M = manager();
+            while (!stack.empty()) {
+                Frame f = stack.back();
+                stack.pop_back();
+                if (f.node == FALSE)
+                    continue;
+                if (f.level == NUM_VARS) {
+                    assert(f.node == TRUE);
+                    current = f.prefix;
+                    atEnd = false;
+                    return;
+                }
+
+                // the variable may be skipped in the diagram,
+                // then both of its values lead to the same node
+                NodeID low = f.node;
+                NodeID high = f.node;
+                if (M.var(f.node) == f.level) {
+                    low = M.low(f.node);
+                    high = M.high(f.node);
+                }
+                uint64_t bit = uint64_t(1) << (NUM_VARS - 1 - f.level);
+                stack.push_back({high, f.level + 1, f.prefix | bit});
+                stack.push_back({low, f.level + 1, f.prefix});
+            }
+            atEnd = true;
+        }
+
+        const_iterator(const PointerIDLookupTable *table, NodeID root,
+                       bool end = false)
+                : _table(table) {
+            if (!end) {
+                stack.push_back({root, 0, 0});
+                advance();
+            }
+        }
+
+        uint64_t id() const { return current; }
+
+      public:
+        const_iterator &operator++() {
+            advance();
+            return *this;
+        }
+
+        const_iterator operator++(int) {
+            auto tmp = *this;
+            operator++();
+            return tmp;
+        }
+
+        Pointer operator*() const { return {_table->get(current)}; }
+
+        bool operator==(const const_iterator &rhs) const {
+            return atEnd == rhs.atEnd && (atEnd || current == rhs.current);
+        }
+
+        bool operator!=(const const_iterator &rhs) const {
+            return !operator==(rhs);
+        }
+
+        friend class BddPointsToSet;
+    };
+
+    const_iterator begin() const { return {_table, root}; }
+    const_iterator end() const { return {_table, root, true /* end */}; }
+
+    friend class const_iterator;
+};
+
+} // namespace pta
+} // namespace dg
+
+#endif // DG_BDDPOINTSTOSET_H
@@ -1,80 +1,219 @@
 #ifndef DG_PTSETS_LOOKUPTABLE_H_
 #define DG_PTSETS_LOOKUPTABLE_H_
 
+#include <atomic>
+#include <cassert>
+#include <cstdint>
 #include <map>
+#include <mutex>
 #include <vector>
 
-#if defined(HAVE_TSL_HOPSCOTCH) || (__clang__)
-#include "dg/ADT/HashMap.h"
-#else
-#include "dg/ADT/Map.h"
-#endif
-
 #include "dg/Offset.h"
 #include "dg/PointerAnalysis/Pointer.h"
 
 namespace dg {
 
+///
+// Mapping between pointers and dense numeric IDs (starting from 1) used
+// by the points-to sets that store pointers as IDs. The tables are owned
+// by pointer graphs (each graph has its own table that is freed with it).
+// A points-to set uses the table that was current in the thread when
+// the set was created (copies of the set use the same table).
+// The graphs make their table current while creating nodes and
+// the analyses make the table of their graph current while they run.
+// The pointers are stored in a flat open-addressing hash table keyed
+// by the ID of the target node and the offset.
+// When the concurrent access is enabled, only the lookup of IDs
+// of pointers is locked. The pointers are stored in chunks that
+// are never moved, so the pointer with a given ID (what the iterators
+// of the points-to sets ask for) is read without the lock.
 class PointerIDLookupTable {
   public:
     using IDTy = size_t;
     using Pointer = pta::Pointer;
     using PSNode = pta::PSNode;
-#if defined(HAVE_TSL_HOPSCOTCH) || (__clang__)
-    using PtrToIDMap = dg::HashMap<PSNode *, dg::HashMap<dg::Offset, IDTy>>;
-#else
-    // we create the lookup table statically and there is a bug in GCC
-    // that breaks statically created std::unordered_map.
-    // So if we have not Hopscotch map, use std::map instead.
-    using PtrToIDMap = dg::Map<PSNode *, dg::Map<dg::Offset, IDTy>>;
-#endif
+
+    PointerIDLookupTable() {
+        for (auto &chunk : _chunks)
+            chunk.store(nullptr, std::memory_order_relaxed);
+        // the pointers of the static nodes have the same IDs in all tables,
+        // so that the points-to sets of these nodes are valid in all tables
+        _getOrCreate(Pointer(pta::NULLPTR, 0));
+        _getOrCreate(Pointer(pta::UNKNOWN_MEMORY, Offset::UNKNOWN));
+    }
+
+    ~PointerIDLookupTable() {
+        for (auto &chunk : _chunks)
+            delete[] chunk.load(std::memory_order_relaxed);
+    }
+
+    PointerIDLookupTable(const PointerIDLookupTable &) = delete;
+    PointerIDLookupTable &operator=(const PointerIDLookupTable &) = delete;
 
     // this will get a new ID for the pointer if not present
     IDTy getOrCreate(const Pointer &ptr) {
-        auto res = get(ptr);
-        if (res != 0)
-            return res;
+        // the default table outlives all graphs, a pointer to a node
+        // of a graph would dangle there when the graph is destroyed
+        assert((this != &getDefault() || ptr.target == pta::NULLPTR ||
+                ptr.target == pta::UNKNOWN_MEMORY ||
+                ptr.target == pta::INVALIDATED) &&
+               "Pointer to a node of a graph in the default table, "
+               "use the table of the graph (PointerIDLookupTable::Scope)");
+        Guard guard(*this);
+        return _getOrCreate(ptr);
+    }
 
-        _idToPtr.push_back(ptr);
-        res = _idToPtr.size();
-#ifndef NDEBUG
-        bool r =
-#endif
-                _ptrToID[ptr.target].put(ptr.offset, res);
+    IDTy get(const Pointer &ptr) const {
+        Guard guard(*this);
+        return _slots.empty() ? 0 : _slots[_find(ptr)];
+    }
 
-        assert(r && "Duplicated ID!");
-        assert(get(res) == ptr);
-        assert(res == get(ptr));
-        assert(res > 0 && "ID must always be greater than 0");
-        return res;
+    // does not lock, the pointer with the ID never moves
+    const Pointer &get(IDTy id) const {
+        assert(id - 1 < size());
+        return _at(id - 1);
     }
 
-    IDTy get(const Pointer &ptr) const {
-        auto it = _ptrToID.find(ptr.target);
-        if (it == _ptrToID.end()) {
-            return 0; // invalid ID
+    // the number of pointers in the table
+    size_t size() const { return _size.load(std::memory_order_acquire); }
+
+    // Serialize the lookups of IDs of pointers, so that the table can be
+    // used from multiple threads. It is off by default, because locking
+    // slows down the sequential analysis.
+    void setConcurrent(bool b) { _concurrent = b; }
+
+    // the table used by points-to sets in this thread
+    static PointerIDLookupTable &current() {
+        return _current ? *_current : getDefault();
+    }
+
+    static void setCurrent(PointerIDLookupTable *T) { _current = T; }
+
+    // the table used when no other table was set, it is never destroyed
+    // (like the static nodes) and it may hold only the pointers
+    // to the static nodes
+    static PointerIDLookupTable &getDefault() {
+        static auto *T = new PointerIDLookupTable();
+        return *T;
+    }
+
+    // make the table current in this thread until the end of the scope
+    class Scope {
+        PointerIDLookupTable *_prev;
+
+      public:
+        Scope(PointerIDLookupTable &T) : _prev(_current) { _current = &T; }
+        ~Scope() { _current = _prev; }
+        Scope(const Scope &) = delete;
+        Scope &operator=(const Scope &) = delete;
+    };
+
+  private:
+    static thread_local PointerIDLookupTable *_current;
+
+    // the slots of the hash table hold IDs, 0 is an empty slot
+    std::vector<uint32_t> _slots;
+
+    // the pointers by IDs (the pointer with the ID 'id' is at 'id - 1').
+    // The chunk k has FIRST_CHUNK << k pointers, so that 32 chunks
+    // are enough for all the 32-bit IDs.
+    static const unsigned FIRST_CHUNK_BITS = 6;
+    static const size_t FIRST_CHUNK = size_t{1} << FIRST_CHUNK_BITS;
+    std::atomic<Pointer *> _chunks[32];
+    std::atomic<size_t> _size{0};
+
+    mutable std::mutex _mutex;
+    bool _concurrent{false};
+
+    // locks the table only when the concurrent access is enabled
+    class Guard {
+        std::unique_lock<std::mutex> _lock;
+
+      public:
+        Guard(const PointerIDLookupTable &T) : _lock(T._mutex, std::defer_lock) {
+            if (T._concurrent)
+                _lock.lock();
+        }
+    };
+
+    // the chunk with the n-th pointer and the position in the chunk
+    static unsigned _chunkOf(size_t n) {
+        return 63 - __builtin_clzll((n >> FIRST_CHUNK_BITS) + 1);
+    }
+
+    static size_t _posInChunk(size_t n, unsigned chunk) {
+        return n - ((size_t{1} << chunk) - 1) * FIRST_CHUNK;
+    }
+
+    const Pointer &_at(size_t n) const {
+        const auto chunk = _chunkOf(n);
+        return _chunks[chunk].load(std::memory_order_acquire)
+                [_posInChunk(n, chunk)];
+    }
+
+    // called with the lock held (if the access is concurrent)
+    void _append(const Pointer &ptr) {
+        const size_t n = _size.load(std::memory_order_relaxed);
+        const auto chunk = _chunkOf(n);
+        assert(chunk < 32 && "Too many pointers");
+        const size_t pos = _posInChunk(n, chunk);
+        Pointer *data = _chunks[chunk].load(std::memory_order_relaxed);
+        if (pos == 0) {
+            data = new Pointer[FIRST_CHUNK << chunk];
+            _chunks[chunk].store(data, std::memory_order_release);
         }
-        auto it2 = it->second.find(ptr.offset);
-        if (it2 == it->second.end())
+        data[pos] = ptr;
+        _size.store(n + 1, std::memory_order_release);
+    }
+
+    size_t _slotOf(const Pointer &ptr) const {
+        // Pointer::hash() is (node ID, offset), scatter it over the table
+        return (ptr.hash() * 0x9e3779b97f4a7c15ULL) >>
+               (64 - __builtin_ctzll(_slots.size()));
+    }
+
+    // the slot with the pointer or the empty slot where it belongs
+    size_t _find(const Pointer &ptr) const {
+        if (_slots.empty())
             return 0;
-        return it2->second;
+
+        const size_t mask = _slots.size() - 1;
+        size_t i = _slotOf(ptr);
+        while (_slots[i] != 0 && !(_at(_slots[i] - 1) == ptr))
+            i = (i + 1) & mask;
+        return i;
     }
 
-    const Pointer &get(IDTy id) const {
-        assert(id - 1 < _idToPtr.size());
-        return _idToPtr[id - 1];
+    void _grow() {
+        std::vector<uint32_t> slots(_slots.empty() ? 64 : 2 * _slots.size(),
+                                    0);
+        _slots.swap(slots);
+        const size_t mask = _slots.size() - 1;
+        for (auto id : slots) {
+            if (id == 0)
+                continue;
+            size_t i = _slotOf(_at(id - 1));
+            while (_slots[i] != 0)
+                i = (i + 1) & mask;
+            _slots[i] = id;
+        }
     }
 
-  private:
-    // PSNode -> (Offset -> id)
-    // Not space efficient, but we need mainly the time efficiency here...
-    // NOTE: unfortunately, atm, we cannot use the id of the target for hashing
-    // because it would break repeated runs of the analysis
-    // as multiple graphs will contain nodes with the same id
-    // (and resetting the state is really painful, I tried that,
-    // but just didn't succeed).
-    PtrToIDMap _ptrToID;
-    std::vector<Pointer> _idToPtr; // starts from 0 (pointer = idVector[id - 1])
+    IDTy _getOrCreate(const Pointer &ptr) {
+        // keep the load factor at most 1/2
+        if (2 * (size() + 1) > _slots.size())
+            _grow();
+
+        auto &slot = _slots[_find(ptr)];
+        if (slot != 0)
+            return slot;
+
+        _append(ptr);
+        assert(size() < (uint64_t{1} << 32) && "Too many pointers");
+        slot = static_cast<uint32_t>(size());
+        assert(slot > 0 && "ID must always be greater than 0");
+        return slot;
+    }
 };
 
 /*
@@ -3,10 +3,11 @@
 
 #include <cassert>
 #include <map>
+#include <utility>
 #include <vector>
 
 #include "LookupTable.h"
-#include "dg/ADT/Bitvector.h"
+#include "dg/ADT/HybridBitvector.h"
 #include "dg/PointerAnalysis/Pointer.h"
 
 namespace dg {
@@ -15,21 +16,26 @@ namespace pta {
 class PSNode;
 
 class PointerIdPointsToSet {
-    static PointerIDLookupTable lookupTable;
+    // the table of pointer IDs of the graph in which the set was created
+    PointerIDLookupTable *_table{&PointerIDLookupTable::current()};
 
-#if defined(HAVE_TSL_HOPSCOTCH) || (__clang__)
-    using PointersT = ADT::SparseBitvectorHashImpl;
-#else
-    using PointersT = ADT::SparseBitvector;
-#endif
+    using PointersT = ADT::HybridBitvector;
     PointersT pointers;
 
+    PointerIDLookupTable &lookupTable() const { return *_table; }
+
     // if the pointer doesn't have ID, it's assigned one
-    static size_t getPointerID(const Pointer &ptr) {
-        return lookupTable.getOrCreate(ptr);
+    size_t getPointerID(const Pointer &ptr) const {
+        return lookupTable().getOrCreate(ptr);
+    }
+
+    // the ID of the pointer or 0 if the pointer has no ID
+    // (then it is not in any set that uses the table)
+    size_t findPointerID(const Pointer &ptr) const {
+        return lookupTable().get(ptr);
     }
 
-    static const Pointer &getPointer(size_t id) { return lookupTable.get(id); }
+    const Pointer &getPointer(size_t id) const { return lookupTable().get(id); }
 
     bool addWithUnknownOffset(PSNode *node) {
         auto ptrid = getPointerID({node, Offset::UNKNOWN});
@@ -66,10 +72,21 @@ class PointerIdPointsToSet {
         return changed;
     }
 
-    bool add(const PointerIdPointsToSet &S) { return pointers.set(S.pointers); }
+    bool add(const PointerIdPointsToSet &S) {
+        if (S._table == _table)
+            return pointers.set(S.pointers);
+
+        // the set uses another table (e.g., a set of a static node),
+        // the IDs must be translated
+        bool changed = false;
+        for (const auto &ptr : S)
+            changed |= add(ptr);
+        return changed;
+    }
 
     bool remove(const Pointer &ptr) {
-        return pointers.unset(getPointerID(ptr));
+        auto ptrid = findPointerID(ptr);
+        return ptrid != 0 && pointers.unset(ptrid);
     }
 
     bool remove(PSNode *target, Offset offset) {
@@ -81,7 +98,7 @@ class PointerIdPointsToSet {
         tmp.reserve(pointers.size());
         bool removed = false;
         for (const auto &ptrID : pointers) {
-            if (lookupTable.get(ptrID).target != target) {
+            if (lookupTable().get(ptrID).target != target) {
                 tmp.set(ptrID);
             } else {
                 removed = true;
@@ -96,7 +113,8 @@ class PointerIdPointsToSet {
     void clear() { pointers.reset(); }
 
     bool pointsTo(const Pointer &ptr) const {
-        return pointers.get(getPointerID(ptr));
+        auto ptrid = findPointerID(ptr);
+        return ptrid != 0 && pointers.get(ptrid);
     }
 
     bool mayPointTo(const Pointer &ptr) const {
@@ -145,13 +163,29 @@ class PointerIdPointsToSet {
 
     size_t size() const { return pointers.size(); }
 
-    void swap(PointerIdPointsToSet &rhs) { pointers.swap(rhs.pointers); }
+    // the bytes allocated by this set
+    size_t getMemoryUsage() const { return pointers.getMemoryUsage(); }
+    // the sets do not share any memory
+    static size_t getSharedMemoryUsage() { return 0; }
+
+    // allow querying distinct sets from multiple threads
+    static void setConcurrent(bool b) {
+        PointerIDLookupTable::current().setConcurrent(b);
+    }
+
+    void swap(PointerIdPointsToSet &rhs) {
+        std::swap(_table, rhs._table);
+        pointers.swap(rhs.pointers);
+    }
 
     class const_iterator {
+        const PointerIDLookupTable *_table;
         typename PointersT::const_iterator container_it;
 
-        const_iterator(const PointersT &pointers, bool end = false)
-                : container_it(end ? pointers.end() : pointers.begin()) {}
+        const_iterator(const PointerIDLookupTable *table,
+                       const PointersT &pointers, bool end = false)
+                : _table(table),
+                  container_it(end ? pointers.end() : pointers.begin()) {}
 
       public:
         const_iterator &operator++() {
@@ -165,7 +199,7 @@ class PointerIdPointsToSet {
             return tmp;
         }
 
-        Pointer operator*() const { return {lookupTable.get(*container_it)}; }
+        Pointer operator*() const { return {_table->get(*container_it)}; }
 
         bool operator==(const const_iterator &rhs) const {
             return container_it == rhs.container_it;
@@ -178,8 +212,8 @@ class PointerIdPointsToSet {
         friend class PointerIdPointsToSet;
     };
 
-    const_iterator begin() const { return {pointers}; }
-    const_iterator end() const { return {pointers, true /* end */}; }
+    const_iterator begin() const { return {_table, pointers}; }
+    const_iterator end() const { return {_table, pointers, true /* end */}; }
 
     friend class const_iterator;
 };
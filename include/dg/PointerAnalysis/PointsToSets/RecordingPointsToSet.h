@@ -0,0 +1,170 @@
+#ifndef DG_RECORDINGPOINTSTOSET_H
+#define DG_RECORDINGPOINTSTOSET_H
+
+#include <cstdint>
+#include <initializer_list>
+#include <utility>
+
+#include "dg/PointerAnalysis/Pointer.h"
+#include "dg/PointerAnalysis/PointsToSetTrace.h"
+
+namespace dg {
+namespace pta {
+
+class PSNode;
+
+///
+// Points-to set that records the operations on it into the trace
+// that is being recorded by PointsToSetTraceWriter (if any)
+// and performs them on the underlying set 'SetT'. The operations
+// that do not change the set and are not recorded (size(), hasUnknown(),
+// ...) are inherited. The sets that existed before the recording
+// started are recorded together with their contents when they are used
+// for the first time. That happens also in const methods, so the sets
+// must not be used from multiple threads while recording (the parallel
+// solver of pointer analysis is turned off then).
+template <typename SetT>
+class RecordingPointsToSet : public SetT {
+    // the number of the set in the trace, 0 if not recorded
+    mutable uint64_t _set{0};
+
+    static PointsToSetTraceWriter *writer() {
+        return PointsToSetTraceWriter::get();
+    }
+
+    const SetT &base() const { return *this; }
+
+    uint64_t traced(PointsToSetTraceWriter *W) const {
+        if (_set == 0) {
+            _set = W->create();
+            for (const auto &ptr : base())
+                W->write(PointsToSetOp::ADD, _set, ptr);
+        }
+        return _set;
+    }
+
+    void record(PointsToSetOp op) const {
+        if (auto *W = writer())
+            W->write(op, traced(W));
+    }
+
+    void record(PointsToSetOp op, const RecordingPointsToSet &rhs) const {
+        if (auto *W = writer())
+            W->write(op, traced(W), rhs.traced(W));
+    }
+
+    void record(PointsToSetOp op, const Pointer &ptr) const {
+        if (auto *W = writer())
+            W->write(op, traced(W), ptr);
+    }
+
+  public:
+    RecordingPointsToSet() {
+        if (auto *W = writer())
+            _set = W->create();
+    }
+
+    RecordingPointsToSet(const std::initializer_list<Pointer> &elems)
+            : RecordingPointsToSet() {
+        add(elems);
+    }
+
+    RecordingPointsToSet(const RecordingPointsToSet &rhs) : SetT(rhs) {
+        if (auto *W = writer())
+            _set = W->create(PointsToSetOp::COPY, rhs.traced(W));
+    }
+
+    RecordingPointsToSet(RecordingPointsToSet &&rhs) noexcept
+            : SetT(std::move(rhs)) {
+        if (auto *W = writer()) {
+            // the contents of 'rhs' are gone if it was not recorded yet
+            if (rhs._set == 0)
+                traced(W);
+            else
+                _set = W->create(PointsToSetOp::MOVE, rhs._set);
+        }
+    }
+
+    RecordingPointsToSet &operator=(const RecordingPointsToSet &rhs) {
+        record(PointsToSetOp::ASSIGN, rhs);
+        SetT::operator=(rhs);
+        return *this;
+    }
+
+    RecordingPointsToSet &operator=(RecordingPointsToSet &&rhs) noexcept {
+        record(PointsToSetOp::MOVE_ASSIGN, rhs);
+        SetT::operator=(std::move(rhs));
+        return *this;
+    }
+
+    ~RecordingPointsToSet() {
+        if (_set != 0) {
+            if (auto *W = writer())
+                W->write(PointsToSetOp::DESTROY, _set);
+        }
+    }
+
+    bool add(PSNode *target, Offset off) { return add(Pointer(target, off)); }
+
+    bool add(const Pointer &ptr) {
+        record(PointsToSetOp::ADD, ptr);
+        return SetT::add(ptr);
+    }
+
+    template <typename ContainerTy>
+    bool add(const ContainerTy &C) {
+        bool changed = false;
+        for (const auto &ptr : C)
+            changed |= add(ptr);
+        return changed;
+    }
+
+    bool add(const RecordingPointsToSet &S) {
+        record(PointsToSetOp::ADD_SET, S);
+        return SetT::add(S.base());
+    }
+
+    bool remove(const Pointer &ptr) {
+        record(PointsToSetOp::REMOVE, ptr);
+        return SetT::remove(ptr);
+    }
+
+    bool remove(PSNode *target, Offset offset) {
+        return remove(Pointer(target, offset));
+    }
+
+    bool removeAny(PSNode *target) {
+        if (auto *W = writer())
+            W->write(PointsToSetOp::REMOVE_ANY, traced(W), target);
+        return SetT::removeAny(target);
+    }
+
+    void clear() {
+        record(PointsToSetOp::CLEAR);
+        SetT::clear();
+    }
+
+    bool pointsTo(const Pointer &ptr) const {
+        record(PointsToSetOp::POINTS_TO, ptr);
+        return SetT::pointsTo(ptr);
+    }
+
+    size_t count(const Pointer &ptr) const { return pointsTo(ptr); }
+
+    bool has(const Pointer &ptr) const { return pointsTo(ptr); }
+
+    void swap(RecordingPointsToSet &rhs) {
+        record(PointsToSetOp::SWAP, rhs);
+        SetT::swap(rhs);
+    }
+
+    typename SetT::const_iterator begin() const {
+        record(PointsToSetOp::ITERATE);
+        return SetT::begin();
+    }
+};
+
+} // namespace pta
+} // namespace dg
+
+#endif // DG_RECORDINGPOINTSTOSET_H
@@ -0,0 +1,484 @@
+#ifndef DG_SHAREDPOINTERIDPOINTSTOSET_H
+#define DG_SHAREDPOINTERIDPOINTSTOSET_H
+
+#include <cassert>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "LookupTable.h"
+#include "dg/ADT/HybridBitvector.h"
+#include "dg/PointerAnalysis/Pointer.h"
+
+namespace dg {
+namespace pta {
+
+class PSNode;
+
+///
+// Points-to set represented as a bitvector of pointer IDs (like
+// PointerIdPointsToSet), but equal bitvectors are hash-consed:
+// sets that are copied or merged into an empty set share one canonical
+// immutable bitvector and a set creates its own copy only when it diverges
+// (copy-on-write). Unions of two canonical bitvectors are memoized.
+// The canonical bitvectors are shared by sets of all graphs (a bitvector
+// is only a set of IDs, every set interprets it with its own table).
+class SharedPointerIdPointsToSet {
+
+    using PointersT = ADT::HybridBitvector;
+
+    // the canonical instance of a bitvector shared by equal sets
+    struct SharedPointers {
+        const PointersT pointers;
+        const size_t hash;
+        const size_t id;
+        size_t refcount{0};
+
+        SharedPointers(PointersT &&p, size_t h, size_t i)
+                : pointers(std::move(p)), hash(h), id(i) {}
+    };
+
+    // The interner is used by the sets of all graphs that may be analyzed
+    // in different threads, so all its operations are serialized.
+    class Interner {
+        struct PairHash {
+            size_t operator()(const std::pair<size_t, size_t> &p) const {
+                return p.first * 0x9e3779b97f4a7c15ULL ^ p.second;
+            }
+        };
+
+        // canonical bitvectors by their hash
+        std::unordered_map<size_t, std::vector<SharedPointers *>> _sets;
+        std::unordered_map<size_t, SharedPointers *> _byID;
+        // memoized unions: (id, id) -> id of the union. The results
+        // may have been released meanwhile, so we check them in _byID.
+        std::unordered_map<std::pair<size_t, size_t>, size_t, PairHash>
+                _unions;
+        size_t _lastID{0};
+
+        mutable std::mutex _mutex;
+        using Lock = std::lock_guard<std::mutex>;
+
+        SharedPointers *_intern(PointersT &pointers) {
+            assert(!pointers.empty() && "Interning an empty set");
+            auto hash = pointers.hash();
+            auto &bucket = _sets[hash];
+            for (auto *S : bucket) {
+                if (S->pointers == pointers)
+                    return S;
+            }
+
+            auto *S = new SharedPointers(std::move(pointers), hash, ++_lastID);
+            bucket.push_back(S);
+            _byID.emplace(S->id, S);
+            return S;
+        }
+
+      public:
+        // get the canonical instance of the bitvector (and retain it),
+        // 'pointers' may be moved to the instance
+        SharedPointers *intern(PointersT &pointers) {
+            Lock lock(_mutex);
+            auto *S = _intern(pointers);
+            ++S->refcount;
+            return S;
+        }
+
+        void retain(SharedPointers *S) {
+            Lock lock(_mutex);
+            ++S->refcount;
+        }
+
+        void release(SharedPointers *S) {
+            Lock lock(_mutex);
+            assert(S->refcount > 0);
+            if (--S->refcount > 0)
+                return;
+
+            auto it = _sets.find(S->hash);
+            assert(it != _sets.end());
+            auto &bucket = it->second;
+            for (auto bit = bucket.begin(), bet = bucket.end(); bit != bet;
+                 ++bit) {
+                if (*bit == S) {
+                    bucket.erase(bit);
+                    break;
+                }
+            }
+            if (bucket.empty())
+                _sets.erase(it);
+            _byID.erase(S->id);
+            delete S;
+        }
+
+        // get the canonical instance of the union (and retain it)
+        SharedPointers *getUnion(SharedPointers *A, SharedPointers *B) {
+            Lock lock(_mutex);
+            SharedPointers *U = _getUnion(A, B);
+            ++U->refcount;
+            return U;
+        }
+
+      private:
+        SharedPointers *_getUnion(SharedPointers *A, SharedPointers *B) {
+            if (A == B)
+                return A;
+
+            auto key = A->id < B->id ? std::make_pair(A->id, B->id)
+                                     : std::make_pair(B->id, A->id);
+            auto it = _unions.find(key);
+            if (it != _unions.end()) {
+                auto rit = _byID.find(it->second);
+                if (rit != _byID.end())
+                    return rit->second;
+            }
+
+            PointersT tmp = A->pointers;
+            SharedPointers *U = tmp.set(B->pointers) ? _intern(tmp) : A;
+
+            // do not let the memoized unions of released sets pile up
+            if (_unions.size() > 4 * _byID.size() + 1024)
+                _unions.clear();
+            _unions[key] = U->id;
+            return U;
+        }
+
+      public:
+        size_t size() const {
+            Lock lock(_mutex);
+            return _byID.size();
+        }
+
+        size_t getMemoryUsage() const {
+            Lock lock(_mutex);
+            size_t bytes = 0;
+            for (const auto &it : _byID)
+                bytes += sizeof(SharedPointers) +
+                         it.second->pointers.getMemoryUsage();
+            return bytes;
+        }
+    };
+
+    // the interner is never destroyed, as there are static nodes
+    // with points-to sets that may be destroyed after it
+    static Interner &interner() {
+        static auto *I = new Interner();
+        return *I;
+    }
+
+    // the table of pointer IDs of the graph in which the set was created
+    PointerIDLookupTable *_table{&PointerIDLookupTable::current()};
+    // the pointers of this set if it does not use the shared instance
+    mutable PointersT pointers;
+    mutable SharedPointers *shared{nullptr};
+
+    PointerIDLookupTable &lookupTable() const { return *_table; }
+
+    // if the pointer doesn't have ID, it's assigned one
+    size_t getPointerID(const Pointer &ptr) const {
+        return lookupTable().getOrCreate(ptr);
+    }
+
+    // the ID of the pointer or 0 if the pointer has no ID
+    // (then it is not in any set that uses the table)
+    size_t findPointerID(const Pointer &ptr) const {
+        return lookupTable().get(ptr);
+    }
+
+    const Pointer &getPointer(size_t id) const { return lookupTable().get(id); }
+
+    const PointersT &getPointers() const {
+        return shared ? shared->pointers : pointers;
+    }
+
+    // get pointers that can be modified (copy the shared instance if needed)
+    PointersT &getWritablePointers() {
+        if (shared) {
+            PointersT(shared->pointers).swap(pointers);
+            interner().release(shared);
+            shared = nullptr;
+        }
+        return pointers;
+    }
+
+    // get the canonical instance of the pointers of this set
+    SharedPointers *share() const {
+        if (!shared && !pointers.empty()) {
+            shared = interner().intern(pointers);
+            PointersT().swap(pointers);
+        }
+        return shared;
+    }
+
+    // use the instance that has been already retained for this set
+    void adoptShared(SharedPointers *S) {
+        if (shared)
+            interner().release(shared);
+        shared = S;
+        PointersT().swap(pointers);
+    }
+
+    void setShared(SharedPointers *S) {
+        if (S)
+            interner().retain(S);
+        adoptShared(S);
+    }
+
+    bool addWithUnknownOffset(PSNode *node) {
+        auto ptrid = getPointerID({node, Offset::UNKNOWN});
+        if (!getPointers().get(ptrid)) {
+            removeAny(node);
+            return !getWritablePointers().set(ptrid);
+        }
+        return false; // we already had it
+    }
+
+  public:
+    SharedPointerIdPointsToSet() = default;
+    explicit SharedPointerIdPointsToSet(
+            const std::initializer_list<Pointer> &elems) {
+        add(elems);
+    }
+
+    SharedPointerIdPointsToSet(const SharedPointerIdPointsToSet &rhs)
+            : _table(rhs._table) {
+        setShared(rhs.share());
+    }
+
+    SharedPointerIdPointsToSet(SharedPointerIdPointsToSet &&rhs) noexcept
+            : _table(rhs._table), pointers(std::move(rhs.pointers)),
+              shared(rhs.shared) {
+        rhs.shared = nullptr;
+    }
+
+    SharedPointerIdPointsToSet &
+    operator=(const SharedPointerIdPointsToSet &rhs) {
+        if (this != &rhs) {
+            _table = rhs._table;
+            setShared(rhs.share());
+        }
+        return *this;
+    }
+
+    SharedPointerIdPointsToSet &
+    operator=(SharedPointerIdPointsToSet &&rhs) noexcept {
+        swap(rhs);
+        return *this;
+    }
+
+    ~SharedPointerIdPointsToSet() {
+        if (shared)
+            interner().release(shared);
+    }
+
+    bool add(PSNode *target, Offset off) { return add(Pointer(target, off)); }
+
+    bool add(const Pointer &ptr) {
+        if (has({ptr.target, Offset::UNKNOWN})) {
+            return false;
+        }
+        if (ptr.offset.isUnknown()) {
+            return addWithUnknownOffset(ptr.target);
+        }
+
+        auto ptrid = getPointerID(ptr);
+        if (getPointers().get(ptrid))
+            return false;
+        return !getWritablePointers().set(ptrid);
+    }
+
+    template <typename ContainerTy>
+    bool add(const ContainerTy &C) {
+        bool changed = false;
+        for (const auto &ptr : C)
+            changed |= add(ptr);
+        return changed;
+    }
+
+    bool add(const SharedPointerIdPointsToSet &S) {
+        if (&S == this || S.empty())
+            return false;
+
+        if (S._table != _table) {
+            // the set uses another table (e.g., a set of a static node),
+            // the IDs must be translated
+            bool changed = false;
+            for (const auto &ptr : S)
+                changed |= add(ptr);
+            return changed;
+        }
+
+        // share the pointers until this set diverges
+        if (empty()) {
+            setShared(S.share());
+            return true;
+        }
+
+        if (shared) {
+            auto *U = interner().getUnion(shared, S.share());
+            if (U == shared) {
+                interner().release(U);
+                return false;
+            }
+            adoptShared(U);
+            return true;
+        }
+
+        return pointers.set(S.getPointers());
+    }
+
+    bool remove(const Pointer &ptr) {
+        auto ptrid = findPointerID(ptr);
+        if (ptrid == 0 || !getPointers().get(ptrid))
+            return false;
+        return getWritablePointers().unset(ptrid);
+    }
+
+    bool remove(PSNode *target, Offset offset) {
+        return remove(Pointer(target, offset));
+    }
+
+    bool removeAny(PSNode *target) {
+        if (!pointsToTarget(target))
+            return false;
+
+        PointersT tmp;
+        tmp.reserve(size());
+        for (const auto &ptrID : getPointers()) {
+            if (lookupTable().get(ptrID).target != target) {
+                tmp.set(ptrID);
+            }
+        }
+
+        setShared(nullptr);
+        tmp.swap(pointers);
+
+        return true;
+    }
+
+    void clear() { setShared(nullptr); }
+
+    bool pointsTo(const Pointer &ptr) const {
+        auto ptrid = findPointerID(ptr);
+        return ptrid != 0 && getPointers().get(ptrid);
+    }
+
+    bool mayPointTo(const Pointer &ptr) const {
+        return pointsTo(ptr) || pointsTo(Pointer(ptr.target, Offset::UNKNOWN));
+    }
+
+    bool mustPointTo(const Pointer &ptr) const {
+        assert(!ptr.offset.isUnknown() && "Makes no sense");
+        return pointsTo(ptr) && isSingleton();
+    }
+
+    bool pointsToTarget(PSNode *target) const {
+        for (auto ptrid : getPointers()) {
+            const auto &ptr = getPointer(ptrid);
+            if (ptr.target == target) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool isSingleton() const { return getPointers().size() == 1; }
+
+    bool empty() const { return getPointers().empty(); }
+
+    size_t count(const Pointer &ptr) const { return pointsTo(ptr); }
+
+    bool has(const Pointer &ptr) const { return count(ptr) > 0; }
+
+    bool hasUnknown() const { return pointsToTarget(UNKNOWN_MEMORY); }
+
+    bool hasNull() const { return pointsToTarget(NULLPTR); }
+
+    bool hasNullWithOffset() const {
+        for (auto ptrid : getPointers()) {
+            const auto &ptr = getPointer(ptrid);
+            if (ptr.target == NULLPTR && *ptr.offset != 0) {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    bool hasInvalidated() const { return pointsToTarget(INVALIDATED); }
+
+    size_t size() const { return getPointers().size(); }
+
+    // is the set using a shared canonical instance of the pointers?
+    bool isShared() const { return shared != nullptr; }
+
+    // the number of canonical instances of points-to sets
+    static size_t getNumOfSharedSets() { return interner().size(); }
+
+    // the bytes allocated by this set (without the shared instance)
+    size_t getMemoryUsage() const {
+        return shared ? 0 : pointers.getMemoryUsage();
+    }
+    // the bytes allocated by the shared instances of all sets
+    static size_t getSharedMemoryUsage() {
+        return interner().getMemoryUsage();
+    }
+
+    // allow querying distinct sets from multiple threads
+    static void setConcurrent(bool b) {
+        PointerIDLookupTable::current().setConcurrent(b);
+    }
+
+    void swap(SharedPointerIdPointsToSet &rhs) {
+        std::swap(_table, rhs._table);
+        pointers.swap(rhs.pointers);
+        std::swap(shared, rhs.shared);
+    }
+
+    class const_iterator {
+        const PointerIDLookupTable *_table;
+        typename PointersT::const_iterator container_it;
+
+        const_iterator(const PointerIDLookupTable *table,
+                       const PointersT &pointers, bool end = false)
+                : _table(table),
+                  container_it(end ? pointers.end() : pointers.begin()) {}
+
+      public:
+        const_iterator &operator++() {
+            container_it++;
+            return *this;
+        }
+
+        const_iterator operator++(int) {
+            auto tmp = *this;
+            operator++();
+            return tmp;
+        }
+
+        Pointer operator*() const { return {_table->get(*container_it)}; }
+
+        bool operator==(const const_iterator &rhs) const {
+            return container_it == rhs.container_it;
+        }
+
+        bool operator!=(const const_iterator &rhs) const {
+            return !operator==(rhs);
+        }
+
+        friend class SharedPointerIdPointsToSet;
+    };
+
+    const_iterator begin() const { return {_table, getPointers()}; }
+    const_iterator end() const {
+        return {_table, getPointers(), true /* end */};
+    }
+
+    friend class const_iterator;
+};
+
+} // namespace pta
+} // namespace dg
+
+#endif // DG_SHAREDPOINTERIDPOINTSTOSET_H
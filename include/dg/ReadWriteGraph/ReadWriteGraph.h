@@ -4,6 +4,7 @@
 #include <memory>
 #include <vector>
 
+#include "dg/ADT/Arena.h"
 #include "dg/BFS.h"
 #include "dg/ReadWriteGraph/RWBBlock.h"
 #include "dg/ReadWriteGraph/RWNode.h"
@@ -16,9 +17,12 @@ namespace dda {
 
 class ReadWriteGraph {
     size_t lastNodeID{0};
-    using NodesT = std::vector<std::unique_ptr<RWNode>>;
+    using NodesT = std::vector<ADT::ArenaPtr<RWNode>>;
     using SubgraphsT = std::vector<std::unique_ptr<RWSubgraph>>;
 
+    // the memory of the nodes, it is freed after '_nodes'
+    // destroys the nodes
+    ADT::Arena _arena;
     NodesT _nodes;
     SubgraphsT _subgraphs;
     RWSubgraph *_entry{nullptr};
@@ -77,9 +81,9 @@ class ReadWriteGraph {
 
     RWNode &create(RWNodeType t) {
         if (t == RWNodeType::CALL) {
-            _nodes.emplace_back(new RWNodeCall(++lastNodeID));
+            _nodes.emplace_back(_arena.create<RWNodeCall>(++lastNodeID));
         } else {
-            _nodes.emplace_back(new RWNode(++lastNodeID, t));
+            _nodes.emplace_back(_arena.create<RWNode>(++lastNodeID, t));
         }
         return *_nodes.back().get();
     }
@@ -62,6 +62,9 @@ class SubgraphNode {
     // size of the memory
     size_t size{0};
 
+    // the graphs renumber the nodes that were built apart from them
+    void setID(IDType newID) { id = newID; }
+
   public:
     SubgraphNode(IDType id) : id(id) {}
 #ifndef NDEBUG
@@ -136,6 +139,13 @@ class SubgraphNode {
         operands.clear();
     }
 
+    // remove all occurrences of the node from the operands
+    void removeOperand(NodeT *op) {
+        operands.erase(std::remove(operands.begin(), operands.end(), op),
+                       operands.end());
+        op->removeUser(static_cast<NodeT *>(this));
+    }
+
     template <typename NodePtr, typename... Args>
     size_t addOperand(NodePtr node, Args &&...args) {
         addOperand(node);
@@ -151,12 +161,35 @@ class SubgraphNode {
                       "class.");
         assert(n && "Passed nullptr as the operand");
         operands.push_back(n);
-        n->addUser(static_cast<NodeT *>(this));
-        assert(!n->users.empty());
+        if (!_deferUsers) {
+            n->addUser(static_cast<NodeT *>(this));
+            assert(!n->users.empty());
+        }
 
         return operands.size();
     }
 
+    // While an object of this class lives, addOperand() in this thread
+    // does not register the node as a user of the operand, because
+    // the operand may be shared with other threads (e.g., when building
+    // parts of a graph in parallel). The users must be registered
+    // later by registerUsers().
+    class DeferUsers {
+        bool _prev;
+
+      public:
+        DeferUsers() : _prev(_deferUsers) { _deferUsers = true; }
+        ~DeferUsers() { _deferUsers = _prev; }
+        DeferUsers(const DeferUsers &) = delete;
+        DeferUsers &operator=(const DeferUsers &) = delete;
+    };
+
+    // register the node as a user of its operands
+    void registerUsers() {
+        for (NodeT *op : operands)
+            op->addUser(static_cast<NodeT *>(this));
+    }
+
     bool hasOperand(NodeT *n) const {
         return dg::any_of(operands, [n](NodeT* x) { return x == n; });
     }
@@ -328,6 +361,23 @@ class SubgraphNode {
         _predecessors.clear();
     }
 
+    // Remove all edges from and to this node. Unlike isolate(),
+    // the predecessors are not connected to the successors.
+    void removeAllEdges() {
+        for (NodeT *succ : _successors)
+            _removeThisFromSuccessorsPredecessors(succ);
+
+        for (NodeT *pred : _predecessors) {
+            auto &succs = pred->_successors;
+            succs.erase(std::remove(succs.begin(), succs.end(),
+                                    static_cast<NodeT *>(this)),
+                        succs.end());
+        }
+
+        _successors.clear();
+        _predecessors.clear();
+    }
+
     void replaceAllUsesWith(NodeT *nd, bool removeDupl = true) {
         assert(nd != this && "Replacing uses of 'this' with 'this'");
 
@@ -364,6 +414,8 @@ class SubgraphNode {
 #endif
 
   private:
+    static thread_local bool _deferUsers;
+
     void _removeThisFromSuccessorsPredecessors(NodeT *succ) {
         std::vector<NodeT *> tmp;
         tmp.reserve(succ->predecessorsNum());
@@ -416,6 +468,9 @@ class SubgraphNode {
     }
 };
 
+template <typename NodeT>
+thread_local bool SubgraphNode<NodeT>::_deferUsers = false;
+
 } // namespace dg
 
 #endif
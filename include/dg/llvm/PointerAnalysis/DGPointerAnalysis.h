@@ -189,7 +189,7 @@ class DGLLVMPointerAnalysis : public LLVMPointerAnalysis {
             return {false, LLVMPointsToSet(getUnknownPTSet())};
     }
 
-    const std::vector<std::unique_ptr<PSNode>> &getNodes() {
+    const PointerGraph::NodesT &getNodes() {
         return PS->getNodes();
     }
 
@@ -4,17 +4,53 @@
 #include "dg/PointerAnalysis/PointerAnalysisOptions.h"
 #include "dg/llvm/LLVMAnalysisOptions.h"
 
+#include <string>
+
 namespace dg {
 
 struct LLVMPointerAnalysisOptions : public LLVMAnalysisOptions,
                                     PointerAnalysisOptions {
-    enum class AnalysisType { fi, fs, inv, svf } analysisType{AnalysisType::fi};
+    // sfs is flow-sensitive analysis staged on the results of fi,
+    // demand is fi that computes points-to sets only when queried,
+    // steensgaard is the (less precise) unification-based analysis
+    enum class AnalysisType {
+        fi,
+        fs,
+        inv,
+        sfs,
+        demand,
+        steensgaard,
+        svf
+    } analysisType{AnalysisType::fi};
 
     bool threads{false};
 
+    // The number of threads that build the pointer graphs of functions.
+    // The graph (including the IDs of nodes) is the same with any number
+    // of threads. Not used with 'threads' (the graph of a program
+    // with threads is built in one thread).
+    unsigned buildThreads{1};
+
+    // Optimize the pointer graph before running the analysis
+    // (remove no-op nodes and merge nodes that provably
+    // have the same points-to sets)
+    bool optimizeGraph{false};
+
+    // The file with the results of the analysis. If it contains the
+    // results for the same module and options, the analysis is not run
+    // and the results are taken from the file. Otherwise, the results
+    // are stored into the file after the analysis finishes.
+    // Not used with threads (the analysis of threads needs the graph).
+    std::string snapshotPath{};
+
     bool isFS() const { return analysisType == AnalysisType::fs; }
     bool isFSInv() const { return analysisType == AnalysisType::inv; }
     bool isFI() const { return analysisType == AnalysisType::fi; }
+    bool isSFS() const { return analysisType == AnalysisType::sfs; }
+    bool isDemand() const { return analysisType == AnalysisType::demand; }
+    bool isSteensgaard() const {
+        return analysisType == AnalysisType::steensgaard;
+    }
     bool isSVF() const { return analysisType == AnalysisType::svf; }
 };
 
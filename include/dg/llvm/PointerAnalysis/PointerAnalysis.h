@@ -1,23 +1,33 @@
 #ifndef LLVM_DG_POINTS_TO_ANALYSIS_H_
 #define LLVM_DG_POINTS_TO_ANALYSIS_H_
 
+#include <algorithm>
 #include <memory>
+#include <set>
+#include <tuple>
+#include <unordered_map>
 #include <utility>
+#include <vector>
 
 #include <llvm/IR/DataLayout.h>
 #include <llvm/IR/Function.h>
 #include <llvm/Support/raw_ostream.h>
 
+#include "dg/PointerAnalysis/AliasCache.h"
 #include "dg/PointerAnalysis/Pointer.h"
 #include "dg/PointerAnalysis/PointerAnalysis.h"
+#include "dg/PointerAnalysis/PointerAnalysisDemand.h"
 #include "dg/PointerAnalysis/PointerAnalysisFI.h"
 #include "dg/PointerAnalysis/PointerAnalysisFS.h"
 #include "dg/PointerAnalysis/PointerAnalysisFSInv.h"
+#include "dg/PointerAnalysis/PointerAnalysisSFS.h"
+#include "dg/PointerAnalysis/PointerAnalysisSteensgaard.h"
 #include "dg/PointerAnalysis/PointerGraph.h"
 #include "dg/PointerAnalysis/PointerGraphOptimizations.h"
 
 #include "dg/llvm/PointerAnalysis/LLVMPointerAnalysisOptions.h"
 #include "dg/llvm/PointerAnalysis/LLVMPointsToSet.h"
+#include "dg/llvm/PointerAnalysis/PointerAnalysisSnapshot.h"
 #include "dg/llvm/PointerAnalysis/PointerGraph.h"
 
 namespace dg {
@@ -76,6 +86,31 @@ class LLVMPointerAnalysis {
     std::pair<bool, LLVMMemoryRegionSet>
     getAccessedMemory(const llvm::Instruction *I);
 
+    // the access of 'size' bytes of memory via the pointer 'ptr'
+    struct MemoryAccess {
+        const llvm::Value *ptr;
+        Offset size;
+    };
+
+    ///
+    // May the memory of 'size1' bytes accessed via 'v1' overlap
+    // the memory of 'size2' bytes accessed via 'v2'? The unknown size
+    // (or 0) means that the access may span the rest of the object.
+    // Null and invalidated memory is not taken into account, the values
+    // without points-to sets may alias with anything.
+    virtual bool alias(const llvm::Value *v1, Offset size1,
+                       const llvm::Value *v2, Offset size2);
+
+    // Answer alias() for all the pairs of accesses at once.
+    // The i-th element of the result is the answer for the i-th pair.
+    virtual std::vector<bool>
+    aliasAll(const std::vector<std::pair<MemoryAccess, MemoryAccess>> &pairs);
+
+    // may the access alias with any of the accesses?
+    // (stops at the first access that may alias)
+    virtual bool mayAliasAny(const MemoryAccess &access,
+                             const std::vector<MemoryAccess> &accesses);
+
     virtual bool run() = 0;
 
     virtual ~LLVMPointerAnalysis() = default;
@@ -120,15 +155,20 @@ class DGLLVMPointerAnalysisImpl : public PTType {
             return false;
         }
 
+#ifndef NDEBUG
+        const auto firstNode = builder->getPS()->getNodes().size();
+#endif // NDEBUG
+
         builder->insertFunctionCall(callsite, called);
 
         // call the original handler that works on generic graphs
         PTType::functionPointerCall(callsite, called);
 
 #ifndef NDEBUG
-        // check the graph after rebuilding, but do not check for connectivity,
-        // because we can call a function that will disconnect the graph
-        if (!builder->validateSubgraph(true)) {
+        // check the new nodes after rebuilding, but do not check for
+        // connectivity, because we can call a function that will
+        // disconnect the graph
+        if (!builder->validateSubgraph(true, firstNode)) {
             llvm::errs() << "Pointer Subgraph is broken!\n";
             llvm::errs() << "This happend after building this function called "
                             "via pointer: "
@@ -147,13 +187,18 @@ class DGLLVMPointerAnalysisImpl : public PTType {
         assert(called->getType() == PSNodeType::FUNCTION &&
                "The called value is not a function");
 
+#ifndef NDEBUG
+        const auto firstNode = builder->getPS()->getNodes().size();
+#endif // NDEBUG
+
         PSNodeFork *fork = PSNodeFork::get(forkNode);
         builder->addFunctionToFork(called, fork);
 
 #ifndef NDEBUG
-        // check the graph after rebuilding, but do not check for connectivity,
-        // because we can call a function that will disconnect the graph
-        if (!builder->validateSubgraph(true)) {
+        // check the new nodes after rebuilding, but do not check for
+        // connectivity, because we can call a function that will
+        // disconnect the graph
+        if (!builder->validateSubgraph(true, firstNode)) {
             const llvm::Function *F = llvm::cast<llvm::Function>(
                     called->getUserData<llvm::Value>());
             llvm::errs() << "Pointer Subgraph is broken!\n";
@@ -176,6 +221,21 @@ class DGLLVMPointerAnalysis : public LLVMPointerAnalysis {
     PointerGraph *PS = nullptr;
     std::unique_ptr<pta::PointerAnalysis> PTA{}; // dg pointer analysis object
     std::unique_ptr<LLVMPointerGraphBuilder> _builder;
+    // the analysis in PTA if it computes the points-to sets on demand
+    pta::PointerAnalysisDemand *demandPTA{nullptr};
+    // the results loaded from a file instead of running the analysis
+    std::unique_ptr<LLVMPointerAnalysisSnapshot> _snapshot;
+    // the answers to alias queries for the current results
+    pta::AliasCache _aliasCache;
+
+    // get the node with the points-to set of the value,
+    // computing the points-to set if the analysis is demand-driven
+    PSNode *getSolvedNode(const llvm::Value *val) {
+        auto *node = getPointsToNode(val);
+        if (node && demandPTA)
+            demandPTA->query(node);
+        return node;
+    }
 
     static LLVMPointerAnalysisOptions createOptions(const char *entry_func,
                                                     uint64_t field_sensitivity,
@@ -220,7 +280,9 @@ class DGLLVMPointerAnalysis : public LLVMPointerAnalysis {
     bool threads() const { return _builder->threads(); }
 
     bool hasPointsTo(const llvm::Value *val) override {
-        if (auto *node = getPointsToNode(val)) {
+        if (_snapshot)
+            return _snapshot->hasPointsTo(val);
+        if (auto *node = getSolvedNode(val)) {
             return !node->pointsTo.empty();
         }
         return false;
@@ -234,8 +296,10 @@ class DGLLVMPointerAnalysis : public LLVMPointerAnalysis {
     // and hasNull() that reflect whether the points-to set of the
     // LLVM value contains unknown element of null.
     LLVMPointsToSet getLLVMPointsTo(const llvm::Value *val) override {
+        if (_snapshot)
+            return _snapshot->getLLVMPointsTo(val);
         DGLLVMPointsToSet *pts;
-        if (auto *node = getPointsToNode(val)) {
+        if (auto *node = getSolvedNode(val)) {
             if (node->pointsTo.empty()) {
                 pts = new DGLLVMPointsToSet(getUnknownPTSet());
             } else {
@@ -254,8 +318,10 @@ class DGLLVMPointerAnalysis : public LLVMPointerAnalysis {
     // unknown element when the node does not exists)
     std::pair<bool, LLVMPointsToSet>
     getLLVMPointsToChecked(const llvm::Value *val) override {
+        if (_snapshot)
+            return _snapshot->getLLVMPointsToChecked(val);
         DGLLVMPointsToSet *pts;
-        if (auto *node = getPointsToNode(val)) {
+        if (auto *node = getSolvedNode(val)) {
             if (node->pointsTo.empty()) {
                 pts = new DGLLVMPointsToSet(getUnknownPTSet());
                 return {false, pts->toLLVMPointsToSet()};
@@ -268,7 +334,100 @@ class DGLLVMPointerAnalysis : public LLVMPointerAnalysis {
         return {false, pts->toLLVMPointsToSet()};
     }
 
-    const std::vector<std::unique_ptr<PSNode>> &getNodes() {
+    bool alias(const llvm::Value *v1, Offset size1, const llvm::Value *v2,
+               Offset size2) override {
+        if (_snapshot)
+            return LLVMPointerAnalysis::alias(v1, size1, v2, size2);
+
+        auto *n1 = getSolvedNode(v1);
+        auto *n2 = getSolvedNode(v2);
+        if (!n1 || !n2)
+            return true;
+        return _aliasCache.alias(n1, size1, n2, size2);
+    }
+
+    // The pairs are grouped by their nodes: every value is mapped
+    // to its node (and solved on demand) once, the queries are sorted
+    // by the nodes and every distinct query is answered once
+    // (the bitvectors of targets of nodes are reused in the cache).
+    std::vector<bool> aliasAll(
+            const std::vector<std::pair<MemoryAccess, MemoryAccess>> &pairs)
+            override {
+        if (_snapshot)
+            return LLVMPointerAnalysis::aliasAll(pairs);
+
+        std::unordered_map<const llvm::Value *, PSNode *> nodes;
+        auto getNode = [&](const llvm::Value *val) {
+            auto it = nodes.find(val);
+            if (it == nodes.end())
+                it = nodes.emplace(val, getSolvedNode(val)).first;
+            return it->second;
+        };
+
+        struct Query {
+            PSNode *n1;
+            Offset::type size1;
+            PSNode *n2;
+            Offset::type size2;
+            size_t idx;
+
+            std::tuple<PSNode *, PSNode *, Offset::type, Offset::type>
+            key() const {
+                return std::make_tuple(n1, n2, size1, size2);
+            }
+        };
+
+        // the values without nodes may alias with anything
+        std::vector<bool> result(pairs.size(), true);
+        std::vector<Query> queries;
+        queries.reserve(pairs.size());
+        for (size_t i = 0; i < pairs.size(); ++i) {
+            const auto &first = pairs[i].first;
+            const auto &second = pairs[i].second;
+            auto *n1 = getNode(first.ptr);
+            auto *n2 = getNode(second.ptr);
+            if (!n1 || !n2)
+                continue;
+            // the query is symmetric
+            if (n2 < n1)
+                queries.push_back({n2, *second.size, n1, *first.size, i});
+            else
+                queries.push_back({n1, *first.size, n2, *second.size, i});
+        }
+
+        std::sort(queries.begin(), queries.end(),
+                  [](const Query &a, const Query &b) {
+                      return a.key() < b.key();
+                  });
+        for (size_t i = 0; i < queries.size(); ++i) {
+            const auto &Q = queries[i];
+            if (i > 0 && queries[i - 1].key() == Q.key())
+                result[Q.idx] = result[queries[i - 1].idx];
+            else
+                result[Q.idx] = _aliasCache.alias(Q.n1, Q.size1, Q.n2,
+                                                  Q.size2);
+        }
+        return result;
+    }
+
+    bool mayAliasAny(const MemoryAccess &access,
+                     const std::vector<MemoryAccess> &accesses) override {
+        if (_snapshot)
+            return LLVMPointerAnalysis::mayAliasAny(access, accesses);
+
+        auto *n1 = getSolvedNode(access.ptr);
+        if (!n1)
+            return !accesses.empty();
+
+        for (const auto &other : accesses) {
+            auto *n2 = getSolvedNode(other.ptr);
+            if (!n2 || _aliasCache.alias(n1, access.size, n2, other.size))
+                return true;
+        }
+        return false;
+    }
+
+    const PointerGraph::NodesT &getNodes() {
         return PS->getNodes();
     }
 
@@ -292,16 +451,23 @@ class DGLLVMPointerAnalysis : public LLVMPointerAnalysis {
             abort();
         }
 
-        /*
-        pta::PointerGraphOptimizer optimizer(PS);
+        if (options.optimizeGraph)
+            optimizeSubgraph();
+    }
+
+    void optimizeSubgraph() {
+        const bool flowInsensitive = options.isFI() || options.isDemand() ||
+                                     options.isSteensgaard();
+        pta::PointerGraphOptimizer optimizer(PS, flowInsensitive);
+        // formal arguments get new operands when
+        // a function is called via a pointer
+        for (PSNode *nd : _builder->getArgumentNodes())
+            optimizer.pin(nd);
+
         optimizer.run();
 
         if (optimizer.getNumOfRemovedNodes() > 0)
             _builder->composeMapping(std::move(optimizer.getMapping()));
-
-        llvm::errs() << "PS optimization removed " <<
-        optimizer.getNumOfRemovedNodes() << " nodes\n";
-        */
     }
 
     void initialize() {
@@ -309,7 +475,11 @@ class DGLLVMPointerAnalysis : public LLVMPointerAnalysis {
             _builder->setInvalidateNodesFlag(true);
 
         buildSubgraph();
+        createAnalysis();
+    }
 
+    void createAnalysis() {
+        demandPTA = nullptr;
         if (options.isFS()) {
             // FIXME: make a interface with run() method
             PTA.reset(new DGLLVMPointerAnalysisImpl<pta::PointerAnalysisFS>(
@@ -320,6 +490,19 @@ class DGLLVMPointerAnalysis : public LLVMPointerAnalysis {
         } else if (options.isFSInv()) {
             PTA.reset(new DGLLVMPointerAnalysisImpl<pta::PointerAnalysisFSInv>(
                     PS, _builder.get(), options));
+        } else if (options.isSFS()) {
+            PTA.reset(new DGLLVMPointerAnalysisImpl<pta::PointerAnalysisSFS>(
+                    PS, _builder.get(), options));
+        } else if (options.isDemand()) {
+            auto *demand =
+                    new DGLLVMPointerAnalysisImpl<pta::PointerAnalysisDemand>(
+                            PS, _builder.get(), options);
+            demandPTA = demand;
+            PTA.reset(demand);
+        } else if (options.isSteensgaard()) {
+            PTA.reset(new DGLLVMPointerAnalysisImpl<
+                      pta::PointerAnalysisSteensgaard>(PS, _builder.get(),
+                                                       options));
         } else {
             assert(0 && "Wrong pointer analysis");
             abort();
@@ -327,9 +510,117 @@ class DGLLVMPointerAnalysis : public LLVMPointerAnalysis {
     }
 
     bool run() override {
+        if (_snapshot)
+            return true;
+
+        _aliasCache.clear();
+
+        const bool useSnapshot =
+                !options.snapshotPath.empty() && !options.threads;
+        if (!PTA && useSnapshot && loadSnapshot(options.snapshotPath))
+            return true;
+
+        if (!PTA) {
+            initialize();
+        }
+        bool ret = PTA->run();
+
+        if (useSnapshot && !saveSnapshot(options.snapshotPath)) {
+            llvm::errs() << "Failed saving the results of pointer analysis "
+                            "to "
+                         << options.snapshotPath << "\n";
+        }
+        return ret;
+    }
+
+    ///
+    // Take the results from the snapshot in the file instead of running
+    // the analysis. Returns false if the file is not a snapshot for this
+    // module and options. With the results from a snapshot, the pointer
+    // graph is not built (getPS() and getPTA() return nullptr).
+    bool loadSnapshot(const std::string &path) {
+        _aliasCache.clear();
+        _snapshot = LLVMPointerAnalysisSnapshot::load(
+                path, _builder->getModule(), options);
+        return _snapshot != nullptr;
+    }
+
+    // store the results of the analysis into the file
+    bool saveSnapshot(const std::string &path) {
+        assert(PTA && !_snapshot && "Have no results to store");
+        return LLVMPointerAnalysisSnapshot::save(
+                path, _builder->getModule(), options,
+                [this](const llvm::Value *val) -> PSNode * {
+                    auto *node = _builder->getPointsToNodeOrNull(val);
+                    if (node && demandPTA)
+                        demandPTA->query(node);
+                    return node;
+                });
+    }
+
+    bool isFromSnapshot() const { return _snapshot != nullptr; }
+
+    ///
+    // Update the results after the module was edited. 'changed' are
+    // the functions whose bodies changed or that were added, 'removed'
+    // are the functions that were removed from the module (these are
+    // used only as keys, so they may be already destroyed).
+    // Only the subgraphs of the edited functions are rebuilt and the
+    // analysis starts from the previous results: the points-to sets
+    // that were computed from the removed nodes are computed anew,
+    // other points-to sets are kept. The results are sound, but may
+    // be less precise than the results of a new analysis, as they may
+    // keep pointers that were stored to memory only by the removed code.
+    // The memory of the old analysis may refer to the removed nodes,
+    // so it is dropped and the fixpoint is computed over the whole graph
+    // again (only the kept points-to sets make it faster). Keeping
+    // the memory of the surviving subgraphs and queueing only the affected
+    // nodes would need the memory purged of the removed nodes first.
+    // If the edit cannot be handled incrementally (the entry function
+    // changed, threads, optimized graph), the analysis runs from scratch.
+    bool update(const std::set<const llvm::Function *> &changed,
+                const std::set<const llvm::Function *> &removed = {}) {
+        _aliasCache.clear();
         if (!PTA) {
+            // the snapshot is for the module before the edit
+            _snapshot.reset();
+            return run();
+        }
+
+        const auto *M = _builder->getModule();
+        bool incremental = !options.threads && !options.optimizeGraph;
+        const auto *entry = M->getFunction(options.entryFunction);
+        if (changed.count(entry) > 0 || removed.count(entry) > 0)
+            incremental = false;
+        for (const auto *F : changed) {
+            if (F->isDeclaration())
+                incremental = false;
+        }
+
+        // the memory of the analysis may refer to the removed nodes
+        PTA.reset();
+        demandPTA = nullptr;
+
+        if (!incremental) {
+            _builder.reset(new LLVMPointerGraphBuilder(M, options));
             initialize();
+            // the static nodes may still have the data of the old analysis
+            PS->clearNodesData();
+            return PTA->run();
         }
+
+        auto affected = _builder->updateFunctions(changed, removed);
+        PS->invalidatePointsTo(affected);
+        PS->clearNodesData();
+
+#ifndef NDEBUG
+        if (!_builder->validateSubgraph(true)) {
+            llvm::errs() << "Pointer Subgraph is broken after update!\n";
+            abort();
+        }
+#endif // NDEBUG
+
+        createAnalysis();
         return PTA->run();
     }
 };
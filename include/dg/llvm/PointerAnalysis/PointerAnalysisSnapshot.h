@@ -0,0 +1,115 @@
+#ifndef DG_LLVM_POINTER_ANALYSIS_SNAPSHOT_H_
+#define DG_LLVM_POINTER_ANALYSIS_SNAPSHOT_H_
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <llvm/IR/Module.h>
+#include <llvm/IR/Value.h>
+#include <llvm/Support/MemoryBuffer.h>
+
+#include "dg/llvm/PointerAnalysis/LLVMPointerAnalysisOptions.h"
+#include "dg/llvm/PointerAnalysis/LLVMPointsToSet.h"
+
+namespace dg {
+
+namespace pta {
+class PSNode;
+}
+
+///
+// Results of the pointer analysis stored in a file, so that later
+// runs over the same module can skip the analysis.
+//
+// The values are identified by their position in a fixed enumeration
+// of the module: globals, functions and then the arguments, the
+// instructions and the constant expressions used by the instructions
+// of every defined function. The file contains a table of all pointers
+// (the index of the target and the offset) that occur in the results
+// and the points-to sets as sorted lists of indices into this table
+// (delta-encoded as varints). Every value refers to its points-to set,
+// equal sets are stored only once.
+//
+// The file is mapped into memory when loaded, only its header
+// is checked and the points-to sets are decoded when queried.
+// The snapshot is valid only for the module with the same content
+// and for the same options that affect the results. It is written
+// in the byte order of the host.
+class LLVMPointerAnalysisSnapshot {
+  public:
+    // get the node with the points-to set of the value or nullptr
+    using GetNodeT = std::function<pta::PSNode *(const llvm::Value *)>;
+
+    static const uint32_t VERSION = 1;
+
+    // special targets of the pointers
+    static const uint32_t NULL_TARGET = ~0U;
+    static const uint32_t UNKNOWN_TARGET = ~0U - 1;
+    static const uint32_t INVALIDATED_TARGET = ~0U - 2;
+
+    struct Entry {
+        // nullptr for the special targets
+        llvm::Value *value;
+        uint32_t target;
+        Offset offset;
+    };
+
+  private:
+    std::unique_ptr<llvm::MemoryBuffer> _buffer;
+    // the enumerated values of the module
+    std::vector<const llvm::Value *> _values;
+    std::unordered_map<const llvm::Value *, uint32_t> _indices;
+
+    // the sections of the mapped file
+    const char *_valueSets{nullptr};
+    const char *_pointers{nullptr};
+    const char *_setOffsets{nullptr};
+    const char *_data{nullptr};
+    uint32_t _pointersNum{0};
+    uint32_t _setsNum{0};
+    uint64_t _dataSize{0};
+
+    LLVMPointerAnalysisSnapshot() = default;
+
+    bool decode(uint32_t set, std::vector<Entry> &ptrs) const;
+    // Get the points-to set of the value. Returns false
+    // if the analysis has no points-to set for the value.
+    bool getPointers(const llvm::Value *val, std::vector<Entry> &ptrs) const;
+
+  public:
+    ///
+    // Store the results of the analysis for the module into the file.
+    // 'getNode' gives the node with the points-to set of a value.
+    static bool save(const std::string &path, const llvm::Module *M,
+                     const LLVMPointerAnalysisOptions &opts,
+                     const GetNodeT &getNode);
+
+    ///
+    // Map the file into memory. Returns nullptr if the file does not
+    // exist or if it is not a snapshot for the module and the options.
+    static std::unique_ptr<LLVMPointerAnalysisSnapshot>
+    load(const std::string &path, const llvm::Module *M,
+         const LLVMPointerAnalysisOptions &opts);
+
+    static uint64_t hashModule(const llvm::Module *M);
+    static uint64_t hashOptions(const LLVMPointerAnalysisOptions &opts);
+
+    // the same as the methods of LLVMPointerAnalysis
+    bool hasPointsTo(const llvm::Value *val) const;
+    LLVMPointsToSet getLLVMPointsTo(const llvm::Value *val) const;
+    std::pair<bool, LLVMPointsToSet>
+    getLLVMPointsToChecked(const llvm::Value *val) const;
+
+    size_t getValuesNum() const { return _values.size(); }
+    size_t getPointersNum() const { return _pointersNum; }
+    size_t getSetsNum() const { return _setsNum; }
+};
+
+} // namespace dg
+
+#endif // DG_LLVM_POINTER_ANALYSIS_SNAPSHOT_H_
@@ -1,7 +1,10 @@
 #ifndef LLVM_DG_POINTER_SUBGRAPH_H_
 #define LLVM_DG_POINTER_SUBGRAPH_H_
 
+#include <memory>
+#include <set>
 #include <unordered_map>
+#include <vector>
 
 #include <llvm/IR/Constants.h>
 #include <llvm/IR/DataLayout.h>
@@ -87,6 +90,8 @@ class LLVMPointerGraphBuilder {
         NodesT::const_iterator end() const { return _nodes.end(); }
     };
 
+    using NodesMapT = std::unordered_map<const llvm::Value *, PSNodesSeq>;
+
     class PSNodesBlock {
         using NodesT = std::vector<PSNodesSeq *>;
         NodesT _nodes;
@@ -124,8 +129,24 @@ class LLVMPointerGraphBuilder {
         // reachable LLVM block (those block for which we built the
         // instructions)
         std::map<const llvm::BasicBlock *, PSNodesBlock> llvmBlocks{};
+        // the nodes of the arguments and instructions of the function,
+        // they are removed with the function when it is rebuilt
+        NodesMapT nodes{};
         bool has_structure{false};
 
+        // when the functions are built in parallel (see buildFunctions()),
+        // the nodes are created in this pool and the calls of defined
+        // functions are connected to the subgraphs after all functions
+        // are built
+        struct PendingCall {
+            PSNode *callNode;
+            const llvm::CallInst *CInst;
+            const llvm::Function *F;
+        };
+
+        std::unique_ptr<PointerNodesPool> pool{};
+        std::vector<PendingCall> calls{};
+
         FuncGraph() = default;
         FuncGraph(const FuncGraph &) = delete;
 
@@ -168,9 +189,35 @@ class LLVMPointerGraphBuilder {
 
     std::unordered_map<const llvm::Function *, FuncGraph> _funcInfo;
 
+    // the pool where the nodes are created in this thread
+    // (if the functions are built in parallel)
+    static thread_local PointerNodesPool *_pool;
+
+    template <PSNodeType Type, typename... Args>
+    PSNode *create(Args &&...args) {
+        if (_pool)
+            return _pool->create<Type>(std::forward<Args>(args)...);
+        return PS.create<Type>(std::forward<Args>(args)...);
+    }
+
     // build pointer state subgraph for given graph
     // \return   root node of the graph
     PointerSubgraph &buildFunction(const llvm::Function &F);
+    // create the subgraph, its root and the arguments
+    PointerSubgraph &createFunctionSubgraph(const llvm::Function &F);
+    // build the nodes of the instructions of the function
+    void buildFunctionBlocks(const llvm::Function &F, PointerSubgraph &subg);
+    // Build the functions reachable from the entry via direct calls
+    // (with the program structure). The functions are built in waves
+    // (the functions called from the previous wave that were not built
+    // yet), the nodes of every function of a wave are created in its own
+    // pool by one of '_options.buildThreads' threads. Then the pools
+    // are added to the graph in the order of the functions, so that
+    // the IDs of nodes do not depend on the number of threads.
+    void buildFunctions(const llvm::Function &entry);
+    // create the nodes of constants that are used by the function,
+    // so that they are not created while the function is being built
+    void prepareConstants(const llvm::Function &F);
     PSNodesSeq &buildInstruction(const llvm::Instruction & /*Inst*/);
 
     PSNodesBlock buildPointerGraphBlock(const llvm::BasicBlock &block,
@@ -193,8 +240,9 @@ class LLVMPointerGraphBuilder {
                                     PSNodesBlock &argsBlk,
                                     PointerSubgraph &subg);
 
-    // map of all nodes we created - use to look up operands
-    std::unordered_map<const llvm::Value *, PSNodesSeq> nodes_map;
+    // map of nodes of globals and constants (the nodes of arguments
+    // and instructions are in the FuncGraph of their function)
+    NodesMapT nodes_map;
     // map of all built subgraphs - the value type is a pair (root, return)
     std::unordered_map<const llvm::Function *, PointerSubgraph *> subgraphs_map;
 
@@ -212,7 +260,21 @@ class LLVMPointerGraphBuilder {
 
     PointerGraph *buildLLVMPointerGraph();
 
-    bool validateSubgraph(bool no_connectivity = false) const;
+    const llvm::Module *getModule() const { return M; }
+
+    // Update the built graph after the module was edited: remove the
+    // subgraphs of the 'changed' and 'removed' functions and build
+    // the changed functions anew (the removed functions are used only
+    // as keys, they may be already destroyed). Other functions
+    // are not rebuilt. Return the nodes whose points-to sets
+    // may depend on the removed nodes.
+    std::vector<PSNode *>
+    updateFunctions(const std::set<const llvm::Function *> &changed,
+                    const std::set<const llvm::Function *> &removed);
+
+    // check the graph (or only the nodes with ID 'firstNode' and higher)
+    bool validateSubgraph(bool no_connectivity = false,
+                          unsigned firstNode = 0) const;
 
     void setAdHocBuilding(bool adHoc) { ad_hoc_building = adHoc; }
 
@@ -240,15 +302,36 @@ class LLVMPointerGraphBuilder {
     bool addFunctionToJoin(PSNode *function, PSNodeJoin *joinNode);
 
     bool matchJoinToRightCreate(PSNode *joinNode);
-    // let the user get the nodes map, so that we can
-    // map the points-to informatio back to LLVM nodes
-    const std::unordered_map<const llvm::Value *, PSNodesSeq> &
-    getNodesMap() const {
-        return nodes_map;
+    // the nodes of formal arguments of the built functions
+    std::vector<PSNode *> getArgumentNodes() const {
+        std::vector<PSNode *> ret;
+        for (const auto &fit : _funcInfo) {
+            for (const auto &it : fit.second.nodes) {
+                if (llvm::isa<llvm::Argument>(it.first))
+                    ret.insert(ret.end(), it.second.begin(), it.second.end());
+            }
+        }
+        return ret;
     }
 
     std::vector<PSNode *> getFunctionNodes(const llvm::Function *F) const;
 
+    // get the node of the value if it has been built
+    PSNode *getPointsToNodeOrNull(const llvm::Value *val) {
+        // if we have a mapping for this node (e.g. the original
+        // node was optimized away and replaced by mapping),
+        // return it
+        if (auto *mp = mapping.get(val))
+            return mp;
+        if (auto *nds = getNodes(val)) {
+            // otherwise get the representant of the built nodes
+            return nds->getRepresentant();
+        }
+
+        // not built!
+        return nullptr;
+    }
+
     // this is the same as the getNode, but it creates ConstantExpr
     PSNode *getPointsToNode(const llvm::Value *val) {
         PSNode *n = getPointsToNodeOrNull(val);
@@ -273,12 +356,34 @@ class LLVMPointerGraphBuilder {
     }
 
     void composeMapping(PointsToMapping<PSNode *> &&rhs) {
+        // redirect also the values whose nodes were removed
+        // and that do not have a mapping yet
+        forEachNodes([&](const llvm::Value *val, PSNodesSeq &seq) {
+            if (seq.empty())
+                return;
+            PSNode *nd = seq.getRepresentant();
+            if (rhs.get(nd) && !mapping.get(val))
+                mapping.add(val, nd);
+        });
+
         mapping.compose(std::move(rhs));
     }
 
     PointerSubgraph *getSubgraph(const llvm::Function * /*F*/);
 
   private:
+    // call 'fun' on every value that has nodes and the nodes, so that
+    // we can map the points-to information back to LLVM values
+    template <typename FunT>
+    void forEachNodes(FunT fun) {
+        for (auto &it : nodes_map)
+            fun(it.first, it.second);
+        for (auto &fit : _funcInfo) {
+            for (auto &it : fit.second.nodes)
+                fun(it.first, it.second);
+        }
+    }
+
     // create subgraph of function @F (the nodes)
     // and call+return nodes to/from it. This function
     // won't add the CFG edges if not 'ad_hoc_building'
@@ -286,25 +391,34 @@ class LLVMPointerGraphBuilder {
     PSNodesSeq &createCallToFunction(const llvm::CallInst * /*CInst*/,
                                      const llvm::Function * /*F*/);
 
-    PSNode *getPointsToNodeOrNull(const llvm::Value *val) {
-        // if we have a mapping for this node (e.g. the original
-        // node was optimized away and replaced by mapping),
-        // return it
-        if (auto *mp = mapping.get(val))
-            return mp;
-        if (auto *nds = getNodes(val)) {
-            // otherwise get the representant of the built nodes
-            return nds->getRepresentant();
+    // the map with the nodes of the value or null if the value
+    // is in a function that was not built
+    NodesMapT *getNodesMap(const llvm::Value *val) {
+        const llvm::Function *F = nullptr;
+        if (const auto *I = llvm::dyn_cast<llvm::Instruction>(val)) {
+            // the instructions created from constant expressions
+            // do not have any parent
+            if (I->getParent())
+                F = I->getFunction();
+        } else if (const auto *A = llvm::dyn_cast<llvm::Argument>(val)) {
+            F = A->getParent();
         }
 
-        // not built!
-        return nullptr;
+        if (!F)
+            return &nodes_map;
+
+        auto it = _funcInfo.find(F);
+        return it == _funcInfo.end() ? nullptr : &it->second.nodes;
     }
 
     // get the built nodes for this value or null
     PSNodesSeq *getNodes(const llvm::Value *val) {
-        auto it = nodes_map.find(val);
-        if (it == nodes_map.end())
+        auto *nodes = getNodesMap(val);
+        if (!nodes)
+            return nullptr;
+
+        auto it = nodes->find(val);
+        if (it == nodes->end())
             return nullptr;
 
         // the node corresponding to the real llvm value
@@ -313,17 +427,21 @@ class LLVMPointerGraphBuilder {
     }
 
     PSNodesSeq &addNode(const llvm::Value *val, PSNode *node) {
-        assert(nodes_map.find(val) == nodes_map.end());
-        auto it = nodes_map.emplace(val, node);
+        auto *nodes = getNodesMap(val);
+        assert(nodes && "Adding a node to a function that is not built");
+        assert(nodes->find(val) == nodes->end());
+        auto it = nodes->emplace(val, node);
         node->setUserData(const_cast<llvm::Value *>(val));
 
         return it.first->second;
     }
 
     PSNodesSeq &addNode(const llvm::Value *val, PSNodesSeq seq) {
-        assert(nodes_map.find(val) == nodes_map.end());
+        auto *nodes = getNodesMap(val);
+        assert(nodes && "Adding a node to a function that is not built");
+        assert(nodes->find(val) == nodes->end());
         seq.getRepresentant()->setUserData(const_cast<llvm::Value *>(val));
-        auto it = nodes_map.emplace(val, std::move(seq));
+        auto it = nodes->emplace(val, std::move(seq));
 
         return it.first->second;
     }
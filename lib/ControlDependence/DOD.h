@@ -6,7 +6,7 @@
 #include <set>
 #include <unordered_map>
 
-#include <dg/ADT/Bitvector.h>
+#include <dg/ADT/HybridBitvector.h>
 #include <dg/ADT/Queue.h>
 #include <dg/ADT/SetQueue.h>
 
@@ -19,11 +19,11 @@ namespace dg {
 // but we remember the results of calls to compute()
 class AllMaxPath {
   public:
-    using ResultT = std::map<CDNode *, const ADT::SparseBitvector &>;
+    using ResultT = std::map<CDNode *, const ADT::HybridBitvector &>;
 
   private:
     struct Info {
-        ADT::SparseBitvector colors;
+        ADT::HybridBitvector colors;
         unsigned short counter;
     };
 
@@ -84,7 +84,7 @@ class DOD {
     // is usually small. There is a flag that computes the relation
     // as ternary.
     using ResultT = std::map<CDNode *, std::set<CDNode *>>;
-    using ColoringT = ADT::SparseBitvector;
+    using ColoringT = ADT::HybridBitvector;
 
   private:
     struct ColoredAp {
@@ -146,7 +146,7 @@ class DOD {
     }
 
     // Create the Ap graph (nodes and edges)
-    ColoredAp createAp(const ADT::SparseBitvector &nodes, CDGraph &graph,
+    ColoredAp createAp(const ADT::HybridBitvector &nodes, CDGraph &graph,
                        CDNode *node) {
         ColoredAp CAp;
         CDGraph &Ap = CAp.Ap;
@@ -0,0 +1,115 @@
+#include <algorithm>
+
+#include "dg/PointerAnalysis/AliasCache.h"
+
+namespace dg {
+namespace pta {
+
+bool AliasCache::overlap(Offset off1, Offset size1, Offset off2,
+                         Offset size2) {
+    if (off1.isUnknown() || off2.isUnknown())
+        return true;
+
+    // the access of unknown size spans the rest of the object
+    const bool unbounded1 = size1.isUnknown() || size1.isZero();
+    const bool unbounded2 = size2.isUnknown() || size2.isZero();
+    return (unbounded2 || *off1 < *off2 + *size2) &&
+           (unbounded1 || *off2 < *off1 + *size1);
+}
+
+const ADT::SparseBitvector &AliasCache::getTargets(const PSNode *node) {
+    auto it = _targets.find(node);
+    if (it != _targets.end())
+        return it->second.ids;
+
+    auto &targets = _targets[node].ids;
+    for (const auto &ptr : node->pointsTo) {
+        if (!ptr.isUnknown())
+            targets.set(ptr.target->getID());
+    }
+    return targets;
+}
+
+void AliasCache::retainTargets(const PSNode *node) {
+    auto it = _targets.find(node);
+    if (it != _targets.end())
+        ++it->second.answers;
+}
+
+// drop the targets of the node if no cached answer is about the node
+void AliasCache::releaseTargets(const PSNode *node) {
+    auto it = _targets.find(node);
+    if (it == _targets.end())
+        return;
+
+    if (it->second.answers == 0 || --it->second.answers == 0)
+        _targets.erase(it);
+}
+
+bool AliasCache::compute(const PSNode *n1, Offset size1, const PSNode *n2,
+                         Offset size2) {
+    if (n1->pointsTo.empty() || n2->pointsTo.empty() ||
+        n1->pointsTo.hasUnknown() || n2->pointsTo.hasUnknown())
+        return true;
+
+    // find the common targets using the bitvectors and compare
+    // the offsets only for the pointers to these targets
+    const auto &targets1 = getTargets(n1);
+    const auto &targets2 = getTargets(n2);
+    if (!targets1.intersects(targets2))
+        return false;
+
+    for (const auto &ptr1 : n1->pointsTo) {
+        if (ptr1.isNull() || ptr1.isInvalidated() ||
+            !targets2.get(ptr1.target->getID()))
+            continue;
+        for (const auto &ptr2 : n2->pointsTo) {
+            if (ptr1.target == ptr2.target &&
+                overlap(ptr1.offset, size1, ptr2.offset, size2))
+                return true;
+        }
+    }
+    return false;
+}
+
+bool AliasCache::alias(const PSNode *n1, Offset size1, const PSNode *n2,
+                       Offset size2) {
+    // the query is symmetric
+    if (n2 < n1) {
+        std::swap(n1, n2);
+        std::swap(size1, size2);
+    }
+
+    const Key key{n1, n2, *size1, *size2};
+    auto it = _index.find(key);
+    if (it != _index.end()) {
+        ++_hits;
+        _answers.splice(_answers.begin(), _answers, it->second);
+        return it->second->second;
+    }
+
+    ++_misses;
+    const bool result = compute(n1, size1, n2, size2);
+    if (_capacity == 0) {
+        releaseTargets(n1);
+        releaseTargets(n2);
+        return result;
+    }
+
+    _answers.emplace_front(key, result);
+    _index.emplace(key, _answers.begin());
+    retainTargets(n1);
+    retainTargets(n2);
+
+    if (_answers.size() > _capacity) {
+        const auto &old = _answers.back().first;
+        releaseTargets(old.n1);
+        releaseTargets(old.n2);
+        _index.erase(old);
+        _answers.pop_back();
+    }
+    return result;
+}
+
+} // namespace pta
+} // namespace dg
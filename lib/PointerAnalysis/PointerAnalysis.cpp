@@ -1,5 +1,16 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <thread>
+#include <unordered_map>
+
 #include "dg/PointerAnalysis/PointerAnalysis.h"
 #include "dg/PointerAnalysis/Pointer.h"
+#include "dg/PointerAnalysis/PointerAnalysisFI.h"
+#include "dg/PointerAnalysis/PointerAnalysisFS.h"
+#include "dg/PointerAnalysis/PointerAnalysisFSInv.h"
+#include "dg/PointerAnalysis/PointerAnalysisSteensgaard.h"
 #include "dg/PointerAnalysis/PointsToSet.h"
 
 #include "dg/util/debug.h"
@@ -33,7 +44,65 @@ static bool funHasAddressTaken(PSNode *node) {
     );
 }
 
-bool PointerAnalysis::processLoad(PSNode *node) {
+PointerAnalysis::ConsumedPointers &
+PointerAnalysis::getConsumed(PSNode *node, size_t idx) {
+    auto id = node->getID();
+    if (consumed.size() <= id)
+        consumed.resize(id + 1);
+
+    auto &C = consumed[id];
+    if (C.size() <= idx)
+        C.resize(idx + 1);
+
+    return C[idx];
+}
+
+template <typename FunT>
+void PointerAnalysis::forEachNewPointer(PSNode *node, size_t idx, FunT F) {
+    PSNode *op = node->getOperand(idx);
+
+    // the special nodes are shared by all graphs and have constant
+    // points-to sets, so do not track the history for them
+    if (!options.diffPropagation || op->isNull() || op->isUnknownMemory() ||
+        op->isInvalidated()) {
+        for (const Pointer &ptr : op->pointsTo)
+            F(ptr);
+        return;
+    }
+
+    op->trackPointsToHistory();
+    const auto *history = op->getPointsToHistory();
+
+    auto &C = getConsumed(node, idx);
+    if (C.operand != op) {
+        // the operand has been changed, start from the scratch
+        C.operand = op;
+        C.pos = 0;
+    }
+
+    // NOTE: 'F' can add pointers to 'op' (if 'op' is 'node'),
+    // so do not use iterators here
+    while (C.pos < history->size()) {
+        Pointer ptr = (*history)[C.pos++];
+        // the pointer may have been subsumed by
+        // the same pointer with unknown offset
+        if (!op->pointsTo.has(ptr))
+            continue;
+        F(ptr);
+    }
+}
+
+void PointerAnalysis::dropPointsToHistory() {
+    for (const auto &nd : PG->getNodes()) {
+        if (nd)
+            nd->dropPointsToHistory();
+    }
+
+    decltype(consumed)().swap(consumed);
+}
+
+template <typename Impl, typename DestT>
+bool PointerAnalysis::processLoad(PSNode *node, DestT *dest) {
     bool changed = false;
     PSNode *operand = node->getOperand(0);
 
@@ -43,7 +112,7 @@ bool PointerAnalysis::processLoad(PSNode *node) {
     for (const Pointer &ptr : operand->pointsTo) {
         if (ptr.isUnknown()) {
             // load from unknown pointer yields unknown pointer
-            changed |= node->addPointsTo(UnknownPointer);
+            changed |= dest->addPointsTo(UnknownPointer);
             continue;
         }
 
@@ -53,7 +122,8 @@ bool PointerAnalysis::processLoad(PSNode *node) {
         // find memory objects holding relevant points-to
         // information
         std::vector<MemoryObject *> objects;
-        getMemoryObjects(node, ptr, objects);
+        analysis<Impl>()->getMemoryObjects(node, ptr, objects);
+        addMemoryReader(node, objects);
 
         PSNodeAlloc *target = PSNodeAlloc::get(ptr.target);
         assert(target && "Target is not memory allocation");
@@ -64,9 +134,9 @@ bool PointerAnalysis::processLoad(PSNode *node) {
             if (target->isZeroInitialized())
                 // if the memory is zero initialized, then everything
                 // is fine, we add nullptr
-                changed |= node->addPointsTo(NullPointer);
+                changed |= dest->addPointsTo(NullPointer);
             else
-                changed |= errorEmptyPointsTo(node, target);
+                changed |= analysis<Impl>()->errorEmptyPointsTo(node, target);
 
             continue;
         }
@@ -81,15 +151,16 @@ bool PointerAnalysis::processLoad(PSNode *node) {
                 // FIXME: don't duplicate the code
                 if (o->pointsTo.empty()) {
                     if (target->isZeroInitialized())
-                        changed |= node->addPointsTo(NullPointer);
+                        changed |= dest->addPointsTo(NullPointer);
                     else if (objects.size() == 1)
-                        changed |= errorEmptyPointsTo(node, target);
+                        changed |= analysis<Impl>()->errorEmptyPointsTo(node,
+                                                                        target);
                 }
 
                 // we have some pointers - copy them all,
                 // since the offset is unknown
                 for (auto &it : o->pointsTo) {
-                    changed |= node->addPointsTo(it.second);
+                    changed |= dest->addPointsTo(it.second);
                 }
 
                 // this is all that we can do here...
@@ -103,23 +174,24 @@ bool PointerAnalysis::processLoad(PSNode *node) {
                 // if the memory is zero initialized, then everything
                 // is fine, we add nullptr
                 if (target->isZeroInitialized())
-                    changed |= node->addPointsTo(NullPointer);
+                    changed |= dest->addPointsTo(NullPointer);
                 // if we don't have a definition even with unknown offset
                 // it is an error
                 // FIXME: don't triplicate the code!
                 else if (!o->pointsTo.count(Offset::UNKNOWN))
-                    changed |= errorEmptyPointsTo(node, target);
+                    changed |= analysis<Impl>()->errorEmptyPointsTo(node,
+                                                                    target);
             } else {
                 // we have pointers on that memory, so we can
                 // do the work
-                changed |= node->addPointsTo(it->second);
+                changed |= dest->addPointsTo(it->second);
             }
 
             // plus always add the pointers at unknown offset,
             // since these can be what we need too
             it = o->pointsTo.find(Offset::UNKNOWN);
             if (it != o->pointsTo.end()) {
-                changed |= node->addPointsTo(it->second);
+                changed |= dest->addPointsTo(it->second);
             }
         }
     }
@@ -127,6 +199,7 @@ bool PointerAnalysis::processLoad(PSNode *node) {
     return changed;
 }
 
+template <typename Impl>
 bool PointerAnalysis::processMemcpy(PSNode *node) {
     bool changed = false;
     PSNodeMemcpy *memcpy = PSNodeMemcpy::get(node);
@@ -144,7 +217,8 @@ bool PointerAnalysis::processMemcpy(PSNode *node) {
             continue;
 
         srcObjects.clear();
-        getMemoryObjects(node, ptr, srcObjects);
+        analysis<Impl>()->getMemoryObjects(node, ptr, srcObjects);
+        addMemoryReader(node, srcObjects);
 
         if (srcObjects.empty()) {
             abort();
@@ -159,15 +233,19 @@ bool PointerAnalysis::processMemcpy(PSNode *node) {
                 continue;
 
             destObjects.clear();
-            getMemoryObjects(node, dptr, destObjects);
+            analysis<Impl>()->getMemoryObjects(node, dptr, destObjects);
 
             if (destObjects.empty()) {
                 abort();
                 return changed;
             }
 
-            changed |= processMemcpy(srcObjects, destObjects, ptr, dptr,
-                                     memcpy->getLength());
+            if (processMemcpy(srcObjects, destObjects, ptr, dptr,
+                              memcpy->getLength())) {
+                changed = true;
+                for (MemoryObject *o : destObjects)
+                    memoryChanged(o);
+            }
         }
     }
 
@@ -226,58 +304,79 @@ bool PointerAnalysis::processMemcpy(std::vector<MemoryObject *> &srcObjects,
         if (contains_null_somewhere)
             changed |= destO->addPointsTo(Offset::UNKNOWN, NullPointer);
 
-        // copy every pointer from srcObjects that is in
-        // the range to destination's objects
+        // copy every pointer from srcObjects that is in the range
+        // to destination's objects, shifted by the offsets we are
+        // working with. The pointers that get out of the object
+        // or beyond the field sensitivity go to the unknown offset.
+        const Offset limit = std::min(Offset(destO->node->getSize()),
+                                      options.fieldSensitivity);
         for (MemoryObject *so : srcObjects) {
-            for (auto &src : so->pointsTo) { // src.first is offset,
-                                             // src.second is a PointToSet
-
-                // if the offset is inbound of the copied memory
-                // or we copy from unknown offset, or this pointer
-                // is on unknown offset, copy this pointer
-                if (src.first.isUnknown() || srcOffset.isUnknown() ||
-                    (srcOffset <= src.first &&
-                     (len.isUnknown() || *src.first - *srcOffset < *len))) {
-                    // copy the pointer, but shift it by the offsets
-                    // we are working with
-                    if (!src.first.isUnknown() && !srcOffset.isUnknown() &&
-                        !destOffset.isUnknown()) {
-                        // check that new offset does not overflow
-                        // Offset::UNKNOWN
-                        if (Offset::UNKNOWN - *destOffset <=
-                            *src.first - *srcOffset) {
-                            changed |= destO->addPointsTo(Offset::UNKNOWN,
-                                                          src.second);
-                            continue;
-                        }
-
-                        Offset newOff = *src.first - *srcOffset + *destOffset;
-                        if (newOff >= destO->node->getSize() ||
-                            newOff >= options.fieldSensitivity) {
-                            changed |= destO->addPointsTo(Offset::UNKNOWN,
-                                                          src.second);
-                        } else {
-                            changed |= destO->addPointsTo(newOff, src.second);
-                        }
-                    } else {
-                        changed |=
-                                destO->addPointsTo(Offset::UNKNOWN, src.second);
-                    }
-                }
+            changed |= destO->mergeRange(*so, srcOffset, len, destOffset,
+                                         limit);
+        }
+    }
+
+    return changed;
+}
+
+template <typename Impl>
+bool PointerAnalysis::processStore(PSNode *node) {
+    bool changed = false;
+    std::vector<MemoryObject *> objects;
+
+    auto store = [&](const Pointer &ptr, const PointsToSetT &values) {
+        assert(ptr.target && "Got nullptr as target");
+
+        if (!canBeDereferenced(ptr))
+            return;
+
+        objects.clear();
+        analysis<Impl>()->getMemoryObjects(node, ptr, objects);
+        for (MemoryObject *o : objects) {
+            if (o->addPointsTo(ptr.offset, values)) {
+                changed = true;
+                memoryChanged(o);
             }
         }
+    };
+
+    PSNode *value = node->getOperand(0);
+    PSNode *pointer = node->getOperand(1);
+
+    if (!options.diffPropagation) {
+        for (const Pointer &ptr : pointer->pointsTo)
+            store(ptr, value->pointsTo);
+        return changed;
     }
 
+    // store the new values to the memory pointed by all pointers...
+    PointsToSetT newValues;
+    forEachNewPointer(node, 0,
+                      [&newValues](const Pointer &ptr) { newValues.add(ptr); });
+    if (!newValues.empty()) {
+        for (const Pointer &ptr : pointer->pointsTo)
+            store(ptr, newValues);
+    }
+
+    // ...and all the values to the memory pointed by the new pointers
+    forEachNewPointer(node, 1,
+                      [&](const Pointer &ptr) { store(ptr, value->pointsTo); });
+
     return changed;
 }
 
-bool PointerAnalysis::processGep(PSNode *node) {
+template <typename DestT>
+bool PointerAnalysis::processGep(PSNode *node, DestT *dest) {
     bool changed = false;
 
     PSNodeGep *gep = PSNodeGep::get(node);
     assert(gep && "Non-GEP given");
 
-    for (const Pointer &ptr : gep->getSource()->pointsTo) {
+    // the operand is in the same collapsed cycle
+    if (inCycleOf(node->getOperand(0), dest))
+        return false;
+
+    forEachNewPointer(node, 0, [&](const Pointer &ptr) {
         Offset::type new_offset;
         if (ptr.offset.isUnknown() || gep->getOffset().isUnknown())
             // set it like this to avoid overflow when adding
@@ -290,17 +389,261 @@ bool PointerAnalysis::processGep(PSNode *node) {
         // to the begining of the memory - therefore make 0 exception
         if ((new_offset == 0 || new_offset < ptr.target->getSize()) &&
             new_offset < *options.fieldSensitivity)
-            changed |= node->addPointsTo(ptr.target, new_offset);
+            changed |= dest->addPointsTo(ptr.target, new_offset);
         else
-            changed |= node->addPointsTo(ptr.target, Offset::UNKNOWN);
+            changed |= dest->addPointsTo(ptr.target, Offset::UNKNOWN);
+    });
+
+    return changed;
+}
+
+template <typename DestT>
+static bool addInvalidatedIfLocal(DestT *dest, const Pointer &ptr) {
+    if (!canBeDereferenced(ptr))
+        return false;
+
+    PSNodeAlloc *target = PSNodeAlloc::get(ptr.target);
+    assert(target && "Target is not memory allocation");
+    if (!target->isHeap() && !target->isGlobal()) {
+        return dest->addPointsTo(INVALIDATED, 0);
+    }
+
+    return false;
+}
+
+// PHI, CAST, RETURN and CALL_RETURN nodes just gather
+// the pointers from their operands
+template <typename DestT>
+bool PointerAnalysis::processCopy(PSNode *node, DestT *dest) {
+    bool changed = false;
+    const bool invalidate = options.invalidateNodes &&
+                            node->getType() == PSNodeType::CALL_RETURN;
+
+    for (size_t i = 0, e = node->getOperandsNum(); i < e; ++i) {
+        // the operand is in the same collapsed cycle
+        if (inCycleOf(node->getOperand(i), dest))
+            continue;
+
+        if (!options.diffPropagation) {
+            PSNode *op = node->getOperand(i);
+            if (invalidate) {
+                for (const Pointer &ptr : op->pointsTo)
+                    changed |= addInvalidatedIfLocal(dest, ptr);
+            }
+            changed |= dest->addPointsTo(op->pointsTo);
+            continue;
+        }
+
+        forEachNewPointer(node, i, [&](const Pointer &ptr) {
+            if (invalidate)
+                changed |= addInvalidatedIfLocal(dest, ptr);
+            changed |= dest->addPointsTo(ptr);
+        });
     }
 
     return changed;
 }
 
+// nodes whose points-to set contains exactly the pointers
+// of their operands
+static bool isCopyNode(PSNode *node) {
+    switch (node->getType()) {
+    case PSNodeType::PHI:
+    case PSNodeType::CAST:
+        return true;
+    case PSNodeType::GEP:
+        return PSNodeGep::get(node)->getOffset().isZero();
+    default:
+        return false;
+    }
+}
+
+static bool samePointsTo(const PSNode *a, const PSNode *b) {
+    if (a->pointsTo.size() != b->pointsTo.size())
+        return false;
+
+    // the sets are ordered
+    auto it = b->pointsTo.begin();
+    for (const auto &ptr : a->pointsTo) {
+        if (!(ptr == *it))
+            return false;
+        ++it;
+    }
+    return true;
+}
+
+void PointerAnalysis::queueUsers(PSNode *node) {
+    if (worklistRunning) {
+        for (auto *user : node->getUsers())
+            enqueueWorklist(user);
+    } else {
+        // the nodes reachable from the node will be processed
+        enqueue(node);
+    }
+}
+
+void PointerAnalysis::syncCycle(PSNode *rep) {
+    queueUsers(rep);
+    for (auto *member : cycleMembers[rep->getID()]) {
+        if (member != rep && member->addPointsTo(rep->pointsTo))
+            queueUsers(member);
+    }
+}
+
+void PointerAnalysis::collapseCycle(const std::vector<PSNode *> &cycle) {
+    assert(cycle.size() > 1);
+
+    // prefer a PHI node as the representative,
+    // every copy cycle in SSA goes through a PHI node
+    PSNode *rep = cycle[0];
+    for (auto *nd : cycle) {
+        if (nd->getType() == PSNodeType::PHI) {
+            rep = nd;
+            break;
+        }
+    }
+
+    DBG(pta, "Collapsing a cycle of " << cycle.size()
+                                      << " nodes into node " << rep->getID());
+
+    const auto size = PG->getNodes().size();
+    if (cycleRep.size() < size)
+        cycleRep.resize(size, nullptr);
+    if (cycleMembers.size() < size)
+        cycleMembers.resize(size);
+
+    for (auto *nd : cycle) {
+        assert(cycleRep[nd->getID()] == nullptr && "Collapsing a node twice");
+        cycleRep[nd->getID()] = rep;
+        rep->addPointsTo(nd->pointsTo);
+    }
+
+    cycleMembers[rep->getID()] = cycle;
+    syncCycle(rep);
+}
+
+// Lazy cycle detection: if the node has the same points-to set
+// as its operand, the node and the operand may be on a cycle
+// of copy nodes. Search for such cycles and collapse them.
+bool PointerAnalysis::detectCycles(PSNode *node) {
+    if (node->pointsTo.empty())
+        return false;
+
+    bool search = false;
+    for (auto *op : node->getOperands()) {
+        if (!isCopyNode(op) || getCycleRep(op) || !samePointsTo(op, node))
+            continue;
+        // check every edge only once
+        if (checkedCopyEdges.insert({op->getID(), node->getID()}).second)
+            search = true;
+    }
+
+    if (!search)
+        return false;
+
+    auto sccs = computeSCCs(node, [this](PSNode *n,
+                                         std::function<void(PSNode *)> F) {
+        for (auto *op : n->getOperands()) {
+            if (isCopyNode(op) && !getCycleRep(op))
+                F(op);
+        }
+    });
+
+    bool collapsed = false;
+    for (auto &scc : sccs) {
+        if (scc.size() > 1) {
+            collapseCycle(scc);
+            collapsed = true;
+        }
+    }
+
+    return collapsed;
+}
+
+// A cycle of copy nodes lies in one class of the unification-based
+// analysis, so search for the cycles only along the edges inside
+// the classes. Every node is searched only once: a cycle through
+// a node searched before would have been found in that search.
+void PointerAnalysis::seedCycles(PointerAnalysisSteensgaard &unification) {
+    std::vector<unsigned> searchedIn(PG->getNodes().size(), 0);
+    unsigned search = 0;
+    for (const auto &nd : PG->getNodes()) {
+        if (!nd || !isCopyNode(nd.get()) || searchedIn[nd->getID()] != 0 ||
+            !unification.mayPointTo(nd.get()))
+            continue;
+
+        ++search;
+        auto sccs = computeSCCs(nd.get(), [&](PSNode *n,
+                                              std::function<void(PSNode *)> F) {
+            searchedIn[n->getID()] = search;
+            for (auto *op : n->getOperands()) {
+                if (!isCopyNode(op) || getCycleRep(op))
+                    continue;
+                const auto in = searchedIn[op->getID()];
+                if ((in == 0 || in == search) &&
+                    unification.pointToSameClass(op, n))
+                    F(op);
+            }
+        });
+
+        for (auto &scc : sccs) {
+            if (scc.size() > 1)
+                collapseCycle(scc);
+        }
+    }
+}
+
+// process the copy nodes collapsed into the cycle represented by 'rep'.
+// The changes are queued here, the function returns false.
+bool PointerAnalysis::processCycle(PSNode *rep) {
+    bool changed = false;
+    for (auto *member : cycleMembers[rep->getID()]) {
+        if (member->getType() == PSNodeType::GEP)
+            changed |= processGep(member, rep);
+        else
+            changed |= processCopy(member, rep);
+    }
+
+    if (changed)
+        syncCycle(rep);
+
+    return false;
+}
+
+template <typename Impl>
 bool PointerAnalysis::processNode(PSNode *node) {
+    if (!stats)
+        return processNodeImpl<Impl>(node);
+    return processNodeWithStatistics<Impl>(node);
+}
+
+template <typename Impl>
+bool PointerAnalysis::processNodeWithStatistics(PSNode *node) {
+    const auto start = std::chrono::steady_clock::now();
+    const bool changed = processNodeImpl<Impl>(node);
+    const auto time = std::chrono::steady_clock::now() - start;
+
+    stats->addVisit(
+            node->getType(), changed,
+            std::chrono::duration_cast<std::chrono::nanoseconds>(time)
+                    .count());
+    return changed;
+}
+
+template <typename Impl>
+bool PointerAnalysis::processNodeImpl(PSNode *node) {
     bool changed = false;
-    std::vector<MemoryObject *> objects;
+
+    // the pre-pass found that the node cannot get any pointers
+    if (isInert(node))
+        return false;
+
+    if (options.collapseCycles) {
+        // the node is collapsed into a cycle,
+        // process the whole cycle at once
+        if (PSNode *rep = getCycleRep(node))
+            return processCycle(rep);
+    }
 
 #ifdef DEBUG_ENABLED
     size_t prev_size = node->pointsTo.size();
@@ -308,22 +651,10 @@ bool PointerAnalysis::processNode(PSNode *node) {
 
     switch (node->type) {
     case PSNodeType::LOAD:
-        changed |= processLoad(node);
+        changed |= processLoad<Impl>(node, node);
         break;
     case PSNodeType::STORE:
-        for (const Pointer &ptr : node->getOperand(1)->pointsTo) {
-            assert(ptr.target && "Got nullptr as target");
-
-            if (!canBeDereferenced(ptr))
-                continue;
-
-            objects.clear();
-            getMemoryObjects(node, ptr, objects);
-            for (MemoryObject *o : objects) {
-                changed |= o->addPointsTo(ptr.offset,
-                                          node->getOperand(0)->pointsTo);
-            }
-        }
+        changed |= processStore<Impl>(node);
         break;
     case PSNodeType::INVALIDATE_OBJECT:
     case PSNodeType::FREE:
@@ -334,11 +665,11 @@ bool PointerAnalysis::processNode(PSNode *node) {
         node->setParent(node->getOperand(0)->getSingleSuccessor()->getParent());
         break;
     case PSNodeType::GEP:
-        changed |= processGep(node);
+        changed |= processGep(node, node);
         break;
     case PSNodeType::CAST:
         // cast only copies the pointers
-        changed |= node->addPointsTo(node->getOperand(0)->pointsTo);
+        changed |= processCopy(node, node);
         break;
     case PSNodeType::CONSTANT:
         // maybe warn? It has no sense to insert the constants into the graph.
@@ -348,26 +679,13 @@ bool PointerAnalysis::processNode(PSNode *node) {
                "Constant should have exactly one pointer");
         break;
     case PSNodeType::CALL_RETURN:
-        if (options.invalidateNodes) {
-            for (PSNode *op : node->operands) {
-                for (const Pointer &ptr : op->pointsTo) {
-                    if (!canBeDereferenced(ptr))
-                        continue;
-                    PSNodeAlloc *target = PSNodeAlloc::get(ptr.target);
-                    assert(target && "Target is not memory allocation");
-                    if (!target->isHeap() && !target->isGlobal()) {
-                        changed |= node->addPointsTo(INVALIDATED, 0);
-                    }
-                }
-            }
-        }
-        // fall-through
+        // with invalidate nodes, the call-return may also add
+        // the pointer to invalidated memory (done in processCopy)
     case PSNodeType::RETURN:
         // gather pointers returned from subprocedure - the same way
         // as PHI works
     case PSNodeType::PHI:
-        for (PSNode *op : node->operands)
-            changed |= node->addPointsTo(op->pointsTo);
+        changed |= processCopy(node, node);
         break;
     case PSNodeType::CALL_FUNCPTR:
         // call via function pointer:
@@ -390,6 +708,8 @@ bool PointerAnalysis::processNode(PSNode *node) {
                 changed = true;
 
                 if (ptr.isValid() && !ptr.isInvalidated()) {
+                    if (stats)
+                        ++stats->functionPointerCalls;
                     functionPointerCall(node, ptr.target);
                 } else {
                     error(node, "Calling invalid pointer as a function!");
@@ -411,6 +731,8 @@ bool PointerAnalysis::processNode(PSNode *node) {
                 changed = true;
 
                 if (ptr.isValid() && !ptr.isInvalidated()) {
+                    if (stats)
+                        ++stats->forkedFunctions;
                     handleFork(node, ptr.target);
                 } else {
                     error(node, "Calling invalid pointer in fork!");
@@ -423,7 +745,7 @@ bool PointerAnalysis::processNode(PSNode *node) {
         changed |= handleJoin(node);
         break;
     case PSNodeType::MEMCPY:
-        changed |= processMemcpy(node);
+        changed |= processMemcpy<Impl>(node);
         break;
     case PSNodeType::ALLOC:
     case PSNodeType::FUNCTION:
@@ -439,6 +761,9 @@ bool PointerAnalysis::processNode(PSNode *node) {
         assert(0 && "Unknown type");
     }
 
+    if (options.collapseCycles && isCopyNode(node))
+        changed |= detectCycles(node);
+
 #ifdef DEBUG_ENABLED
     // the change of points-to set is not the only
     // change that can happen, so we don't use it as an
@@ -478,18 +803,585 @@ void PointerAnalysis::sanityCheck() {
 #endif // not NDEBUG
 }
 
-static void setToEmpty(std::vector<PSNode *> &nodes) {
-    for (auto *n : nodes) {
-        if (n->getType() != PSNodeType::ALLOC &&
-            n->getType() != PSNodeType::CONSTANT) {
-            n->pointsTo.clear();
+#if DEBUG_ENABLED
+#define DUMP_NTH_ITER 100
+#endif
+
+PointerAnalysis::Precision PointerAnalysis::getBudgetPrecision() {
+    auto budgetPrecision = Precision::FULL;
+    if (options.timeBudget > 0) {
+        const auto ms = static_cast<uint64_t>(
+                std::chrono::duration_cast<std::chrono::milliseconds>(
+                        std::chrono::steady_clock::now() - startTime)
+                        .count());
+        // leave a part of the budget for the coarser abstractions
+        if (ms >= options.timeBudget)
+            budgetPrecision = Precision::UNKNOWN_MEMORY;
+        else if (ms >= options.timeBudget / 4 * 3)
+            budgetPrecision = Precision::COLLAPSED_OBJECTS;
+        else if (ms >= options.timeBudget / 2)
+            budgetPrecision = Precision::FIELD_INSENSITIVE;
+    }
+
+    if (options.memoryBudget > 0 &&
+        budgetPrecision != Precision::UNKNOWN_MEMORY &&
+        processedSinceMemoryCheck >= PG->size()) {
+        processedSinceMemoryCheck = 0;
+        PointerAnalysisStatistics S;
+        collectMemoryStatistics(S);
+        // try the next coarser abstraction, the memory is checked
+        // again when all nodes have been processed with it
+        if (getPointsToMemory() + S.pointsToMemory > options.memoryBudget) {
+            budgetPrecision = std::max(
+                    budgetPrecision,
+                    static_cast<Precision>(static_cast<int>(precision) + 1));
+        }
+    }
+
+    return std::max(budgetPrecision, precision);
+}
+
+bool PointerAnalysis::degradePrecision(Precision to) {
+    assert(to > precision && "Not a coarser precision");
+    DBG(pta, "Exceeded the budget, switching to precision "
+                     << static_cast<int>(to));
+
+    if (precision < Precision::FIELD_INSENSITIVE)
+        dropFieldSensitivity();
+    if (precision < Precision::COLLAPSED_OBJECTS &&
+        to >= Precision::COLLAPSED_OBJECTS)
+        collapseOffsets();
+
+    precision = to;
+    // switching the precision scans the whole graph too,
+    // so the memory can be measured again right away
+    processedSinceMemoryCheck = PG->size();
+    if (to == Precision::UNKNOWN_MEMORY) {
+        addUnknownMemory();
+        return false;
+    }
+
+    // the points-to sets have changed behind the back
+    // of difference propagation, start it from the scratch
+    if (options.diffPropagation)
+        dropPointsToHistory();
+    return true;
+}
+
+void PointerAnalysis::dropFieldSensitivity() {
+    for (const auto &nd : PG->getNodes()) {
+        if (!nd)
+            continue;
+        if (PSNodeGep *gep = PSNodeGep::get(nd.get()))
+            gep->setOffset(Offset::UNKNOWN);
+    }
+}
+
+void PointerAnalysis::collapseOffsets() {
+    std::vector<PSNode *> targets;
+    for (const auto &nd : PG->getNodes()) {
+        // allocations and constants have fixed points-to sets
+        if (!nd || nd->getType() == PSNodeType::ALLOC ||
+            nd->getType() == PSNodeType::CONSTANT)
+            continue;
+
+        targets.clear();
+        for (const auto &ptr : nd->pointsTo) {
+            if (ptr.isValid() && !ptr.isInvalidated() &&
+                !ptr.offset.isUnknown() &&
+                ptr.target->getType() == PSNodeType::ALLOC)
+                targets.push_back(ptr.target);
+        }
+
+        // the pointer with unknown offset subsumes
+        // the pointers with the same target
+        for (auto *target : targets)
+            nd->addPointsTo(target, Offset::UNKNOWN);
+    }
+
+    collapseMemoryObjects();
+}
+
+void PointerAnalysis::addUnknownMemory() {
+    for (const auto &nd : PG->getNodes()) {
+        if (!nd)
+            continue;
+
+        switch (nd->getType()) {
+        case PSNodeType::LOAD:
+        case PSNodeType::GEP:
+        case PSNodeType::PHI:
+        case PSNodeType::CAST:
+        case PSNodeType::CALL:
+        case PSNodeType::CALL_RETURN:
+        case PSNodeType::RETURN:
+            nd->addPointsTo(UnknownPointer);
+            break;
+        default:
+            break;
+        }
+    }
+}
+
+// the nodes that do not change memory nor the graph, their change
+// can be observed only by their users
+static bool changesOnlyPointsTo(PSNode *node) {
+    switch (node->getType()) {
+    case PSNodeType::LOAD:
+    case PSNodeType::GEP:
+    case PSNodeType::PHI:
+    case PSNodeType::CAST:
+    case PSNodeType::CONSTANT:
+    case PSNodeType::RETURN:
+    case PSNodeType::CALL_RETURN:
+    case PSNodeType::ALLOC:
+    case PSNodeType::FUNCTION:
+    case PSNodeType::CALL:
+    case PSNodeType::ENTRY:
+    case PSNodeType::NOOP:
+        return true;
+    default:
+        return false;
+    }
+}
+
+static bool changesGraph(PSNode *node) {
+    return node->getType() == PSNodeType::CALL_FUNCPTR ||
+           node->getType() == PSNodeType::FORK ||
+           node->getType() == PSNodeType::JOIN;
+}
+
+void PointerAnalysis::unificationPrepass() {
+    PointerAnalysisSteensgaard unification(PG);
+    unification.unifyClasses();
+
+    // The pre-pass does not resolve calls via pointers, so its classes
+    // do not bound the results if there are such calls. The invalidated
+    // memory is added by the analysis also to the nodes without pointers.
+    bool bound = !options.invalidateNodes;
+    inert.clear();
+    for (const auto &nd : PG->getNodes()) {
+        if (nd && changesGraph(nd.get()))
+            bound = false;
+    }
+
+    if (bound) {
+        inert.assign(PG->getNodes().size(), false);
+        size_t num = 0;
+        for (const auto &nd : PG->getNodes()) {
+            if (nd && canProcessInParallel(nd.get()) &&
+                !unification.mayPointTo(nd.get())) {
+                inert[nd->getID()] = true;
+                ++num;
+            }
+        }
+        DBG(pta, "The pre-pass found " << num << " nodes without pointers");
+    }
+
+    if (options.collapseCycles) {
+        seedCycles(unification);
+        // the users of the cycles are processed in the first
+        // iteration anyway
+        changed.clear();
+    }
+}
+
+void PointerAnalysis::computeWorklistOrder() {
+    const auto size = PG->getNodes().size();
+
+    auto sccs = computeSCCs(PG->getEntry()->getRoot(),
+                            [](PSNode *n, std::function<void(PSNode *)> F) {
+                                PointerGraph::forEachSuccessor(n, F);
+                            });
+
+    // Tarjan's algorithm yields the SCCs in the reverse topological order.
+    // Inside SCCs, the nodes are in the DFS order, so that predecessors
+    // go before the successors if it is possible
+    worklistPos.assign(size, 0);
+    worklistGapEnd.clear();
+    uint64_t pos = 0;
+    for (auto it = sccs.rbegin(), et = sccs.rend(); it != et; ++it) {
+        for (auto *nd : *it) {
+            pos += WORKLIST_POS_GAP;
+            worklistPos[nd->getID()] = pos;
+        }
+    }
+
+    pendingEpoch.resize(size, 0);
+    propagatedEpoch.resize(size, 0);
+
+    // re-queue the nodes with the new positions
+    std::vector<PSNode *> queued;
+    queued.reserve(worklist.size());
+    while (!worklist.empty())
+        queued.push_back(worklist.pop().second);
+
+    for (auto *nd : queued)
+        enqueueWorklist(nd);
+}
+
+void PointerAnalysis::insertIntoWorklistOrder(PSNode *node) {
+    const auto size = PG->getNodes().size();
+    worklistPos.resize(size, 0);
+    pendingEpoch.resize(size, 0);
+    propagatedEpoch.resize(size, 0);
+
+    // the new nodes in the topological order of their SCCs,
+    // they are marked with a temporary position while collecting them
+    const uint64_t collected = ~uint64_t(0);
+    std::vector<PSNode *> newNodes;
+    auto isOrdered = [this](PSNode *n) { return worklistPos[n->getID()] != 0; };
+    auto unorderedSuccessors = [&isOrdered](PSNode *n,
+                                            std::function<void(PSNode *)> F) {
+        PointerGraph::forEachSuccessor(n, [&](PSNode *s) {
+            if (!isOrdered(s))
+                F(s);
+        });
+    };
+
+    PointerGraph::forEachSuccessor(node, [&](PSNode *start) {
+        if (isOrdered(start))
+            return;
+
+        auto sccs = computeSCCs(start, unorderedSuccessors);
+        for (auto it = sccs.rbegin(), et = sccs.rend(); it != et; ++it) {
+            for (auto *nd : *it) {
+                worklistPos[nd->getID()] = collected;
+                newNodes.push_back(nd);
+            }
+        }
+    });
+
+    if (newNodes.empty())
+        return;
+
+    // The new nodes go right after the node (e.g., after the call and
+    // before its call return) and after the nodes that were put there
+    // earlier, but before the next ordered node. If there is no space
+    // left in the gap, order the whole graph again.
+    const uint64_t pos = worklistPos[node->getID()];
+    const uint64_t gap = pos / WORKLIST_POS_GAP;
+    auto &last = worklistGapEnd[gap];
+    if (last < pos)
+        last = pos;
+    if (last + newNodes.size() >= (gap + 1) * WORKLIST_POS_GAP) {
+        DBG(pta, "No space for new nodes in the order, ordering again");
+        computeWorklistOrder();
+    } else {
+        for (auto *nd : newNodes)
+            worklistPos[nd->getID()] = ++last;
+    }
+
+    // the new nodes have not been processed yet
+    for (auto *nd : newNodes)
+        enqueueWorklist(nd);
+}
+
+void PointerAnalysis::addMemoryReader(PSNode *node,
+                                      const std::vector<MemoryObject *> &objects) {
+    if (!queueMemoryReaders)
+        return;
+
+    for (MemoryObject *o : objects)
+        memoryReaders[o->node].insert(node);
+}
+
+void PointerAnalysis::memoryChanged(MemoryObject *o) {
+    if (!queueMemoryReaders)
+        return;
+
+    auto it = memoryReaders.find(o->node);
+    if (it == memoryReaders.end())
+        return;
+
+    for (PSNode *reader : it->second)
+        enqueueWorklist(reader);
+}
+
+void PointerAnalysis::enqueueWorklist(PSNode *node) {
+    auto id = node->getID();
+    // the node is not reachable from the entry
+    if (id >= worklistPos.size() || worklistPos[id] == 0)
+        return;
+
+    worklist.push({worklistPos[id], node});
+}
+
+template <typename Impl>
+size_t PointerAnalysis::runWorklist() {
+    computeWorklistOrder();
+    const auto propagation = analysis<Impl>()->memoryPropagation();
+    worklistRunning = true;
+    queueMemoryReaders = propagation != MemoryPropagation::DEF_USE;
+
+    // process all the nodes reachable from the entry at least once
+    for (const auto &nd : PG->getNodes()) {
+        if (nd)
+            enqueueWorklist(nd.get());
+    }
+
+    // an iteration is a pass through the order,
+    // a new one starts when we return to a previous position
+    size_t n = 0;
+    uint64_t lastPos = ~uint64_t(0);
+    while (!worklist.empty()) {
+        auto item = worklist.pop();
+        PSNode *cur = item.second;
+        ++processedSinceMemoryCheck;
+
+        if (item.first <= lastPos) {
+            ++n;
+            if (stats)
+                iterationStatistics(worklist.size() + 1);
+            auto budgetPrecision = precision;
+            if (options.maxIterations > 0 && n > options.maxIterations) {
+                DBG(pta, "Reached the maximum number of iterations: " << n);
+                budgetPrecision = Precision::UNKNOWN_MEMORY;
+            } else if (hasBudget()) {
+                budgetPrecision = getBudgetPrecision();
+            }
+
+            if (budgetPrecision > precision) {
+                if (!degradePrecision(budgetPrecision)) {
+                    while (!worklist.empty())
+                        worklist.pop();
+                    break;
+                }
+                // process everything again with the new abstraction
+                for (const auto &nd : PG->getNodes()) {
+                    if (nd)
+                        enqueueWorklist(nd.get());
+                }
+            }
+#if DEBUG_ENABLED
+            if (n % DUMP_NTH_ITER == 0) {
+                DBG(pta,
+                    "Iteration " << n << ", queue size " << worklist.size());
+            }
+#endif
+        }
+        lastPos = item.first;
+
+        bool memoryChanged = analysis<Impl>()->beforeProcessed(cur);
+        bool changed = processNode<Impl>(cur);
+        if (analysis<Impl>()->afterProcessed(cur)) {
+            memoryChanged = true;
+            // the node has not seen the changes made after processing it
+            enqueueWorklist(cur);
+        }
+
+        if (changed) {
+            // e.g., a function called via a pointer was added
+            if (changesGraph(cur))
+                insertIntoWorklistOrder(cur);
+            if (!changesOnlyPointsTo(cur))
+                memoryChanged = true;
+
+            for (auto *user : cur->getUsers())
+                enqueueWorklist(user);
+        }
+
+        if (propagation == MemoryPropagation::DEF_USE) {
+            if (memoryChanged) {
+                for (PSNode *user : analysis<Impl>()->getMemoryUsers(cur))
+                    enqueueWorklist(user);
+            }
+            continue;
+        }
+
+        // the memory is the same everywhere, its readers
+        // have been queued when the memory changed
+        if (propagation == MemoryPropagation::READERS)
+            continue;
+
+        // the position of 'cur' may have changed
+        // if the order has been recomputed
+        auto id = cur->getID();
+        auto epoch = pendingEpoch[id];
+        if (memoryChanged)
+            epoch = ++memoryEpoch;
+
+        // propagate the change of memory to the successors, they
+        // may not change, but the nodes further in the flow may
+        // (e.g., loads that share the memory with the successors)
+        if (epoch > propagatedEpoch[id]) {
+            propagatedEpoch[id] = epoch;
+            PointerGraph::forEachSuccessor(cur, [this, epoch](PSNode *s) {
+                enqueueWorklist(s);
+                if (s->getID() < pendingEpoch.size()) {
+                    pendingEpoch[s->getID()] =
+                            std::max(pendingEpoch[s->getID()], epoch);
+                }
+            });
+        }
+    }
+
+    worklistRunning = false;
+    queueMemoryReaders = false;
+    return n;
+}
+
+// the nodes whose processing only reads the points-to sets
+// and memory and writes the points-to set of the node
+bool PointerAnalysis::canProcessInParallel(PSNode *node) {
+    switch (node->getType()) {
+    case PSNodeType::LOAD:
+    case PSNodeType::GEP:
+    case PSNodeType::CAST:
+    case PSNodeType::PHI:
+    case PSNodeType::RETURN:
+    case PSNodeType::CALL_RETURN:
+        return true;
+    default:
+        return false;
+    }
+}
+
+template <typename Impl>
+void PointerAnalysis::processInParallel(CollectedPointers &C) {
+    switch (C.node->getType()) {
+    case PSNodeType::LOAD:
+        processLoad<Impl>(C.node, &C);
+        break;
+    case PSNodeType::GEP:
+        processGep(C.node, &C);
+        break;
+    default:
+        processCopy(C.node, &C);
+    }
+}
+
+template <typename Impl>
+bool PointerAnalysis::parallelIteration() {
+    assert(changed.empty());
+
+    std::vector<CollectedPointers> collected(to_process.size());
+    std::vector<CollectedPointers *> parallel;
+    for (size_t i = 0, e = to_process.size(); i < e; ++i) {
+        if (canProcessInParallel(to_process[i]) && !isInert(to_process[i])) {
+            collected[i].node = to_process[i];
+            parallel.push_back(&collected[i]);
+        }
+    }
+
+    // the threads take chunks of nodes until all nodes are processed
+    const size_t chunk = 64;
+    std::atomic<size_t> next{0};
+    auto worker = [&]() {
+        size_t i;
+        while ((i = next.fetch_add(chunk)) < parallel.size()) {
+            for (size_t e = std::min(i + chunk, parallel.size()); i < e; ++i)
+                processInParallel<Impl>(*parallel[i]);
+        }
+    };
+
+    // it does not pay off to start threads for a few nodes
+    const size_t threadsNum =
+            std::min<size_t>(options.solverThreads, parallel.size() / chunk);
+    if (threadsNum > 1) {
+        // the threads must use the same table of pointer IDs as we do
+        auto &pointerIDs = PointerIDLookupTable::current();
+        PointsToSetT::setConcurrent(true);
+        std::vector<std::thread> threads;
+        threads.reserve(threadsNum - 1);
+        for (size_t i = 1; i < threadsNum; ++i) {
+            threads.emplace_back([&]() {
+                PointerIDLookupTable::Scope scope(pointerIDs);
+                worker();
+            });
         }
+        worker();
+        for (auto &thr : threads)
+            thr.join();
+        PointsToSetT::setConcurrent(false);
+    } else {
+        worker();
     }
+
+    // add the collected pointers and process the rest of nodes
+    // in the order as in the sequential iteration
+    for (size_t i = 0, e = to_process.size(); i < e; ++i) {
+        PSNode *cur = to_process[i];
+        bool enq = false;
+        if (collected[i].node) {
+            for (const auto &ptr : collected[i].pointers)
+                enq |= cur->addPointsTo(ptr);
+            if (stats)
+                stats->addVisit(cur->getType(), enq, 0);
+        } else {
+            enq |= analysis<Impl>()->beforeProcessed(cur);
+            enq |= processNode<Impl>(cur);
+            enq |= analysis<Impl>()->afterProcessed(cur);
+        }
+
+        if (enq)
+            analysis<Impl>()->enqueue(cur);
+    }
+
+    return !changed.empty();
+}
+
+template <typename Impl>
+bool PointerAnalysis::iteration() {
+    assert(changed.empty());
+
+    for (PSNode *cur : to_process) {
+        bool enq = false;
+        enq |= analysis<Impl>()->beforeProcessed(cur);
+        enq |= processNode<Impl>(cur);
+        enq |= analysis<Impl>()->afterProcessed(cur);
+
+        if (enq)
+            analysis<Impl>()->enqueue(cur);
+    }
+
+    return !changed.empty();
+}
+
+size_t PointerAnalysis::getPointsToMemory() const {
+    size_t bytes = PointsToSetT::getSharedMemoryUsage();
+    for (const auto &nd : PG->getNodes()) {
+        if (nd)
+            bytes += nd->pointsTo.getMemoryUsage();
+    }
+    return bytes;
+}
+
+void PointerAnalysis::iterationStatistics(size_t queued) {
+    stats->worklistSizes.push_back(queued);
+    stats->addPointsToMemorySample(getPointsToMemory());
+}
+
+void PointerAnalysis::finishStatistics() {
+    assert(stats && "Do not gather statistics");
+
+    stats->pointsToSizes.clear();
+    stats->maxPointsToSize = 0;
+    for (const auto &nd : PG->getNodes()) {
+        if (nd)
+            stats->addPointsToSize(nd->pointsTo.size());
+    }
+
+    stats->memoryObjects = 0;
+    stats->memoryObjectsOffsets = 0;
+    stats->pointsToMemory = getPointsToMemory();
+    stats->addPointsToMemorySample(stats->pointsToMemory);
+    collectMemoryStatistics(*stats);
 }
 
-bool PointerAnalysis::run() {
+bool PointerAnalysis::run() { return solve<PointerAnalysis>(); }
+
+template <typename Impl>
+bool PointerAnalysis::solve() {
     DBG_SECTION_BEGIN(pta, "Running pointer analysis");
 
+    // the points-to sets use the pointer IDs of the analyzed graph
+    PointerIDLookupTable::Scope pointerIDs(PG->getPointerIDs());
+
+    startTime = std::chrono::steady_clock::now();
+    // measure the memory in the first iteration
+    processedSinceMemoryCheck = PG->size();
+
     preprocess();
 
     // check that the current state of pointer analysis makes sense
@@ -498,14 +1390,15 @@ bool PointerAnalysis::run() {
     // process global nodes, these must reach fixpoint after one iteration
     DBG(pta, "Processing global nodes");
     queue_globals();
-    iteration();
+    iteration<Impl>();
     assert((to_process.clear(), changed.clear(), queue_globals(),
-            !iteration()) &&
+            !iteration<Impl>()) &&
            "Globals did not reach fixpoint");
     to_process.clear();
     changed.clear();
 
-    initialize_queue();
+    if (options.unificationPrepass)
+        unificationPrepass();
 
     // override the pre-set value
     if (options.maxIterations > 0) {
@@ -514,28 +1407,60 @@ bool PointerAnalysis::run() {
     }
 
     size_t n = 0;
-    // do fixpoint
-    do {
-        if (options.maxIterations > 0 && n > options.maxIterations) {
-            DBG(pta, "Reached the maximum number of iterations: " << n);
-            setToEmpty(to_process);
-            to_process.clear();
-            break;
-        }
+    if (options.sccOrderedWorklist ||
+        analysis<Impl>()->memoryPropagation() ==
+                MemoryPropagation::DEF_USE) {
+        n = runWorklist<Impl>();
+    } else {
+        initialize_queue();
+
+        // do fixpoint
+        do {
+            auto budgetPrecision = precision;
+            if (options.maxIterations > 0 && n > options.maxIterations) {
+                DBG(pta, "Reached the maximum number of iterations: " << n);
+                budgetPrecision = Precision::UNKNOWN_MEMORY;
+            } else if (hasBudget()) {
+                budgetPrecision = getBudgetPrecision();
+            }
+
+            if (budgetPrecision > precision) {
+                to_process.clear();
+                if (!degradePrecision(budgetPrecision))
+                    break;
+                // process everything again with the new abstraction
+                initialize_queue();
+            }
 #if DEBUG_ENABLED
-#define DUMP_NTH_ITER 100
-        if (n % DUMP_NTH_ITER == 0) {
-            DBG(pta, "Iteration " << n << ", queue size " << to_process.size());
-        }
+            if (n % DUMP_NTH_ITER == 0) {
+                DBG(pta, "Iteration " << n << ", queue size "
+                                      << to_process.size());
+            }
 #endif
-        ++n;
+            ++n;
+            if (stats)
+                iterationStatistics(to_process.size());
+            processedSinceMemoryCheck += to_process.size();
 
-        iteration();
-        queue_changed();
-    } while (!to_process.empty());
+            if (useParallelSolver())
+                parallelIteration<Impl>();
+            else
+                iteration<Impl>();
+            queue_changed();
+        } while (!to_process.empty());
+    }
 
     DBG(pta, "Reached fixpoint after " << n << " iterations\n");
 
+    if (stats) {
+        stats->iterations += n;
+        finishStatistics();
+    }
+
+    // the history of points-to sets is not needed anymore
+    if (options.diffPropagation)
+        dropPointsToHistory();
+
     assert(to_process.empty());
     assert(changed.empty());
 
@@ -553,8 +1478,19 @@ bool PointerAnalysis::run() {
 
     DBG_SECTION_END(pta, "Running pointer analysis done");
 
-    return options.maxIterations > 0 ? n <= options.maxIterations : true;
+    return precision != Precision::UNKNOWN_MEMORY;
 }
 
+// the generic solver (used also by the clients of the analysis)
+template bool PointerAnalysis::processNode<PointerAnalysis>(PSNode *node);
+template bool PointerAnalysis::iteration<PointerAnalysis>();
+// the solvers specialized for the analyses (see PointerAnalysisSolver)
+template bool
+PointerAnalysis::solve<PointerAnalysisSolver<PointerAnalysisFIBase>>();
+template bool
+PointerAnalysis::solve<PointerAnalysisSolver<PointerAnalysisFSBase>>();
+template bool
+PointerAnalysis::solve<PointerAnalysisSolver<PointerAnalysisFSInvBase>>();
+
 } // namespace pta
 } // namespace dg
@@ -0,0 +1,77 @@
+#include "dg/PointerAnalysis/PointerAnalysisStatistics.h"
+
+namespace dg {
+namespace pta {
+
+void PointerAnalysisStatistics::addPointsToSize(size_t size) {
+    size_t bucket = 0;
+    for (size_t s = size; s > 0; s >>= 1)
+        ++bucket;
+
+    if (pointsToSizes.size() <= bucket)
+        pointsToSizes.resize(bucket + 1);
+    ++pointsToSizes[bucket];
+
+    if (size > maxPointsToSize)
+        maxPointsToSize = size;
+}
+
+template <typename ContT>
+static void dumpArray(std::ostream &os, const ContT &cont) {
+    os << "[";
+    bool first = true;
+    for (const auto &it : cont) {
+        if (!first)
+            os << ", ";
+        first = false;
+        os << it;
+    }
+    os << "]";
+}
+
+void PointerAnalysisStatistics::dumpJSON(std::ostream &os) const {
+    os << "{\n";
+    os << "  \"iterations\": " << iterations << ",\n";
+    os << "  \"worklist_sizes\": ";
+    dumpArray(os, worklistSizes);
+    os << ",\n";
+
+    os << "  \"nodes\": {";
+    bool first = true;
+    for (size_t i = 0; i < NODE_TYPES_NUM; ++i) {
+        const auto &S = nodeTypes[i];
+        if (S.visits == 0)
+            continue;
+
+        if (!first)
+            os << ",";
+        first = false;
+        // skip the "PSNodeType::" prefix
+        const char *name = PSNodeTypeToCString(static_cast<PSNodeType>(i));
+        os << "\n    \"" << (name + 12) << "\": {\"visits\": " << S.visits
+           << ", \"changes\": " << S.changes
+           << ", \"time_ns\": " << S.nanoseconds << "}";
+    }
+    os << "\n  },\n";
+
+    os << "  \"function_pointer_calls\": " << functionPointerCalls << ",\n";
+    os << "  \"forked_functions\": " << forkedFunctions << ",\n";
+
+    // the upper bounds of the buckets of the histogram
+    os << "  \"points_to_sizes\": {";
+    for (size_t i = 0; i < pointsToSizes.size(); ++i) {
+        if (i > 0)
+            os << ",";
+        os << "\n    \"<" << (size_t(1) << i) << "\": " << pointsToSizes[i];
+    }
+    os << "\n  },\n";
+    os << "  \"max_points_to_size\": " << maxPointsToSize << ",\n";
+    os << "  \"memory_objects\": " << memoryObjects << ",\n";
+    os << "  \"memory_objects_offsets\": " << memoryObjectsOffsets << ",\n";
+    os << "  \"points_to_memory\": " << pointsToMemory << ",\n";
+    os << "  \"peak_points_to_memory\": " << peakPointsToMemory << "\n";
+    os << "}\n";
+}
+
+} // namespace pta
+} // namespace dg
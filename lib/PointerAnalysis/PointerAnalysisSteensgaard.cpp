@@ -0,0 +1,538 @@
+#include <algorithm>
+#include <iterator>
+#include <utility>
+
+#include "dg/PointerAnalysis/PointerAnalysisSteensgaard.h"
+
+#include "dg/util/debug.h"
+
+namespace dg {
+namespace pta {
+
+constexpr unsigned PointerAnalysisSteensgaard::NONE;
+constexpr size_t PointerAnalysisSteensgaard::MAX_OFFSETS;
+
+unsigned PointerAnalysisSteensgaard::newElement(uint8_t f) {
+    const unsigned e = parent.size();
+    parent.push_back(e);
+    rank.push_back(0);
+    pointee.push_back(NONE);
+    flags.push_back(f);
+    return e;
+}
+
+unsigned PointerAnalysisSteensgaard::find(unsigned e) {
+    // path halving
+    while (parent[e] != e) {
+        parent[e] = parent[parent[e]];
+        e = parent[e];
+    }
+    return e;
+}
+
+unsigned PointerAnalysisSteensgaard::getPointee(unsigned e) {
+    const unsigned r = find(e);
+    if (pointee[r] == NONE) {
+        // the contents of unknown memory are unknown
+        const unsigned p = newElement(flags[r] & HAS_UNKNOWN);
+        pointee[r] = p;
+        return p;
+    }
+    return find(pointee[r]);
+}
+
+void PointerAnalysisSteensgaard::addFlags(unsigned e, uint8_t f) {
+    e = find(e);
+    while ((flags[e] & f) != f) {
+        flags[e] |= f;
+        // only the unknown memory is propagated to the contents
+        f &= HAS_UNKNOWN;
+        if (f == 0 || pointee[e] == NONE)
+            break;
+        e = find(pointee[e]);
+    }
+}
+
+void PointerAnalysisSteensgaard::unify(unsigned a, unsigned b) {
+    std::vector<std::pair<unsigned, unsigned>> pending{{a, b}};
+    while (!pending.empty()) {
+        a = find(pending.back().first);
+        b = find(pending.back().second);
+        pending.pop_back();
+        if (a == b)
+            continue;
+
+        if (rank[a] < rank[b])
+            std::swap(a, b);
+        parent[b] = a;
+        if (rank[a] == rank[b])
+            ++rank[a];
+
+        if (pointee[a] == NONE)
+            pointee[a] = pointee[b];
+        else if (pointee[b] != NONE)
+            pending.emplace_back(pointee[a], pointee[b]);
+
+        const uint8_t f = flags[a] | flags[b];
+        flags[a] = f;
+        if ((f & HAS_UNKNOWN) && pointee[a] != NONE)
+            addFlags(pointee[a], HAS_UNKNOWN);
+    }
+}
+
+unsigned PointerAnalysisSteensgaard::getValue(PSNode *node) {
+    assert(!isSpecial(node) && "The special nodes have no classes");
+    const auto id = node->getID();
+    if (valueElem.size() <= id)
+        valueElem.resize(id + 1, NONE);
+    if (valueElem[id] == NONE)
+        valueElem[id] = newElement();
+    return valueElem[id];
+}
+
+unsigned PointerAnalysisSteensgaard::getObject(PSNode *node) {
+    assert(!isSpecial(node) && "The special nodes have no classes");
+    const auto id = node->getID();
+    if (objectElem.size() <= id)
+        objectElem.resize(id + 1, NONE);
+    if (objectElem[id] == NONE)
+        objectElem[id] = newElement(HAS_OBJECTS);
+    return objectElem[id];
+}
+
+uint8_t PointerAnalysisSteensgaard::specialFlag(const PSNode *node) {
+    if (node->isNull())
+        return HAS_NULL;
+    if (node->isUnknownMemory())
+        return HAS_UNKNOWN;
+    assert(node->isInvalidated());
+    return HAS_INVALIDATED;
+}
+
+void PointerAnalysisSteensgaard::addPointers(unsigned cls, PSNode *op) {
+    if (isSpecial(op))
+        addFlags(cls, specialFlag(op));
+    else
+        unify(cls, getPointed(op));
+}
+
+void PointerAnalysisSteensgaard::addTarget(unsigned cls, PSNode *target) {
+    if (isSpecial(target))
+        addFlags(cls, specialFlag(target));
+    else
+        unify(cls, getObject(target));
+}
+
+void PointerAnalysisSteensgaard::processNode(PSNode *node) {
+    const auto id = node->getID();
+    if (processed.size() <= id)
+        processed.resize(id + 1, 0);
+
+    auto &done = processed[id];
+    const auto opsNum = node->getOperandsNum();
+
+    switch (node->getType()) {
+    case PSNodeType::PHI:
+    case PSNodeType::CAST:
+    case PSNodeType::GEP:
+    case PSNodeType::RETURN:
+    case PSNodeType::CALL_RETURN:
+        for (; done < opsNum; ++done)
+            addPointers(getPointed(node), node->getOperand(done));
+        return;
+    default:
+        break;
+    }
+
+    // the other nodes do not get new operands
+    if (done > 0)
+        return;
+    done = 1;
+
+    switch (node->getType()) {
+    case PSNodeType::ALLOC:
+        unify(getPointed(node), getObject(node));
+        if (PSNodeAlloc::get(node)->isZeroInitialized())
+            addFlags(getPointee(getObject(node)), HAS_NULL);
+        break;
+    case PSNodeType::FUNCTION:
+        unify(getPointed(node), getObject(node));
+        break;
+    case PSNodeType::CONSTANT:
+        addTarget(getPointed(node), PSNodeConstant::get(node)->getTarget());
+        break;
+    case PSNodeType::LOAD: {
+        PSNode *ptr = node->getOperand(0);
+        // load from null or invalidated memory yields nothing
+        if (ptr->isUnknownMemory())
+            addFlags(getPointed(node), HAS_UNKNOWN);
+        else if (!isSpecial(ptr))
+            unify(getPointed(node), getContents(ptr));
+        break;
+    }
+    case PSNodeType::STORE: {
+        // store to special memory is ignored
+        // the same way as in the inclusion-based analysis
+        PSNode *ptr = node->getOperand(1);
+        if (!isSpecial(ptr))
+            addPointers(getContents(ptr), node->getOperand(0));
+        break;
+    }
+    case PSNodeType::MEMCPY: {
+        PSNodeMemcpy *memcpy = PSNodeMemcpy::get(node);
+        PSNode *src = memcpy->getSource();
+        PSNode *dest = memcpy->getDestination();
+        if (!isSpecial(src) && !isSpecial(dest))
+            unify(getContents(dest), getContents(src));
+        break;
+    }
+    default:
+        // the calls via pointers are resolved after unification,
+        // the other nodes do not yield or store pointers
+        break;
+    }
+}
+
+std::vector<PSNode *> PointerAnalysisSteensgaard::getReachableNodes() {
+    std::vector<PSNode *> nodes(PG->getGlobals().begin(),
+                                PG->getGlobals().end());
+    auto reachable = PG->getNodes(PG->getEntry()->getRoot());
+    nodes.insert(nodes.end(), reachable.begin(), reachable.end());
+
+    // constants need not be in the graph, they are only operands
+    std::vector<bool> seen(PG->getNodes().size());
+    for (PSNode *node : nodes)
+        seen[node->getID()] = true;
+    const auto size = nodes.size();
+    for (size_t i = 0; i < size; ++i) {
+        for (PSNode *op : nodes[i]->getOperands()) {
+            if (op->getType() == PSNodeType::CONSTANT && !seen[op->getID()]) {
+                seen[op->getID()] = true;
+                nodes.push_back(op);
+            }
+        }
+    }
+    return nodes;
+}
+
+// join the offsets 'from' into 'to', return true if 'to' changed
+bool PointerAnalysisSteensgaard::joinOffsets(Offsets &to,
+                                             const Offsets &from) {
+    if (isUnknown(to) || from.empty())
+        return false;
+
+    Offsets joined;
+    joined.reserve(to.size() + from.size());
+    std::set_union(to.begin(), to.end(), from.begin(), from.end(),
+                   std::back_inserter(joined));
+    if (joined.size() == to.size())
+        return false;
+
+    if (joined.size() > MAX_OFFSETS || joined.back() == Offset::UNKNOWN)
+        to.assign(1, Offset::UNKNOWN);
+    else
+        to.swap(joined);
+    return true;
+}
+
+PointerAnalysisSteensgaard::Offsets
+PointerAnalysisSteensgaard::getOffsets(const PSNode *node) const {
+    if (node->isUnknownMemory())
+        return {Offset::UNKNOWN};
+    if (isSpecial(node))
+        return {0};
+    return offsets[node->getID()];
+}
+
+// join the offsets into the offsets of pointers stored
+// in the class 'cls' and queue the readers of the class
+void PointerAnalysisSteensgaard::joinContentsOffsets(
+        unsigned cls, const Offsets &offs, std::vector<PSNode *> &queue) {
+    cls = find(cls);
+    if (!joinOffsets(contentsOffsets[cls], offs))
+        return;
+
+    auto it = contentsReaders.find(cls);
+    if (it != contentsReaders.end())
+        queue.insert(queue.end(), it->second.begin(), it->second.end());
+}
+
+// compute the offsets of pointers of the node from its operands,
+// return true if the offsets changed. The offsets only grow
+// (and collapse to the unknown offset when there are too many)
+bool PointerAnalysisSteensgaard::computeOffsets(PSNode *node,
+                                                std::vector<PSNode *> &queue) {
+    Offsets offs;
+
+    switch (node->getType()) {
+    case PSNodeType::ALLOC:
+        if (PSNodeAlloc::get(node)->isZeroInitialized())
+            joinContentsOffsets(getContents(node), {0}, queue);
+        // fall-through
+    case PSNodeType::FUNCTION:
+        offs.push_back(0);
+        break;
+    case PSNodeType::CONSTANT:
+        offs.push_back(*PSNodeConstant::get(node)->getOffset());
+        break;
+    case PSNodeType::LOAD: {
+        PSNode *ptr = node->getOperand(0);
+        if (ptr->isUnknownMemory()) {
+            offs.push_back(Offset::UNKNOWN);
+        } else if (!isSpecial(ptr)) {
+            auto it = contentsOffsets.find(find(getContents(ptr)));
+            if (it != contentsOffsets.end())
+                offs = it->second;
+        }
+        break;
+    }
+    case PSNodeType::STORE: {
+        PSNode *ptr = node->getOperand(1);
+        if (!isSpecial(ptr))
+            joinContentsOffsets(getContents(ptr),
+                                getOffsets(node->getOperand(0)), queue);
+        return false;
+    }
+    case PSNodeType::MEMCPY: {
+        PSNodeMemcpy *memcpy = PSNodeMemcpy::get(node);
+        PSNode *src = memcpy->getSource();
+        PSNode *dest = memcpy->getDestination();
+        if (isSpecial(src) || isSpecial(dest))
+            return false;
+        auto it = contentsOffsets.find(find(getContents(src)));
+        if (it != contentsOffsets.end())
+            joinContentsOffsets(getContents(dest), Offsets(it->second),
+                                queue);
+        return false;
+    }
+    case PSNodeType::GEP: {
+        const Offset gepOff = PSNodeGep::get(node)->getOffset();
+        Offsets shifted;
+        for (auto o : getOffsets(node->getOperand(0))) {
+            Offset off = Offset(o) + gepOff;
+            if (!off.isUnknown() && *off >= *options.fieldSensitivity)
+                off = Offset::UNKNOWN;
+            shifted.push_back(*off);
+        }
+        std::sort(shifted.begin(), shifted.end());
+        shifted.erase(std::unique(shifted.begin(), shifted.end()),
+                      shifted.end());
+        joinOffsets(offs, shifted);
+        break;
+    }
+    case PSNodeType::PHI:
+    case PSNodeType::CAST:
+    case PSNodeType::RETURN:
+    case PSNodeType::CALL_RETURN:
+        for (PSNode *op : node->getOperands())
+            joinOffsets(offs, getOffsets(op));
+        break;
+    default:
+        return false;
+    }
+
+    return joinOffsets(offsets[node->getID()], offs);
+}
+
+void PointerAnalysisSteensgaard::computeOffsets(
+        const std::vector<PSNode *> &nodes) {
+    offsets.resize(PG->getNodes().size());
+
+    // the classes do not change here, gather the nodes
+    // that read the offsets stored in the classes
+    contentsReaders.clear();
+    for (PSNode *node : nodes) {
+        PSNode *ptr = nullptr;
+        if (node->getType() == PSNodeType::LOAD)
+            ptr = node->getOperand(0);
+        else if (node->getType() == PSNodeType::MEMCPY)
+            ptr = PSNodeMemcpy::get(node)->getSource();
+        if (ptr && !isSpecial(ptr))
+            contentsReaders[find(getContents(ptr))].push_back(node);
+    }
+
+    // every node and class changes its offsets
+    // at most MAX_OFFSETS + 1 times
+    std::vector<PSNode *> queue(nodes.rbegin(), nodes.rend());
+    while (!queue.empty()) {
+        PSNode *cur = queue.back();
+        queue.pop_back();
+        if (computeOffsets(cur, queue)) {
+            for (PSNode *user : cur->getUsers())
+                queue.push_back(user);
+        }
+    }
+}
+
+void PointerAnalysisSteensgaard::groupObjects() {
+    classObjects.clear();
+    classSets.clear();
+    for (const auto &nd : PG->getNodes()) {
+        if (!nd)
+            continue;
+        const auto id = nd->getID();
+        if (id < objectElem.size() && objectElem[id] != NONE)
+            classObjects[find(objectElem[id])].push_back(nd.get());
+    }
+}
+
+const PointsToSetT &PointerAnalysisSteensgaard::getClassSet(unsigned cls,
+                                                            Offset off) {
+    cls = find(cls);
+    auto it = classSets.find({cls, *off});
+    if (it != classSets.end())
+        return it->second;
+
+    // the same rules as for GEPs in the inclusion-based analysis
+    auto getTargetOffset = [off](const PSNode *target) -> Offset {
+        if (off.isUnknown() || off.isZero() || *off < target->getSize())
+            return off;
+        return Offset::UNKNOWN;
+    };
+
+    PointsToSetT &S = classSets[{cls, *off}];
+    for (PSNode *target : classObjects[cls])
+        S.add(target, getTargetOffset(target));
+
+    if (flags[cls] & HAS_NULL)
+        S.add(NULLPTR, getTargetOffset(NULLPTR));
+    if (flags[cls] & HAS_UNKNOWN)
+        S.add(UnknownPointer);
+    if (flags[cls] & HAS_INVALIDATED)
+        S.add(INVALIDATED, getTargetOffset(INVALIDATED));
+
+    return S;
+}
+
+void PointerAnalysisSteensgaard::setPointsTo(
+        const std::vector<PSNode *> &nodes) {
+    for (PSNode *node : nodes) {
+        switch (node->getType()) {
+        case PSNodeType::LOAD:
+        case PSNodeType::GEP:
+        case PSNodeType::CAST:
+        case PSNodeType::PHI:
+        case PSNodeType::RETURN:
+        case PSNodeType::CALL_RETURN:
+            break;
+        default:
+            // the other nodes have constant points-to sets
+            // or do not yield pointers
+            continue;
+        }
+
+        const auto id = node->getID();
+        if (id >= valueElem.size() || valueElem[id] == NONE)
+            continue;
+
+        const unsigned r = find(valueElem[id]);
+        if (pointee[r] == NONE)
+            continue;
+        // e.g., a load of memory with no pointers stored
+        if (offsets[id].empty()) {
+            node->addPointsTo(getClassSet(pointee[r], Offset::UNKNOWN));
+            continue;
+        }
+        for (auto off : offsets[id])
+            node->addPointsTo(getClassSet(pointee[r], off));
+    }
+}
+
+bool PointerAnalysisSteensgaard::resolveCalls(
+        const std::vector<PSNode *> &nodes) {
+    bool changed = false;
+    for (PSNode *node : nodes) {
+        if (node->getType() == PSNodeType::JOIN) {
+            changed |= handleJoin(node);
+            continue;
+        }
+
+        if (node->getType() != PSNodeType::CALL_FUNCPTR &&
+            node->getType() != PSNodeType::FORK)
+            continue;
+
+        PSNode *op = node->getOperand(0);
+        if (isSpecial(op))
+            continue;
+
+        // copy the objects, resolving the call adds new nodes
+        const auto objects = classObjects[find(getPointed(op))];
+        for (PSNode *target : objects) {
+            if (target->getType() != PSNodeType::FUNCTION ||
+                !node->addPointsTo(target, 0))
+                continue;
+
+            changed = true;
+            if (node->getType() == PSNodeType::FORK)
+                handleFork(node, target);
+            else
+                functionPointerCall(node, target);
+        }
+    }
+    return changed;
+}
+
+void PointerAnalysisSteensgaard::unifyClasses() {
+    for (PSNode *node : getReachableNodes())
+        processNode(node);
+}
+
+bool PointerAnalysisSteensgaard::mayPointTo(PSNode *node) {
+    if (isSpecial(node))
+        return true;
+
+    const auto id = node->getID();
+    if (id >= processed.size() || processed[id] == 0)
+        return true;
+    if (id >= valueElem.size() || valueElem[id] == NONE)
+        return false;
+    const unsigned r = find(valueElem[id]);
+    return pointee[r] != NONE && flags[find(pointee[r])] != 0;
+}
+
+bool PointerAnalysisSteensgaard::pointToSameClass(PSNode *a, PSNode *b) {
+    if (isSpecial(a) || isSpecial(b))
+        return false;
+    return getPointed(a) == getPointed(b);
+}
+
+bool PointerAnalysisSteensgaard::run() {
+    DBG_SECTION_BEGIN(pta, "Running unification-based pointer analysis");
+
+    // the points-to sets use the pointer IDs of the analyzed graph
+    PointerIDLookupTable::Scope pointerIDs(PG->getPointerIDs());
+
+    // the calls via pointers add new nodes and operands,
+    // unify them until no new function is called
+    size_t rounds = 0;
+    bool changed;
+    do {
+        ++rounds;
+        auto nodes = getReachableNodes();
+        for (PSNode *node : nodes)
+            processNode(node);
+
+        computeOffsets(nodes);
+        groupObjects();
+        setPointsTo(nodes);
+        changed = resolveCalls(nodes);
+    } while (changed);
+
+    DBG(pta, "Unified " << parent.size() << " elements in " << rounds
+                        << " rounds");
+
+    // the sets are shared by the nodes now
+    decltype(classSets)().swap(classSets);
+    decltype(classObjects)().swap(classObjects);
+    decltype(contentsOffsets)().swap(contentsOffsets);
+    decltype(contentsReaders)().swap(contentsReaders);
+
+    if (getStatistics())
+        finishStatistics();
+
+    DBG_SECTION_END(pta, "Running unification-based pointer analysis done");
+    return true;
+}
+
+} // namespace pta
+} // namespace dg
@@ -1,4 +1,7 @@
+#include <algorithm>
 #include <cassert>
+#include <set>
+#include <vector>
 
 #include "dg/PointerAnalysis/PSNode.h"
 #include "dg/PointerAnalysis/PointerGraph.h"
@@ -42,6 +45,181 @@ void PointerGraph::remove(PSNode *nd) {
     nodes[nd->getID()].reset();
 }
 
+std::vector<PSNode *> PointerGraph::removeSubgraph(PointerSubgraph *subg) {
+    assert(subg != _entry && "Cannot remove the entry subgraph");
+    DBG_SECTION_BEGIN(pta, "Removing subgraph " << subg->getID());
+
+    std::set<PSNode *> removed;
+    removed.insert(subg->root);
+    if (subg->vararg)
+        removed.insert(subg->vararg);
+    for (const auto &nd : nodes) {
+        if (nd && nd->getParent() == subg)
+            removed.insert(nd.get());
+    }
+
+    // disconnect the calls of the subgraph
+    if (auto *entry = PSNodeEntry::get(subg->root)) {
+        for (PSNode *caller : entry->getCallers()) {
+            auto *C = PSNodeCall::get(caller);
+            if (!C || removed.count(C) > 0)
+                continue;
+
+            C->removeCallee(subg);
+            // the call does not return anywhere now, keep the caller
+            // connected to the return site (as calls of undefined functions)
+            if (C->getCallees().empty() && C->successorsNum() == 0 &&
+                C->getPairedNode())
+                C->addSuccessor(C->getPairedNode());
+        }
+    }
+    for (PSNode *ret : subg->returnNodes) {
+        if (auto *R = PSNodeRet::get(ret)) {
+            for (PSNode *site : R->getReturnSites()) {
+                if (auto *CR = PSNodeCallRet::get(site))
+                    CR->removeReturn(ret);
+            }
+        }
+    }
+
+    // disconnect the calls from the subgraph
+    for (PSNode *nd : removed) {
+        auto *C = PSNodeCall::get(nd);
+        if (!C)
+            continue;
+
+        for (PointerSubgraph *callee : C->getCallees()) {
+            if (callee == subg)
+                continue;
+            if (auto *entry = PSNodeEntry::get(callee->root))
+                entry->removeCaller(C);
+            for (PSNode *ret : callee->returnNodes) {
+                if (auto *R = PSNodeRet::get(ret))
+                    R->removeReturnSite(C->getPairedNode());
+            }
+        }
+    }
+
+    std::vector<PSNode *> affected;
+    for (PSNode *nd : removed) {
+        // copy the users, removing the operand changes them
+        auto users = nd->getUsers();
+        for (PSNode *user : users) {
+            if (removed.count(user) > 0)
+                continue;
+            user->removeOperand(nd);
+            affected.push_back(user);
+        }
+
+        nd->removeAllOperands();
+        nd->removeAllEdges();
+    }
+
+    // remove the pointers to the removed nodes
+    std::vector<PSNode *> targets;
+    for (const auto &nd : nodes) {
+        if (!nd || removed.count(nd.get()) > 0)
+            continue;
+
+        for (const auto &ptr : nd->pointsTo) {
+            if (removed.count(ptr.target) > 0)
+                targets.push_back(ptr.target);
+        }
+        for (PSNode *target : targets)
+            nd->pointsTo.removeAny(target);
+        targets.clear();
+    }
+
+    for (PSNode *nd : removed)
+        remove(nd);
+
+    auto it = std::find_if(_subgraphs.begin(), _subgraphs.end(),
+                           [subg](const std::unique_ptr<PointerSubgraph> &s) {
+                               return s.get() == subg;
+                           });
+    assert(it != _subgraphs.end() && "The subgraph is not in the graph");
+    _subgraphs.erase(it);
+
+    std::sort(affected.begin(), affected.end(),
+              [](PSNode *a, PSNode *b) { return a->getID() < b->getID(); });
+    affected.erase(std::unique(affected.begin(), affected.end()),
+                   affected.end());
+
+    DBG_SECTION_END(pta, "Removed " << removed.size() << " nodes, "
+                                    << affected.size() << " nodes affected");
+    return affected;
+}
+
+void PointerGraph::invalidatePointsTo(const std::vector<PSNode *> &nodes) {
+    std::set<PSNode *> visited;
+    std::vector<PSNode *> stack(nodes.begin(), nodes.end());
+    while (!stack.empty()) {
+        PSNode *cur = stack.back();
+        stack.pop_back();
+        if (!visited.insert(cur).second)
+            continue;
+
+        switch (cur->getType()) {
+        case PSNodeType::LOAD:
+        case PSNodeType::GEP:
+        case PSNodeType::CAST:
+        case PSNodeType::PHI:
+        case PSNodeType::CALL_RETURN:
+        case PSNodeType::RETURN:
+            cur->pointsTo.clear();
+            cur->dropPointsToHistory();
+            for (PSNode *user : cur->getUsers())
+                stack.push_back(user);
+            break;
+        default:
+            // the points-to set is not computed from the operands
+            // or the node does not have a points-to set
+            break;
+        }
+    }
+}
+
+void PointerGraph::adopt(PointerNodesPool &pool) {
+    // first give the nodes their IDs, the pointers in the points-to sets
+    // are hashed by the IDs of their targets
+    nodes.reserve(nodes.size() + pool._nodes.size());
+    for (auto &nd : pool._nodes) {
+        nd->setID(getNewNodeId());
+        nodes.push_back(std::move(nd));
+    }
+
+    // The points-to sets were created with the table of the pool, create
+    // them again with the table of this graph. The sets may point only
+    // to the nodes of this graph (or to the nodes from the pool).
+    PointerIDLookupTable::Scope pointerIDs(*_pointerIDs);
+    std::vector<Pointer> pointers;
+    for (size_t i = nodes.size() - pool._nodes.size(); i < nodes.size(); ++i) {
+        PSNode *nd = nodes[i].get();
+        pointers.clear();
+        for (const auto &ptr : nd->pointsTo)
+            pointers.push_back(ptr);
+        nd->pointsTo = PointsToSetT();
+        for (const auto &ptr : pointers)
+            nd->pointsTo.add(ptr);
+
+        nd->registerUsers();
+    }
+
+    _arena.take(pool._arena);
+    pool._nodes.clear();
+}
+
+void PointerGraph::clearNodesData() {
+    for (const auto &nd : nodes) {
+        if (nd)
+            nd->setData<void>(nullptr);
+    }
+
+    NULLPTR->setData<void>(nullptr);
+    UNKNOWN_MEMORY->setData<void>(nullptr);
+    INVALIDATED->setData<void>(nullptr);
+}
+
 void PointerGraph::initStaticNodes() {
     NULLPTR->pointsTo.clear();
     UNKNOWN_MEMORY->pointsTo.clear();
@@ -58,6 +236,18 @@ void PointerGraph::computeLoops() {
     }
 }
 
+void PointerGraph::updateLoops(PSNode *callsite) {
+    if (PSNodeCall *C = PSNodeCall::get(callsite)) {
+        for (auto *subg : C->getCallees()) {
+            if (!subg->computedLoops())
+                subg->computeLoops();
+        }
+    }
+
+    if (PointerSubgraph *caller = callsite->getParent())
+        caller->callInserted(callsite);
+}
+
 void PointerGraph::setEntry(PointerSubgraph *e) {
 #if DEBUG_ENABLED
     bool found = false;
@@ -72,6 +262,11 @@ void PointerGraph::setEntry(PointerSubgraph *e) {
     _entry = e;
 }
 
+static bool isOwnSuccessor(PSNode *n) {
+    return std::find(n->successors().begin(), n->successors().end(), n) !=
+           n->successors().end();
+}
+
 void PointerSubgraph::computeLoops() {
     // FIXME: remember just that a node is on loop, not the whole loops
 
@@ -81,13 +276,20 @@ void PointerSubgraph::computeLoops() {
 
     DBG(pta, "Computing information about loops");
 
-    // compute the strongly connected components
-    auto SCCs = SCC<PSNode>().compute(root);
+    // compute the strongly connected components, calls step over
+    // to their call returns, so that the loops do not depend on
+    // the called functions (which may be discovered later)
+    auto SCCs = computeSCCs(root, [](PSNode *n,
+                                     std::function<void(PSNode *)> F) {
+        for (auto *succ : n->successors())
+            F(succ);
+        PSNodeCall *C = PSNodeCall::get(n);
+        if (C && !C->getCallees().empty() && C->getPairedNode())
+            F(C->getPairedNode());
+    });
     for (auto &scc : SCCs) {
-        if (scc.empty())
-            continue;
         // self-loop is also loop
-        if (scc.size() == 1 && scc[0]->getSingleSuccessorOrNull() != scc[0])
+        if (scc.size() == 1 && !isOwnSuccessor(scc[0]))
             continue;
 
         _loops.push_back(std::move(scc));
@@ -99,5 +301,34 @@ void PointerSubgraph::computeLoops() {
     }
 }
 
+void PointerSubgraph::callInserted(PSNode *callsite) {
+    assert(callsite->getParent() == this && "The call is not from this graph");
+    if (!computedLoops())
+        return;
+
+    // the new nodes are on the paths from the call site to its call
+    // return, so they are on a loop only if the call site is
+    auto it = _node_to_loop.find(callsite);
+    if (it == _node_to_loop.end())
+        return;
+
+    const auto idx = it->second;
+    ADT::QueueLIFO<PSNode *> queue;
+    for (auto *succ : callsite->successors())
+        queue.push(succ);
+
+    while (!queue.empty()) {
+        PSNode *cur = queue.pop();
+        if (cur->getParent() != this ||
+            _node_to_loop.find(cur) != _node_to_loop.end())
+            continue;
+
+        _node_to_loop[cur] = idx;
+        _loops[idx].push_back(cur);
+        for (auto *succ : cur->successors())
+            queue.push(succ);
+    }
+}
+
 } // namespace pta
 } // namespace dg
@@ -1,3 +1,9 @@
+#include <algorithm>
+#include <map>
+#include <set>
+#include <tuple>
+#include <vector>
+
 #include "dg/PointerAnalysis/PointerGraphOptimizations.h"
 #include "dg/PointerAnalysis/PointerGraph.h"
 
@@ -9,6 +15,10 @@ static inline bool isStoreOfUnknown(PSNode *S, PSNode *to) {
             S->getOperand(0)->isUnknownMemory());
 }
 
+static inline bool isPinned(const std::set<PSNode *> *pinned, PSNode *nd) {
+    return pinned && pinned->count(nd) > 0;
+}
+
 static inline bool usersImplyUnknown(PSNode *alloc) {
     assert(alloc->getType() == PSNodeType::ALLOC);
 
@@ -51,6 +61,9 @@ void PSUnknownsReducer::processAllocs() {
                 // create a copy of users, as we will modify the container
                 auto tmp = nd->getUsers();
                 for (PSNode *user : tmp) {
+                    if (isPinned(pinned, user))
+                        continue;
+
                     if (user->getType() == PSNodeType::LOAD) {
                         // replace the uses of the load value by unknown
                         // (this is what would happen in the analysis)
@@ -66,7 +79,7 @@ void PSUnknownsReducer::processAllocs() {
                 // pointer to itself and may be queried for this pointer
             }
         } else if (nd->getType() == PSNodeType::PHI &&
-                   nd->getOperandsNum() == 0) {
+                   nd->getOperandsNum() == 0 && !isPinned(pinned, nd.get())) {
             auto tmp = nd->getUsers();
             for (PSNode *user : tmp) {
                 // replace the uses of this value with unknown
@@ -84,6 +97,36 @@ void PSUnknownsReducer::processAllocs() {
     }
 }
 
+// remove duplicate operands of PHI-like nodes
+// after some of their operands were merged
+static void removeDuplicateOperands(PSNode *nd) {
+    std::vector<PSNode *> ops;
+    ops.reserve(nd->getOperandsNum());
+    for (PSNode *op : nd->getOperands()) {
+        if (std::find(ops.begin(), ops.end(), op) == ops.end())
+            ops.push_back(op);
+    }
+
+    if (ops.size() == nd->getOperandsNum())
+        return;
+
+    nd->removeAllOperands();
+    for (PSNode *op : ops)
+        nd->addOperand(op);
+}
+
+// replace the uses of 'node' by 'rep'. Do not remove duplicate
+// operands in all users, e.g., a store would lose its operand
+static void replaceUses(PSNode *node, PSNode *rep) {
+    auto users = node->getUsers();
+    node->replaceAllUsesWith(rep, false /* removeDupl */);
+    for (PSNode *user : users) {
+        if (user->getType() == PSNodeType::PHI ||
+            user->getType() == PSNodeType::CALL_RETURN)
+            removeDuplicateOperands(user);
+    }
+}
+
 static inline bool allOperandsAreSame(PSNode *nd) {
     auto opNum = nd->getOperandsNum();
     if (opNum < 1)
@@ -105,6 +148,8 @@ void PSEquivalentNodesMerger::mergeCasts() {
             continue;
 
         PSNode *node = nodeptr.get();
+        if (isPinned(pinned, node))
+            continue;
 
         // cast is always 'a proxy' to the real value,
         // it does not change the pointers
@@ -121,7 +166,7 @@ void PSEquivalentNodesMerger::mergeCasts() {
 
 void PSEquivalentNodesMerger::merge(PSNode *node1, PSNode *node2) {
     // remove node1
-    node1->replaceAllUsesWith(node2);
+    replaceUses(node1, node2);
     removeNode(G, node1);
 
     // update the mapping
@@ -130,6 +175,110 @@ void PSEquivalentNodesMerger::merge(PSNode *node1, PSNode *node2) {
     ++merged_nodes_num;
 }
 
+static std::vector<unsigned> getOperandIDs(PSNode *nd) {
+    std::vector<unsigned> ids;
+    ids.reserve(nd->getOperandsNum());
+    for (PSNode *op : nd->getOperands())
+        ids.push_back(op->getID());
+
+    std::sort(ids.begin(), ids.end());
+    ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+    return ids;
+}
+
+bool PSPointerEquivalenceMerger::canMerge(PSNode *node) const {
+    if (isPinned(pinned, node))
+        return false;
+
+    switch (node->getType()) {
+    case PSNodeType::GEP:
+    case PSNodeType::PHI:
+        return node->getOperandsNum() > 0;
+    case PSNodeType::LOAD:
+        return flowInsensitive;
+    case PSNodeType::CALL_RETURN: {
+        // call-return of a call via function pointer
+        // gets new operands during the analysis
+        const PSNode *call = node->getPairedNode();
+        return node->getOperandsNum() > 0 &&
+               (!call || call->getType() == PSNodeType::CALL);
+    }
+    default:
+        return false;
+    }
+}
+
+void PSPointerEquivalenceMerger::merge(PSNode *node, PSNode *rep) {
+    replaceUses(node, rep);
+
+    if (node->getType() == PSNodeType::CALL_RETURN) {
+        // keep the call-return node in the graph, it is paired with
+        // the call and connected to the return nodes of the callee.
+        // It just does not have any operands now.
+        node->removeAllOperands();
+    } else {
+        removeNode(G, node);
+    }
+
+    mapping.add(node, rep);
+    ++merged_nodes_num;
+}
+
+unsigned PSPointerEquivalenceMerger::mergeEquivalent() {
+    using GepKey = std::pair<unsigned, Offset::type>;
+    using OperandsKey = std::vector<unsigned>;
+
+    std::map<GepKey, PSNode *> geps;
+    std::map<OperandsKey, PSNode *> phis;
+    std::map<OperandsKey, PSNode *> callrets;
+    std::map<unsigned, PSNode *> loads;
+
+    unsigned merged = 0;
+    for (const auto &nodeptr : G->getNodes()) {
+        if (!nodeptr)
+            continue;
+
+        PSNode *node = nodeptr.get();
+        if (!canMerge(node))
+            continue;
+
+        PSNode *&rep = [&]() -> PSNode *& {
+            switch (node->getType()) {
+            case PSNodeType::GEP: {
+                auto *GEP = PSNodeGep::get(node);
+                return geps[GepKey(GEP->getSource()->getID(),
+                                   *GEP->getOffset())];
+            }
+            case PSNodeType::PHI:
+                return phis[getOperandIDs(node)];
+            case PSNodeType::CALL_RETURN:
+                return callrets[getOperandIDs(node)];
+            default:
+                assert(node->getType() == PSNodeType::LOAD);
+                return loads[node->getOperand(0)->getID()];
+            }
+        }();
+
+        if (!rep) {
+            rep = node;
+            continue;
+        }
+
+        merge(node, rep);
+        ++merged;
+    }
+
+    return merged;
+}
+
+unsigned PSPointerEquivalenceMerger::run() {
+    // merging nodes can make their users equivalent
+    while (mergeEquivalent() > 0)
+        ;
+
+    return merged_nodes_num;
+}
+
 unsigned PSNoopRemover::run() {
     unsigned removed = 0;
     for (const auto &nd : G->getNodes()) {
@@ -86,22 +86,31 @@ static bool hasNonpointerOperand(const PSNode *nd) {
     );
 }
 
+// the nodes of the graph are stored at the position given by their ID
+bool PointerGraphValidator::isKnownNode(const PSNode *nd) const {
+    const auto &nodes = PS->getNodes();
+    return nd->getID() < nodes.size() && nodes[nd->getID()].get() == nd;
+}
+
 bool PointerGraphValidator::checkOperands() {
     bool invalid = false;
 
     std::set<const PSNode *> known_nodes;
     const auto &nodes = PS->getNodes();
 
-    for (const auto *g : PS->getGlobals()) {
-        if (!known_nodes.insert(g).second)
-            invalid |= reportInvalNode(
-                    g, "Global node multiple times in the graph");
+    if (first_node == 0) {
+        for (const auto *g : PS->getGlobals()) {
+            if (!known_nodes.insert(g).second)
+                invalid |= reportInvalNode(
+                        g, "Global node multiple times in the graph");
+        }
     }
 
     // globals are also normal nodes, so we must forget them now
     known_nodes.clear();
 
-    for (const auto &nd : nodes) {
+    for (size_t i = first_node; i < nodes.size(); ++i) {
+        const auto &nd = nodes[i];
         if (!nd)
             continue;
 
@@ -110,14 +119,15 @@ bool PointerGraphValidator::checkOperands() {
                                        "Node multiple times in the graph");
     }
 
-    for (const auto &ndptr : nodes) {
+    for (size_t i = first_node; i < nodes.size(); ++i) {
+        const auto &ndptr = nodes[i];
         if (!ndptr)
             continue;
 
         PSNode *nd = ndptr.get();
         for (const PSNode *op : nd->getOperands()) {
             if (op != NULLPTR && op != UNKNOWN_MEMORY && op != INVALIDATED &&
-                known_nodes.count(op) == 0) {
+                !isKnownNode(op)) {
                 invalid |= reportInvalOperands(
                         nd, "Node has unknown (maybe dangling) operand");
             }
@@ -223,9 +233,10 @@ std::set<const PSNode *> reachableNodes(const PSNode *nd) {
 bool PointerGraphValidator::checkEdges() {
     bool invalid = false;
 
-    // check incoming/outcoming edges of all nodes
+    // check incoming/outcoming edges of all (or the new) nodes
     const auto &nodes = PS->getNodes();
-    for (const auto &nd : nodes) {
+    for (size_t i = first_node; i < nodes.size(); ++i) {
+        const auto &nd = nodes[i];
         if (!nd)
             continue;
 
@@ -251,7 +262,8 @@ bool PointerGraphValidator::checkEdges() {
 
     // check that all nodes are reachable from the root
     const auto reachable = getReachableNodes(PS->getEntry()->getRoot());
-    for (const auto &nd : nodes) {
+    for (size_t i = first_node; i < nodes.size(); ++i) {
+        const auto &nd = nodes[i];
         if (!nd)
             continue;
 
@@ -15,11 +15,12 @@ std::vector<PSNode *> SmallOffsetsPointsToSet::idVector;
 std::vector<PSNode *> AlignedSmallOffsetsPointsToSet::idVector;
 std::vector<Pointer> AlignedPointerIdPointsToSet::idVector;
 std::map<PSNode *, size_t> SeparateOffsetsPointsToSet::ids;
-dg::PointerIDLookupTable PointerIdPointsToSet::lookupTable;
 std::map<PSNode *, size_t> SmallOffsetsPointsToSet::ids;
 std::map<PSNode *, size_t> AlignedSmallOffsetsPointsToSet::ids;
 std::map<Pointer, size_t> AlignedPointerIdPointsToSet::ids;
 
 } // namespace pta
 
+thread_local PointerIDLookupTable *PointerIDLookupTable::_current{nullptr};
+
 } // namespace dg
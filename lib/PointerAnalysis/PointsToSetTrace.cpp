@@ -0,0 +1,185 @@
+#include <cassert>
+#include <cstring>
+
+#include "dg/PointerAnalysis/PSNode.h"
+#include "dg/PointerAnalysis/PointsToSetTrace.h"
+
+namespace dg {
+namespace pta {
+
+static const char TRACE_MAGIC[] = {'D', 'G', 'P', 'T', 'S', 'E', 'T'};
+static const uint8_t TRACE_VERSION = 1;
+static const size_t BUFFER_SIZE = 1 << 16;
+
+PointsToSetTraceWriter *PointsToSetTraceWriter::_current{nullptr};
+
+PointsToSetTraceWriter::PointsToSetTraceWriter(FILE *file) : _file(file) {
+    _buffer.reserve(BUFFER_SIZE);
+    _buffer.insert(_buffer.end(), TRACE_MAGIC,
+                   TRACE_MAGIC + sizeof(TRACE_MAGIC));
+    _buffer.push_back(TRACE_VERSION);
+}
+
+PointsToSetTraceWriter::~PointsToSetTraceWriter() {
+    flush();
+    fclose(_file);
+}
+
+bool PointsToSetTraceWriter::start(const std::string &path) {
+    stop();
+
+    FILE *file = fopen(path.c_str(), "wb");
+    if (!file)
+        return false;
+
+    _current = new PointsToSetTraceWriter(file);
+    return true;
+}
+
+void PointsToSetTraceWriter::stop() {
+    delete _current;
+    _current = nullptr;
+}
+
+void PointsToSetTraceWriter::flush() {
+    if (!_buffer.empty())
+        fwrite(_buffer.data(), 1, _buffer.size(), _file);
+    _buffer.clear();
+}
+
+void PointsToSetTraceWriter::put(uint64_t num) {
+    while (num >= 0x80) {
+        _buffer.push_back(static_cast<uint8_t>(num) | 0x80);
+        num >>= 7;
+    }
+    _buffer.push_back(static_cast<uint8_t>(num));
+}
+
+uint64_t PointsToSetTraceWriter::create(PointsToSetOp op, uint64_t from) {
+    assert((op == PointsToSetOp::CREATE || op == PointsToSetOp::COPY ||
+            op == PointsToSetOp::MOVE) &&
+           "Not an operation that creates a set");
+    std::lock_guard<std::mutex> lock(_mutex);
+    uint64_t set = ++_lastSet;
+    _buffer.push_back(static_cast<uint8_t>(op));
+    put(set);
+    if (op != PointsToSetOp::CREATE)
+        put(from);
+    if (_buffer.size() >= BUFFER_SIZE)
+        flush();
+    return set;
+}
+
+void PointsToSetTraceWriter::write(PointsToSetOp op, uint64_t set) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _buffer.push_back(static_cast<uint8_t>(op));
+    put(set);
+    if (_buffer.size() >= BUFFER_SIZE)
+        flush();
+}
+
+void PointsToSetTraceWriter::write(PointsToSetOp op, uint64_t set,
+                                   uint64_t other) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _buffer.push_back(static_cast<uint8_t>(op));
+    put(set);
+    put(other);
+    if (_buffer.size() >= BUFFER_SIZE)
+        flush();
+}
+
+void PointsToSetTraceWriter::write(PointsToSetOp op, uint64_t set,
+                                   const PSNode *target) {
+    write(op, set, static_cast<uint64_t>(target->getID()));
+}
+
+void PointsToSetTraceWriter::write(PointsToSetOp op, uint64_t set,
+                                   const Pointer &ptr) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _buffer.push_back(static_cast<uint8_t>(op));
+    put(set);
+    put(ptr.target->getID());
+    // the unknown offset wraps to 0
+    put(*ptr.offset + 1);
+    if (_buffer.size() >= BUFFER_SIZE)
+        flush();
+}
+
+PointsToSetTraceReader::~PointsToSetTraceReader() {
+    if (_file)
+        fclose(_file);
+}
+
+bool PointsToSetTraceReader::open(const std::string &path) {
+    _file = fopen(path.c_str(), "rb");
+    if (!_file)
+        return false;
+
+    char header[sizeof(TRACE_MAGIC) + 1];
+    if (fread(header, 1, sizeof(header), _file) != sizeof(header) ||
+        memcmp(header, TRACE_MAGIC, sizeof(TRACE_MAGIC)) != 0 ||
+        static_cast<uint8_t>(header[sizeof(TRACE_MAGIC)]) != TRACE_VERSION) {
+        _error = true;
+        return false;
+    }
+    return true;
+}
+
+bool PointsToSetTraceReader::get(uint64_t &num) {
+    num = 0;
+    for (unsigned shift = 0; shift < 64; shift += 7) {
+        int c = getc(_file);
+        if (c == EOF)
+            return false;
+        num |= static_cast<uint64_t>(c & 0x7f) << shift;
+        if ((c & 0x80) == 0)
+            return true;
+    }
+    return false;
+}
+
+bool PointsToSetTraceReader::next(Record &rec) {
+    int c = getc(_file);
+    if (c == EOF)
+        return false;
+
+    if (c == 0 || c > static_cast<int>(PointsToSetOp::LAST)) {
+        _error = true;
+        return false;
+    }
+
+    rec.op = static_cast<PointsToSetOp>(c);
+    rec.arg = 0;
+    rec.offset = 0;
+    bool ok = get(rec.set);
+    switch (rec.op) {
+    case PointsToSetOp::CREATE:
+    case PointsToSetOp::DESTROY:
+    case PointsToSetOp::CLEAR:
+    case PointsToSetOp::ITERATE:
+        break;
+    case PointsToSetOp::COPY:
+    case PointsToSetOp::MOVE:
+    case PointsToSetOp::ASSIGN:
+    case PointsToSetOp::MOVE_ASSIGN:
+    case PointsToSetOp::SWAP:
+    case PointsToSetOp::ADD_SET:
+    case PointsToSetOp::REMOVE_ANY:
+        ok = ok && get(rec.arg);
+        break;
+    case PointsToSetOp::ADD:
+    case PointsToSetOp::REMOVE:
+    case PointsToSetOp::POINTS_TO:
+        ok = ok && get(rec.arg) && get(rec.offset);
+        // the unknown offset was stored as 0
+        --rec.offset;
+        break;
+    }
+
+    if (!ok)
+        _error = true;
+    return ok;
+}
+
+} // namespace pta
+} // namespace dg
@@ -1080,7 +1080,13 @@ void LLVMDependenceGraph::computeCriticalSections(
 void LLVMDependenceGraph::computeInterferenceDependentEdges(
         const std::set<const llvm::Instruction *> &loads,
         const std::set<const llvm::Instruction *> &stores) {
+    const auto &DL = getModule()->getDataLayout();
+    auto getAccessSize = [&DL](llvm::Type *Ty) -> Offset {
+        return llvmutils::getAllocatedSize(Ty, &DL);
+    };
+
     for (const auto &load : loads) {
+        const Offset loadSize = getAccessSize(load->getType());
         auto *loadInst = const_cast<llvm::Instruction *>(load);
         auto loadFunction = constructedFunctions.find(
                 const_cast<llvm::Function *>(load->getParent()->getParent()));
@@ -1101,21 +1107,9 @@ void LLVMDependenceGraph::computeInterferenceDependentEdges(
             if (!storeNode)
                 continue;
 
-            auto loadPts = PTA->getLLVMPointsTo(load->getOperand(0));
-            auto storePts = PTA->getLLVMPointsTo(store->getOperand(1));
-            for (const auto &pointerLoad : loadPts) {
-                for (const auto &pointerStore : storePts) {
-                    if (pointerLoad.value == pointerStore.value &&
-                        (pointerLoad.offset.isUnknown() ||
-                         pointerStore.offset.isUnknown() ||
-                         pointerLoad.offset == pointerStore.offset)) {
-                        storeNode->addInterferenceDependence(loadNode);
-                    }
-                }
-            }
-
-            // handle the unknown pointer
-            if (loadPts.hasUnknown() || storePts.hasUnknown())
+            if (PTA->alias(load->getOperand(0), loadSize,
+                           store->getOperand(1),
+                           getAccessSize(store->getOperand(0)->getType())))
                 storeNode->addInterferenceDependence(loadNode);
         }
     }
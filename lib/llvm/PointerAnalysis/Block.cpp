@@ -36,13 +36,19 @@ LLVMPointerGraphBuilder::buildPointerGraphBlock(const llvm::BasicBlock &block,
         if (!isRelevantInstruction(Inst)) {
             // check if it is a zeroing of memory,
             // if so, set the corresponding memory to zeroed
-            if (llvm::isa<llvm::MemSetInst>(&Inst))
+            if (llvm::isa<llvm::MemSetInst>(&Inst)) {
                 checkMemSet(&Inst);
+                // the memset may have been built as a store
+                if (auto *seq = getNodes(&Inst)) {
+                    for (auto *nd : *seq)
+                        nd->setParent(parent);
+                }
+            }
 
             continue;
         }
 
-        assert(nodes_map.count(&Inst) == 0 && "Already built this instruction");
+        assert(!getNodes(&Inst) && "Already built this instruction");
         auto &seq = buildInstruction(Inst);
 
         // set parent to the new nodes
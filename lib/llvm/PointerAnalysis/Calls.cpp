@@ -1,3 +1,5 @@
+#include <atomic>
+
 #include "dg/llvm/PointerAnalysis/PointerGraph.h"
 #include "llvm/llvm-utils.h"
 
@@ -67,7 +69,7 @@ LLVMPointerGraphBuilder::createUndefFunctionCall(const llvm::CallInst *CInst,
         auto *dest = CInst->getOperand(0);
         auto *src = CInst->getOperand(1);
         auto lenVal = llvmutils::getConstantValue(CInst->getOperand(2));
-        return PS.create<PSNodeType::MEMCPY>(getOperand(src), getOperand(dest),
+        return create<PSNodeType::MEMCPY>(getOperand(src), getOperand(dest),
                                              lenVal);
     }
 
@@ -81,8 +83,8 @@ LLVMPointerGraphBuilder::createFuncptrCall(const llvm::CallInst *CInst,
     // when the pointers are resolved during analysis, the graph
     // will be dynamically created and it will replace these nodes
     PSNode *op = getOperand(calledVal);
-    PSNode *call_funcptr = PS.create<PSNodeType::CALL_FUNCPTR>(op);
-    PSNode *ret_call = PS.create<PSNodeType::CALL_RETURN>();
+    PSNode *call_funcptr = create<PSNodeType::CALL_FUNCPTR>(op);
+    PSNode *ret_call = create<PSNodeType::CALL_RETURN>();
 
     ret_call->setPairedNode(call_funcptr);
     call_funcptr->setPairedNode(ret_call);
@@ -97,7 +99,7 @@ PSNode *LLVMPointerGraphBuilder::createUnknownCall() {
     // inside bitcast - it defaults to int, but is bitcased
     // to pointer
     // assert(CInst->getType()->isPointerTy());
-    PSNode *call = PS.create<PSNodeType::CALL>();
+    PSNode *call = create<PSNodeType::CALL>();
     call->setPairedNode(call);
 
     // the only thing that the node will point at
@@ -126,7 +128,7 @@ LLVMPointerGraphBuilder::createMemTransfer(const llvm::IntrinsicInst *I) {
 
     PSNode *destNode = getOperand(dest);
     PSNode *srcNode = getOperand(src);
-    PSNode *node = PS.create<PSNodeType::MEMCPY>(srcNode, destNode, lenVal);
+    PSNode *node = create<PSNodeType::MEMCPY>(srcNode, destNode, lenVal);
 
     return node;
 }
@@ -144,8 +146,8 @@ LLVMPointerGraphBuilder::createMemSet(const llvm::Instruction *Inst) {
 
     PSNode *op = getOperand(Inst->getOperand(0)->stripInBoundsOffsets());
     // we need to make unknown offsets
-    PSNode *G = PS.create<PSNodeType::GEP>(op, Offset::UNKNOWN);
-    PSNode *S = PS.create<PSNodeType::STORE>(val, G);
+    PSNode *G = create<PSNodeType::GEP>(op, Offset::UNKNOWN);
+    PSNode *S = create<PSNodeType::STORE>(val, G);
 
     PSNodesSeq ret(G);
     ret.append(S);
@@ -164,7 +166,7 @@ LLVMPointerGraphBuilder::createVarArg(const llvm::IntrinsicInst *Inst) {
 
     // first we need to get the vararg argument phi
     const llvm::Function *F = Inst->getParent()->getParent();
-    PointerSubgraph *subg = subgraphs_map[F];
+    PointerSubgraph *subg = getSubgraph(F);
     assert(subg);
     PSNode *arg = subg->vararg;
     assert(F->isVarArg() && "vastart in a non-variadic function");
@@ -173,7 +175,7 @@ LLVMPointerGraphBuilder::createVarArg(const llvm::IntrinsicInst *Inst) {
     // vastart will be node that will keep the memory
     // with pointers, its argument is the alloca, that
     // alloca will keep pointer to vastart
-    PSNode *vastart = PS.create<PSNodeType::ALLOC>();
+    PSNode *vastart = create<PSNodeType::ALLOC>();
 
     // vastart has only one operand which is the struct
     // it uses for storing the va arguments. Strip it so that we'll
@@ -187,10 +189,10 @@ LLVMPointerGraphBuilder::createVarArg(const llvm::IntrinsicInst *Inst) {
     // get node with the same pointer, but with Offset::UNKNOWN
     // FIXME: we're leaking it
     // make the memory in alloca point to our memory in vastart
-    PSNode *ptr = PS.create<PSNodeType::GEP>(op, Offset::UNKNOWN);
-    PSNode *S1 = PS.create<PSNodeType::STORE>(vastart, ptr);
+    PSNode *ptr = create<PSNodeType::GEP>(op, Offset::UNKNOWN);
+    PSNode *S1 = create<PSNodeType::STORE>(vastart, ptr);
     // and also make vastart point to the vararg args
-    PSNode *S2 = PS.create<PSNodeType::STORE>(arg, vastart);
+    PSNode *S2 = create<PSNodeType::STORE>(arg, vastart);
 
     ret.append(vastart);
     ret.append(ptr);
@@ -205,7 +207,7 @@ LLVMPointerGraphBuilder::createVarArg(const llvm::IntrinsicInst *Inst) {
 PSNode *
 LLVMPointerGraphBuilder::createLifetimeEnd(const llvm::Instruction *Inst) {
     PSNode *op1 = getOperand(Inst->getOperand(1));
-    return PS.create<PSNodeType::INVALIDATE_OBJECT>(op1);
+    return create<PSNodeType::INVALIDATE_OBJECT>(op1);
 }
 
 LLVMPointerGraphBuilder::PSNodesSeq
@@ -226,7 +228,7 @@ LLVMPointerGraphBuilder::createIntrinsic(const llvm::Instruction *Inst) {
     case Intrinsic::stacksave:
         errs() << "WARNING: Saving stack may yield unsound results!: " << *Inst
                << "\n";
-        return {PSNodeAlloc::get(PS.create<PSNodeType::ALLOC>())};
+        return {PSNodeAlloc::get(create<PSNodeType::ALLOC>())};
     case Intrinsic::stackrestore:
         return {createInternalLoad(Inst)};
     case Intrinsic::lifetime_end:
@@ -245,15 +247,15 @@ LLVMPointerGraphBuilder::createAsm(const llvm::Instruction *Inst) {
     // we are here, then we got here because this
     // is undefined call that returns pointer.
     // In this case return an unknown pointer
-    static bool warned = false;
-    if (!warned) {
+    // the functions may be built in parallel
+    static std::atomic<bool> warned{false};
+    if (!warned.exchange(true)) {
         llvm::errs()
                 << "PTA: Inline assembly found, analysis  may be unsound\n";
-        warned = true;
     }
 
     PSNode *n =
-            PS.create<PSNodeType::CONSTANT>(UNKNOWN_MEMORY, Offset::UNKNOWN);
+            create<PSNodeType::CONSTANT>(UNKNOWN_MEMORY, Offset::UNKNOWN);
     // it is call that returns pointer, so we'd like to have
     // a 'return' node that contains that pointer
     n->setPairedNode(n);
@@ -262,7 +264,7 @@ LLVMPointerGraphBuilder::createAsm(const llvm::Instruction *Inst) {
 
 PSNode *LLVMPointerGraphBuilder::createFree(const llvm::Instruction *Inst) {
     PSNode *op1 = getOperand(Inst->getOperand(0));
-    PSNode *node = PS.create<PSNodeType::FREE>(op1);
+    PSNode *node = create<PSNodeType::FREE>(op1);
 
     return node;
 }
@@ -273,7 +275,7 @@ PSNode *LLVMPointerGraphBuilder::createDynamicAlloc(const llvm::CallInst *CInst,
 
     const Value *op;
     uint64_t size = 0, size2 = 0;
-    PSNodeAlloc *node = PSNodeAlloc::get(PS.create<PSNodeType::ALLOC>());
+    PSNodeAlloc *node = PSNodeAlloc::get(create<PSNodeType::ALLOC>());
     node->setIsHeap();
 
     switch (type) {
@@ -318,15 +320,15 @@ LLVMPointerGraphBuilder::createRealloc(const llvm::CallInst *CInst) {
 
     // we create new allocation node and memcpy old pointers there
     PSNode *orig_mem = getOperand(CInst->getOperand(0));
-    PSNodeAlloc *reall = PSNodeAlloc::get(PS.create<PSNodeType::ALLOC>());
+    PSNodeAlloc *reall = PSNodeAlloc::get(create<PSNodeType::ALLOC>());
     reall->setIsHeap();
     reall->setUserData(const_cast<llvm::CallInst *>(CInst));
 
     // copy everything that is in orig_mem to reall
     PSNode *mcp =
-            PS.create<PSNodeType::MEMCPY>(orig_mem, reall, Offset::UNKNOWN);
+            create<PSNodeType::MEMCPY>(orig_mem, reall, Offset::UNKNOWN);
     // we need the pointer in the last node that we return
-    PSNode *ptr = PS.create<PSNodeType::CONSTANT>(reall, 0);
+    PSNode *ptr = create<PSNodeType::CONSTANT>(reall, 0);
 
     reall->setIsHeap();
     reall->setSize(llvmutils::getConstantSizeValue(CInst->getOperand(1)));
@@ -210,7 +210,7 @@ LLVMPointerGraphBuilder::getConstantExprPointer(const llvm::ConstantExpr *CE) {
 LLVMPointerGraphBuilder::PSNodesSeq &
 LLVMPointerGraphBuilder::createConstantExpr(const llvm::ConstantExpr *CE) {
     Pointer ptr = getConstantExprPointer(CE);
-    PSNode *node = PS.create<PSNodeType::CONSTANT>(ptr.target, ptr.offset);
+    PSNode *node = create<PSNodeType::CONSTANT>(ptr.target, ptr.offset);
 
     return addNode(CE, node);
 }
@@ -222,7 +222,7 @@ LLVMPointerGraphBuilder::createUnknown(const llvm::Value *val) {
 
     // FIXME: or there's enough unknown offset? Check it out!
     PSNode *node =
-            PS.create<PSNodeType::CONSTANT>(UNKNOWN_MEMORY, Offset::UNKNOWN);
+            create<PSNodeType::CONSTANT>(UNKNOWN_MEMORY, Offset::UNKNOWN);
     assert(node);
 
     return addNode(val, node);
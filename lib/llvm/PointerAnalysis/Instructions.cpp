@@ -6,7 +6,7 @@ namespace pta {
 
 LLVMPointerGraphBuilder::PSNodesSeq &
 LLVMPointerGraphBuilder::createAlloc(const llvm::Instruction *Inst) {
-    PSNodeAlloc *node = PSNodeAlloc::get(PS.create<PSNodeType::ALLOC>());
+    PSNodeAlloc *node = PSNodeAlloc::get(create<PSNodeType::ALLOC>());
 
     const llvm::AllocaInst *AI = llvm::dyn_cast<llvm::AllocaInst>(Inst);
     if (AI)
@@ -23,11 +23,11 @@ LLVMPointerGraphBuilder::createStore(const llvm::Instruction *Inst) {
     PSNode *op1;
     if (isa<AtomicRMWInst>(valOp)) {
         // we store the old value of AtomicRMW
-        auto it = nodes_map.find(valOp);
-        if (it == nodes_map.end()) {
+        auto *nodes = getNodes(valOp);
+        if (!nodes) {
             op1 = UNKNOWN_MEMORY;
         } else {
-            op1 = it->second.getFirst();
+            op1 = nodes->getFirst();
             assert(op1->getType() == PSNodeType::LOAD &&
                    "Invalid AtomicRMW nodes seq");
         }
@@ -36,7 +36,7 @@ LLVMPointerGraphBuilder::createStore(const llvm::Instruction *Inst) {
     }
 
     PSNode *op2 = getOperand(Inst->getOperand(1));
-    PSNode *node = PS.create<PSNodeType::STORE>(op1, op2);
+    PSNode *node = create<PSNodeType::STORE>(op1, op2);
 
     assert(node);
     return addNode(Inst, node);
@@ -47,7 +47,7 @@ LLVMPointerGraphBuilder::createInternalLoad(const llvm::Instruction *Inst) {
     const llvm::Value *op = Inst->getOperand(0);
 
     PSNode *op1 = getOperand(op);
-    PSNode *node = PS.create<PSNodeType::LOAD>(op1);
+    PSNode *node = create<PSNodeType::LOAD>(op1);
     assert(node);
 
     return node;
@@ -78,7 +78,7 @@ LLVMPointerGraphBuilder::createGEP(const llvm::Instruction *Inst) {
             // is 0 < offset < field_sensitivity ?
             uint64_t off = offset.getLimitedValue(*_options.fieldSensitivity);
             if (off == 0 || off < *_options.fieldSensitivity)
-                node = PS.create<PSNodeType::GEP>(op, offset.getZExtValue());
+                node = create<PSNodeType::GEP>(op, offset.getZExtValue());
         } else
             errs() << "WARN: GEP offset greater than " << bitwidth << "-bit";
         // fall-through to Offset::UNKNOWN in this case
@@ -88,7 +88,7 @@ LLVMPointerGraphBuilder::createGEP(const llvm::Instruction *Inst) {
     // in which case we are supposed to create a node
     // with Offset::UNKNOWN
     if (!node)
-        node = PS.create<PSNodeType::GEP>(op, Offset::UNKNOWN);
+        node = create<PSNodeType::GEP>(op, Offset::UNKNOWN);
 
     assert(node);
 
@@ -106,7 +106,7 @@ LLVMPointerGraphBuilder::createSelect(const llvm::Instruction *Inst) {
     PSNode *op2 = getOperand(Inst->getOperand(2));
 
     // select works as a PHI in points-to analysis
-    PSNode *node = PS.create<PSNodeType::PHI>(op1, op2);
+    PSNode *node = create<PSNodeType::PHI>(op1, op2);
     assert(node);
 
     return addNode(Inst, node);
@@ -159,9 +159,9 @@ LLVMPointerGraphBuilder::createExtract(const llvm::Instruction *Inst) {
 
     // extract <agg> <idx> {<idx>, ...}
     PSNode *op1 = getOperand(EI->getAggregateOperand());
-    PSNode *G = PS.create<PSNodeType::GEP>(
+    PSNode *G = create<PSNodeType::GEP>(
             op1, accumulateEVOffsets(EI, M->getDataLayout()));
-    PSNode *L = PS.create<PSNodeType::LOAD>(G);
+    PSNode *L = create<PSNodeType::LOAD>(G);
 
     // FIXME: add this later with all edges
     G->addSuccessor(L);
@@ -172,7 +172,7 @@ LLVMPointerGraphBuilder::createExtract(const llvm::Instruction *Inst) {
 
 LLVMPointerGraphBuilder::PSNodesSeq &
 LLVMPointerGraphBuilder::createPHI(const llvm::Instruction *Inst) {
-    PSNode *node = PS.create<PSNodeType::PHI>();
+    PSNode *node = create<PSNodeType::PHI>();
     assert(node);
 
     // NOTE: we didn't add operands to PHI node here, but after building
@@ -186,7 +186,7 @@ LLVMPointerGraphBuilder::PSNodesSeq &
 LLVMPointerGraphBuilder::createCast(const llvm::Instruction *Inst) {
     const llvm::Value *op = Inst->getOperand(0);
     PSNode *op1 = getOperand(op);
-    PSNode *node = PS.create<PSNodeType::CAST>(op1);
+    PSNode *node = create<PSNodeType::CAST>(op1);
     assert(node);
     return addNode(Inst, node);
 }
@@ -202,7 +202,7 @@ LLVMPointerGraphBuilder::createPtrToInt(const llvm::Instruction *Inst) {
     // this way we cover any shift of the pointer due to arithmetic
     // operations
     // PSNode *node = PS.create(PSNodeType::CAST, op1);
-    PSNode *node = PS.create<PSNodeType::GEP>(op1, 0);
+    PSNode *node = create<PSNodeType::GEP>(op1, 0);
     return addNode(Inst, node);
 }
 
@@ -220,7 +220,7 @@ LLVMPointerGraphBuilder::createIntToPtr(const llvm::Instruction *Inst) {
     } else
         op1 = getOperand(op);
 
-    PSNode *node = PS.create<PSNodeType::CAST>(op1);
+    PSNode *node = create<PSNodeType::CAST>(op1);
     assert(node);
 
     return addNode(Inst, node);
@@ -258,7 +258,7 @@ LLVMPointerGraphBuilder::createAdd(const llvm::Instruction *Inst) {
     if (val)
         off = llvmutils::getConstantValue(val);
 
-    node = PS.create<PSNodeType::GEP>(op, off);
+    node = create<PSNodeType::GEP>(op, off);
     assert(node);
 
     return addNode(Inst, node);
@@ -292,7 +292,7 @@ LLVMPointerGraphBuilder::createArithmetic(const llvm::Instruction *Inst) {
 
     // we don't know what the operation does,
     // so set unknown offset
-    node = PS.create<PSNodeType::GEP>(op, Offset::UNKNOWN);
+    node = create<PSNodeType::GEP>(op, Offset::UNKNOWN);
     assert(node);
 
     return addNode(Inst, node);
@@ -351,8 +351,8 @@ LLVMPointerGraphBuilder::createReturn(const llvm::Instruction *Inst) {
     assert((op1 || !retVal || !retVal->getType()->isPointerTy()) &&
            "Don't have an operand for ReturnInst with pointer");
 
-    PSNode *node = op1 ? PS.create<PSNodeType::RETURN>(op1)
-                       : PS.create<PSNodeType::RETURN>();
+    PSNode *node = op1 ? create<PSNodeType::RETURN>(op1)
+                       : create<PSNodeType::RETURN>();
     assert(node);
 
     return addNode(Inst, node);
@@ -365,7 +365,7 @@ LLVMPointerGraphBuilder::createInsertElement(const llvm::Instruction *Inst) {
     PSNodesSeq seq;
 
     if (llvm::isa<llvm::UndefValue>(Inst->getOperand(0))) {
-        tempAlloc = PSNodeAlloc::get(PS.create<PSNodeType::ALLOC>());
+        tempAlloc = PSNodeAlloc::get(create<PSNodeType::ALLOC>());
         tempAlloc->setIsTemporary();
         seq.append(tempAlloc);
         lastNode = tempAlloc;
@@ -374,14 +374,14 @@ LLVMPointerGraphBuilder::createInsertElement(const llvm::Instruction *Inst) {
         assert(fromTempAlloc);
         assert(fromTempAlloc->isTemporary());
 
-        tempAlloc = PSNodeAlloc::get(PS.create<PSNodeType::ALLOC>());
+        tempAlloc = PSNodeAlloc::get(create<PSNodeType::ALLOC>());
         tempAlloc->setIsTemporary();
         assert(tempAlloc);
         seq.append(tempAlloc);
 
         // copy old temporary allocation to the new temp allocation
         // (this is how insertelem works)
-        auto *cpy = PS.create<PSNodeType::MEMCPY>(fromTempAlloc, tempAlloc,
+        auto *cpy = create<PSNodeType::MEMCPY>(fromTempAlloc, tempAlloc,
                                                   Offset::UNKNOWN);
         seq.append(cpy);
         lastNode = cpy;
@@ -402,8 +402,8 @@ LLVMPointerGraphBuilder::createInsertElement(const llvm::Instruction *Inst) {
     // also, set the size of the temporary allocation
     tempAlloc->setSize(llvmutils::getAllocatedSize(Ty, &M->getDataLayout()));
 
-    auto *GEP = PS.create<PSNodeType::GEP>(tempAlloc, elemSize * idx);
-    auto *S = PS.create<PSNodeType::STORE>(ptr, GEP);
+    auto *GEP = create<PSNodeType::GEP>(tempAlloc, elemSize * idx);
+    auto *S = create<PSNodeType::STORE>(ptr, GEP);
 
     seq.append(GEP);
     seq.append(S);
@@ -431,8 +431,8 @@ LLVMPointerGraphBuilder::createExtractElement(const llvm::Instruction *Inst) {
     auto elemSize = llvmutils::getAllocatedSize(Ty->getContainedType(0),
                                                 &M->getDataLayout());
 
-    auto *GEP = PS.create<PSNodeType::GEP>(op, elemSize * idx);
-    auto *L = PS.create<PSNodeType::LOAD>(GEP);
+    auto *GEP = create<PSNodeType::GEP>(op, elemSize * idx);
+    auto *L = create<PSNodeType::LOAD>(GEP);
 
     GEP->addSuccessor(L);
 
@@ -456,7 +456,7 @@ LLVMPointerGraphBuilder::createAtomicRMW(const llvm::Instruction *Inst) {
     auto *ptr = getOperand(RMW->getPointerOperand());
     Offset cval = Offset::UNKNOWN;
 
-    auto *R = PS.create<PSNodeType::LOAD>(ptr);
+    auto *R = create<PSNodeType::LOAD>(ptr);
 
     PSNode *M = nullptr;
     switch (operation) {
@@ -465,14 +465,14 @@ LLVMPointerGraphBuilder::createAtomicRMW(const llvm::Instruction *Inst) {
         break;
     case AtomicRMWInst::Add:
         cval = Offset(llvmutils::getConstantValue(RMW->getValOperand()));
-        M = PS.create<PSNodeType::GEP>(ptr, cval);
+        M = create<PSNodeType::GEP>(ptr, cval);
         R->addSuccessor(M);
         break;
     case AtomicRMWInst::Sub:
         break;
         cval = Offset(0) -
                Offset(llvmutils::getConstantValue(RMW->getValOperand()));
-        M = PS.create<PSNodeType::GEP>(ptr, cval);
+        M = create<PSNodeType::GEP>(ptr, cval);
         R->addSuccessor(M);
         break;
     default:
@@ -481,7 +481,7 @@ LLVMPointerGraphBuilder::createAtomicRMW(const llvm::Instruction *Inst) {
     }
     assert(M);
 
-    auto *W = PS.create<PSNodeType::STORE>(M, ptr);
+    auto *W = create<PSNodeType::STORE>(M, ptr);
     if (operation == AtomicRMWInst::Add || operation == AtomicRMWInst::Sub) {
         M->addSuccessor(W);
     }
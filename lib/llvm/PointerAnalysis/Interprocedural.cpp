@@ -58,9 +58,9 @@ void LLVMPointerGraphBuilder::addArgumentsOperands(const llvm::Function *F,
                                                    const llvm::CallInst *CI,
                                                    unsigned index) {
     for (auto A = F->arg_begin(), E = F->arg_end(); A != E; ++A, ++index) {
-        auto it = nodes_map.find(&*A);
-        assert(it != nodes_map.end());
-        PSNodesSeq &cur = it->second;
+        auto *nodes = getNodes(&*A);
+        assert(nodes);
+        PSNodesSeq &cur = *nodes;
 
         if (CI) {
             // with func ptr call we know from which
@@ -110,4 +110,43 @@ LLVMPointerAnalysis::getAccessedMemory(const llvm::Instruction *I) {
     return {PTSet.hasUnknown(), regions};
 }
 
+bool LLVMPointerAnalysis::alias(const llvm::Value *v1, Offset size1,
+                                const llvm::Value *v2, Offset size2) {
+    auto pts1 = getLLVMPointsTo(v1);
+    auto pts2 = getLLVMPointsTo(v2);
+    // the empty points-to sets are reported as unknown
+    if (pts1.hasUnknown() || pts2.hasUnknown())
+        return true;
+
+    for (const auto &ptr1 : pts1) {
+        for (const auto &ptr2 : pts2) {
+            if (ptr1.value == ptr2.value &&
+                pta::AliasCache::overlap(ptr1.offset, size1, ptr2.offset,
+                                         size2))
+                return true;
+        }
+    }
+    return false;
+}
+
+std::vector<bool> LLVMPointerAnalysis::aliasAll(
+        const std::vector<std::pair<MemoryAccess, MemoryAccess>> &pairs) {
+    std::vector<bool> result;
+    result.reserve(pairs.size());
+    for (const auto &it : pairs) {
+        result.push_back(alias(it.first.ptr, it.first.size, it.second.ptr,
+                               it.second.size));
+    }
+    return result;
+}
+
+bool LLVMPointerAnalysis::mayAliasAny(
+        const MemoryAccess &access, const std::vector<MemoryAccess> &accesses) {
+    for (const auto &other : accesses) {
+        if (alias(access.ptr, access.size, other.ptr, other.size))
+            return true;
+    }
+    return false;
+}
+
 } // namespace dg
@@ -0,0 +1,517 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <unordered_set>
+
+#include <llvm/Config/llvm-config.h>
+#include <llvm/IR/Constants.h>
+#include <llvm/IR/Function.h>
+#include <llvm/IR/Instructions.h>
+#include <llvm/IR/Module.h>
+#include <llvm/Support/raw_ostream.h>
+
+#include "dg/PointerAnalysis/PSNode.h"
+#include "dg/llvm/PointerAnalysis/PointerAnalysisSnapshot.h"
+#include "llvm/llvm-utils.h"
+
+namespace dg {
+
+using pta::PSNode;
+
+namespace {
+
+///
+// The layout of the file:
+//
+//  header         (HEADER_SIZE bytes, see below)
+//  value sets     uint32_t for every enumerated value: the index
+//                 of the points-to set or NO_SET (padded to 8 bytes)
+//  pointers       uint32_t target, uint32_t (zero), uint64_t offset
+//  set offsets    uint64_t for every set + 1: the ranges in the data
+//  data           the encoded points-to sets: the number of pointers
+//                 and the deltas of the sorted pointer indices (varints)
+const char MAGIC[8] = {'D', 'G', 'P', 'T', 'A', 'S', 'N', 'P'};
+const size_t HEADER_SIZE = 64;
+const size_t POINTER_SIZE = 16;
+const uint32_t NO_SET = ~0U;
+
+// the offsets of the fields in the header
+const size_t H_VERSION = 8;
+const size_t H_VALUES_NUM = 12;
+const size_t H_MODULE_HASH = 16;
+const size_t H_OPTIONS_HASH = 24;
+const size_t H_POINTERS_NUM = 32;
+const size_t H_SETS_NUM = 36;
+const size_t H_DATA_SIZE = 40;
+
+uint64_t align8(uint64_t n) { return (n + 7) & ~uint64_t(7); }
+
+template <typename T>
+T read(const char *ptr) {
+    T val;
+    std::memcpy(&val, ptr, sizeof(T));
+    return val;
+}
+
+template <typename T>
+void write(std::string &out, size_t pos, T val) {
+    std::memcpy(&out[pos], &val, sizeof(T));
+}
+
+void writeVarint(std::string &out, uint64_t val) {
+    while (val >= 0x80) {
+        out.push_back(static_cast<char>((val & 0x7f) | 0x80));
+        val >>= 7;
+    }
+    out.push_back(static_cast<char>(val));
+}
+
+bool readVarint(const char *&ptr, const char *end, uint64_t &val) {
+    val = 0;
+    for (unsigned shift = 0; ptr < end && shift < 64; shift += 7) {
+        auto byte = static_cast<unsigned char>(*ptr++);
+        val |= static_cast<uint64_t>(byte & 0x7f) << shift;
+        if ((byte & 0x80) == 0)
+            return true;
+    }
+    return false;
+}
+
+// FNV-1a
+const uint64_t FNV_BASIS = 0xcbf29ce484222325ULL;
+
+uint64_t hashBytes(uint64_t hash, const char *ptr, size_t size) {
+    for (size_t i = 0; i < size; ++i) {
+        hash ^= static_cast<unsigned char>(ptr[i]);
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+// stream that only hashes what is written into it
+class HashingStream : public llvm::raw_ostream {
+    uint64_t _hash{FNV_BASIS};
+    uint64_t _pos{0};
+
+    void write_impl(const char *ptr, size_t size) override {
+        _hash = hashBytes(_hash, ptr, size);
+        _pos += size;
+    }
+
+    uint64_t current_pos() const override { return _pos; }
+
+  public:
+    ~HashingStream() override { flush(); }
+
+    uint64_t getHash() {
+        flush();
+        return _hash;
+    }
+};
+
+void addConstantExprs(const llvm::Value *val,
+                      std::unordered_set<const llvm::Value *> &seen,
+                      std::vector<const llvm::Value *> &values) {
+    const auto *CE = llvm::dyn_cast<llvm::ConstantExpr>(val);
+    if (!CE || !seen.insert(CE).second)
+        return;
+
+    values.push_back(CE);
+    for (const auto &op : CE->operands())
+        addConstantExprs(op, seen, values);
+}
+
+// the values of the module in the order that identifies
+// them in the snapshot
+std::vector<const llvm::Value *> enumerateValues(const llvm::Module *M) {
+    std::vector<const llvm::Value *> values;
+    std::unordered_set<const llvm::Value *> constantExprs;
+
+    for (const auto &G : M->globals())
+        values.push_back(&G);
+    for (const auto &F : *M)
+        values.push_back(&F);
+
+    for (const auto &F : *M) {
+        if (F.isDeclaration())
+            continue;
+
+        for (const auto &A : F.args())
+            values.push_back(&A);
+        for (const auto &B : F) {
+            for (const auto &I : B) {
+                values.push_back(&I);
+                for (const auto &op : I.operands())
+                    addConstantExprs(op, constantExprs, values);
+            }
+        }
+    }
+
+    return values;
+}
+
+/// Implementation of LLVMPointsToSet that iterates
+//  over the points-to set decoded from a snapshot
+class SnapshotLLVMPointsToSet
+        : public LLVMPointsToSetImplTemplate<
+                  std::vector<LLVMPointerAnalysisSnapshot::Entry>> {
+    using Snapshot = LLVMPointerAnalysisSnapshot;
+
+    bool has(uint32_t target) const {
+        for (const auto &ptr : PTSet) {
+            if (ptr.target == target)
+                return true;
+        }
+        return false;
+    }
+
+    void _findNextReal() override {
+        while (it != PTSet.end() && !it->value) {
+            ++it;
+            ++_position;
+        }
+    }
+
+  public:
+    SnapshotLLVMPointsToSet(std::vector<Snapshot::Entry> S)
+            : LLVMPointsToSetImplTemplate(std::move(S)) {
+        initialize_iterator();
+    }
+
+    bool hasUnknown() const override { return has(Snapshot::UNKNOWN_TARGET); }
+    bool hasNull() const override { return has(Snapshot::NULL_TARGET); }
+    bool hasNullWithOffset() const override {
+        for (const auto &ptr : PTSet) {
+            if (ptr.target == Snapshot::NULL_TARGET && *ptr.offset != 0)
+                return true;
+        }
+        return false;
+    }
+    bool hasInvalidated() const override {
+        return has(Snapshot::INVALIDATED_TARGET);
+    }
+    size_t size() const override { return PTSet.size(); }
+
+    LLVMPointer getKnownSingleton() const override {
+        assert(isKnownSingleton());
+        return {PTSet.front().value, PTSet.front().offset};
+    }
+
+    LLVMPointer get() const override {
+        assert((it != PTSet.end()) && "Dereferenced end() iterator");
+        return {it->value, it->offset};
+    }
+};
+
+LLVMPointsToSet
+toLLVMPointsToSet(std::vector<LLVMPointerAnalysisSnapshot::Entry> ptrs) {
+    auto *pts = new SnapshotLLVMPointsToSet(std::move(ptrs));
+    return pts->toLLVMPointsToSet();
+}
+
+std::vector<LLVMPointerAnalysisSnapshot::Entry> getUnknownPointers() {
+    return {{nullptr, LLVMPointerAnalysisSnapshot::UNKNOWN_TARGET, 0}};
+}
+
+} // anonymous namespace
+
+uint64_t LLVMPointerAnalysisSnapshot::hashModule(const llvm::Module *M) {
+    HashingStream stream;
+    M->print(stream, nullptr);
+    return stream.getHash();
+}
+
+uint64_t LLVMPointerAnalysisSnapshot::hashOptions(
+        const LLVMPointerAnalysisOptions &opts) {
+    // only the options that change the results
+    std::string str;
+    llvm::raw_string_ostream os(str);
+    os << static_cast<int>(opts.analysisType) << ";" << *opts.fieldSensitivity
+       << ";" << opts.entryFunction << ";" << opts.threads << ";"
+       << opts.preprocessGeps << ";" << opts.invalidateNodes << ";"
+       << opts.maxIterations << ";" << opts.timeBudget << ";"
+       << opts.memoryBudget;
+    for (const auto &it : opts.allocationFunctions)
+        os << ";" << it.first << "=" << static_cast<int>(it.second);
+    os.flush();
+
+    return hashBytes(FNV_BASIS, str.data(), str.size());
+}
+
+bool LLVMPointerAnalysisSnapshot::save(const std::string &path,
+                                       const llvm::Module *M,
+                                       const LLVMPointerAnalysisOptions &opts,
+                                       const GetNodeT &getNode) {
+    using PointerT = std::pair<uint32_t, uint64_t>;
+    using SetT = std::vector<PointerT>;
+
+    const auto values = enumerateValues(M);
+    std::unordered_map<const llvm::Value *, uint32_t> indices;
+    indices.reserve(values.size());
+    for (uint32_t i = 0; i < values.size(); ++i)
+        indices.emplace(values[i], i);
+
+    auto getTarget = [&indices](const pta::Pointer &ptr) -> uint32_t {
+        if (ptr.isNull())
+            return NULL_TARGET;
+        if (ptr.isInvalidated())
+            return INVALIDATED_TARGET;
+        if (ptr.isUnknown())
+            return UNKNOWN_TARGET;
+        // the targets that can not be mapped back to the module
+        // would not be reported by the analysis either
+        auto it = indices.find(ptr.target->getUserData<llvm::Value>());
+        return it == indices.end() ? UNKNOWN_TARGET : it->second;
+    };
+
+    // gather the distinct points-to sets
+    std::map<SetT, uint32_t> sets;
+    std::vector<uint32_t> valueSets(values.size(), NO_SET);
+    for (uint32_t i = 0; i < values.size(); ++i) {
+        PSNode *node = getNode(values[i]);
+        if (!node)
+            continue;
+
+        SetT set;
+        for (const auto &ptr : node->pointsTo)
+            set.emplace_back(getTarget(ptr), *ptr.offset);
+        std::sort(set.begin(), set.end());
+        set.erase(std::unique(set.begin(), set.end()), set.end());
+
+        auto it = sets.emplace(std::move(set), sets.size()).first;
+        valueSets[i] = it->second;
+    }
+
+    // the pointer IDs are the indices into the sorted table of pointers,
+    // so that the pointers to the same object get close IDs
+    std::vector<PointerT> pointers;
+    for (const auto &it : sets)
+        pointers.insert(pointers.end(), it.first.begin(), it.first.end());
+    std::sort(pointers.begin(), pointers.end());
+    pointers.erase(std::unique(pointers.begin(), pointers.end()),
+                   pointers.end());
+
+    std::vector<const SetT *> setsByID(sets.size());
+    for (const auto &it : sets)
+        setsByID[it.second] = &it.first;
+
+    std::string data;
+    std::vector<uint64_t> setOffsets;
+    setOffsets.reserve(sets.size() + 1);
+    for (const SetT *set : setsByID) {
+        setOffsets.push_back(data.size());
+        writeVarint(data, set->size());
+        uint64_t last = 0;
+        for (const auto &ptr : *set) {
+            uint64_t id = std::lower_bound(pointers.begin(), pointers.end(),
+                                           ptr) -
+                          pointers.begin();
+            writeVarint(data, id - last);
+            last = id;
+        }
+    }
+    setOffsets.push_back(data.size());
+
+    const size_t valuesSize = align8(values.size() * sizeof(uint32_t));
+    std::string out(HEADER_SIZE + valuesSize + pointers.size() * POINTER_SIZE +
+                            setOffsets.size() * sizeof(uint64_t),
+                    '\0');
+    std::memcpy(&out[0], MAGIC, sizeof(MAGIC));
+    write<uint32_t>(out, H_VERSION, VERSION);
+    write<uint32_t>(out, H_VALUES_NUM, values.size());
+    write<uint64_t>(out, H_MODULE_HASH, hashModule(M));
+    write<uint64_t>(out, H_OPTIONS_HASH, hashOptions(opts));
+    write<uint32_t>(out, H_POINTERS_NUM, pointers.size());
+    write<uint32_t>(out, H_SETS_NUM, sets.size());
+    write<uint64_t>(out, H_DATA_SIZE, data.size());
+
+    size_t pos = HEADER_SIZE;
+    for (uint32_t set : valueSets) {
+        write<uint32_t>(out, pos, set);
+        pos += sizeof(uint32_t);
+    }
+    pos = HEADER_SIZE + valuesSize;
+    for (const auto &ptr : pointers) {
+        write<uint32_t>(out, pos, ptr.first);
+        write<uint64_t>(out, pos + 8, ptr.second);
+        pos += POINTER_SIZE;
+    }
+    for (uint64_t off : setOffsets) {
+        write<uint64_t>(out, pos, off);
+        pos += sizeof(uint64_t);
+    }
+    out += data;
+
+    // write to a temporary file first, so that other processes
+    // never see a partially written snapshot
+    const std::string tmp = path + ".tmp";
+    {
+        std::ofstream ofs(tmp, std::ios::binary | std::ios::trunc);
+        if (!ofs.write(out.data(), out.size()))
+            return false;
+    }
+    return std::rename(tmp.c_str(), path.c_str()) == 0;
+}
+
+std::unique_ptr<LLVMPointerAnalysisSnapshot>
+LLVMPointerAnalysisSnapshot::load(const std::string &path,
+                                  const llvm::Module *M,
+                                  const LLVMPointerAnalysisOptions &opts) {
+    // large files are mapped into memory (if the platform supports it)
+#if LLVM_VERSION_MAJOR >= 13
+    auto buf = llvm::MemoryBuffer::getFile(path, /* IsText = */ false,
+                                           /* RequiresNullTerminator = */
+                                           false);
+#else
+    auto buf = llvm::MemoryBuffer::getFile(path, /* FileSize = */ -1,
+                                           /* RequiresNullTerminator = */
+                                           false);
+#endif
+    if (!buf)
+        return nullptr;
+
+    const char *start = (*buf)->getBufferStart();
+    const uint64_t size = (*buf)->getBufferSize();
+    if (size < HEADER_SIZE || std::memcmp(start, MAGIC, sizeof(MAGIC)) != 0 ||
+        read<uint32_t>(start + H_VERSION) != VERSION ||
+        read<uint64_t>(start + H_OPTIONS_HASH) != hashOptions(opts))
+        return nullptr;
+
+    const auto valuesNum = read<uint32_t>(start + H_VALUES_NUM);
+    const auto pointersNum = read<uint32_t>(start + H_POINTERS_NUM);
+    const auto setsNum = read<uint32_t>(start + H_SETS_NUM);
+    const auto dataSize = read<uint64_t>(start + H_DATA_SIZE);
+    const uint64_t valuesSize = align8(uint64_t(valuesNum) * sizeof(uint32_t));
+    const uint64_t tablesSize = HEADER_SIZE + valuesSize +
+                                uint64_t(pointersNum) * POINTER_SIZE +
+                                (uint64_t(setsNum) + 1) * sizeof(uint64_t);
+    if (size < tablesSize || size - tablesSize != dataSize)
+        return nullptr;
+
+    // checking the hash of the module takes longer than the checks
+    // above, so do it only when the file looks right
+    if (read<uint64_t>(start + H_MODULE_HASH) != hashModule(M))
+        return nullptr;
+
+    std::unique_ptr<LLVMPointerAnalysisSnapshot> snapshot(
+            new LLVMPointerAnalysisSnapshot());
+    snapshot->_values = enumerateValues(M);
+    if (snapshot->_values.size() != valuesNum)
+        return nullptr;
+
+    snapshot->_indices.reserve(valuesNum);
+    for (uint32_t i = 0; i < valuesNum; ++i)
+        snapshot->_indices.emplace(snapshot->_values[i], i);
+
+    snapshot->_valueSets = start + HEADER_SIZE;
+    snapshot->_pointers = snapshot->_valueSets + valuesSize;
+    snapshot->_setOffsets =
+            snapshot->_pointers + uint64_t(pointersNum) * POINTER_SIZE;
+    snapshot->_data = start + tablesSize;
+    snapshot->_pointersNum = pointersNum;
+    snapshot->_setsNum = setsNum;
+    snapshot->_dataSize = dataSize;
+    snapshot->_buffer = std::move(*buf);
+
+    return snapshot;
+}
+
+bool LLVMPointerAnalysisSnapshot::decode(uint32_t set,
+                                         std::vector<Entry> &ptrs) const {
+    if (set >= _setsNum)
+        return false;
+
+    const auto begin = read<uint64_t>(_setOffsets + set * sizeof(uint64_t));
+    const auto end =
+            read<uint64_t>(_setOffsets + (set + 1) * sizeof(uint64_t));
+    if (begin > end || end > _dataSize)
+        return false;
+
+    const char *ptr = _data + begin;
+    const char *const endptr = _data + end;
+    uint64_t num;
+    if (!readVarint(ptr, endptr, num))
+        return false;
+
+    ptrs.reserve(num);
+    uint64_t id = 0;
+    for (uint64_t i = 0; i < num; ++i) {
+        uint64_t delta;
+        if (!readVarint(ptr, endptr, delta))
+            return false;
+        id += delta;
+        if (id >= _pointersNum)
+            return false;
+
+        const char *entry = _pointers + id * POINTER_SIZE;
+        const auto target = read<uint32_t>(entry);
+        const auto offset = read<uint64_t>(entry + 8);
+        llvm::Value *value = nullptr;
+        if (target < _values.size())
+            value = const_cast<llvm::Value *>(_values[target]);
+        else if (target != NULL_TARGET && target != UNKNOWN_TARGET &&
+                 target != INVALIDATED_TARGET)
+            return false;
+
+        ptrs.push_back({value, target, offset});
+    }
+
+    return true;
+}
+
+bool LLVMPointerAnalysisSnapshot::getPointers(const llvm::Value *val,
+                                              std::vector<Entry> &ptrs) const {
+    auto it = _indices.find(val);
+    if (it != _indices.end()) {
+        const auto set = read<uint32_t>(_valueSets +
+                                        it->second * sizeof(uint32_t));
+        if (set != NO_SET) {
+            // a corrupted set tells nothing about the value
+            if (!decode(set, ptrs))
+                ptrs = getUnknownPointers();
+            return true;
+        }
+    }
+
+    // the values that the analysis did not build nodes for,
+    // these are handled the same way as in LLVMPointerGraphBuilder
+    if (llvm::isa<llvm::ConstantPointerNull>(val) ||
+        llvmutils::isConstantZero(val)) {
+        ptrs.push_back({nullptr, NULL_TARGET, 0});
+        return true;
+    }
+    if (llvm::isa<llvm::Function>(val) && it != _indices.end()) {
+        // functions point to themselves
+        ptrs.push_back({const_cast<llvm::Value *>(val), it->second, 0});
+        return true;
+    }
+    if (llvm::isa<llvm::Constant>(val) || llvm::isa<llvm::UndefValue>(val)) {
+        ptrs = getUnknownPointers();
+        return true;
+    }
+
+    return false;
+}
+
+bool LLVMPointerAnalysisSnapshot::hasPointsTo(const llvm::Value *val) const {
+    std::vector<Entry> ptrs;
+    return getPointers(val, ptrs) && !ptrs.empty();
+}
+
+LLVMPointsToSet
+LLVMPointerAnalysisSnapshot::getLLVMPointsTo(const llvm::Value *val) const {
+    return getLLVMPointsToChecked(val).second;
+}
+
+std::pair<bool, LLVMPointsToSet>
+LLVMPointerAnalysisSnapshot::getLLVMPointsToChecked(
+        const llvm::Value *val) const {
+    std::vector<Entry> ptrs;
+    if (!getPointers(val, ptrs) || ptrs.empty())
+        return {false, toLLVMPointsToSet(getUnknownPointers())};
+    return {true, toLLVMPointsToSet(std::move(ptrs))};
+}
+
+} // namespace dg
@@ -1,5 +1,7 @@
+#include <atomic>
 #include <cassert>
 #include <set>
+#include <thread>
 
 #include <llvm/Config/llvm-config.h>
 
@@ -17,12 +19,14 @@
 #include <llvm/IR/Instructions.h>
 #include <llvm/IR/IntrinsicInst.h>
 #include <llvm/IR/Module.h>
+#include <llvm/IR/TypeFinder.h>
 #include <llvm/Support/raw_os_ostream.h>
 
 #include <llvm/IR/Dominators.h>
 
 #include "dg/PointerAnalysis/PointerGraph.h"
 #include "dg/PointerAnalysis/PointerGraphOptimizations.h"
+#include "dg/PointerAnalysis/PointsToSetTrace.h"
 #include "dg/llvm/PointerAnalysis/PointerGraph.h"
 
 #include "llvm/PointerAnalysis/PointerGraphValidator.h"
@@ -33,16 +37,25 @@
 namespace dg {
 namespace pta {
 
+thread_local PointerNodesPool *LLVMPointerGraphBuilder::_pool = nullptr;
+
 PSNode *LLVMPointerGraphBuilder::getConstant(const llvm::Value *val) {
     using namespace llvm;
     if (isa<ConstantPointerNull>(val) || llvmutils::isConstantZero(val)) {
         return NULLPTR;
     }
+    if (_pool && (isa<ConstantExpr>(val) || isa<Function>(val))) {
+        // the nodes of constants are shared by all functions,
+        // they must be created before the functions are built
+        llvm::errs() << "ERR: constant was not prepared for building "
+                     << "functions in parallel: " << *val << "\n";
+        abort();
+    }
     if (const ConstantExpr *CE = dyn_cast<ConstantExpr>(val)) {
         return createConstantExpr(CE).getRepresentant();
     }
     if (isa<Function>(val)) {
-        PSNode *ret = PS.create<PSNodeType::FUNCTION>();
+        PSNode *ret = create<PSNodeType::FUNCTION>();
         addNode(val, ret);
         return ret;
     }
@@ -56,11 +69,10 @@ PSNode *LLVMPointerGraphBuilder::getConstant(const llvm::Value *val) {
 
 // try get operand, return null if no such value has been constructed
 PSNode *LLVMPointerGraphBuilder::tryGetOperand(const llvm::Value *val) {
-    auto it = nodes_map.find(val);
     PSNode *op = nullptr;
 
-    if (it != nodes_map.end())
-        op = it->second.getRepresentant();
+    if (auto *nodes = getNodes(val))
+        op = nodes->getRepresentant();
 
     // if we don't have the operand, then it is a ConstantExpr
     // or some operand of intToPtr instruction (or related to that)
@@ -128,13 +140,22 @@ LLVMPointerGraphBuilder::getAndConnectSubgraph(const llvm::Function *F,
 LLVMPointerGraphBuilder::PSNodesSeq &
 LLVMPointerGraphBuilder::createCallToFunction(const llvm::CallInst *CInst,
                                               const llvm::Function *F) {
-    PSNodeCall *callNode = PSNodeCall::get(PS.create<PSNodeType::CALL>());
-    auto &subg = getAndConnectSubgraph(F, CInst, callNode);
+    PSNodeCall *callNode = PSNodeCall::get(create<PSNodeType::CALL>());
+    PointerSubgraph *subg = nullptr;
+    if (_pool) {
+        // the function may be being built in another thread,
+        // the call is connected when all functions are built
+        auto it = _funcInfo.find(CInst->getFunction());
+        assert(it != _funcInfo.end() && "The caller is not being built");
+        it->second.calls.push_back({callNode, CInst, F});
+    } else {
+        subg = &getAndConnectSubgraph(F, CInst, callNode);
+    }
 
     // the operands to the return node (which works as a phi node)
     // are going to be added when the subgraph is built
     PSNodeCallRet *returnNode =
-            PSNodeCallRet::get(PS.create<PSNodeType::CALL_RETURN>());
+            PSNodeCallRet::get(create<PSNodeType::CALL_RETURN>());
 
     returnNode->setPairedNode(callNode);
     callNode->setPairedNode(returnNode);
@@ -142,7 +163,7 @@ LLVMPointerGraphBuilder::createCallToFunction(const llvm::CallInst *CInst,
     // this must be after we created the CALL_RETURN node
     if (ad_hoc_building) {
         // add operands to arguments and return nodes
-        addInterproceduralOperands(F, subg, CInst, callNode);
+        addInterproceduralOperands(F, *subg, CInst, callNode);
     }
 
     PSNodesSeq seq({callNode, returnNode});
@@ -172,6 +193,8 @@ void LLVMPointerGraphBuilder::insertFunctionCall(PSNode *callsite,
         // as we didn't call addNode
         auto *repr = seq.getRepresentant();
         repr->setUserData(const_cast<llvm::CallInst *>(CI));
+        for (auto *nd : seq)
+            nd->setParent(callsite->getParent());
         // add internal successors
         PSNodesSequenceAddSuccessors(seq);
 
@@ -202,13 +225,13 @@ LLVMPointerGraphBuilder::getPointsToFunctions(const llvm::Value *calledValue) {
     std::vector<PSNode *> functions;
     if (isa<Function>(calledValue)) {
         PSNode *node;
-        auto iterator = nodes_map.find(calledValue);
-        if (iterator == nodes_map.end()) {
-            node = PS.create<PSNodeType::FUNCTION>();
+        auto *nodes = getNodes(calledValue);
+        if (!nodes) {
+            node = create<PSNodeType::FUNCTION>();
             addNode(calledValue, node);
             functions.push_back(node);
         } else {
-            functions.push_back(iterator->second.getFirst());
+            functions.push_back(nodes->getFirst());
         }
         return functions;
     }
@@ -444,7 +467,7 @@ bool LLVMPointerGraphBuilder::isRelevantInstruction(
 // create a formal argument
 LLVMPointerGraphBuilder::PSNodesSeq &
 LLVMPointerGraphBuilder::createArgument(const llvm::Argument *farg) {
-    PSNode *arg = PS.create<PSNodeType::PHI>();
+    PSNode *arg = create<PSNodeType::PHI>();
     return addNode(farg, arg);
 }
 
@@ -537,16 +560,14 @@ void LLVMPointerGraphBuilder::buildArguments(const llvm::Function &F,
 }
 
 PointerSubgraph &
-LLVMPointerGraphBuilder::buildFunction(const llvm::Function &F) {
-    DBG_SECTION_BEGIN(pta, "building function '" << F.getName().str() << "'");
-
+LLVMPointerGraphBuilder::createFunctionSubgraph(const llvm::Function &F) {
     assert(!getSubgraph(&F) && "We already built this function");
     assert(!F.isDeclaration() && "Cannot build an undefined function");
 
     // create root and later (an unified) return nodes of this subgraph.
     // These are just for our convenience when building the graph,
     // they can be optimized away later since they are noops
-    PSNodeEntry *root = PSNodeEntry::get(PS.create<PSNodeType::ENTRY>());
+    PSNodeEntry *root = PSNodeEntry::get(create<PSNodeType::ENTRY>());
     assert(root);
     root->setFunctionName(F.getName().str());
 
@@ -554,7 +575,7 @@ LLVMPointerGraphBuilder::buildFunction(const llvm::Function &F) {
     // then create the node for it
     PSNode *vararg = nullptr;
     if (F.isVarArg()) {
-        vararg = PS.create<PSNodeType::PHI>();
+        vararg = create<PSNodeType::PHI>();
     }
 
     // add record to built graphs here, so that subsequent call of this function
@@ -565,6 +586,10 @@ LLVMPointerGraphBuilder::buildFunction(const llvm::Function &F) {
 
     assert(subg->root == root && subg->vararg == vararg);
 
+    // the nodes of the arguments are kept in the function info
+    assert(_funcInfo.find(&F) == _funcInfo.end());
+    _funcInfo[&F];
+
     // create the arguments
     buildArguments(F, subg);
 
@@ -572,14 +597,18 @@ LLVMPointerGraphBuilder::buildFunction(const llvm::Function &F) {
     if (vararg)
         vararg->setParent(subg);
 
-    assert(_funcInfo.find(&F) == _funcInfo.end());
+    return *subg;
+}
+
+void LLVMPointerGraphBuilder::buildFunctionBlocks(const llvm::Function &F,
+                                                  PointerSubgraph &subg) {
     auto &finfo = _funcInfo[&F];
     auto llvmBlocks =
             getBasicBlocksInDominatorOrder(const_cast<llvm::Function &>(F));
 
     // build the instructions from blocks
     for (const llvm::BasicBlock *block : llvmBlocks) {
-        auto blk = buildPointerGraphBlock(*block, subg);
+        auto blk = buildPointerGraphBlock(*block, &subg);
 
         if (blk.empty()) {
             continue;
@@ -590,7 +619,7 @@ LLVMPointerGraphBuilder::buildFunction(const llvm::Function &F) {
 
         // gather all return nodes
         if ((blk.getLastNode()->getType() == PSNodeType::RETURN)) {
-            subg->returnNodes.insert(blk.getLastNode());
+            subg.returnNodes.insert(blk.getLastNode());
         }
 
         finfo.llvmBlocks.emplace(block, std::move(blk));
@@ -599,11 +628,199 @@ LLVMPointerGraphBuilder::buildFunction(const llvm::Function &F) {
     // add operands to PHI nodes. It must be done after all blocks are
     // built, since the PHI gathers values from different blocks
     addPHIOperands(F);
+}
+
+PointerSubgraph &
+LLVMPointerGraphBuilder::buildFunction(const llvm::Function &F) {
+    DBG_SECTION_BEGIN(pta, "building function '" << F.getName().str() << "'");
+
+    PointerSubgraph &subg = createFunctionSubgraph(F);
+    buildFunctionBlocks(F, subg);
 
     assert(getSubgraph(&F)->root != nullptr);
     DBG_SECTION_END(pta,
                     "building function '" << F.getName().str() << "' done");
-    return *subg;
+    return subg;
+}
+
+// the constant expressions that getConstantExprPointer() can handle
+static bool isSupportedConstantExpr(const llvm::ConstantExpr *CE) {
+    using namespace llvm;
+
+    switch (CE->getOpcode()) {
+    case Instruction::GetElementPtr:
+    case Instruction::BitCast:
+    case Instruction::SExt:
+    case Instruction::ZExt:
+    case Instruction::PtrToInt:
+    case Instruction::IntToPtr:
+    case Instruction::Add:
+    case Instruction::And:
+    case Instruction::Or:
+    case Instruction::Trunc:
+    case Instruction::Shl:
+    case Instruction::LShr:
+    case Instruction::AShr:
+    case Instruction::Sub:
+    case Instruction::Mul:
+    case Instruction::SDiv:
+        break;
+    default:
+        return false;
+    }
+
+    for (const Use &op : CE->operands()) {
+        const auto *opCE = dyn_cast<ConstantExpr>(op.get());
+        if (opCE && !isSupportedConstantExpr(opCE))
+            return false;
+    }
+    return true;
+}
+
+void LLVMPointerGraphBuilder::prepareConstants(const llvm::Function &F) {
+    using namespace llvm;
+
+    auto prepare = [this](const Value *val) {
+        for (const Value *V :
+             {val, val->stripPointerCasts(), val->stripInBoundsOffsets()}) {
+            const auto *CE = dyn_cast<ConstantExpr>(V);
+            if ((CE && isSupportedConstantExpr(CE)) || isa<Function>(V))
+                getPointsToNode(V);
+        }
+    };
+
+    // the instructions from the blocks reachable from the entry
+    // are built (the same blocks as in the dominator tree)
+    std::set<const BasicBlock *> reachable{&F.getEntryBlock()};
+    std::vector<const BasicBlock *> queue{&F.getEntryBlock()};
+    while (!queue.empty()) {
+        const BasicBlock *block = queue.back();
+        queue.pop_back();
+
+        for (const Instruction &I : *block) {
+            if (!isRelevantInstruction(I) && !isa<MemSetInst>(&I))
+                continue;
+
+            const Value *called = nullptr;
+            if (const auto *CI = dyn_cast<CallInst>(&I)) {
+#if LLVM_VERSION_MAJOR >= 8
+                called = CI->getCalledOperand();
+#else
+                called = CI->getCalledValue();
+#endif
+            }
+
+            for (const Use &op : I.operands()) {
+                // the nodes of called functions are created
+                // when the calls are connected
+                if (op.get() == called &&
+                    isa<Function>(called->stripPointerCasts()))
+                    continue;
+                prepare(op.get());
+            }
+        }
+
+        for (const BasicBlock *succ : successors(block)) {
+            if (reachable.insert(succ).second)
+                queue.push_back(succ);
+        }
+    }
+}
+
+// the sizes of types are computed lazily and cached in the types
+// and in the data layout, compute them before the functions are built
+// in parallel
+static void prepareTypes(const llvm::Module &M) {
+    llvm::TypeFinder types;
+    types.run(M, /* onlyNamed = */ false);
+
+    const auto &DL = M.getDataLayout();
+    for (llvm::StructType *ST : types) {
+        if (!ST->isOpaque() && ST->isSized())
+            DL.getStructLayout(ST);
+    }
+}
+
+void LLVMPointerGraphBuilder::buildFunctions(const llvm::Function &entry) {
+    // the recording of points-to sets and the table of nodes
+    // of the BDD-based points-to sets are not thread-safe
+#if defined(DG_BDD_POINTS_TO_SET)
+    const unsigned threadsNum = 1;
+#else
+    const unsigned threadsNum =
+            PointsToSetTraceWriter::get() ? 1 : _options.buildThreads;
+#endif
+    if (threadsNum > 1)
+        prepareTypes(*M);
+
+    std::vector<const llvm::Function *> functions;
+    std::vector<const llvm::Function *> wave{&entry};
+    while (!wave.empty()) {
+        DBG(pta, "Building " << wave.size() << " functions");
+
+        // the subgraphs, the arguments and the constants are shared
+        // by the functions, create them before building the functions
+        std::vector<PointerSubgraph *> subgraphs;
+        subgraphs.reserve(wave.size());
+        for (const auto *F : wave)
+            subgraphs.push_back(&createFunctionSubgraph(*F));
+        for (const auto *F : wave) {
+            prepareConstants(*F);
+            _funcInfo[F].pool.reset(new PointerNodesPool());
+        }
+
+        std::atomic<size_t> next{0};
+        auto build = [&]() {
+            size_t i;
+            while ((i = next.fetch_add(1, std::memory_order_relaxed)) <
+                   wave.size()) {
+                auto &pool = *_funcInfo.find(wave[i])->second.pool;
+                PointerNodesPool::Scope scope(pool);
+                _pool = &pool;
+                buildFunctionBlocks(*wave[i], *subgraphs[i]);
+                _pool = nullptr;
+            }
+        };
+
+        std::vector<std::thread> workers;
+        for (unsigned t = 1; t < std::min<size_t>(threadsNum, wave.size());
+             ++t)
+            workers.emplace_back(build);
+        build();
+        for (auto &worker : workers)
+            worker.join();
+
+        // add the nodes to the graph and find the functions
+        // for the next wave in a deterministic order
+        std::vector<const llvm::Function *> nextWave;
+        std::set<const llvm::Function *> found;
+        for (const auto *F : wave) {
+            auto &finfo = _funcInfo[F];
+            PS.adopt(*finfo.pool);
+            finfo.pool.reset();
+
+            for (const auto &call : finfo.calls) {
+                if (!getSubgraph(call.F) && found.insert(call.F).second)
+                    nextWave.push_back(call.F);
+            }
+            functions.push_back(F);
+        }
+        wave.swap(nextWave);
+    }
+
+    // connect the calls and add the program structure
+    for (const auto *F : functions) {
+        auto &finfo = _funcInfo[F];
+        for (const auto &call : finfo.calls)
+            getAndConnectSubgraph(call.F, call.CInst, call.callNode);
+        finfo.calls.clear();
+    }
+
+    for (const auto *F : functions) {
+        PointerSubgraph *subg = getSubgraph(F);
+        addProgramStructure(F, *subg);
+        addInterproceduralOperands(F, *subg);
+    }
 }
 
 void LLVMPointerGraphBuilder::addProgramStructure() {
@@ -636,13 +853,19 @@ PointerGraph *LLVMPointerGraphBuilder::buildLLVMPointerGraph() {
     buildGlobals();
 
     // now we can build rest of the graph
-    PointerSubgraph &subg = buildFunction(*F);
-    PSNode *root = subg.root;
-    assert(root != nullptr);
-    (void) root; // c++17 TODO: replace with [[maybe_unused]]
+    if (threads_) {
+        // the calls of pthread functions build the subgraphs
+        // of the threads while building the callers
+        PointerSubgraph &subg = buildFunction(*F);
+        PSNode *root = subg.root;
+        assert(root != nullptr);
+        (void) root; // c++17 TODO: replace with [[maybe_unused]]
 
-    // fill in the CFG edges
-    addProgramStructure();
+        // fill in the CFG edges
+        addProgramStructure();
+    } else {
+        buildFunctions(*F);
+    }
 
     // FIXME: set entry procedure, not an entry node
     auto *mainsg = getSubgraph(F);
@@ -683,8 +906,94 @@ PointerGraph *LLVMPointerGraphBuilder::buildLLVMPointerGraph() {
     return &PS;
 }
 
-bool LLVMPointerGraphBuilder::validateSubgraph(bool no_connectivity) const {
-    LLVMPointerGraphValidator validator(getPS(), no_connectivity);
+std::vector<PSNode *> LLVMPointerGraphBuilder::updateFunctions(
+        const std::set<const llvm::Function *> &changed,
+        const std::set<const llvm::Function *> &removed) {
+    DBG_SECTION_BEGIN(pta, "updating pointer graph");
+    assert(ad_hoc_building && "The graph has not been built yet");
+    assert(!threads_ && "Updating graphs with threads is not supported");
+
+    std::set<const llvm::Function *> edited(changed.begin(), changed.end());
+    edited.insert(removed.begin(), removed.end());
+
+    std::set<const PointerSubgraph *> editedSubgraphs;
+    for (const auto *F : edited) {
+        if (auto *subg = getSubgraph(F))
+            editedSubgraphs.insert(subg);
+    }
+
+    // the calls of the changed functions from the code that did not change,
+    // they are going to call the new subgraphs
+    std::vector<std::pair<PSNode *, const llvm::Function *>> calls;
+    std::vector<const llvm::Function *> rebuild;
+    for (const auto *F : changed) {
+        auto *subg = getSubgraph(F);
+        if (!subg || removed.count(F) > 0)
+            continue;
+
+        rebuild.push_back(F);
+        for (PSNode *caller : PSNodeEntry::cast(subg->root)->getCallers()) {
+            if (editedSubgraphs.count(caller->getParent()) == 0)
+                calls.emplace_back(caller, F);
+        }
+    }
+
+    std::vector<PSNode *> affected;
+    for (const auto *F : edited) {
+        auto it = subgraphs_map.find(F);
+        if (it == subgraphs_map.end())
+            continue;
+
+        for (PSNode *nd : PS.removeSubgraph(it->second)) {
+            // the nodes of edited functions are going to be removed too
+            if (editedSubgraphs.count(nd->getParent()) == 0)
+                affected.push_back(nd);
+        }
+
+        // this removes also the nodes of the arguments and instructions
+        auto fit = _funcInfo.find(F);
+        assert(fit != _funcInfo.end());
+        _funcInfo.erase(fit);
+        subgraphs_map.erase(it);
+    }
+
+    std::set<const llvm::Function *> built;
+    for (auto &it : subgraphs_map)
+        built.insert(it.first);
+
+    // build the changed functions (this builds also the functions
+    // that they call and that were not built yet)
+    for (const auto *F : rebuild)
+        createOrGetSubgraph(F);
+
+    for (auto &it : calls) {
+        PSNode *callNode = it.first;
+        const auto *F = it.second;
+        if (callNode->getType() == PSNodeType::CALL_FUNCPTR) {
+            insertFunctionCall(callNode, getPointsToNode(F));
+            continue;
+        }
+
+        const auto *CI =
+                callNode->getPairedNode()->getUserData<llvm::CallInst>();
+        auto &subg = getAndConnectSubgraph(F, CI, callNode);
+        addInterproceduralOperands(F, subg, CI, callNode);
+    }
+
+    // add the operands from all the calls of the new subgraphs,
+    // the recursive calls could not get them while building
+    for (auto &it : subgraphs_map) {
+        if (built.count(it.first) == 0)
+            addInterproceduralOperands(it.first, *it.second);
+    }
+
+    DBG_SECTION_END(pta, "updating pointer graph done");
+    return affected;
+}
+
+bool LLVMPointerGraphBuilder::validateSubgraph(bool no_connectivity,
+                                               unsigned firstNode) const {
+    LLVMPointerGraphValidator validator(getPS(), no_connectivity, firstNode);
     if (validator.validate()) {
         assert(!validator.getErrors().empty());
         llvm::errs() << validator.getErrors();
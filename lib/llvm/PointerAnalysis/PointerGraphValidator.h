@@ -16,8 +16,9 @@ class LLVMPointerGraphValidator : public PointerGraphValidator {
 
   public:
     LLVMPointerGraphValidator(const PointerGraph *ps,
-                              bool no_connectivity = false)
-            : PointerGraphValidator(ps, no_connectivity) {}
+                              bool no_connectivity = false,
+                              unsigned first_node = 0)
+            : PointerGraphValidator(ps, no_connectivity, first_node) {}
 
     ~LLVMPointerGraphValidator() override = default;
 };
@@ -56,11 +56,11 @@ LLVMPointerGraphBuilder::buildArgumentsStructure(const llvm::Function &F) {
 
     int idx = 0;
     for (auto A = F.arg_begin(), E = F.arg_end(); A != E; ++A, ++idx) {
-        auto it = nodes_map.find(&*A);
-        if (it == nodes_map.end())
+        auto *nodes = getNodes(&*A);
+        if (!nodes)
             continue;
 
-        PSNodesSeq &cur = it->second;
+        PSNodesSeq &cur = *nodes;
         assert(cur.getFirst() == cur.getLast());
 
         blk.append(&cur);
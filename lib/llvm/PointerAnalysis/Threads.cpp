@@ -87,9 +87,9 @@ bool LLVMPointerGraphBuilder::addFunctionToJoin(PSNode *function,
         DBG(pta, "Found a new join point for function '" << F->getName().str()
                                                          << "'");
         if (!CInst->getOperand(1)->isNull()) {
-            PSNode *phi = PS.create<PSNodeType::PHI>();
+            PSNode *phi = create<PSNodeType::PHI>();
             PSNode *store =
-                    PS.create<PSNodeType::STORE>(phi, CInst->getOperand(1));
+                    create<PSNodeType::STORE>(phi, CInst->getOperand(1));
             phi->addSuccessor(store);
             store->addSuccessor(joinNode);
             for (PSNode *ret : subgraph->returnNodes) {
@@ -107,7 +107,7 @@ bool LLVMPointerGraphBuilder::addFunctionToJoin(PSNode *function,
 
 LLVMPointerGraphBuilder::PSNodesSeq
 LLVMPointerGraphBuilder::createPthreadCreate(const llvm::CallInst *CInst) {
-    PSNodeCall *callNode = PSNodeCall::get(PS.create<PSNodeType::CALL>());
+    PSNodeCall *callNode = PSNodeCall::get(create<PSNodeType::CALL>());
     PSNodeFork *forkNode = createForkNode(CInst, callNode);
 
     callNode->addSuccessor(forkNode);
@@ -119,7 +119,7 @@ LLVMPointerGraphBuilder::createPthreadCreate(const llvm::CallInst *CInst) {
 
 LLVMPointerGraphBuilder::PSNodesSeq
 LLVMPointerGraphBuilder::createPthreadJoin(const llvm::CallInst *CInst) {
-    PSNodeCall *callNode = PSNodeCall::get(PS.create<PSNodeType::CALL>());
+    PSNodeCall *callNode = PSNodeCall::get(create<PSNodeType::CALL>());
     PSNodeJoin *joinNode = createJoinNode(CInst, callNode);
 
     // FIXME: create only the join node, not call node and join node
@@ -130,7 +130,7 @@ PSNodeFork *LLVMPointerGraphBuilder::createForkNode(const llvm::CallInst *CInst,
                                                     PSNode *callNode) {
     using namespace llvm;
     PSNodeFork *forkNode = PSNodeFork::get(
-            PS.create<PSNodeType::FORK>(getOperand(CInst->getArgOperand(2))));
+            create<PSNodeType::FORK>(getOperand(CInst->getArgOperand(2))));
     callNode->setPairedNode(forkNode);
     forkNode->setPairedNode(callNode);
 
@@ -151,7 +151,7 @@ PSNodeJoin *LLVMPointerGraphBuilder::createJoinNode(const llvm::CallInst *CInst,
                                                     PSNode *callNode) {
     using namespace llvm;
 
-    PSNodeJoin *joinNode = PSNodeJoin::get(PS.create<PSNodeType::JOIN>());
+    PSNodeJoin *joinNode = PSNodeJoin::get(create<PSNodeType::JOIN>());
     callNode->setPairedNode(joinNode);
     joinNode->setPairedNode(callNode);
 
@@ -167,12 +167,12 @@ LLVMPointerGraphBuilder::PSNodesSeq
 LLVMPointerGraphBuilder::createPthreadExit(const llvm::CallInst *CInst) {
     using namespace llvm;
 
-    PSNodeCall *callNode = PSNodeCall::get(PS.create<PSNodeType::CALL>());
+    PSNodeCall *callNode = PSNodeCall::get(create<PSNodeType::CALL>());
     addArgumentOperands(*CInst, *callNode);
     auto *pthread_exit_operand = callNode->getOperand(0);
 
     PSNodeRet *returnNode =
-            PSNodeRet::get(PS.create<PSNodeType::RETURN>(pthread_exit_operand));
+            PSNodeRet::get(create<PSNodeType::RETURN>(pthread_exit_operand));
     callNode->setPairedNode(returnNode);
     returnNode->setPairedNode(callNode);
     callNode->addSuccessor(returnNode);
@@ -69,10 +69,17 @@ class LLVMReadWriteGraphBuilder
 
     ReadWriteGraph &&build() {
         // FIXME: this is a bit of a hack
-        if (!PTA->getOptions().isSVF()) {
-            auto *dgpta = static_cast<DGLLVMPointerAnalysis *>(PTA);
+        auto *dgpta = PTA->getOptions().isSVF()
+                              ? nullptr
+                              : static_cast<DGLLVMPointerAnalysis *>(PTA);
+        if (dgpta && dgpta->getPTA()) {
             llvmdg::CallGraph CG(dgpta->getPTA()->getPG()->getCallGraph());
             buildFromLLVM(&CG);
+        } else if (dgpta) {
+            // the results were loaded from a snapshot,
+            // there is no call graph from the analysis
+            llvmdg::CallGraph CG(getModule(), PTA);
+            buildFromLLVM(&CG);
         } else {
             buildFromLLVM();
         }
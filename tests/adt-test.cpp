@@ -1,6 +1,11 @@
 #include <catch2/catch.hpp>
 
+#include <map>
+#include <random>
+
+#include "dg/ADT/Arena.h"
 #include "dg/ADT/Bitvector.h"
+#include "dg/ADT/PersistentMap.h"
 #include "dg/ADT/Queue.h"
 #include "dg/ReadWriteGraph/DefSite.h"
 
@@ -171,6 +176,181 @@ TEST_CASE("STL hashmap collision test", "HashMap") {
     hashCollisionTest<dg::STLHashMap<MyInt, int>>();
 }
 
+// merge the values by taking the maximum
+struct MaxMergePolicy {
+    bool canShareAll() const { return true; }
+    bool canShare(int * /*unused*/, int /*unused*/) const { return true; }
+    static int create(int * /*unused*/) { return 0; }
+    bool merge(int &to, int from) const {
+        if (from <= to)
+            return false;
+        to = from;
+        return true;
+    }
+};
+
+TEST_CASE("Persistent map basic manip", "PersistentMap") {
+    int keys[100];
+    PersistentMap<int *, int> M;
+    REQUIRE(M.empty());
+    REQUIRE(M.find(&keys[0]) == nullptr);
+
+    for (int i = 99; i >= 0; i -= 3)
+        M[&keys[i]] = i;
+
+    REQUIRE(M.size() == 34);
+    for (int i = 0; i < 100; ++i) {
+        if ((99 - i) % 3 == 0)
+            REQUIRE(*M.find(&keys[i]) == i);
+        else
+            REQUIRE(M.find(&keys[i]) == nullptr);
+    }
+
+    // the entries are ordered by the keys
+    int *last = nullptr;
+    for (const auto &it : M) {
+        REQUIRE(last < it.first);
+        REQUIRE(it.second == it.first - keys);
+        last = it.first;
+    }
+}
+
+TEST_CASE("Persistent map copy-on-write", "PersistentMap") {
+    int keys[50];
+    PersistentMap<int *, int> M;
+    for (int i = 0; i < 50; ++i)
+        M[&keys[i]] = i;
+
+    auto C = M;
+    REQUIRE(C.sharesWith(M));
+
+    C[&keys[10]] = 100;
+    C.getWritable(&keys[1], -1) = 1000;
+    REQUIRE(!C.sharesWith(M));
+    REQUIRE(*C.find(&keys[10]) == 100);
+    REQUIRE(*C.find(&keys[1]) == 1000);
+    REQUIRE(*M.find(&keys[10]) == 10);
+    REQUIRE(*M.find(&keys[1]) == 1);
+    for (int i = 0; i < 50; ++i) {
+        if (i != 1 && i != 10)
+            REQUIRE(C.find(&keys[i]) == M.find(&keys[i]));
+    }
+
+    PersistentMap<int *, int> N;
+    N.getWritable(&keys[0], 7);
+    REQUIRE(*N.find(&keys[0]) == 7);
+    REQUIRE(M.find(&keys[0]) != N.find(&keys[0]));
+}
+
+TEST_CASE("Persistent map merge", "PersistentMap") {
+    int keys[200];
+    std::mt19937 gen(7);
+    std::uniform_int_distribution<int> key(0, 199);
+    std::uniform_int_distribution<int> val(0, 1000);
+
+    for (int round = 0; round < 20; ++round) {
+        PersistentMap<int *, int> A, B;
+        std::map<int *, int> refA, refB;
+        for (int i = 0; i < 60; ++i) {
+            int *k = &keys[key(gen)];
+            int v = val(gen);
+            A[k] = v;
+            refA[k] = v;
+            k = &keys[key(gen)];
+            v = val(gen);
+            B[k] = v;
+            refB[k] = v;
+        }
+
+        // maps derived from each other
+        auto C = A;
+        C[&keys[key(gen)]] = 2000;
+
+        MaxMergePolicy policy;
+        bool changed = false;
+        for (const auto &it : refB) {
+            auto &v = refA[it.first];
+            if (it.second > v) {
+                v = it.second;
+                changed = true;
+            }
+        }
+        changed |= refA.size() != A.size();
+
+        REQUIRE(A.merge(B, policy) == changed);
+        REQUIRE(!A.merge(B, policy));
+        REQUIRE(A.size() == refA.size());
+        for (const auto &it : refA)
+            REQUIRE(*A.find(it.first) == it.second);
+        for (const auto &it : refB)
+            REQUIRE(*B.find(it.first) == it.second);
+
+        REQUIRE(C.merge(A, policy));
+        REQUIRE(!C.merge(A, policy));
+        for (const auto &it : A)
+            REQUIRE(*C.find(it.first) >= it.second);
+    }
+}
+
+// counts the living objects
+struct ArenaObject {
+    static int alive;
+    std::vector<int> data;
+    ArenaObject(int n) : data(n, n) { ++alive; }
+    ~ArenaObject() { --alive; }
+};
+int ArenaObject::alive = 0;
+
+TEST_CASE("Arena allocation", "Arena") {
+    {
+        Arena arena;
+        std::vector<ArenaPtr<ArenaObject>> objects;
+        for (int i = 0; i < 10000; ++i)
+            objects.emplace_back(arena.create<ArenaObject>(i % 10));
+        REQUIRE(ArenaObject::alive == 10000);
+        // the objects are allocated in the order of creation
+        REQUIRE(objects[1].get() - objects[0].get() == 1);
+        REQUIRE(arena.getAllocatedBytes() == 10000 * sizeof(ArenaObject));
+        REQUIRE(arena.getChunksNum() < 10);
+        for (int i = 0; i < 10000; ++i)
+            REQUIRE(objects[i]->data.size() == static_cast<size_t>(i % 10));
+
+        // aligned allocations
+        auto *d = arena.create<double>(1.0);
+        REQUIRE(reinterpret_cast<uintptr_t>(d) % alignof(double) == 0);
+        auto *c = arena.create<char>('a');
+        auto *l = arena.create<long long>(2);
+        REQUIRE(reinterpret_cast<uintptr_t>(l) % alignof(long long) == 0);
+        REQUIRE(*d == 1.0);
+        REQUIRE(*c == 'a');
+        REQUIRE(*l == 2);
+
+        objects[5].reset();
+        REQUIRE(ArenaObject::alive == 9999);
+
+        // moving the arena keeps the objects where they are
+        Arena other = std::move(arena);
+        REQUIRE(objects[9999]->data.size() == 9);
+
+        // the memory taken from another arena is freed with this arena
+        auto allocated = other.getAllocatedBytes();
+        auto chunks = other.getChunksNum();
+        {
+            Arena pool;
+            objects.emplace_back(pool.create<ArenaObject>(3));
+            other.take(pool);
+            REQUIRE(pool.getChunksNum() == 0);
+            REQUIRE(pool.getAllocatedBytes() == 0);
+        }
+        REQUIRE(objects.back()->data.size() == 3);
+        REQUIRE(other.getChunksNum() == chunks + 1);
+        REQUIRE(other.getAllocatedBytes() == allocated + sizeof(ArenaObject));
+        // destroy the objects before the arena
+        objects.clear();
+    }
+    REQUIRE(ArenaObject::alive == 0);
+}
+
 #ifdef HAVE_TSL_HOPSCOTCH
 #include "dg/ADT/TslHopscotchHashMap.h"
 
@@ -4,7 +4,9 @@
 #include <set>
 
 #include "dg/ADT/Bitvector.h"
+#include "dg/ADT/HybridBitvector.h"
 
+using dg::ADT::HybridBitvector;
 using dg::ADT::SparseBitvector;
 
 TEST_CASE("Querying empty set", "SparseBitvector") {
@@ -205,3 +207,141 @@ TEST_CASE("Merge random bitvectors (union)", "SparseBitvector") {
     //    B2.merge(B1);
     //    REQUIRE(B1 == B2);
 }
+
+TEST_CASE("Intersecting bitvectors", "SparseBitvector") {
+    SparseBitvector B1;
+    SparseBitvector B2;
+    REQUIRE(!B1.intersects(B2));
+
+    // the same bucket, different bits
+    B1.set(1);
+    B1.set(1000);
+    B2.set(2);
+    REQUIRE(!B1.intersects(B2));
+    REQUIRE(!B2.intersects(B1));
+
+    B2.set(~uint64_t{0});
+    B2.set(130);
+    REQUIRE(!B1.intersects(B2));
+
+    B1.set(130);
+    REQUIRE(B1.intersects(B2));
+    REQUIRE(B2.intersects(B1));
+    REQUIRE(B1.intersects(B1));
+}
+
+template <typename BitvectorT>
+static void checkEqual(const BitvectorT &B, const std::set<uint64_t> &numbers) {
+    REQUIRE(B.size() == numbers.size());
+    REQUIRE(B.empty() == numbers.empty());
+    auto it = numbers.begin();
+    for (auto x : B) {
+        REQUIRE(it != numbers.end());
+        REQUIRE(x == *it);
+        ++it;
+    }
+    REQUIRE(it == numbers.end());
+}
+
+TEST_CASE("Hybrid bitvector set and unset", "HybridBitvector") {
+    HybridBitvector B;
+    std::set<uint64_t> numbers;
+
+    std::default_random_engine generator;
+    // small range, so that the bitvector gets dense
+    std::uniform_int_distribution<uint64_t> distribution(0, 20000);
+
+    for (int i = 0; i < 10000; ++i) {
+        auto x = distribution(generator);
+        REQUIRE(B.set(x) == (numbers.count(x) > 0));
+        numbers.insert(x);
+    }
+    REQUIRE(B.isDense());
+    checkEqual(B, numbers);
+
+    for (int i = 0; i < 20000; ++i) {
+        auto x = distribution(generator);
+        REQUIRE(B.unset(x) == (numbers.erase(x) > 0));
+        REQUIRE(!B.get(x));
+    }
+    checkEqual(B, numbers);
+
+    // keep only the smallest and the greatest number
+    auto lo = *numbers.begin();
+    auto hi = *numbers.rbegin();
+    for (auto x : numbers) {
+        if (x != lo && x != hi)
+            REQUIRE(B.unset(x));
+    }
+    REQUIRE(!B.isDense());
+    checkEqual(B, {lo, hi});
+
+    REQUIRE(B.unset(lo));
+    REQUIRE(B.unset(hi));
+    REQUIRE(B.empty());
+    REQUIRE(B.begin() == B.end());
+}
+
+TEST_CASE("Hybrid bitvector extreme values", "HybridBitvector") {
+    HybridBitvector B;
+    for (unsigned int i = 0; i < 64; ++i) {
+        REQUIRE(B.set(uint64_t{1} << i) == false);
+    }
+    REQUIRE(B.set(~uint64_t{0}) == false);
+    REQUIRE(B.size() == 65);
+    for (unsigned int i = 0; i < 64; ++i) {
+        REQUIRE(B.get(uint64_t{1} << i));
+    }
+    REQUIRE(B.get(~uint64_t{0}));
+    REQUIRE(!B.isDense());
+}
+
+TEST_CASE("Hybrid bitvector operations", "HybridBitvector") {
+    std::default_random_engine generator;
+
+    for (uint64_t range : {uint64_t{1000}, uint64_t{100000}, ~uint64_t{0}}) {
+        std::uniform_int_distribution<uint64_t> distribution(0, range);
+        for (int round = 0; round < 10; ++round) {
+            HybridBitvector B1, B2;
+            std::set<uint64_t> N1, N2;
+            for (int i = 0; i < 2000; ++i) {
+                auto x = distribution(generator);
+                B1.set(x);
+                N1.insert(x);
+                // make the other bitvector less dense
+                if (i % 3 == 0) {
+                    x = distribution(generator);
+                    B2.set(x);
+                    N2.insert(x);
+                }
+            }
+
+            std::set<uint64_t> U(N1), I;
+            U.insert(N2.begin(), N2.end());
+            for (auto x : N1) {
+                if (N2.count(x) > 0)
+                    I.insert(x);
+            }
+
+            REQUIRE(B1.intersects(B2) == !I.empty());
+
+            HybridBitvector U1(B1), U2(B2);
+            REQUIRE(U1.set(B2) == (U.size() != N1.size()));
+            REQUIRE(U2.set(B1));
+            REQUIRE(!U1.set(B2));
+            checkEqual(U1, U);
+            checkEqual(U2, U);
+            REQUIRE(U1 == U2);
+            REQUIRE(U1.hash() == U2.hash());
+            REQUIRE(U1 != B1);
+
+            HybridBitvector I1(B1), I2(B2);
+            REQUIRE(I1.intersect(B2) == (I.size() != N1.size()));
+            I2.intersect(B1);
+            checkEqual(I1, I);
+            checkEqual(I2, I);
+            REQUIRE(I1 == I2);
+            REQUIRE(I1.hash() == I2.hash());
+        }
+    }
+}
@@ -1,8 +1,14 @@
 #include <catch2/catch.hpp>
 
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "dg/PointerAnalysis/MemoryObject.h"
 #include "dg/PointerAnalysis/PSNode.h"
 #include "dg/PointerAnalysis/Pointer.h"
 #include "dg/PointerAnalysis/PointerGraph.h"
+#include "dg/PointerAnalysis/PointsToSetTrace.h"
 
 using namespace dg::pta;
 
@@ -15,8 +21,9 @@ void queryingEmptySet() {
 
 template <typename PTSetT>
 void addAnElement() {
-    PTSetT B;
     PointerGraph PS;
+    dg::PointerIDLookupTable::Scope IDs(PS.getPointerIDs());
+    PTSetT B;
     PSNode *A = PS.create<PSNodeType::ALLOC>();
     B.add(Pointer(A, 0));
     REQUIRE(*(B.begin()) == Pointer(A, 0));
@@ -24,8 +31,9 @@ void addAnElement() {
 
 template <typename PTSetT>
 void addFewElements() {
-    PTSetT S;
     PointerGraph PS;
+    dg::PointerIDLookupTable::Scope IDs(PS.getPointerIDs());
+    PTSetT S;
     PSNode *A = PS.create<PSNodeType::ALLOC>();
     REQUIRE(S.add(Pointer(A, 0)) == true);
     REQUIRE(S.add(Pointer(A, 20)) == true);
@@ -40,8 +48,9 @@ void addFewElements() {
 
 template <typename PTSetT>
 void addFewElements2() {
-    PTSetT S;
     PointerGraph PS;
+    dg::PointerIDLookupTable::Scope IDs(PS.getPointerIDs());
+    PTSetT S;
     PSNode *A = PS.create<PSNodeType::ALLOC>();
     PSNode *B = PS.create<PSNodeType::ALLOC>();
     REQUIRE(S.add(Pointer(A, 0)) == true);
@@ -67,9 +76,10 @@ void addFewElements2() {
 
 template <typename PTSetT>
 void mergePointsToSets() {
+    PointerGraph PS;
+    dg::PointerIDLookupTable::Scope IDs(PS.getPointerIDs());
     PTSetT S1;
     PTSetT S2;
-    PointerGraph PS;
     PSNode *A = PS.create<PSNodeType::ALLOC>();
     PSNode *B = PS.create<PSNodeType::ALLOC>();
 
@@ -85,8 +95,9 @@ void mergePointsToSets() {
 
 template <typename PTSetT>
 void removeElement() {
-    PTSetT S;
     PointerGraph PS;
+    dg::PointerIDLookupTable::Scope IDs(PS.getPointerIDs());
+    PTSetT S;
     PSNode *A = PS.create<PSNodeType::ALLOC>();
 
     REQUIRE(S.add({A, 0}) == true);
@@ -98,8 +109,9 @@ void removeElement() {
 
 template <typename PTSetT>
 void removeFewElements() {
-    PTSetT S;
     PointerGraph PS;
+    dg::PointerIDLookupTable::Scope IDs(PS.getPointerIDs());
+    PTSetT S;
     PSNode *A = PS.create<PSNodeType::ALLOC>();
     PSNode *B = PS.create<PSNodeType::ALLOC>();
 
@@ -117,8 +129,9 @@ void removeFewElements() {
 
 template <typename PTSetT>
 void removeAnyTest() {
-    PTSetT S;
     PointerGraph PS;
+    dg::PointerIDLookupTable::Scope IDs(PS.getPointerIDs());
+    PTSetT S;
     PSNode *A = PS.create<PSNodeType::ALLOC>();
     PSNode *B = PS.create<PSNodeType::ALLOC>();
 
@@ -138,8 +151,9 @@ void removeAnyTest() {
 
 template <typename PTSetT>
 void pointsToTest() {
-    PTSetT S;
     PointerGraph PS;
+    dg::PointerIDLookupTable::Scope IDs(PS.getPointerIDs());
+    PTSetT S;
     PSNode *A = PS.create<PSNodeType::ALLOC>();
     PSNode *B = PS.create<PSNodeType::ALLOC>();
     S.add(Pointer(A, 0));
@@ -170,8 +184,9 @@ void pointsToTest() {
 template <typename PTSetT>
 void testAlignedOverflowBehavior() { // only works for aligned PTSets using
                                      // overflow Set
-    PTSetT S;
     PointerGraph PS;
+    dg::PointerIDLookupTable::Scope IDs(PS.getPointerIDs());
+    PTSetT S;
     PSNode *A = PS.create<PSNodeType::ALLOC>();
     PSNode *B = PS.create<PSNodeType::ALLOC>();
     REQUIRE(S.getMultiplier() > 1);
@@ -209,8 +224,9 @@ void testAlignedOverflowBehavior() { // only works for aligned PTSets using
 
 template <typename PTSetT>
 void testSmallOverflowBehavior() { // only works for SmallOffsetsPTSet
-    PTSetT S;
     PointerGraph PS;
+    dg::PointerIDLookupTable::Scope IDs(PS.getPointerIDs());
+    PTSetT S;
     PSNode *A = PS.create<PSNodeType::ALLOC>();
     PSNode *B = PS.create<PSNodeType::ALLOC>();
     REQUIRE(S.add(Pointer(A, 0)) == true);
@@ -250,6 +266,8 @@ TEST_CASE("Querying empty set", "PointsToSet") {
     queryingEmptySet<SimplePointsToSet>();
     queryingEmptySet<SeparateOffsetsPointsToSet>();
     queryingEmptySet<PointerIdPointsToSet>();
+    queryingEmptySet<SharedPointerIdPointsToSet>();
+    queryingEmptySet<BddPointsToSet>();
     queryingEmptySet<SmallOffsetsPointsToSet>();
     queryingEmptySet<AlignedSmallOffsetsPointsToSet>();
     queryingEmptySet<AlignedPointerIdPointsToSet>();
@@ -260,6 +278,8 @@ TEST_CASE("Add an element", "PointsToSet") {
     addAnElement<SimplePointsToSet>();
     addAnElement<SeparateOffsetsPointsToSet>();
     addAnElement<PointerIdPointsToSet>();
+    addAnElement<SharedPointerIdPointsToSet>();
+    addAnElement<BddPointsToSet>();
     addAnElement<SmallOffsetsPointsToSet>();
     addAnElement<AlignedSmallOffsetsPointsToSet>();
     addAnElement<AlignedPointerIdPointsToSet>();
@@ -270,6 +290,8 @@ TEST_CASE("Add few elements", "PointsToSet") {
     addFewElements<SimplePointsToSet>();
     addFewElements<SeparateOffsetsPointsToSet>();
     addFewElements<PointerIdPointsToSet>();
+    addFewElements<SharedPointerIdPointsToSet>();
+    addFewElements<BddPointsToSet>();
     addFewElements<SmallOffsetsPointsToSet>();
     addFewElements<AlignedSmallOffsetsPointsToSet>();
     addFewElements<AlignedPointerIdPointsToSet>();
@@ -280,6 +302,8 @@ TEST_CASE("Add few elements 2", "PointsToSet") {
     addFewElements2<SimplePointsToSet>();
     addFewElements2<SeparateOffsetsPointsToSet>();
     addFewElements2<PointerIdPointsToSet>();
+    addFewElements2<SharedPointerIdPointsToSet>();
+    addFewElements2<BddPointsToSet>();
     addFewElements2<SmallOffsetsPointsToSet>();
     addFewElements2<AlignedSmallOffsetsPointsToSet>();
     addFewElements2<AlignedPointerIdPointsToSet>();
@@ -290,6 +314,8 @@ TEST_CASE("Merge points-to sets", "PointsToSet") {
     mergePointsToSets<SimplePointsToSet>();
     mergePointsToSets<SeparateOffsetsPointsToSet>();
     mergePointsToSets<PointerIdPointsToSet>();
+    mergePointsToSets<SharedPointerIdPointsToSet>();
+    mergePointsToSets<BddPointsToSet>();
     mergePointsToSets<SmallOffsetsPointsToSet>();
     mergePointsToSets<AlignedSmallOffsetsPointsToSet>();
     mergePointsToSets<AlignedPointerIdPointsToSet>();
@@ -301,6 +327,8 @@ TEST_CASE("Remove element",
     removeElement<OffsetsSetPointsToSet>();
     removeElement<SimplePointsToSet>();
     removeElement<PointerIdPointsToSet>();
+    removeElement<SharedPointerIdPointsToSet>();
+    removeElement<BddPointsToSet>();
     removeElement<SmallOffsetsPointsToSet>();
     removeElement<AlignedSmallOffsetsPointsToSet>();
     removeElement<AlignedPointerIdPointsToSet>();
@@ -312,6 +340,8 @@ TEST_CASE("Remove few elements",
     removeFewElements<OffsetsSetPointsToSet>();
     removeFewElements<SimplePointsToSet>();
     removeFewElements<PointerIdPointsToSet>();
+    removeFewElements<SharedPointerIdPointsToSet>();
+    removeFewElements<BddPointsToSet>();
     removeFewElements<SmallOffsetsPointsToSet>();
     removeFewElements<AlignedSmallOffsetsPointsToSet>();
     removeFewElements<AlignedPointerIdPointsToSet>();
@@ -323,6 +353,8 @@ TEST_CASE("Remove all elements pointing to a target",
     removeAnyTest<OffsetsSetPointsToSet>();
     removeAnyTest<SimplePointsToSet>();
     removeAnyTest<PointerIdPointsToSet>();
+    removeAnyTest<SharedPointerIdPointsToSet>();
+    removeAnyTest<BddPointsToSet>();
     removeAnyTest<SmallOffsetsPointsToSet>();
     removeAnyTest<AlignedSmallOffsetsPointsToSet>();
     removeAnyTest<AlignedPointerIdPointsToSet>();
@@ -333,11 +365,66 @@ TEST_CASE("Test various points-to functions", "PointsToSet") {
     pointsToTest<SimplePointsToSet>();
     pointsToTest<SeparateOffsetsPointsToSet>();
     pointsToTest<PointerIdPointsToSet>();
+    pointsToTest<SharedPointerIdPointsToSet>();
+    pointsToTest<BddPointsToSet>();
     pointsToTest<SmallOffsetsPointsToSet>();
     pointsToTest<AlignedSmallOffsetsPointsToSet>();
     pointsToTest<AlignedPointerIdPointsToSet>();
 }
 
+TEST_CASE("Sharing points-to sets", "PointsToSet") {
+    PointerGraph PS;
+    dg::PointerIDLookupTable::Scope IDs(PS.getPointerIDs());
+    PSNode *A = PS.create<PSNodeType::ALLOC>();
+    PSNode *B = PS.create<PSNodeType::ALLOC>();
+
+    auto sharedSets = SharedPointerIdPointsToSet::getNumOfSharedSets();
+    SharedPointerIdPointsToSet S1;
+    S1.add(Pointer(A, 0));
+    S1.add(Pointer(B, 0));
+    REQUIRE(!S1.isShared());
+
+    // copying the set shares the pointers
+    SharedPointerIdPointsToSet S2(S1);
+    SharedPointerIdPointsToSet S3;
+    REQUIRE(S3.add(S1));
+    REQUIRE(S1.isShared());
+    REQUIRE(S2.isShared());
+    REQUIRE(S3.isShared());
+    REQUIRE(SharedPointerIdPointsToSet::getNumOfSharedSets() == sharedSets + 1);
+
+    // the set diverges
+    REQUIRE(S2.add(Pointer(A, 4)));
+    REQUIRE(!S2.isShared());
+    REQUIRE(S2.size() == 3);
+    REQUIRE(S1.size() == 2);
+    REQUIRE(S3.size() == 2);
+    REQUIRE(!S3.has(Pointer(A, 4)));
+
+    // unions of shared sets are shared
+    SharedPointerIdPointsToSet S4(S2);
+    REQUIRE(S3.add(S4));
+    REQUIRE(S3.isShared());
+    REQUIRE(S3.size() == 3);
+    REQUIRE(S3.has(Pointer(A, 4)));
+    REQUIRE(!S3.add(S4));
+    REQUIRE(!S3.add(S1));
+    REQUIRE(S1.size() == 2);
+    REQUIRE(!S1.has(Pointer(A, 4)));
+    SharedPointerIdPointsToSet S5(S1);
+    REQUIRE(S5.add(S4));
+    REQUIRE(S5.size() == 3);
+    REQUIRE(SharedPointerIdPointsToSet::getNumOfSharedSets() == sharedSets + 2);
+
+    S1.clear();
+    S5.clear();
+    REQUIRE(S1.empty());
+    REQUIRE(S3.size() == 3);
+    REQUIRE(S3.removeAny(A));
+    REQUIRE(S3.size() == 1);
+    REQUIRE(S4.size() == 3);
+}
+
 TEST_CASE("Test small overflow set behavior", "PointsToSet") {
     testSmallOverflowBehavior<SmallOffsetsPointsToSet>();
 }
@@ -346,3 +433,328 @@ TEST_CASE("Test aligned overflow set behavior", "PointsToSet") {
     testAlignedOverflowBehavior<AlignedSmallOffsetsPointsToSet>();
     testAlignedOverflowBehavior<AlignedPointerIdPointsToSet>();
 }
+
+TEST_CASE("BDD points-to sets", "PointsToSet") {
+    PointerGraph PS;
+    dg::PointerIDLookupTable::Scope IDs(PS.getPointerIDs());
+    std::vector<PSNode *> nodes;
+    for (int i = 0; i < 20; ++i)
+        nodes.push_back(PS.create<PSNodeType::ALLOC>());
+
+    BddPointsToSet S1, S2;
+    for (auto *nd : nodes) {
+        for (dg::Offset off = 0; off < 64; off += 4) {
+            REQUIRE(S1.add(Pointer(nd, off)));
+        }
+    }
+    // the same pointers in different order give the same diagram
+    for (auto it = nodes.rbegin(); it != nodes.rend(); ++it) {
+        for (dg::Offset off = 0; off < 64; off += 4) {
+            REQUIRE(S2.add(Pointer(*it, off)));
+        }
+    }
+    REQUIRE(S1.size() == 20 * 16);
+    REQUIRE(S1 == S2);
+
+    // the pointers are iterated in the order of their IDs
+    size_t n = 0;
+    for (const auto &ptr : S1) {
+        REQUIRE(S2.has(ptr));
+        ++n;
+    }
+    REQUIRE(n == S1.size());
+
+    BddPointsToSet S3(S1);
+    REQUIRE(!S3.add(S2));
+    REQUIRE(S3.add(Pointer(nodes[0], dg::Offset::UNKNOWN)));
+    REQUIRE(S3 != S1);
+    REQUIRE(S3.size() == 19 * 16 + 1);
+    REQUIRE(S3.mayPointTo(Pointer(nodes[0], 8)));
+    REQUIRE(!S3.pointsTo(Pointer(nodes[0], 8)));
+
+    REQUIRE(S1.add(S3));
+    REQUIRE(S1.size() == 20 * 16 + 1);
+    REQUIRE(S1.removeAny(nodes[0]));
+    REQUIRE(S3.remove(Pointer(nodes[0], dg::Offset::UNKNOWN)));
+    REQUIRE(S1 == S3);
+    REQUIRE(S1.size() == 19 * 16);
+}
+
+TEST_CASE("Pointer IDs are per graph", "PointsToSet") {
+    auto &defaultIDs = dg::PointerIDLookupTable::getDefault();
+    {
+        PointerGraph PS1;
+        PSNode *A = PS1.create<PSNodeType::ALLOC>();
+        // creating the graph does not change the current table
+        REQUIRE(&dg::PointerIDLookupTable::current() == &defaultIDs);
+
+        auto &IDs1 = PS1.getPointerIDs();
+        dg::PointerIDLookupTable::Scope scope1(IDs1);
+        SharedPointerIdPointsToSet S1;
+        for (uint64_t off = 0; off < 1000; ++off)
+            REQUIRE(S1.add(Pointer(A, off)));
+        // the IDs are dense and start after the pointers of static nodes
+        REQUIRE(IDs1.get(Pointer(A, 0)) > 2);
+        REQUIRE(IDs1.get(Pointer(A, 999)) - IDs1.get(Pointer(A, 0)) == 999);
+        REQUIRE(IDs1.get(Pointer(A, 1000)) == 0);
+        REQUIRE(IDs1.size() < 1010);
+        for (uint64_t off = 0; off < 1000; ++off)
+            REQUIRE(IDs1.get(IDs1.get(Pointer(A, off))) == Pointer(A, off));
+        auto size1 = IDs1.size();
+
+        // querying does not create new IDs
+        REQUIRE(!S1.has(Pointer(A, 1000)));
+        REQUIRE(IDs1.size() == size1);
+
+        PointerGraph PS2;
+        PSNode *B = PS2.create<PSNodeType::ALLOC>();
+        SharedPointerIdPointsToSet S2;
+        {
+            dg::PointerIDLookupTable::Scope scope2(PS2.getPointerIDs());
+            SharedPointerIdPointsToSet S3;
+            REQUIRE(S3.add(Pointer(B, 0)));
+            S2 = S3;
+        }
+        REQUIRE(PS2.getPointerIDs().size() < 10);
+        REQUIRE(PS2.getPointerIDs().get(Pointer(B, 0)) > 2);
+        REQUIRE(IDs1.get(Pointer(B, 0)) == 0);
+        REQUIRE(IDs1.size() == size1);
+
+        // every set uses its own table, whatever table is current
+        REQUIRE(S1.size() == 1000);
+        REQUIRE(S1.has(Pointer(A, 500)));
+        for (const auto &ptr : S1)
+            REQUIRE(ptr.target == A);
+        REQUIRE(*S2.begin() == Pointer(B, 0));
+
+        // merging sets with different tables translates the IDs
+        SharedPointerIdPointsToSet S4;
+        REQUIRE(S4.add(S2));
+        REQUIRE(S4.add(S1));
+        REQUIRE(S4.size() == 1001);
+        REQUIRE(S4.has(Pointer(B, 0)));
+        REQUIRE(IDs1.get(Pointer(B, 0)) != 0);
+
+        // the static nodes have the same pointers in all tables
+        REQUIRE(*NULLPTR->pointsTo.begin() == Pointer(NULLPTR, 0));
+        PSNode *C = PS1.create<PSNodeType::CAST>(A);
+        REQUIRE(C->pointsTo.empty());
+        REQUIRE(C->addPointsTo(NULLPTR->pointsTo));
+        REQUIRE(C->pointsTo.has(Pointer(NULLPTR, 0)));
+    }
+    REQUIRE(&dg::PointerIDLookupTable::current() == &defaultIDs);
+}
+
+TEST_CASE("Recording points-to sets", "PointsToSet") {
+    using RecordedSet = RecordingPointsToSet<SimplePointsToSet>;
+    const char *path = "ptset-trace-test.bin";
+
+    PointerGraph PS;
+    dg::PointerIDLookupTable::Scope IDs(PS.getPointerIDs());
+    PSNode *A = PS.create<PSNodeType::ALLOC>();
+    PSNode *B = PS.create<PSNodeType::ALLOC>();
+
+    // the set created before the recording is recorded with its contents
+    RecordedSet S0;
+    S0.add(Pointer(B, 8));
+    REQUIRE(PointsToSetTraceWriter::start(path));
+    {
+        RecordedSet S1;
+        REQUIRE(S1.add(Pointer(A, 0)));
+        REQUIRE(S1.add(S0));
+        RecordedSet S2 = S1;
+        REQUIRE(S2.pointsTo(Pointer(B, 8)));
+        REQUIRE(S2.removeAny(B));
+        REQUIRE(S2.add(Pointer(A, dg::Offset::UNKNOWN)));
+        size_t n = 0;
+        for (const auto &ptr : S2) {
+            REQUIRE(ptr == Pointer(A, dg::Offset::UNKNOWN));
+            ++n;
+        }
+        REQUIRE(n == 1);
+        REQUIRE(S1.size() == 2);
+    }
+    PointsToSetTraceWriter::stop();
+    // not recorded anymore
+    S0.add(Pointer(A, 0));
+
+    using Op = PointsToSetOp;
+    using Record = PointsToSetTraceReader::Record;
+    std::vector<Record> expected = {
+            {Op::CREATE, 1, 0, 0},
+            {Op::ADD, 1, A->getID(), 0},
+            {Op::CREATE, 2, 0, 0},
+            {Op::ADD, 2, B->getID(), 8},
+            {Op::ADD_SET, 1, 2, 0},
+            {Op::COPY, 3, 1, 0},
+            {Op::POINTS_TO, 3, B->getID(), 8},
+            {Op::REMOVE_ANY, 3, B->getID(), 0},
+            {Op::ADD, 3, A->getID(), dg::Offset::UNKNOWN},
+            {Op::ITERATE, 3, 0, 0},
+            {Op::DESTROY, 3, 0, 0},
+            {Op::DESTROY, 1, 0, 0},
+    };
+
+    PointsToSetTraceReader reader;
+    REQUIRE(reader.open(path));
+    Record rec;
+    for (const auto &exp : expected) {
+        REQUIRE(reader.next(rec));
+        REQUIRE(rec.op == exp.op);
+        REQUIRE(rec.set == exp.set);
+        REQUIRE(rec.arg == exp.arg);
+        REQUIRE(rec.offset == exp.offset);
+    }
+    REQUIRE(!reader.next(rec));
+    REQUIRE(!reader.hasError());
+    std::remove(path);
+}
+
+TEST_CASE("Offset map", "MemoryObject") {
+    PointerGraph PS;
+    dg::PointerIDLookupTable::Scope IDs(PS.getPointerIDs());
+    PSNode *A = PS.create<PSNodeType::ALLOC>();
+    PSNode *B = PS.create<PSNodeType::ALLOC>();
+
+    MemoryObject mo(A);
+    REQUIRE(mo.pointsTo.empty());
+    REQUIRE(mo.find(0) == mo.end());
+    REQUIRE(mo.pointsTo.count(dg::Offset::UNKNOWN) == 0);
+
+    // insert the offsets out of order, more than fits inline
+    const uint64_t offsets[] = {16, 0, 8, 4, 32, 12, 24, 20, 28, 2, 6};
+    REQUIRE(mo.addPointsTo(dg::Offset::UNKNOWN, Pointer(B, 0)));
+    for (auto off : offsets) {
+        REQUIRE(mo.addPointsTo(off, Pointer(A, off)));
+        REQUIRE(!mo.addPointsTo(off, Pointer(A, off)));
+    }
+    REQUIRE(mo.pointsTo.size() == 12);
+
+    // the entries are ordered by offsets, unknown offset is the last one
+    dg::Offset prev = 0;
+    for (const auto &it : mo.pointsTo) {
+        REQUIRE(prev <= it.first);
+        prev = it.first;
+        if (!it.first.isUnknown())
+            REQUIRE(it.second.has(Pointer(A, it.first)));
+    }
+    REQUIRE(prev.isUnknown());
+
+    for (auto off : offsets)
+        REQUIRE(mo.find(off)->second.has(Pointer(A, off)));
+    REQUIRE(mo.find(dg::Offset::UNKNOWN)->second.has(Pointer(B, 0)));
+    REQUIRE(mo.find(1) == mo.end());
+
+    // copies and moves keep the entries
+    MemoryObject copy = mo;
+    REQUIRE(copy.pointsTo.size() == 12);
+    MemoryObject moved = std::move(copy);
+    REQUIRE(moved.find(32)->second.has(Pointer(A, 32)));
+
+    MemoryObject small(B);
+    small.addPointsTo(4, Pointer(B, 0));
+    MemoryObject small2 = std::move(small);
+    REQUIRE(small2.pointsTo.size() == 1);
+    small2 = moved;
+    REQUIRE(small2.pointsTo.size() == 12);
+
+    mo.pointsTo.clear();
+    REQUIRE(mo.pointsTo.empty());
+    REQUIRE(mo.addPointsTo(0, Pointer(B, 0)));
+    REQUIRE(mo.pointsTo.size() == 1);
+}
+
+// copy the range pointer by pointer (the reference for mergeRange)
+static void mergeRangeNaive(MemoryObject &dst, const MemoryObject &src,
+                            dg::Offset from, dg::Offset len, dg::Offset to,
+                            dg::Offset limit) {
+    const auto entries = src.pointsTo;
+    for (const auto &it : entries) {
+        if (it.second.empty())
+            continue;
+        if (it.first.isUnknown() || from.isUnknown() || to.isUnknown()) {
+            if (it.first.isUnknown() || from.isUnknown() ||
+                (from <= it.first && *it.first - *from < *len))
+                dst.addPointsTo(dg::Offset::UNKNOWN, it.second);
+            continue;
+        }
+        if (it.first < from || (!len.isUnknown() && *it.first - *from >= *len))
+            continue;
+        dg::Offset off = *it.first - *from + *to;
+        dst.addPointsTo(off < limit ? off : dg::Offset::UNKNOWN, it.second);
+    }
+}
+
+TEST_CASE("Memory object ranges", "MemoryObject") {
+    PointerGraph PS;
+    dg::PointerIDLookupTable::Scope IDs(PS.getPointerIDs());
+    PSNode *A = PS.create<PSNodeType::ALLOC>();
+    PSNode *B = PS.create<PSNodeType::ALLOC>();
+
+    MemoryObject mo(A);
+    for (uint64_t off = 0; off < 64; off += 8)
+        mo.addPointsTo(off, Pointer(B, off));
+    mo.addPointsTo(dg::Offset::UNKNOWN, Pointer(A, 0));
+
+    auto range = mo.range(8, 24);
+    REQUIRE(range.second - range.first == 3);
+    REQUIRE(range.first->first == 8);
+    REQUIRE((range.second - 1)->first == 24);
+    range = mo.range(9, 1);
+    REQUIRE(range.first == range.second);
+    // the unknown length spans the known offsets
+    range = mo.range(40, dg::Offset::UNKNOWN);
+    REQUIRE(range.second - range.first == 3);
+    REQUIRE(range.second == mo.find(dg::Offset::UNKNOWN));
+
+    // shifting the range merges it with the existing entries
+    MemoryObject dst(B);
+    dst.addPointsTo(4, Pointer(A, 4));
+    dst.addPointsTo(100, Pointer(A, 100));
+    REQUIRE(dst.mergeRange(mo, 16, 24, 4, 96));
+    REQUIRE(!dst.mergeRange(mo, 16, 24, 4, 96));
+    REQUIRE(dst.pointsTo.size() == 5);
+    REQUIRE(dst.find(4)->second.has(Pointer(A, 4)));
+    REQUIRE(dst.find(4)->second.has(Pointer(B, 16)));
+    REQUIRE(dst.find(12)->second.has(Pointer(B, 24)));
+    REQUIRE(dst.find(20)->second.has(Pointer(B, 32)));
+    REQUIRE(dst.find(100)->second.size() == 1);
+    REQUIRE(dst.find(dg::Offset::UNKNOWN)->second.has(Pointer(A, 0)));
+
+    // compare with copying pointer by pointer on random objects
+    std::mt19937 gen(42);
+    const dg::Offset::type U = dg::Offset::UNKNOWN;
+    for (int round = 0; round < 500; ++round) {
+        MemoryObject src(A), dst1(B);
+        for (int i = 0; i < static_cast<int>(gen() % 20); ++i)
+            src.addPointsTo(gen() % 64, Pointer(A, gen() % 4));
+        if (gen() % 4 == 0)
+            src.addPointsTo(U, Pointer(B, 0));
+        for (int i = 0; i < static_cast<int>(gen() % 20); ++i)
+            dst1.addPointsTo(gen() % 64, Pointer(B, gen() % 4));
+        if (gen() % 4 == 0)
+            dst1.addPointsTo(U, Pointer(A, 0));
+        MemoryObject dst2(dst1);
+
+        dg::Offset from = gen() % 8 == 0 ? U : gen() % 64;
+        dg::Offset len = gen() % 8 == 0 ? U : 1 + gen() % 64;
+        dg::Offset to = gen() % 8 == 0 ? U : gen() % 64;
+        dg::Offset limit = gen() % 8 == 0 ? U : gen() % 128;
+        // copying within one object
+        bool self = gen() % 8 == 0;
+        auto &from1 = self ? dst1 : src;
+        auto &from2 = self ? dst2 : src;
+
+        dst1.mergeRange(from1, from, len, to, limit);
+        mergeRangeNaive(dst2, from2, from, len, to, limit);
+
+        REQUIRE(dst1.pointsTo.size() == dst2.pointsTo.size());
+        for (const auto &it : dst2.pointsTo) {
+            auto dit = dst1.find(it.first);
+            REQUIRE(dit != dst1.end());
+            REQUIRE(dit->second.size() == it.second.size());
+            for (const auto &ptr : it.second)
+                REQUIRE(dit->second.has(ptr));
+        }
+    }
+}
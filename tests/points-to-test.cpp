@@ -1,8 +1,20 @@
 #include <catch2/catch.hpp>
 
+#include <set>
+#include <sstream>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "dg/PointerAnalysis/PointerAnalysisDemand.h"
 #include "dg/PointerAnalysis/PointerAnalysisFI.h"
 #include "dg/PointerAnalysis/PointerAnalysisFS.h"
+#include "dg/PointerAnalysis/PointerAnalysisSFS.h"
+#include "dg/PointerAnalysis/PointerAnalysisSteensgaard.h"
+#include "dg/PointerAnalysis/AliasCache.h"
 #include "dg/PointerAnalysis/PointerGraph.h"
+#include "dg/PointerAnalysis/PointerGraphOptimizations.h"
 
 using namespace dg::pta;
 using dg::Offset;
@@ -922,6 +934,537 @@ TEST_CASE("Flow sensitive", "FS") {
     memcpy_test8<dg::pta::PointerAnalysisFS>();
 }
 
+// the points-to sets of all nodes of the graph (as pairs of IDs and offsets)
+static std::vector<std::set<std::pair<unsigned, uint64_t>>>
+collect_results(const PointerGraph &PS) {
+    std::vector<std::set<std::pair<unsigned, uint64_t>>> ret;
+    for (const auto &nd : PS.getNodes()) {
+        ret.emplace_back();
+        if (!nd)
+            continue;
+        // union of sets does not subsume concrete offsets by the unknown
+        // offset, so compare only the pointers that are not subsumed
+        for (const auto &ptr : nd->pointsTo) {
+            if (!ptr.offset.isUnknown() &&
+                nd->pointsTo.has(Pointer(ptr.target, Offset::UNKNOWN)))
+                continue;
+            ret.back().emplace(ptr.target->getID(), *ptr.offset);
+        }
+        // the analysis does not keep the history
+        REQUIRE(nd->getPointsToHistory() == nullptr);
+    }
+
+    return ret;
+}
+
+// build a graph with a cycle through memory and through a PHI node
+// and return the points-to sets of the nodes (as pairs of IDs and offsets)
+template <typename PTStoT>
+std::vector<std::set<std::pair<unsigned, uint64_t>>>
+loop_results(const dg::PointerAnalysisOptions &opts) {
+    PointerGraph PS;
+    PSNode *A = PS.create<PSNodeType::ALLOC>();
+    A->setSize(16);
+    PSNode *B = PS.create<PSNodeType::ALLOC>();
+    PSNode *C = PS.create<PSNodeType::ALLOC>();
+    C->setSize(8);
+    PSNode *S1 = PS.create<PSNodeType::STORE>(A, B);
+    PSNode *L1 = PS.create<PSNodeType::LOAD>(B);
+    PSNode *G = PS.create<PSNodeType::GEP>(L1, 4);
+    PSNode *PHI = PS.create<PSNodeType::PHI>(C, G);
+    PSNode *CAST = PS.create<PSNodeType::CAST>(PHI);
+    PSNode *S2 = PS.create<PSNodeType::STORE>(CAST, B);
+    PSNode *L2 = PS.create<PSNodeType::LOAD>(B);
+
+    A->addSuccessor(B);
+    B->addSuccessor(C);
+    C->addSuccessor(S1);
+    S1->addSuccessor(L1);
+    L1->addSuccessor(G);
+    G->addSuccessor(PHI);
+    PHI->addSuccessor(CAST);
+    CAST->addSuccessor(S2);
+    S2->addSuccessor(L2);
+    L2->addSuccessor(L1);
+
+    auto *subg = PS.createSubgraph(A);
+    PS.setEntry(subg);
+    PTStoT PA(&PS, opts);
+    PA.run();
+
+    REQUIRE(L2->pointsTo.mayPointTo(Pointer(A, 0)));
+    REQUIRE(L2->pointsTo.mayPointTo(Pointer(C, 0)));
+
+    return collect_results(PS);
+}
+
+// a cycle of copy nodes:
+//  P1 = phi(A, C2), C1 = cast P1, G0 = gep C1 + 0,
+//  P2 = phi(G0, B), C2 = cast P2
+template <typename PTStoT>
+std::vector<std::set<std::pair<unsigned, uint64_t>>>
+copy_cycle_results(dg::PointerAnalysisOptions opts) {
+    PointerGraph PS;
+    PSNode *A = PS.create<PSNodeType::ALLOC>();
+    PSNode *B = PS.create<PSNodeType::ALLOC>();
+    PSNode *P1 = PS.create<PSNodeType::PHI>(A);
+    PSNode *C1 = PS.create<PSNodeType::CAST>(P1);
+    PSNode *G0 = PS.create<PSNodeType::GEP>(C1, 0);
+    PSNode *P2 = PS.create<PSNodeType::PHI>(G0, B);
+    PSNode *C2 = PS.create<PSNodeType::CAST>(P2);
+    P1->addOperand(C2);
+    PSNode *L = PS.create<PSNodeType::LOAD>(C2);
+
+    A->addSuccessor(B);
+    B->addSuccessor(P1);
+    P1->addSuccessor(C1);
+    C1->addSuccessor(G0);
+    G0->addSuccessor(P2);
+    P2->addSuccessor(C2);
+    C2->addSuccessor(P1);
+    C2->addSuccessor(L);
+
+    auto *subg = PS.createSubgraph(A);
+    PS.setEntry(subg);
+    // the GEP would get unknown offset as it is on a loop
+    PTStoT PA(&PS, opts.setPreprocessGeps(false));
+    PA.run();
+
+    for (auto *nd : {P1, C1, G0, P2, C2}) {
+        REQUIRE(nd->pointsTo.size() == 2);
+        REQUIRE(nd->doesPointsTo(A, 0));
+        REQUIRE(nd->doesPointsTo(B, 0));
+    }
+
+    return collect_results(PS);
+}
+
+// run the analysis with the options returned by Opts
+template <typename PTStoT, dg::PointerAnalysisOptions (*Opts)()>
+class WithOptions : public PTStoT {
+  public:
+    WithOptions(PointerGraph *PS) : PTStoT(PS, Opts()) {}
+};
+
+static dg::PointerAnalysisOptions diffPropagation() {
+    return dg::PointerAnalysisOptions().setDiffPropagation(true);
+}
+
+static dg::PointerAnalysisOptions sccOrderedWorklist() {
+    return dg::PointerAnalysisOptions().setSCCOrderedWorklist(true);
+}
+
+static dg::PointerAnalysisOptions collapseCycles() {
+    return dg::PointerAnalysisOptions().setCollapseCycles(true);
+}
+
+static dg::PointerAnalysisOptions parallelSolver() {
+    return dg::PointerAnalysisOptions().setSolverThreads(4);
+}
+
+template <typename PTStoT>
+void all_tests() {
+    store_load<PTStoT>();
+    store_load2<PTStoT>();
+    store_load3<PTStoT>();
+    store_load4<PTStoT>();
+    store_load5<PTStoT>();
+    gep1<PTStoT>();
+    gep2<PTStoT>();
+    gep3<PTStoT>();
+    gep4<PTStoT>();
+    gep5<PTStoT>();
+    nulltest<PTStoT>();
+    constant_store<PTStoT>();
+    load_from_zeroed<PTStoT>();
+    load_from_unknown_offset<PTStoT>();
+    load_from_unknown_offset2<PTStoT>();
+    load_from_unknown_offset3<PTStoT>();
+    memcpy_test<PTStoT>();
+    memcpy_test2<PTStoT>();
+    memcpy_test3<PTStoT>();
+    memcpy_test4<PTStoT>();
+    memcpy_test5<PTStoT>();
+    memcpy_test6<PTStoT>();
+    memcpy_test7<PTStoT>();
+    memcpy_test8<PTStoT>();
+}
+
+TEST_CASE("Flow insensitive with difference propagation", "FI-diff") {
+    all_tests<WithOptions<dg::pta::PointerAnalysisFI, diffPropagation>>();
+}
+
+TEST_CASE("Flow sensitive with difference propagation", "FS-diff") {
+    all_tests<WithOptions<dg::pta::PointerAnalysisFS, diffPropagation>>();
+}
+
+TEST_CASE("Difference propagation", "diff") {
+    dg::PointerAnalysisOptions opts;
+    dg::PointerAnalysisOptions diffopts;
+    diffopts.setDiffPropagation(true);
+
+    REQUIRE(loop_results<dg::pta::PointerAnalysisFI>(opts) ==
+            loop_results<dg::pta::PointerAnalysisFI>(diffopts));
+    REQUIRE(loop_results<dg::pta::PointerAnalysisFS>(opts) ==
+            loop_results<dg::pta::PointerAnalysisFS>(diffopts));
+}
+
+TEST_CASE("Flow insensitive with SCC-ordered worklist", "FI-worklist") {
+    all_tests<WithOptions<dg::pta::PointerAnalysisFI, sccOrderedWorklist>>();
+}
+
+TEST_CASE("Flow sensitive with SCC-ordered worklist", "FS-worklist") {
+    all_tests<WithOptions<dg::pta::PointerAnalysisFS, sccOrderedWorklist>>();
+}
+
+TEST_CASE("SCC-ordered worklist FI memory", "worklist") {
+    // in flow-insensitive analysis, the load must see
+    // also the stores that are after it in the control flow
+    PointerGraph PS;
+    PSNode *A = PS.create<PSNodeType::ALLOC>();
+    PSNode *P = PS.create<PSNodeType::ALLOC>();
+    PSNode *L = PS.create<PSNodeType::LOAD>(P);
+    PSNode *S = PS.create<PSNodeType::STORE>(A, P);
+
+    A->addSuccessor(P);
+    P->addSuccessor(L);
+    L->addSuccessor(S);
+
+    auto *subg = PS.createSubgraph(A);
+    PS.setEntry(subg);
+    WithOptions<dg::pta::PointerAnalysisFI, sccOrderedWorklist> PA(&PS);
+    PA.run();
+
+    REQUIRE(L->doesPointsTo(A));
+}
+
+TEST_CASE("SCC-ordered worklist FI queues only readers", "worklist") {
+    // a loop where the store at the end changes the memory read
+    // by the load at the beginning. Only the load must be processed
+    // again, not the whole loop
+    PointerGraph PS;
+    PSNode *A = PS.create<PSNodeType::ALLOC>();
+    PSNode *P = PS.create<PSNodeType::ALLOC>();
+    PSNode *Q = PS.create<PSNodeType::ALLOC>();
+    PSNode *H = PS.create<PSNodeType::NOOP>();
+    PSNode *L = PS.create<PSNodeType::LOAD>(P);
+    A->addSuccessor(P);
+    P->addSuccessor(Q);
+    Q->addSuccessor(H);
+    H->addSuccessor(L);
+
+    PSNode *last = L;
+    for (int i = 0; i < 100; ++i) {
+        PSNode *N = PS.create<PSNodeType::NOOP>();
+        last->addSuccessor(N);
+        last = N;
+    }
+
+    PSNode *S1 = PS.create<PSNodeType::STORE>(A, Q);
+    PSNode *L2 = PS.create<PSNodeType::LOAD>(Q);
+    PSNode *S2 = PS.create<PSNodeType::STORE>(L2, P);
+    last->addSuccessor(S1);
+    S1->addSuccessor(L2);
+    L2->addSuccessor(S2);
+    S2->addSuccessor(H);
+
+    auto *subg = PS.createSubgraph(A);
+    PS.setEntry(subg);
+    PointerAnalysisFI PA(&PS, sccOrderedWorklist().setStatistics(true));
+    PA.run();
+    REQUIRE(L->doesPointsTo(A));
+
+    size_t visits = 0;
+    for (const auto &T : PA.getStatistics()->nodeTypes)
+        visits += T.visits;
+    // every node once and the load again
+    REQUIRE(visits <= PS.getNodes().size() + 2);
+}
+
+TEST_CASE("SCC-ordered worklist", "worklist") {
+    dg::PointerAnalysisOptions opts;
+    dg::PointerAnalysisOptions wlopts;
+    wlopts.setSCCOrderedWorklist(true);
+
+    REQUIRE(loop_results<dg::pta::PointerAnalysisFI>(opts) ==
+            loop_results<dg::pta::PointerAnalysisFI>(wlopts));
+    REQUIRE(loop_results<dg::pta::PointerAnalysisFS>(opts) ==
+            loop_results<dg::pta::PointerAnalysisFS>(wlopts));
+
+    wlopts.setDiffPropagation(true);
+    REQUIRE(loop_results<dg::pta::PointerAnalysisFI>(opts) ==
+            loop_results<dg::pta::PointerAnalysisFI>(wlopts));
+    REQUIRE(loop_results<dg::pta::PointerAnalysisFS>(opts) ==
+            loop_results<dg::pta::PointerAnalysisFS>(wlopts));
+}
+
+TEST_CASE("Flow insensitive with collapsing cycles", "FI-cycles") {
+    all_tests<WithOptions<dg::pta::PointerAnalysisFI, collapseCycles>>();
+}
+
+TEST_CASE("Flow sensitive with collapsing cycles", "FS-cycles") {
+    all_tests<WithOptions<dg::pta::PointerAnalysisFS, collapseCycles>>();
+}
+
+TEST_CASE("Collapsing cycles", "cycles") {
+    dg::PointerAnalysisOptions opts;
+    dg::PointerAnalysisOptions cycopts;
+    cycopts.setCollapseCycles(true);
+
+    REQUIRE(copy_cycle_results<dg::pta::PointerAnalysisFI>(opts) ==
+            copy_cycle_results<dg::pta::PointerAnalysisFI>(cycopts));
+    REQUIRE(copy_cycle_results<dg::pta::PointerAnalysisFS>(opts) ==
+            copy_cycle_results<dg::pta::PointerAnalysisFS>(cycopts));
+    REQUIRE(loop_results<dg::pta::PointerAnalysisFI>(opts) ==
+            loop_results<dg::pta::PointerAnalysisFI>(cycopts));
+
+    cycopts.setSCCOrderedWorklist(true).setDiffPropagation(true);
+    REQUIRE(copy_cycle_results<dg::pta::PointerAnalysisFI>(opts) ==
+            copy_cycle_results<dg::pta::PointerAnalysisFI>(cycopts));
+    REQUIRE(copy_cycle_results<dg::pta::PointerAnalysisFS>(opts) ==
+            copy_cycle_results<dg::pta::PointerAnalysisFS>(cycopts));
+}
+
+TEST_CASE("Flow insensitive with parallel solver", "FI-parallel") {
+    all_tests<WithOptions<dg::pta::PointerAnalysisFI, parallelSolver>>();
+}
+
+// a graph big enough to be processed by multiple threads:
+// a chain of blocks that store and load pointers through
+// a shared memory and a loop around the whole chain
+static std::vector<std::set<std::pair<unsigned, uint64_t>>>
+parallel_results(unsigned threads) {
+    PointerGraph PS;
+    PSNode *M = PS.create<PSNodeType::ALLOC>();
+    M->setSize(16);
+    PSNode *first = M;
+    PSNode *last = M;
+    auto append = [&last](PSNode *nd) {
+        last->addSuccessor(nd);
+        last = nd;
+        return nd;
+    };
+
+    PSNode *PHI = append(PS.create<PSNodeType::PHI>());
+    PSNode *prev = PHI;
+    for (int i = 0; i < 200; ++i) {
+        PSNode *A = append(PS.create<PSNodeType::ALLOC>());
+        A->setSize(16);
+        PSNode *G = append(PS.create<PSNodeType::GEP>(M, (i % 2) * 8));
+        PSNode *L = append(PS.create<PSNodeType::LOAD>(G));
+        PSNode *P = append(PS.create<PSNodeType::PHI>(L, A, prev));
+        PSNode *C = append(PS.create<PSNodeType::CAST>(P));
+        append(PS.create<PSNodeType::STORE>(C, G));
+        prev = append(PS.create<PSNodeType::GEP>(C, 4));
+    }
+    PHI->addOperand(prev);
+    last->addSuccessor(PHI);
+
+    auto *subg = PS.createSubgraph(first);
+    PS.setEntry(subg);
+    PointerAnalysisFI PA(&PS,
+                         dg::PointerAnalysisOptions().setSolverThreads(threads));
+    PA.run();
+
+    return collect_results(PS);
+}
+
+TEST_CASE("Parallel solver", "parallel") {
+    dg::PointerAnalysisOptions opts;
+    dg::PointerAnalysisOptions paropts;
+    paropts.setSolverThreads(4);
+
+    REQUIRE(loop_results<dg::pta::PointerAnalysisFI>(opts) ==
+            loop_results<dg::pta::PointerAnalysisFI>(paropts));
+    REQUIRE(parallel_results(1) == parallel_results(4));
+}
+
+TEST_CASE("Staged flow sensitive", "SFS") {
+    all_tests<PointerAnalysisSFS>();
+}
+
+TEST_CASE("Staged flow sensitive results", "SFS") {
+    dg::PointerAnalysisOptions opts;
+    REQUIRE(loop_results<dg::pta::PointerAnalysisFS>(opts) ==
+            loop_results<dg::pta::PointerAnalysisSFS>(opts));
+    REQUIRE(copy_cycle_results<dg::pta::PointerAnalysisFS>(opts) ==
+            copy_cycle_results<dg::pta::PointerAnalysisSFS>(opts));
+}
+
+TEST_CASE("Staged flow sensitive memory maps", "SFS") {
+    // the memory D is never read, so the store S1 does not need
+    // its own memory map (as opposed to the flow-sensitive analysis)
+    PointerGraph PS;
+    PSNode *A = PS.create<PSNodeType::ALLOC>();
+    PSNode *B = PS.create<PSNodeType::ALLOC>();
+    PSNode *C = PS.create<PSNodeType::ALLOC>();
+    PSNode *D = PS.create<PSNodeType::ALLOC>();
+    PSNode *S1 = PS.create<PSNodeType::STORE>(A, D);
+    PSNode *S2 = PS.create<PSNodeType::STORE>(C, B);
+    PSNode *L1 = PS.create<PSNodeType::LOAD>(B);
+    PSNode *N = PS.create<PSNodeType::NOOP>();
+    PSNode *L2 = PS.create<PSNodeType::LOAD>(B);
+
+    A->addSuccessor(B);
+    B->addSuccessor(C);
+    C->addSuccessor(D);
+    D->addSuccessor(S1);
+    D->addSuccessor(S2);
+    S1->addSuccessor(N);
+    S2->addSuccessor(L1);
+    L1->addSuccessor(N);
+    N->addSuccessor(L2);
+
+    auto *subg = PS.createSubgraph(A);
+    PS.setEntry(subg);
+    PointerAnalysisSFS PA(&PS);
+    PA.run();
+
+    REQUIRE(L1->pointsTo.size() == 1);
+    REQUIRE(L1->doesPointsTo(C));
+    REQUIRE(L2->doesPointsTo(C));
+    // the root, S2 and the join N
+    REQUIRE(PA.getNumOfMapOwners() == 3);
+}
+
+// a loop with a chain of K pointers that are loaded and stored in the
+// reverse order (so that every pass through the loop moves the pointer
+// one link further) and many nodes that do not touch the memory;
+// returns the points-to sets of the nodes and the number of processed nodes
+template <typename PTStoT>
+std::pair<std::vector<std::set<std::pair<unsigned, uint64_t>>>, size_t>
+memory_chain_results() {
+    const unsigned K = 5;
+    PointerGraph PS;
+    PSNode *X = PS.create<PSNodeType::ALLOC>();
+    std::vector<PSNode *> P;
+    for (unsigned i = 0; i <= K; ++i)
+        P.push_back(PS.create<PSNodeType::ALLOC>());
+    PSNode *S0 = PS.create<PSNodeType::STORE>(X, P[0]);
+    PSNode *H = PS.create<PSNodeType::NOOP>();
+
+    X->addSuccessor(P[0]);
+    for (unsigned i = 0; i < K; ++i)
+        P[i]->addSuccessor(P[i + 1]);
+    P[K]->addSuccessor(S0);
+    S0->addSuccessor(H);
+
+    PSNode *last = H;
+    for (unsigned i = K; i > 0; --i) {
+        PSNode *L = PS.create<PSNodeType::LOAD>(P[i - 1]);
+        PSNode *S = PS.create<PSNodeType::STORE>(L, P[i]);
+        last->addSuccessor(L);
+        L->addSuccessor(S);
+        last = S;
+    }
+    for (unsigned i = 0; i < 100; ++i) {
+        PSNode *N = PS.create<PSNodeType::NOOP>();
+        last->addSuccessor(N);
+        last = N;
+    }
+    PSNode *L = PS.create<PSNodeType::LOAD>(P[K]);
+    last->addSuccessor(L);
+    L->addSuccessor(H);
+
+    auto *subg = PS.createSubgraph(X);
+    PS.setEntry(subg);
+    PTStoT PA(&PS, sccOrderedWorklist().setStatistics(true));
+    PA.run();
+    REQUIRE(L->doesPointsTo(X));
+
+    size_t visits = 0;
+    for (const auto &T : PA.getStatistics()->nodeTypes)
+        visits += T.visits;
+    return {collect_results(PS), visits};
+}
+
+TEST_CASE("Staged flow sensitive def-use propagation", "SFS") {
+    auto FS = memory_chain_results<PointerAnalysisFS>();
+    auto SFS = memory_chain_results<PointerAnalysisSFS>();
+    REQUIRE(FS.first == SFS.first);
+    // the changes of memory are propagated only to the loads
+    // and joins that use them, not through the whole loop
+    REQUIRE(SFS.second < FS.second);
+}
+
+template <typename PTStoT>
+std::vector<std::set<std::pair<unsigned, Offset::type>>>
+equivalent_nodes_results(bool optimize) {
+    const bool fi = std::is_same<PTStoT, PointerAnalysisFI>::value;
+
+    PointerGraph PS;
+    PSNode *A = PS.create<PSNodeType::ALLOC>();
+    PSNode *B = PS.create<PSNodeType::ALLOC>();
+    PSNode *S1 = PS.create<PSNodeType::STORE>(A, B);
+    PSNode *G1 = PS.create<PSNodeType::GEP>(A, 4);
+    PSNode *G2 = PS.create<PSNodeType::GEP>(A, 4);
+    PSNode *G3 = PS.create<PSNodeType::GEP>(A, 8);
+    PSNode *P1 = PS.create<PSNodeType::PHI>(G1, B);
+    PSNode *P2 = PS.create<PSNodeType::PHI>(B, G2);
+    PSNode *S2 = PS.create<PSNodeType::STORE>(G2, G1);
+    PSNode *L1 = PS.create<PSNodeType::LOAD>(B);
+    PSNode *L2 = PS.create<PSNodeType::LOAD>(B);
+    PSNode *L3 = PS.create<PSNodeType::LOAD>(P2);
+
+    A->addSuccessor(B);
+    B->addSuccessor(S1);
+    S1->addSuccessor(G1);
+    G1->addSuccessor(G2);
+    G2->addSuccessor(G3);
+    G3->addSuccessor(P1);
+    P1->addSuccessor(P2);
+    P2->addSuccessor(S2);
+    S2->addSuccessor(L1);
+    L1->addSuccessor(L2);
+    L2->addSuccessor(L3);
+
+    auto *subg = PS.createSubgraph(A);
+    PS.setEntry(subg);
+
+    // the merged nodes are replaced by their representants
+    std::vector<PSNode *> nodes{G1, G2, G3, P1, P2, L1, L2, L3};
+    if (optimize) {
+        PointerGraphOptimizer optimizer(&PS, fi);
+        // loads are merged only in flow-insensitive analysis
+        REQUIRE(optimizer.run() == (fi ? 3 : 2));
+
+        const auto &mapping = optimizer.getMapping();
+        REQUIRE(mapping.get(G2) == G1);
+        REQUIRE(mapping.get(P2) == P1);
+        REQUIRE(mapping.get(G3) == nullptr);
+        REQUIRE(mapping.get(L2) == (fi ? L1 : nullptr));
+        // the store keeps both operands
+        REQUIRE(S2->getOperandsNum() == 2);
+        REQUIRE(S2->getOperand(0) == G1);
+        REQUIRE(S2->getOperand(1) == G1);
+        REQUIRE(L3->getOperand(0) == P1);
+
+        for (auto &nd : nodes) {
+            if (PSNode *rep = mapping.get(nd))
+                nd = rep;
+        }
+    }
+
+    PTStoT PA(&PS);
+    PA.run();
+
+    std::vector<std::set<std::pair<unsigned, Offset::type>>> results;
+    for (PSNode *nd : nodes) {
+        results.emplace_back();
+        for (const auto &ptr : nd->pointsTo)
+            results.back().emplace(ptr.target->getID(), *ptr.offset);
+    }
+
+    return results;
+}
+
+TEST_CASE("Merging pointer-equivalent nodes", "optimizer") {
+    REQUIRE(equivalent_nodes_results<PointerAnalysisFI>(false) ==
+            equivalent_nodes_results<PointerAnalysisFI>(true));
+    REQUIRE(equivalent_nodes_results<PointerAnalysisFS>(false) ==
+            equivalent_nodes_results<PointerAnalysisFS>(true));
+}
+
 TEST_CASE("PSNode test", "PSNode") {
     using namespace dg::pta;
     PointerGraph PS;
@@ -936,3 +1479,737 @@ TEST_CASE("PSNode test", "PSNode") {
     REQUIRE(N2->pointsTo.size() == 1);
     REQUIRE(N2->addPointsTo(N1, 3) == false);
 }
+
+// a function that returns a new allocation
+static PointerSubgraph *createAllocFun(PointerGraph &PS, PSNode *call) {
+    PSNode *E = PS.create<PSNodeType::ENTRY>();
+    PSNode *A = PS.create<PSNodeType::ALLOC>();
+    PSNode *R = PS.create<PSNodeType::RETURN>(A);
+    E->addSuccessor(A);
+    A->addSuccessor(R);
+
+    auto *subg = PS.createSubgraph(E);
+    subg->returnNodes.insert(R);
+    for (PSNode *nd : {E, A, R})
+        nd->setParent(subg);
+
+    PSNodeCall::cast(call)->addCallee(subg);
+    PSNodeEntry::cast(E)->addCaller(call);
+    PSNode *callRet = call->getPairedNode();
+    callRet->addOperand(R);
+    PSNodeRet::get(R)->addReturnSite(callRet);
+    PSNodeCallRet::cast(callRet)->addReturn(R);
+    return subg;
+}
+
+template <typename PTStoT>
+void remove_subgraph() {
+    PointerGraph PS;
+    PSNode *E = PS.create<PSNodeType::ENTRY>();
+    PSNode *M = PS.create<PSNodeType::ALLOC>();
+    PSNode *C = PS.create<PSNodeType::CALL>();
+    PSNode *CR = PS.create<PSNodeType::CALL_RETURN>();
+    C->setPairedNode(CR);
+    CR->setPairedNode(C);
+    PSNode *S = PS.create<PSNodeType::STORE>(CR, M);
+    PSNode *L = PS.create<PSNodeType::LOAD>(M);
+    PSNode *P = PS.create<PSNodeType::PHI>(CR);
+
+    E->addSuccessor(M);
+    M->addSuccessor(C);
+    C->addSuccessor(CR);
+    CR->addSuccessor(S);
+    S->addSuccessor(L);
+    L->addSuccessor(P);
+
+    auto *main = PS.createSubgraph(E);
+    for (PSNode *nd : {E, M, C, CR, S, L, P})
+        nd->setParent(main);
+    PS.setEntry(main);
+
+    auto *fun = createAllocFun(PS, C);
+    PSNode *A1 = fun->root->getSingleSuccessor();
+    {
+        PTStoT PA(&PS);
+        PA.run();
+        REQUIRE(CR->doesPointsTo(A1));
+        REQUIRE(L->doesPointsTo(A1));
+        REQUIRE(P->doesPointsTo(A1));
+    }
+
+    auto affected = PS.removeSubgraph(fun);
+    REQUIRE(affected == std::vector<PSNode *>{CR});
+    REQUIRE(PS.getSubgraphs().size() == 1);
+    REQUIRE(PSNodeCall::cast(C)->getCallees().empty());
+    REQUIRE(CR->getOperandsNum() == 0);
+    REQUIRE(PSNodeCallRet::cast(CR)->getReturns().empty());
+    // the pointers to the removed nodes are gone
+    REQUIRE(CR->pointsTo.empty());
+    REQUIRE(L->pointsTo.empty());
+    REQUIRE(P->pointsTo.empty());
+
+    // build the function anew and re-run the analysis
+    // (starting from the results of the previous run)
+    auto *fun2 = createAllocFun(PS, C);
+    PSNode *A2 = fun2->root->getSingleSuccessor();
+    REQUIRE(fun2->getID() != main->getID());
+    CR->addPointsTo(M, 0);
+    PS.invalidatePointsTo(affected);
+    REQUIRE(CR->pointsTo.empty());
+    PS.clearNodesData();
+
+    PTStoT PA(&PS);
+    PA.run();
+    REQUIRE(CR->doesPointsTo(A2));
+    REQUIRE(L->doesPointsTo(A2));
+    REQUIRE(P->doesPointsTo(A2));
+    REQUIRE(CR->pointsTo.size() == 1);
+    REQUIRE(L->pointsTo.size() == 1);
+    REQUIRE(P->pointsTo.size() == 1);
+}
+
+TEST_CASE("Removing subgraphs", "incremental") {
+    remove_subgraph<PointerAnalysisFI>();
+    remove_subgraph<PointerAnalysisFS>();
+}
+
+// build the function called via a pointer when the call is resolved
+template <typename PTStoT>
+class BuildCalledFun : public PTStoT {
+  public:
+    PSNode *calledAlloc{nullptr};
+
+    BuildCalledFun(PointerGraph *PS)
+            : PTStoT(PS, sccOrderedWorklist().setStatistics(true)) {}
+
+    bool functionPointerCall(PSNode *where, PSNode *what) override {
+        auto *subg = createAllocFun(*this->getPG(), where);
+        calledAlloc = subg->root->getSingleSuccessor();
+        PTStoT::functionPointerCall(where, what);
+        return true;
+    }
+};
+
+template <typename PTStoT>
+void worklist_funptr_call() {
+    PointerGraph PS;
+    PSNode *E = PS.create<PSNodeType::ENTRY>();
+    PSNode *F = PS.create<PSNodeType::FUNCTION>();
+    PSNode *M = PS.create<PSNodeType::ALLOC>();
+    PSNode *C = PS.create<PSNodeType::CALL_FUNCPTR>(F);
+    PSNode *CR = PS.create<PSNodeType::CALL_RETURN>();
+    C->setPairedNode(CR);
+    CR->setPairedNode(C);
+    PSNode *S = PS.create<PSNodeType::STORE>(CR, M);
+    PSNode *L = PS.create<PSNodeType::LOAD>(M);
+
+    E->addSuccessor(F);
+    F->addSuccessor(M);
+    M->addSuccessor(C);
+    C->addSuccessor(CR);
+    CR->addSuccessor(S);
+    S->addSuccessor(L);
+
+    auto *main = PS.createSubgraph(E);
+    PS.setEntry(main);
+    for (PSNode *nd : {E, F, M, C, CR, S, L})
+        nd->setParent(main);
+
+    BuildCalledFun<PTStoT> PA(&PS);
+    PA.run();
+    REQUIRE(PA.calledAlloc);
+    REQUIRE(CR->doesPointsTo(PA.calledAlloc));
+    REQUIRE(L->doesPointsTo(PA.calledAlloc));
+    // the called function is processed between the call and the call
+    // return, so its results reach the call return in the same pass
+    REQUIRE(PA.getStatistics()->iterations == 1);
+}
+
+TEST_CASE("SCC-ordered worklist with calls via pointers", "worklist") {
+    worklist_funptr_call<PointerAnalysisFI>();
+    worklist_funptr_call<PointerAnalysisFS>();
+}
+
+// a GEP to the 8th byte of an allocation, solved
+static PSNode *solvedGep(PointerGraph &PS, PSNode *&A) {
+    A = PS.create<PSNodeType::ALLOC>();
+    A->setSize(16);
+    PSNode *B = PS.create<PSNodeType::ALLOC>();
+    PSNode *G = PS.create<PSNodeType::GEP>(A, 8);
+    A->addSuccessor(B);
+    B->addSuccessor(G);
+
+    auto *subg = PS.createSubgraph(A);
+    PS.setEntry(subg);
+    PointerAnalysisFI PA(&PS);
+    PA.run();
+    return G;
+}
+
+TEST_CASE("Querying a graph after building another", "pointer-ids") {
+    PointerGraph PS1;
+    PSNode *A1;
+    PSNode *G1 = solvedGep(PS1, A1);
+    REQUIRE(G1->pointsTo.size() == 1);
+    REQUIRE(*G1->pointsTo.begin() == Pointer(A1, 8));
+
+    {
+        PointerGraph PS2;
+        PSNode *A2;
+        PSNode *G2 = solvedGep(PS2, A2);
+        // the queries of the first graph use the table of the first graph
+        REQUIRE(G1->doesPointsTo(A1, 8));
+        REQUIRE(*G1->pointsTo.begin() == Pointer(A1, 8));
+        REQUIRE(*G2->pointsTo.begin() == Pointer(A2, 8));
+        REQUIRE(!G1->pointsTo.pointsToTarget(A2));
+    }
+
+    // and also after the other graph is destroyed
+    REQUIRE(G1->pointsTo.size() == 1);
+    REQUIRE(G1->doesPointsTo(A1, 8));
+    REQUIRE(*G1->pointsTo.begin() == Pointer(A1, 8));
+}
+
+TEST_CASE("Adopting nodes built apart from the graph", "pointer-ids") {
+    PointerGraph PS;
+    PSNode *A = PS.create<PSNodeType::ALLOC>();
+    PSNode *B = PS.create<PSNodeType::ALLOC>();
+
+    PointerNodesPool pool;
+    PSNode *C, *S, *L;
+    // build the nodes in another thread as the builder does
+    std::thread builder([&]() {
+        PointerNodesPool::Scope scope(pool);
+        C = pool.create<PSNodeType::CONSTANT>(A, 4);
+        S = pool.create<PSNodeType::STORE>(C, B);
+        L = pool.create<PSNodeType::LOAD>(B);
+    });
+    builder.join();
+
+    REQUIRE(pool.size() == 3);
+    REQUIRE(C->getID() == 1);
+    REQUIRE(L->getID() == 3);
+    // the nodes of the graph are not touched before adopting the nodes
+    REQUIRE(A->getUsers().empty());
+    REQUIRE(B->getUsers().empty());
+
+    PS.adopt(pool);
+    REQUIRE(pool.empty());
+    REQUIRE(C->getID() == B->getID() + 1);
+    REQUIRE(S->getID() == B->getID() + 2);
+    REQUIRE(L->getID() == B->getID() + 3);
+    REQUIRE(PS.getNodes()[L->getID()].get() == L);
+    REQUIRE(A->getUsers().size() == 1);
+    REQUIRE(B->getUsers().size() == 2);
+    REQUIRE(C->getUsers().size() == 1);
+    // the points-to set uses the table of the graph now
+    REQUIRE(C->pointsTo.size() == 1);
+    REQUIRE(*C->pointsTo.begin() == Pointer(A, 4));
+    REQUIRE(PS.getPointerIDs().get(Pointer(A, 4)) != 0);
+
+    A->addSuccessor(B);
+    B->addSuccessor(C);
+    C->addSuccessor(S);
+    S->addSuccessor(L);
+    PS.setEntry(PS.createSubgraph(A));
+    PointerAnalysisFI PA(&PS);
+    PA.run();
+    REQUIRE(L->doesPointsTo(A, 4));
+}
+
+// answer the queries for all nodes (in the reverse order,
+// so that the nodes are queried before their operands)
+class DemandAll : public PointerAnalysisDemand {
+  public:
+    DemandAll(PointerGraph *PS) : PointerAnalysisDemand(PS) {}
+    DemandAll(PointerGraph *PS, const dg::PointerAnalysisOptions &opts)
+            : PointerAnalysisDemand(PS, opts) {}
+
+    bool run() override {
+        PointerAnalysisDemand::run();
+        const auto &nodes = getPG()->getNodes();
+        for (auto it = nodes.rbegin(), et = nodes.rend(); it != et; ++it) {
+            if (*it)
+                query(it->get());
+        }
+        REQUIRE(!isExhaustive());
+        return true;
+    }
+};
+
+TEST_CASE("Demand-driven", "demand") {
+    all_tests<DemandAll>();
+
+    dg::PointerAnalysisOptions opts;
+    REQUIRE(loop_results<dg::pta::PointerAnalysisFI>(opts) ==
+            loop_results<DemandAll>(opts));
+    REQUIRE(copy_cycle_results<dg::pta::PointerAnalysisFI>(opts) ==
+            copy_cycle_results<DemandAll>(opts));
+}
+
+TEST_CASE("Demand-driven queries", "demand") {
+    PointerGraph PS;
+    PSNode *A = PS.create<PSNodeType::ALLOC>();
+    PSNode *B = PS.create<PSNodeType::ALLOC>();
+    PSNode *C = PS.create<PSNodeType::ALLOC>();
+    PSNode *P = PS.create<PSNodeType::ALLOC>();
+    PSNode *D = PS.create<PSNodeType::ALLOC>();
+    PSNode *E = PS.create<PSNodeType::ALLOC>();
+    // B = A; P = &B; *P = C; (the address of B escapes to P)
+    PSNode *S1 = PS.create<PSNodeType::STORE>(A, B);
+    PSNode *S2 = PS.create<PSNodeType::STORE>(B, P);
+    PSNode *LP = PS.create<PSNodeType::LOAD>(P);
+    PSNode *S3 = PS.create<PSNodeType::STORE>(C, LP);
+    PSNode *LB = PS.create<PSNodeType::LOAD>(B);
+    // E = D (unrelated to B)
+    PSNode *S4 = PS.create<PSNodeType::STORE>(D, E);
+    PSNode *LE = PS.create<PSNodeType::LOAD>(E);
+
+    PSNode *nodes[] = {A, B, C, P, D, E, S1, S2, LP, S3, LB, S4, LE};
+    for (size_t i = 1; i < sizeof(nodes) / sizeof(*nodes); ++i)
+        nodes[i - 1]->addSuccessor(nodes[i]);
+
+    auto *subg = PS.createSubgraph(A);
+    PS.setEntry(subg);
+
+    SECTION("Only the relevant nodes are processed") {
+        PointerAnalysisDemand PA(&PS);
+        PA.run();
+        REQUIRE(PA.query(LB));
+        REQUIRE(LB->pointsTo.size() == 2);
+        REQUIRE(LB->doesPointsTo(A));
+        REQUIRE(LB->doesPointsTo(C));
+        // the writes to E are not needed (S4, LE and D are not processed,
+        // E is processed as the destination of a store as B escapes)
+        REQUIRE(LE->pointsTo.empty());
+        REQUIRE(PA.getSliceSize() == 10);
+
+        // the next query continues from the previous one
+        REQUIRE(PA.query(LE));
+        REQUIRE(LE->pointsTo.size() == 1);
+        REQUIRE(LE->doesPointsTo(D));
+    }
+
+    SECTION("Exceeding the budget solves the whole graph") {
+        PointerAnalysisDemand PA(&PS,
+                                 dg::PointerAnalysisOptions().setDemandBudget(2));
+        PA.run();
+        REQUIRE(!PA.query(LB));
+        REQUIRE(PA.isExhaustive());
+        REQUIRE(LB->pointsTo.size() == 2);
+        REQUIRE(LB->doesPointsTo(A));
+        REQUIRE(LB->doesPointsTo(C));
+        REQUIRE(LE->doesPointsTo(D));
+    }
+}
+
+template <typename PTStoT>
+void statistics_test() {
+    PointerGraph PS;
+    PSNode *A = PS.create<PSNodeType::ALLOC>();
+    PSNode *B = PS.create<PSNodeType::ALLOC>();
+    PSNode *S = PS.create<PSNodeType::STORE>(A, B);
+    PSNode *L = PS.create<PSNodeType::LOAD>(B);
+
+    A->addSuccessor(B);
+    B->addSuccessor(S);
+    S->addSuccessor(L);
+
+    auto *subg = PS.createSubgraph(A);
+    PS.setEntry(subg);
+
+    PTStoT PA(&PS, dg::PointerAnalysisOptions().setStatistics(true));
+    PA.run();
+
+    REQUIRE(L->doesPointsTo(A));
+
+    const auto *stats = PA.getStatistics();
+    REQUIRE(stats);
+    REQUIRE(stats->iterations > 0);
+    REQUIRE(stats->worklistSizes.size() >= stats->iterations);
+
+    const auto &store = stats->nodeTypes[static_cast<size_t>(
+            PSNodeType::STORE)];
+    const auto &load =
+            stats->nodeTypes[static_cast<size_t>(PSNodeType::LOAD)];
+    REQUIRE(store.visits > 0);
+    REQUIRE(store.changes > 0);
+    REQUIRE(load.visits > 0);
+    REQUIRE(load.changes > 0);
+    REQUIRE(stats->functionPointerCalls == 0);
+
+    // A and B point to themselves, L points to A, S to nothing
+    size_t nodes = 0;
+    for (auto n : stats->pointsToSizes)
+        nodes += n;
+    REQUIRE(nodes == 4);
+    REQUIRE(stats->maxPointsToSize == 1);
+
+    // the memory object of B with the offset 0
+    REQUIRE(stats->memoryObjects == 1);
+    REQUIRE(stats->memoryObjectsOffsets == 1);
+    REQUIRE(stats->peakPointsToMemory > 0);
+
+    std::ostringstream ss;
+    stats->dumpJSON(ss);
+    REQUIRE(ss.str().find("\"STORE\": {\"visits\": ") != std::string::npos);
+    REQUIRE(ss.str().find("\"memory_objects\": 1") != std::string::npos);
+}
+
+TEST_CASE("Statistics", "statistics") {
+    statistics_test<PointerAnalysisFI>();
+    statistics_test<PointerAnalysisFS>();
+
+    SECTION("Statistics are not gathered by default") {
+        PointerGraph PS;
+        PSNode *A = PS.create<PSNodeType::ALLOC>();
+        PS.setEntry(PS.createSubgraph(A));
+        PointerAnalysisFI PA(&PS);
+        PA.run();
+        REQUIRE(PA.getStatistics() == nullptr);
+    }
+}
+
+template <typename PTStoT>
+void budget_test() {
+    // the load is processed before the store,
+    // so the analysis needs more iterations
+    PointerGraph PS;
+    PSNode *A = PS.create<PSNodeType::ALLOC>();
+    PSNode *B = PS.create<PSNodeType::ALLOC>();
+    PSNode *C = PS.create<PSNodeType::ALLOC>();
+    PSNode *G = PS.create<PSNodeType::GEP>(B, 8);
+    PSNode *L = PS.create<PSNodeType::LOAD>(G);
+    PSNode *S = PS.create<PSNodeType::STORE>(A, G);
+    PSNode *S2 = PS.create<PSNodeType::STORE>(C, B);
+    PSNode *L2 = PS.create<PSNodeType::LOAD>(B);
+
+    A->addSuccessor(B);
+    B->addSuccessor(C);
+    C->addSuccessor(G);
+    G->addSuccessor(L);
+    L->addSuccessor(S);
+    S->addSuccessor(S2);
+    S2->addSuccessor(L2);
+    S2->addSuccessor(G);
+
+    auto *subg = PS.createSubgraph(A);
+    PS.setEntry(subg);
+
+    SECTION("Enough budget") {
+        PTStoT PA(&PS, dg::PointerAnalysisOptions()
+                               .setTimeBudget(1000000)
+                               .setMemoryBudget(~static_cast<size_t>(0)));
+        REQUIRE(PA.run());
+        REQUIRE(PA.getPrecision() == PointerAnalysis::Precision::FULL);
+        REQUIRE(L->doesPointsTo(A));
+        REQUIRE(!L->pointsTo.hasUnknown());
+        REQUIRE(L2->doesPointsTo(C));
+        REQUIRE(!L2->pointsTo.hasUnknown());
+    }
+
+    SECTION("Exceeded memory budget") {
+        PTStoT PA(&PS, dg::PointerAnalysisOptions().setMemoryBudget(1));
+        // the analysis has been stopped
+        REQUIRE(!PA.run());
+        REQUIRE(PA.getPrecision() ==
+                PointerAnalysis::Precision::UNKNOWN_MEMORY);
+        // the results are coarser, but sound
+        REQUIRE(L->pointsTo.hasUnknown());
+        REQUIRE(L2->pointsTo.hasUnknown());
+        REQUIRE(G->pointsTo.hasUnknown());
+        REQUIRE(A->pointsTo.size() == 1);
+        REQUIRE(A->doesPointsTo(A, 0));
+    }
+
+    SECTION("Exceeded the number of iterations") {
+        dg::PointerAnalysisOptions opts;
+        opts.maxIterations = 1;
+        PTStoT PA(&PS, opts);
+        REQUIRE(!PA.run());
+        REQUIRE(PA.getPrecision() ==
+                PointerAnalysis::Precision::UNKNOWN_MEMORY);
+        REQUIRE(L->pointsTo.hasUnknown());
+        REQUIRE(L2->pointsTo.hasUnknown());
+    }
+}
+
+TEST_CASE("Budget", "budget") {
+    SECTION("Flow-insensitive") { budget_test<PointerAnalysisFI>(); }
+    SECTION("Flow-sensitive") { budget_test<PointerAnalysisFS>(); }
+}
+
+TEST_CASE("Budget coarser abstractions", "budget") {
+    // the store writes at offset 8, the load reads offset 0
+    PointerGraph PS;
+    PSNode *A = PS.create<PSNodeType::ALLOC>();
+    PSNode *B = PS.create<PSNodeType::ALLOC>();
+    PSNode *G = PS.create<PSNodeType::GEP>(B, 8);
+    PSNode *S = PS.create<PSNodeType::STORE>(A, G);
+    PSNode *L = PS.create<PSNodeType::LOAD>(B);
+    A->addSuccessor(B);
+    B->addSuccessor(G);
+    G->addSuccessor(S);
+    S->addSuccessor(L);
+    PS.setEntry(PS.createSubgraph(A));
+
+    PointerAnalysisFI PA(&PS, dg::PointerAnalysisOptions().setMemoryBudget(1));
+    const bool finished = PA.run();
+    REQUIRE(PA.getPrecision() != PointerAnalysis::Precision::FULL);
+    REQUIRE(finished ==
+            (PA.getPrecision() != PointerAnalysis::Precision::UNKNOWN_MEMORY));
+    // field-insensitive results
+    REQUIRE(G->doesPointsTo(B, Offset::UNKNOWN));
+    REQUIRE((L->doesPointsTo(A) || L->doesPointsTo(A, Offset::UNKNOWN) ||
+             L->pointsTo.hasUnknown()));
+}
+
+TEST_CASE("Budget with worklist", "budget") {
+    SECTION("Flow-insensitive") {
+        PointerGraph PS;
+        PSNode *A = PS.create<PSNodeType::ALLOC>();
+        PSNode *B = PS.create<PSNodeType::ALLOC>();
+        PSNode *L = PS.create<PSNodeType::LOAD>(B);
+        PSNode *S = PS.create<PSNodeType::STORE>(A, B);
+        A->addSuccessor(B);
+        B->addSuccessor(L);
+        L->addSuccessor(S);
+        S->addSuccessor(L);
+        PS.setEntry(PS.createSubgraph(A));
+
+        PointerAnalysisFI PA(&PS, dg::PointerAnalysisOptions()
+                                          .setSCCOrderedWorklist(true)
+                                          .setMemoryBudget(1));
+        REQUIRE(!PA.run());
+        REQUIRE(PA.getPrecision() ==
+                PointerAnalysis::Precision::UNKNOWN_MEMORY);
+        REQUIRE(L->pointsTo.hasUnknown());
+    }
+}
+
+TEST_CASE("Updating loops after inserting a call", "loops") {
+    PointerGraph PS;
+    // R -> C -> CR -> N -> C (a loop through a call)
+    PSNode *R = PS.create<PSNodeType::NOOP>();
+    PSNode *C = PS.create<PSNodeType::CALL_FUNCPTR>(R);
+    PSNode *CR = PS.create<PSNodeType::CALL_RETURN>();
+    PSNode *N = PS.create<PSNodeType::NOOP>();
+    C->setPairedNode(CR);
+    CR->setPairedNode(C);
+    R->addSuccessor(C);
+    C->addSuccessor(CR);
+    CR->addSuccessor(N);
+    N->addSuccessor(C);
+
+    auto *caller = PS.createSubgraph(R);
+    PS.setEntry(caller);
+    for (auto *nd : {R, C, CR, N})
+        nd->setParent(caller);
+
+    PS.computeLoops();
+    REQUIRE(caller->getLoop(R) == nullptr);
+    REQUIRE(caller->getLoop(C) != nullptr);
+    REQUIRE(caller->getLoop(C)->size() == 3);
+
+    // a function that is already in the graph, but is not called yet
+    PSNode *G = PS.create<PSNodeType::NOOP>();
+    auto *other = PS.createSubgraph(G);
+    G->setParent(other);
+
+    // resolve the call: call the function F and insert a node
+    // between the call and the call return in the caller
+    PSNode *F = PS.create<PSNodeType::NOOP>();
+    PSNode *FL = PS.create<PSNodeType::NOOP>();
+    F->addSuccessor(FL);
+    FL->addSuccessor(F);
+    auto *callee = PS.createSubgraph(F);
+    F->setParent(callee);
+    FL->setParent(callee);
+    PSNodeCall::cast(C)->addCallee(callee);
+
+    PSNode *X = PS.create<PSNodeType::NOOP>();
+    X->setParent(caller);
+    C->removeSingleSuccessor();
+    C->addSuccessor(X);
+    X->addSuccessor(CR);
+
+    PS.updateLoops(C);
+
+    // the call still steps over to its call return
+    REQUIRE(caller->getLoop(C) != nullptr);
+    REQUIRE(caller->getLoop(X) == caller->getLoop(C));
+    REQUIRE(caller->getLoop(C)->size() == 4);
+    REQUIRE(callee->computedLoops());
+    REQUIRE(callee->getLoop(F) != nullptr);
+    // the other subgraphs are not touched
+    REQUIRE(!other->computedLoops());
+}
+
+TEST_CASE("Unification-based", "steensgaard") {
+    // the other tests check that the pointers are not in
+    // the points-to sets, but the classes are field-insensitive
+    store_load<PointerAnalysisSteensgaard>();
+    store_load2<PointerAnalysisSteensgaard>();
+    store_load3<PointerAnalysisSteensgaard>();
+    store_load4<PointerAnalysisSteensgaard>();
+    store_load5<PointerAnalysisSteensgaard>();
+    gep1<PointerAnalysisSteensgaard>();
+    gep2<PointerAnalysisSteensgaard>();
+    gep3<PointerAnalysisSteensgaard>();
+    gep4<PointerAnalysisSteensgaard>();
+    gep5<PointerAnalysisSteensgaard>();
+    nulltest<PointerAnalysisSteensgaard>();
+    constant_store<PointerAnalysisSteensgaard>();
+    load_from_zeroed<PointerAnalysisSteensgaard>();
+    load_from_unknown_offset<PointerAnalysisSteensgaard>();
+    load_from_unknown_offset2<PointerAnalysisSteensgaard>();
+    load_from_unknown_offset3<PointerAnalysisSteensgaard>();
+    memcpy_test<PointerAnalysisSteensgaard>();
+    memcpy_test4<PointerAnalysisSteensgaard>();
+    memcpy_test6<PointerAnalysisSteensgaard>();
+    memcpy_test7<PointerAnalysisSteensgaard>();
+    memcpy_test8<PointerAnalysisSteensgaard>();
+}
+
+TEST_CASE("Unification-based is a superset", "steensgaard") {
+    dg::PointerAnalysisOptions opts;
+    auto fi = loop_results<dg::pta::PointerAnalysisFI>(opts);
+    auto unif = loop_results<PointerAnalysisSteensgaard>(opts);
+    REQUIRE(fi.size() == unif.size());
+    for (size_t i = 0; i < fi.size(); ++i) {
+        for (const auto &ptr : fi[i]) {
+            REQUIRE((unif[i].count(ptr) > 0 ||
+                     unif[i].count({ptr.first, Offset::UNKNOWN}) > 0));
+        }
+    }
+}
+
+TEST_CASE("Unification-based merges classes", "steensgaard") {
+    PointerGraph PS;
+    PSNode *A = PS.create<PSNodeType::ALLOC>();
+    PSNode *B = PS.create<PSNodeType::ALLOC>();
+    PSNode *C = PS.create<PSNodeType::ALLOC>();
+    PSNode *PHI = PS.create<PSNodeType::PHI>(A, B);
+    PSNode *CAST = PS.create<PSNodeType::CAST>(A);
+    PSNode *CAST2 = PS.create<PSNodeType::CAST>(C);
+
+    A->addSuccessor(B);
+    B->addSuccessor(C);
+    C->addSuccessor(PHI);
+    PHI->addSuccessor(CAST);
+    CAST->addSuccessor(CAST2);
+
+    auto *subg = PS.createSubgraph(A);
+    PS.setEntry(subg);
+    PointerAnalysisSteensgaard PA(&PS);
+    PA.run();
+
+    // A and B are in the same class because of the PHI node
+    REQUIRE(CAST->doesPointsTo(A, 0));
+    REQUIRE(CAST->doesPointsTo(B, 0));
+    REQUIRE(CAST->pointsTo.size() == 2);
+    REQUIRE(CAST2->pointsTo.size() == 1);
+    REQUIRE(CAST2->doesPointsTo(C, 0));
+    REQUIRE(PA.pointToSameClass(PHI, CAST));
+    REQUIRE(!PA.pointToSameClass(PHI, CAST2));
+}
+
+TEST_CASE("Unification-based field sensitivity", "steensgaard") {
+    PointerGraph PS;
+    PSNode *A = PS.create<PSNodeType::ALLOC>();
+    A->setSize(32);
+    PSNode *G1 = PS.create<PSNodeType::GEP>(A, 4);
+    PSNode *G2 = PS.create<PSNodeType::GEP>(A, 16);
+
+    A->addSuccessor(G1);
+    G1->addSuccessor(G2);
+
+    auto *subg = PS.createSubgraph(A);
+    PS.setEntry(subg);
+    dg::PointerAnalysisOptions opts;
+    opts.setFieldSensitivity(8);
+    PointerAnalysisSteensgaard PA(&PS, opts);
+    PA.run();
+
+    REQUIRE(G1->doesPointsTo(A, 4));
+    REQUIRE(G2->doesPointsTo(A, Offset::UNKNOWN));
+}
+
+TEST_CASE("Unification pre-pass", "steensgaard") {
+    dg::PointerAnalysisOptions opts;
+    dg::PointerAnalysisOptions unifopts;
+    unifopts.setUnificationPrepass(true);
+
+    REQUIRE(loop_results<dg::pta::PointerAnalysisFI>(opts) ==
+            loop_results<dg::pta::PointerAnalysisFI>(unifopts));
+    REQUIRE(loop_results<dg::pta::PointerAnalysisFS>(opts) ==
+            loop_results<dg::pta::PointerAnalysisFS>(unifopts));
+    REQUIRE(copy_cycle_results<dg::pta::PointerAnalysisFI>(opts) ==
+            copy_cycle_results<dg::pta::PointerAnalysisFI>(unifopts));
+
+    unifopts.setCollapseCycles(true);
+    REQUIRE(loop_results<dg::pta::PointerAnalysisFI>(opts) ==
+            loop_results<dg::pta::PointerAnalysisFI>(unifopts));
+    REQUIRE(copy_cycle_results<dg::pta::PointerAnalysisFI>(opts) ==
+            copy_cycle_results<dg::pta::PointerAnalysisFI>(unifopts));
+    REQUIRE(copy_cycle_results<dg::pta::PointerAnalysisFS>(opts) ==
+            copy_cycle_results<dg::pta::PointerAnalysisFS>(unifopts));
+
+    unifopts.setSCCOrderedWorklist(true);
+    REQUIRE(loop_results<dg::pta::PointerAnalysisFS>(opts) ==
+            loop_results<dg::pta::PointerAnalysisFS>(unifopts));
+}
+
+TEST_CASE("Alias queries", "alias") {
+    PointerGraph PS;
+    PSNode *A = PS.create<PSNodeType::ALLOC>();
+    A->setSize(16);
+    PSNode *B = PS.create<PSNodeType::ALLOC>();
+    PSNode *G4 = PS.create<PSNodeType::GEP>(A, 4);
+    PSNode *G8 = PS.create<PSNodeType::GEP>(A, 8);
+    PSNode *GU = PS.create<PSNodeType::GEP>(A, Offset::UNKNOWN);
+    PSNode *L = PS.create<PSNodeType::LOAD>(B);
+
+    A->addSuccessor(B);
+    B->addSuccessor(G4);
+    G4->addSuccessor(G8);
+    G8->addSuccessor(GU);
+    GU->addSuccessor(L);
+
+    auto *subg = PS.createSubgraph(A);
+    PS.setEntry(subg);
+    dg::pta::PointerAnalysisFI PA(&PS);
+    PA.run();
+
+    dg::pta::AliasCache cache(2);
+    REQUIRE(!cache.alias(A, 4, B, 4));
+    REQUIRE(cache.alias(A, 4, A, 4));
+    // the accesses [4, 8) and [8, 12) do not overlap
+    REQUIRE(!cache.alias(G4, 4, G8, 4));
+    REQUIRE(cache.alias(G4, 8, G8, 4));
+    REQUIRE(cache.alias(G4, Offset::UNKNOWN, G8, 4));
+    REQUIRE(cache.alias(A, 4, GU, 1));
+    // nothing was stored to B, the load may point anywhere
+    REQUIRE(cache.alias(L, 1, B, 1));
+
+    // the queries are symmetric and only the last two answers are kept
+    REQUIRE(cache.size() == 2);
+    const auto misses = cache.getMisses();
+    REQUIRE(cache.alias(B, 1, L, 1));
+    REQUIRE(cache.alias(GU, 1, A, 4));
+    REQUIRE(cache.getMisses() == misses);
+    REQUIRE(!cache.alias(G8, 4, G4, 4));
+    REQUIRE(cache.getMisses() == misses + 1);
+    // only the targets of nodes in the cached answers are kept
+    // (G4 and G8 from the last answer, GU and A from the other one)
+    REQUIRE(cache.getTargetsNum() == 4);
+
+    cache.clear();
+    REQUIRE(cache.size() == 0);
+    REQUIRE(!cache.alias(A, 4, B, 4));
+
+    dg::pta::AliasCache nocache(0);
+    REQUIRE(!nocache.alias(G4, 4, G8, 4));
+    REQUIRE(nocache.size() == 0);
+    REQUIRE(nocache.getTargetsNum() == 0);
+}
@@ -0,0 +1,355 @@
+// Replay a trace of operations on points-to sets (recorded by
+// llvm-pta-dump -record-ptset-trace) against the implementations
+// of points-to sets and report the time, the peak memory
+// and the sizes of the sets.
+//
+// Usage: ptset-replay TRACE [IMPLEMENTATION ...]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <string>
+#include <vector>
+
+#include "../tools/include/dg/tools/TimeMeasure.h"
+#include "dg/PointerAnalysis/PointerGraph.h"
+#include "dg/PointerAnalysis/PointsToSet.h"
+#include "dg/PointerAnalysis/PointsToSetTrace.h"
+
+using namespace dg;
+using namespace dg::pta;
+
+// The bytes allocated by operator new. The size of the memory
+// is stored before the memory, so that delete knows it.
+static const size_t HEADER = alignof(std::max_align_t);
+static size_t allocated = 0;
+static size_t peak = 0;
+
+static void *allocate(size_t size) {
+    auto *mem = static_cast<char *>(std::malloc(size + HEADER));
+    if (!mem)
+        return nullptr;
+    *reinterpret_cast<size_t *>(mem) = size;
+    allocated += size;
+    if (allocated > peak)
+        peak = allocated;
+    return mem + HEADER;
+}
+
+void *operator new(size_t size) {
+    void *mem = allocate(size);
+    if (!mem) {
+        std::cerr << "Out of memory\n";
+        std::abort();
+    }
+    return mem;
+}
+
+void operator delete(void *ptr) noexcept {
+    if (!ptr)
+        return;
+    char *mem = static_cast<char *>(ptr) - HEADER;
+    allocated -= *reinterpret_cast<size_t *>(mem);
+    std::free(mem);
+}
+
+void *operator new[](size_t size) { return operator new(size); }
+void operator delete[](void *ptr) noexcept { operator delete(ptr); }
+void operator delete(void *ptr, size_t /*unused*/) noexcept {
+    operator delete(ptr);
+}
+void operator delete[](void *ptr, size_t /*unused*/) noexcept {
+    operator delete(ptr);
+}
+
+void *operator new(size_t size, const std::nothrow_t & /*unused*/) noexcept {
+    return allocate(size);
+}
+
+void *operator new[](size_t size, const std::nothrow_t & /*unused*/) noexcept {
+    return allocate(size);
+}
+
+using Record = PointsToSetTraceReader::Record;
+
+struct Trace {
+    std::vector<Record> records;
+    uint64_t sets{0};
+    uint64_t targets{0};
+    size_t ops[static_cast<size_t>(PointsToSetOp::LAST) + 1]{};
+
+    bool load(const std::string &path) {
+        PointsToSetTraceReader reader;
+        if (!reader.open(path)) {
+            std::cerr << "Cannot open the trace '" << path << "'\n";
+            return false;
+        }
+
+        // check that the records use only the sets that exist
+        std::vector<bool> alive(1);
+        auto isAlive = [&alive](uint64_t set) {
+            return set < alive.size() && alive[set];
+        };
+
+        Record rec;
+        while (reader.next(rec)) {
+            bool ok = true;
+            switch (rec.op) {
+            case PointsToSetOp::CREATE:
+            case PointsToSetOp::COPY:
+            case PointsToSetOp::MOVE:
+                ok = !isAlive(rec.set) &&
+                     (rec.op == PointsToSetOp::CREATE || isAlive(rec.arg));
+                if (rec.set >= alive.size())
+                    alive.resize(rec.set + 1);
+                alive[rec.set] = true;
+                sets = std::max(sets, rec.set);
+                break;
+            case PointsToSetOp::DESTROY:
+                ok = isAlive(rec.set);
+                if (ok)
+                    alive[rec.set] = false;
+                break;
+            case PointsToSetOp::ASSIGN:
+            case PointsToSetOp::MOVE_ASSIGN:
+            case PointsToSetOp::SWAP:
+            case PointsToSetOp::ADD_SET:
+                ok = isAlive(rec.set) && isAlive(rec.arg);
+                break;
+            case PointsToSetOp::ADD:
+            case PointsToSetOp::REMOVE:
+            case PointsToSetOp::REMOVE_ANY:
+            case PointsToSetOp::POINTS_TO:
+                ok = isAlive(rec.set) && rec.arg > 0;
+                targets = std::max(targets, rec.arg);
+                break;
+            case PointsToSetOp::CLEAR:
+            case PointsToSetOp::ITERATE:
+                ok = isAlive(rec.set);
+                break;
+            }
+
+            if (!ok) {
+                std::cerr << "Invalid record " << records.size()
+                          << " in the trace\n";
+                return false;
+            }
+            ++ops[static_cast<size_t>(rec.op)];
+            records.push_back(rec);
+        }
+
+        if (reader.hasError()) {
+            std::cerr << "The trace '" << path << "' is malformed\n";
+            return false;
+        }
+        return true;
+    }
+};
+
+// histogram of sizes of sets, the buckets are 0, 1, 2-3, 4-7, ...
+struct SizeHistogram {
+    std::vector<size_t> buckets;
+
+    void add(size_t size) {
+        size_t bucket = 0;
+        while (size > 0) {
+            ++bucket;
+            size >>= 1;
+        }
+        if (bucket >= buckets.size())
+            buckets.resize(bucket + 1);
+        ++buckets[bucket];
+    }
+
+    void dump(const char *title) const {
+        std::cout << title << "\n";
+        for (size_t i = 0; i < buckets.size(); ++i) {
+            std::string range = i == 0 ? "0" : std::to_string(1UL << (i - 1));
+            if (i > 1)
+                range += "-" + std::to_string((1UL << i) - 1);
+            std::cout << "  " << std::setw(14) << range << ": " << buckets[i]
+                      << "\n";
+        }
+    }
+};
+
+struct Sizes {
+    // the sizes of sets when they are destroyed
+    // (or at the end of the trace)
+    SizeHistogram final;
+    SizeHistogram iterated;
+};
+
+// the result of queries, so that they are not optimized away
+static volatile size_t sink;
+
+template <typename PTSetT>
+static void replay(const Trace &trace, const std::vector<PSNode *> &nodes,
+                   Sizes *sizes) {
+    std::vector<std::unique_ptr<PTSetT>> sets(trace.sets + 1);
+    size_t result = 0;
+
+    for (const auto &rec : trace.records) {
+        auto &S = sets[rec.set];
+        switch (rec.op) {
+        case PointsToSetOp::CREATE:
+            S.reset(new PTSetT());
+            break;
+        case PointsToSetOp::DESTROY:
+            if (sizes)
+                sizes->final.add(S->size());
+            S.reset();
+            break;
+        case PointsToSetOp::COPY:
+            S.reset(new PTSetT(*sets[rec.arg]));
+            break;
+        case PointsToSetOp::MOVE:
+            S.reset(new PTSetT(std::move(*sets[rec.arg])));
+            break;
+        // some sets cannot be assigned, so the assigned set is created anew
+        case PointsToSetOp::ASSIGN:
+            if (rec.arg != rec.set)
+                S.reset(new PTSetT(*sets[rec.arg]));
+            break;
+        case PointsToSetOp::MOVE_ASSIGN:
+            if (rec.arg != rec.set)
+                S.reset(new PTSetT(std::move(*sets[rec.arg])));
+            break;
+        case PointsToSetOp::SWAP:
+            S->swap(*sets[rec.arg]);
+            break;
+        case PointsToSetOp::CLEAR:
+            S->clear();
+            break;
+        case PointsToSetOp::ADD:
+            S->add(Pointer(nodes[rec.arg], rec.offset));
+            break;
+        case PointsToSetOp::ADD_SET:
+            S->add(*sets[rec.arg]);
+            break;
+        case PointsToSetOp::REMOVE:
+            S->remove(Pointer(nodes[rec.arg], rec.offset));
+            break;
+        case PointsToSetOp::REMOVE_ANY:
+            S->removeAny(nodes[rec.arg]);
+            break;
+        case PointsToSetOp::POINTS_TO:
+            result += S->pointsTo(Pointer(nodes[rec.arg], rec.offset));
+            break;
+        case PointsToSetOp::ITERATE:
+            if (sizes)
+                sizes->iterated.add(S->size());
+            for (const auto &ptr : *S)
+                result += *ptr.offset;
+            break;
+        }
+    }
+
+    if (sizes) {
+        for (const auto &S : sets) {
+            if (S)
+                sizes->final.add(S->size());
+        }
+    }
+    sink = result;
+}
+
+template <typename PTSetT>
+static void run(const Trace &trace, const char *name,
+                const std::vector<std::string> &only, Sizes *sizes = nullptr) {
+    if (!only.empty() &&
+        std::find(only.begin(), only.end(), name) == only.end())
+        return;
+
+    // every implementation gets a fresh graph
+    // (with a fresh table of pointer IDs)
+    PointerGraph PG;
+    PointerIDLookupTable::Scope scope(PG.getPointerIDs());
+
+    std::vector<PSNode *> nodes(trace.targets + 1);
+    for (uint64_t id = 1; id <= trace.targets; ++id) {
+        if (id == ID_UNKNOWN)
+            nodes[id] = UNKNOWN_MEMORY;
+        else if (id == ID_NULL)
+            nodes[id] = NULLPTR;
+        else if (id == ID_INVALIDATED)
+            nodes[id] = INVALIDATED;
+        else
+            nodes[id] = PG.create<PSNodeType::ALLOC>();
+    }
+
+    if (sizes) {
+        replay<PTSetT>(trace, nodes, sizes);
+        return;
+    }
+
+    const size_t before = allocated;
+    peak = allocated;
+
+    debug::TimeMeasure tm;
+    tm.start();
+    replay<PTSetT>(trace, nodes, nullptr);
+    tm.stop();
+
+    const double ms =
+            std::chrono::duration<double, std::milli>(tm.duration()).count();
+    std::cout << std::left << std::setw(32) << name << std::right
+              << std::setw(12) << std::fixed << std::setprecision(2) << ms
+              << std::setw(20)
+              << (peak - before) / 1024 << "\n";
+}
+
+int main(int argc, char *argv[]) {
+    if (argc < 2) {
+        std::cerr << "Usage: " << argv[0] << " TRACE [IMPLEMENTATION ...]\n";
+        return 1;
+    }
+
+    Trace trace;
+    if (!trace.load(argv[1]))
+        return 1;
+
+    static const char *opNames[] = {"",          "create",     "destroy",
+                                    "copy",      "move",       "assign",
+                                    "move-assign", "swap",     "clear",
+                                    "add",       "add-set",    "remove",
+                                    "remove-any", "points-to", "iterate"};
+    std::cout << "Trace: " << trace.records.size() << " operations on "
+              << trace.sets << " sets with " << trace.targets << " targets\n";
+    for (size_t i = 1; i <= static_cast<size_t>(PointsToSetOp::LAST); ++i) {
+        std::cout << "  " << std::setw(14) << opNames[i] << ": "
+                  << trace.ops[i] << "\n";
+    }
+
+    const std::vector<std::string> only(argv + 2, argv + argc);
+
+    std::cout << "\n"
+              << std::left << std::setw(32) << "Implementation" << std::right
+              << std::setw(12) << "Time [ms]" << std::setw(20)
+              << "Peak memory [kB]"
+              << "\n";
+    run<SimplePointsToSet>(trace, "SimplePointsToSet", only);
+    run<OffsetsSetPointsToSet>(trace, "OffsetsSetPointsToSet", only);
+    run<PointerIdPointsToSet>(trace, "PointerIdPointsToSet", only);
+    run<SharedPointerIdPointsToSet>(trace, "SharedPointerIdPointsToSet", only);
+    run<AlignedPointerIdPointsToSet>(trace, "AlignedPointerIdPointsToSet",
+                                     only);
+    run<SmallOffsetsPointsToSet>(trace, "SmallOffsetsPointsToSet", only);
+    run<AlignedSmallOffsetsPointsToSet>(
+            trace, "AlignedSmallOffsetsPointsToSet", only);
+    run<BddPointsToSet>(trace, "BddPointsToSet", only);
+    // SeparateOffsetsPointsToSet cannot remove pointers, so it is not here
+
+    // the sizes are taken from the exact representation
+    Sizes sizes;
+    run<SimplePointsToSet>(trace, "SimplePointsToSet", {}, &sizes);
+    std::cout << "\n";
+    sizes.final.dump("Sizes of sets (when destroyed or at the end):");
+    sizes.iterated.dump("Sizes of iterated sets:");
+
+    return 0;
+}
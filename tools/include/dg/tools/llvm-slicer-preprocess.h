@@ -1,6 +1,7 @@
 #ifndef LLVM_SLICER_PREPROCESS_H_
 #define LLVM_SLICER_PREPROCESS_H_
 
+#include <string>
 #include <vector>
 
 namespace llvm {
@@ -9,11 +10,15 @@ namespace llvm {
 }
 
 namespace dg {
+class LLVMPointerAnalysis;
+
 namespace llvmdg {
 
+// if 'pta' is given, it is used to resolve calls via pointers
 bool cutoffDivergingBranches(llvm::Module& M,
                              const std::string& entry,
-                             const std::vector<const llvm::Value *>& criteria);
+                             const std::vector<const llvm::Value *>& criteria,
+                             LLVMPointerAnalysis *pta = nullptr);
 } // namespace llvmdg
 } // namespace dg
 
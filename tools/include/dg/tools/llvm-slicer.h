@@ -3,6 +3,7 @@
 
 #include <ctime>
 #include <fstream>
+#include <sstream>
 
 #include <llvm/IR/Module.h>
 #include <llvm/Support/raw_os_ostream.h>
@@ -113,6 +114,28 @@ class Slicer {
         llvm::errs()
                 << "[llvm-slicer] CPU time of control dependence analysis: "
                 << double(stats.cdaTime) / CLOCKS_PER_SEC << " s\n";
+
+        dumpPTAStatistics();
+    }
+
+    // dump the statistics of the solver of pointer analysis
+    // (if gathered, i.e., with the 'statistics' option)
+    void dumpPTAStatistics() {
+        const auto &ptaopts = _options.dgOptions.PTAOptions;
+        if (!ptaopts.statistics || ptaopts.isSVF())
+            return;
+
+        auto *dgpta = static_cast<dg::DGLLVMPointerAnalysis *>(
+                _builder.getPTA());
+        if (!dgpta || !dgpta->getPTA())
+            return;
+
+        if (const auto *S = dgpta->getPTA()->getStatistics()) {
+            std::ostringstream ss;
+            S->dumpJSON(ss);
+            llvm::errs() << "[llvm-slicer] Pointer analysis statistics:\n"
+                         << ss.str();
+        }
     }
 
     // Mark the nodes from the slice.
@@ -512,6 +535,15 @@ class ModuleAnnotator {
         else if (options.dgOptions.PTAOptions.analysisType ==
                  LLVMPointerAnalysisOptions::AnalysisType::inv)
             module_comment += "flow-sensitive with invalidate\n";
+        else if (options.dgOptions.PTAOptions.analysisType ==
+                 LLVMPointerAnalysisOptions::AnalysisType::sfs)
+            module_comment += "staged flow-sensitive\n";
+        else if (options.dgOptions.PTAOptions.analysisType ==
+                 LLVMPointerAnalysisOptions::AnalysisType::demand)
+            module_comment += "demand-driven flow-insensitive\n";
+        else if (options.dgOptions.PTAOptions.analysisType ==
+                 LLVMPointerAnalysisOptions::AnalysisType::steensgaard)
+            module_comment += "unification-based\n";
 
         module_comment += ";   * PTA field sensitivity: ";
         if (options.dgOptions.PTAOptions.fieldSensitivity == Offset::UNKNOWN)
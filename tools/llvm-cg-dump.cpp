@@ -146,8 +146,10 @@ int main(int argc, char *argv[]) {
             DGLLVMPointerAnalysis PTA(M.get(), ptaopts);
             PTA.run();
 
-            if (lazy) {
-                llvmdg::CallGraph CG(M.get(), &PTA, lazy);
+            // with the results from a snapshot,
+            // the analysis has no call graph to re-use
+            if (lazy || PTA.isFromSnapshot()) {
+                llvmdg::CallGraph CG(M.get(), &PTA, true);
                 CG.build();
                 dumpCallGraph(CG);
             } else {
@@ -152,8 +152,18 @@ int main(int argc, char *argv[]) {
     } else if (strcmp(pts, "inv") == 0) {
         options.PTAOptions.analysisType =
                 LLVMPointerAnalysisOptions::AnalysisType::inv;
+    } else if (strcmp(pts, "sfs") == 0) {
+        options.PTAOptions.analysisType =
+                LLVMPointerAnalysisOptions::AnalysisType::sfs;
+    } else if (strcmp(pts, "demand") == 0) {
+        options.PTAOptions.analysisType =
+                LLVMPointerAnalysisOptions::AnalysisType::demand;
+    } else if (strcmp(pts, "steensgaard") == 0) {
+        options.PTAOptions.analysisType =
+                LLVMPointerAnalysisOptions::AnalysisType::steensgaard;
     } else {
-        llvm::errs() << "Unknown points to analysis, try: fs, fi, inv\n";
+        llvm::errs() << "Unknown points to analysis, try: fs, fi, inv, sfs, "
+                        "demand, steensgaard\n";
         abort();
     }
 
@@ -68,6 +68,11 @@ llvm::cl::opt<bool> fsinv(
                 "Run flow-sensitive PTA with invalidated memory analysis."),
         llvm::cl::init(false), llvm::cl::cat(SlicingOpts));
 
+llvm::cl::opt<bool> steensgaard(
+        "steensgaard",
+        llvm::cl::desc("Run unification-based (Steensgaard's) PTA."),
+        llvm::cl::init(false), llvm::cl::cat(SlicingOpts));
+
 #if HAVE_SVF
 llvm::cl::opt<bool> svf("svf", llvm::cl::desc("Run SVF PTA (Andersen)."),
                         llvm::cl::init(false), llvm::cl::cat(SlicingOpts));
@@ -263,6 +268,13 @@ int main(int argc, char *argv[]) {
                 "DG FSinv",
                 createAnalysis<DGLLVMPointerAnalysis>(M.get(), opts), 0);
     }
+    if (steensgaard) {
+        opts.analysisType =
+                dg::LLVMPointerAnalysisOptions::AnalysisType::steensgaard;
+        analyses.emplace_back(
+                "DG Steensgaard",
+                createAnalysis<DGLLVMPointerAnalysis>(M.get(), opts), 0);
+    }
 #ifdef HAVE_SVF
     if (svf) {
         opts.analysisType = dg::LLVMPointerAnalysisOptions::AnalysisType::svf;
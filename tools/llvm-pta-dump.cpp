@@ -31,6 +31,7 @@
 #endif
 
 #include "dg/PointerAnalysis/Pointer.h"
+#include "dg/PointerAnalysis/PointsToSetTrace.h"
 #include "dg/llvm/PointerAnalysis/PointerAnalysis.h"
 
 #include "dg/tools/TimeMeasure.h"
@@ -124,6 +125,13 @@ llvm::cl::opt<bool> dump_c_lines(
                        "Requires metadata in the bitcode (default=false)."),
         llvm::cl::init(false), llvm::cl::cat(SlicingOpts));
 
+llvm::cl::opt<std::string> record_trace(
+        "record-ptset-trace",
+        llvm::cl::desc("Record the operations on points-to sets into the "
+                       "given file (for ptset-replay). Requires dg built "
+                       "with RECORD_POINTS_TO_SETS=ON."),
+        llvm::cl::init(""), llvm::cl::cat(SlicingOpts));
+
 using VariablesMapTy = std::map<const llvm::Value *, CVariableDecl>;
 VariablesMapTy allocasToVars(const llvm::Module &M);
 VariablesMapTy valuesToVars;
@@ -270,7 +278,7 @@ static void dumpPointer(const Pointer &ptr, bool dot) {
         printf(" + %" PRIu64, *ptr.offset);
 }
 
-static void dumpMemoryObject(MemoryObject *mo, int ind, bool dot) {
+static void dumpMemoryObject(const MemoryObject *mo, int ind, bool dot) {
     bool printed_multi = false;
     for (auto &it : mo->pointsTo) {
         int width = 0;
@@ -324,7 +332,7 @@ static void dumpMemoryMap(PointerAnalysisFS::MemoryMapT *mm, int ind,
         else
             putchar('\n');
 
-        dumpMemoryObject(it.second.get(), ind + 4, dot);
+        dumpMemoryObject(&it.second, ind + 4, dot);
     }
 }
 
@@ -508,7 +516,9 @@ static void dumpNodeEdgesToDot(PSNode *node) {
 }
 
 PSNode *getNodePtr(PSNode *ptr) { return ptr; }
-PSNode *getNodePtr(const std::unique_ptr<PSNode> &ptr) { return ptr.get(); }
+PSNode *getNodePtr(const PointerGraph::NodesT::value_type &ptr) {
+    return ptr.get();
+}
 
 template <typename ContT>
 static void dumpToDot(const ContT &nodes, PTType type) {
@@ -772,6 +782,11 @@ static void dumpStats(DGLLVMPointerAnalysis *pta) {
     printf("Pointing to stack: %zu\n", pointing_to_stack);
     printf("Pointing to function: %zu\n", pointing_to_function);
     printf("Maximum pt-set size: %zu\n", maximum);
+
+    if (const auto *S = pta->getPTA()->getStatistics()) {
+        fflush(stdout);
+        S->dumpJSON(std::cout);
+    }
 }
 
 std::unique_ptr<llvm::Module> parseModule(llvm::LLVMContext &context,
@@ -842,8 +857,31 @@ int main(int argc, char *argv[]) {
         }
     }
 
+    // the recording stops when leaving main,
+    // after the analysis and its sets were destroyed
+    struct TraceRecording {
+        ~TraceRecording() { PointsToSetTraceWriter::stop(); }
+    } traceRecording;
+    if (!record_trace.empty()) {
+#ifdef DG_RECORD_POINTS_TO_SETS
+        if (!PointsToSetTraceWriter::start(record_trace)) {
+            llvm::errs() << "Cannot create the trace file '" << record_trace
+                         << "'\n";
+            return 1;
+        }
+#else
+        llvm::errs() << "Recording traces of points-to sets requires dg "
+                        "built with RECORD_POINTS_TO_SETS=ON\n";
+        return 1;
+#endif
+    }
+
     TimeMeasure tm;
     auto &opts = options.dgOptions.PTAOptions;
+    // we dump the pointer graph, so always run the analysis
+    opts.snapshotPath.clear();
+    // gather the statistics of the solver
+    opts.statistics = _stats;
 
 #ifdef HAVE_SVF
     if (opts.isSVF()) {
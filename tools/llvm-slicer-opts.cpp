@@ -162,6 +162,91 @@ SlicerOptions parseSlicerOptions(int argc, char *argv[], bool requireCrit,
             llvm::cl::value_desc("N"), llvm::cl::init(dg::Offset::UNKNOWN),
             llvm::cl::cat(SlicingOpts));
 
+    llvm::cl::opt<bool> ptaDiffPropagation(
+            "pta-diff-propagation",
+            llvm::cl::desc("Use difference propagation in pointer analysis,\n"
+                           "i.e., process only the pointers that are new\n"
+                           "since the last visit of a node (default=false).\n"),
+            llvm::cl::init(false), llvm::cl::cat(SlicingOpts));
+
+    llvm::cl::opt<bool> ptaSCCWorklist(
+            "pta-scc-worklist",
+            llvm::cl::desc("Use a worklist ordered by SCCs of the control flow\n"
+                           "in pointer analysis instead of re-processing all\n"
+                           "nodes reachable from changes (default=false).\n"),
+            llvm::cl::init(false), llvm::cl::cat(SlicingOpts));
+
+    llvm::cl::opt<bool> ptaCollapseCycles(
+            "pta-collapse-cycles",
+            llvm::cl::desc("Detect cycles of PHI, cast and zero-offset GEP\n"
+                           "nodes in pointer analysis and collapse them\n"
+                           "into a single node (default=false).\n"),
+            llvm::cl::init(false), llvm::cl::cat(SlicingOpts));
+
+    llvm::cl::opt<bool> ptaUnificationPrepass(
+            "pta-unification-prepass",
+            llvm::cl::desc("Run unification-based pointer analysis first\n"
+                           "and use its results to skip nodes that cannot\n"
+                           "point anywhere and to find cycles of copy nodes\n"
+                           "(default=false).\n"),
+            llvm::cl::init(false), llvm::cl::cat(SlicingOpts));
+
+    llvm::cl::opt<unsigned> ptaSolverThreads(
+            "pta-solver-threads",
+            llvm::cl::desc("Use N threads to solve flow-insensitive pointer\n"
+                           "analysis. Ignored with -pta-diff-propagation,\n"
+                           "-pta-scc-worklist and -pta-collapse-cycles\n"
+                           "(default=1).\n"),
+            llvm::cl::value_desc("N"), llvm::cl::init(1),
+            llvm::cl::cat(SlicingOpts));
+
+    llvm::cl::opt<unsigned> ptaBuildThreads(
+            "pta-build-threads",
+            llvm::cl::desc("Use N threads to build the pointer graphs\n"
+                           "of functions. Ignored with -consider-threads\n"
+                           "(default=1).\n"),
+            llvm::cl::value_desc("N"), llvm::cl::init(1),
+            llvm::cl::cat(SlicingOpts));
+
+    llvm::cl::opt<bool> ptaOptimizeGraph(
+            "pta-optimize-graph",
+            llvm::cl::desc("Optimize the pointer graph before running\n"
+                           "pointer analysis: remove no-op nodes and merge\n"
+                           "nodes with the same points-to sets\n"
+                           "(default=false).\n"),
+            llvm::cl::init(false), llvm::cl::cat(SlicingOpts));
+
+    llvm::cl::opt<uint64_t> ptaTimeBudget(
+            "pta-time-budget",
+            llvm::cl::desc("The time budget of pointer analysis in ms.\n"
+                           "When exceeded, the analysis continues with\n"
+                           "coarser (but sound) abstractions. If it must\n"
+                           "stop, the calls via pointers that were not\n"
+                           "resolved yet stay unresolved (default=0,\n"
+                           "no limit).\n"),
+            llvm::cl::value_desc("ms"), llvm::cl::init(0),
+            llvm::cl::cat(SlicingOpts));
+
+    llvm::cl::opt<uint64_t> ptaMemoryBudget(
+            "pta-memory-budget",
+            llvm::cl::desc("The budget for points-to sets in MB.\n"
+                           "When exceeded, the analysis continues with\n"
+                           "coarser (but sound) abstractions. If it must\n"
+                           "stop, the calls via pointers that were not\n"
+                           "resolved yet stay unresolved (default=0,\n"
+                           "no limit).\n"),
+            llvm::cl::value_desc("MB"), llvm::cl::init(0),
+            llvm::cl::cat(SlicingOpts));
+
+    llvm::cl::opt<std::string> ptaSnapshot(
+            "pta-snapshot",
+            llvm::cl::desc("Load the results of pointer analysis from the\n"
+                           "file if they were stored there for the same\n"
+                           "module and options, otherwise run the analysis\n"
+                           "and store the results into the file.\n"),
+            llvm::cl::value_desc("file"), llvm::cl::init(""),
+            llvm::cl::cat(SlicingOpts));
+
     llvm::cl::opt<dg::dda::UndefinedFunsBehavior> undefinedFunsBehavior(
             "undefined-funs",
             llvm::cl::desc("Set the behavior of undefined functions\n"),
@@ -232,7 +317,18 @@ SlicerOptions parseSlicerOptions(int argc, char *argv[], bool requireCrit,
                     clEnumValN(LLVMPointerAnalysisOptions::AnalysisType::fs,
                                "fs", "Flow-sensitive PTA"),
                     clEnumValN(LLVMPointerAnalysisOptions::AnalysisType::inv,
-                               "inv", "PTA with invalidate nodes")
+                               "inv", "PTA with invalidate nodes"),
+                    clEnumValN(LLVMPointerAnalysisOptions::AnalysisType::sfs,
+                               "sfs",
+                               "Flow-sensitive PTA staged on flow-insensitive "
+                               "PTA"),
+                    clEnumValN(LLVMPointerAnalysisOptions::AnalysisType::demand,
+                               "demand",
+                               "Flow-insensitive PTA computed on demand"),
+                    clEnumValN(LLVMPointerAnalysisOptions::AnalysisType::
+                                       steensgaard,
+                               "steensgaard",
+                               "Unification-based (Steensgaard's) PTA")
 #ifdef HAVE_SVF
                             ,
                     clEnumValN(LLVMPointerAnalysisOptions::AnalysisType::svf,
@@ -367,6 +463,20 @@ SlicerOptions parseSlicerOptions(int argc, char *argv[], bool requireCrit,
         }
     }
 
+    if (ptaSolverThreads > 1 &&
+        (ptaType != LLVMPointerAnalysisOptions::AnalysisType::fi ||
+         ptaDiffPropagation || ptaSCCWorklist || ptaCollapseCycles)) {
+        llvm::errs() << "WARNING: -pta-solver-threads is used only by the "
+                        "flow-insensitive analysis without "
+                        "-pta-diff-propagation, -pta-scc-worklist and "
+                        "-pta-collapse-cycles, ignoring it\n";
+    }
+
+    if (ptaBuildThreads > 1 && threads) {
+        llvm::errs() << "WARNING: -pta-build-threads is not used "
+                        "with -consider-threads, ignoring it\n";
+    }
+
     /// Fill the structure
     SlicerOptions options;
 
@@ -398,6 +508,16 @@ SlicerOptions parseSlicerOptions(int argc, char *argv[], bool requireCrit,
     PTAOptions.entryFunction = entryFunction;
     PTAOptions.fieldSensitivity = dg::Offset(ptaFieldSensitivity);
     PTAOptions.analysisType = ptaType;
+    PTAOptions.diffPropagation = ptaDiffPropagation;
+    PTAOptions.sccOrderedWorklist = ptaSCCWorklist;
+    PTAOptions.collapseCycles = ptaCollapseCycles;
+    PTAOptions.solverThreads = ptaSolverThreads;
+    PTAOptions.buildThreads = ptaBuildThreads;
+    PTAOptions.unificationPrepass = ptaUnificationPrepass;
+    PTAOptions.optimizeGraph = ptaOptimizeGraph;
+    PTAOptions.timeBudget = ptaTimeBudget;
+    PTAOptions.memoryBudget = ptaMemoryBudget * 1024 * 1024;
+    PTAOptions.snapshotPath = ptaSnapshot;
     PTAOptions.threads = threads;
 
     DDAOptions.threads = threads;
@@ -50,14 +50,15 @@ inline bool hasRelevantPredecessor(llvm::BasicBlock *B,
 // FIXME: refactor
 // FIXME: configurable entry
 bool cutoffDivergingBranches(Module& M, const std::string& entry,
-                             const std::vector<const llvm::Value *>& criteria) {
+                             const std::vector<const llvm::Value *>& criteria,
+                             LLVMPointerAnalysis *pta) {
 
     if (criteria.empty()) {
         assert(false && "Have no slicing criteria instructions");
         return false;
     }
 
-    llvmdg::LazyLLVMCallGraph CG(&M);
+    llvmdg::LazyLLVMCallGraph CG(&M, pta);
     std::set<BasicBlock*> relevant;
     std::set<BasicBlock*> visited;
     std::stack<BasicBlock*> queue; // not efficient...
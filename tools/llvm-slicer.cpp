@@ -113,6 +113,13 @@ llvm::cl::opt<bool> cutoff_diverging(
                 " (default=true)."),
         llvm::cl::init(true), llvm::cl::cat(SlicingOpts));
 
+llvm::cl::opt<bool> cutoff_diverging_pta(
+        "cutoff-diverging-pta",
+        llvm::cl::desc("Resolve calls via pointers when cutting off diverging "
+                       "paths using unification-based pointer analysis "
+                       "(default=false)."),
+        llvm::cl::init(false), llvm::cl::cat(SlicingOpts));
+
 static void maybe_print_statistics(llvm::Module *M,
                                    const char *prefix = nullptr) {
     if (!statistics)
@@ -219,6 +226,9 @@ int main(int argc, char *argv[]) {
         DBG_ENABLE();
     }
 
+    // gather also the statistics of the pointer analysis
+    options.dgOptions.PTAOptions.statistics = statistics;
+
     // dump_dg_only implies dumg_dg
     if (dump_dg_only) {
         dump_dg = true;
@@ -275,8 +285,19 @@ int main(int argc, char *argv[]) {
         }
 
         DBG(llvm - slicer, "Cutting off diverging branches");
+        // a fast (and coarse) analysis is enough here
+        std::unique_ptr<DGLLVMPointerAnalysis> cutoffPTA;
+        if (cutoff_diverging_pta) {
+            auto ptaopts = options.dgOptions.PTAOptions;
+            ptaopts.analysisType =
+                    LLVMPointerAnalysisOptions::AnalysisType::steensgaard;
+            ptaopts.snapshotPath.clear();
+            cutoffPTA.reset(new DGLLVMPointerAnalysis(M.get(), ptaopts));
+            cutoffPTA->run();
+        }
         if (!llvmdg::cutoffDivergingBranches(
-                    *M.get(), options.dgOptions.entryFunction, csvalues)) {
+                    *M.get(), options.dgOptions.entryFunction, csvalues,
+                    cutoffPTA.get())) {
             errs() << "[llvm-slicer]: Failed cutting off diverging branches\n";
             return 1;
         }